@@ -159,6 +159,8 @@ class Context;
 
 } // namespace interp
 
+class ConstexprCallCache;
+
 namespace serialization {
 template <class> class AbstractTypeReader;
 } // namespace serialization
@@ -644,6 +646,7 @@ private:
   const TargetInfo *AuxTarget = nullptr;
   clang::PrintingPolicy PrintingPolicy;
   std::unique_ptr<interp::Context> InterpContext;
+  std::unique_ptr<ConstexprCallCache> ConstexprCalls;
   std::unique_ptr<ParentMapContext> ParentMapCtx;
 
   /// Keeps track of the deallocated DeclListNodes for future reuse.
@@ -661,6 +664,10 @@ public:
   /// Returns the clang bytecode interpreter context.
   interp::Context &getInterpContext();
 
+  /// Returns the cache of constexpr call results used by the constant
+  /// evaluator with -fconstexpr-call-cache.
+  ConstexprCallCache &getConstexprCallCache();
+
   struct CUDAConstantEvalContext {
     /// Do not allow wrong-sided variables in constant expressions.
     bool NoWrongSidedVars = false;
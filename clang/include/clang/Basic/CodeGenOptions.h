@@ -60,7 +60,8 @@ public:
     LIBMVEC,           // GLIBC vector math library.
     MASSV,             // IBM MASS vector library.
     SVML,              // Intel short vector math library.
-    Darwin_libsystem_m // Use Darwin's libsytem_m vector functions.
+    Darwin_libsystem_m, // Use Darwin's libsytem_m vector functions.
+    LLVMLibc            // LLVM libc vector math functions.
   };
 
   enum ObjCDispatchMethodKind {
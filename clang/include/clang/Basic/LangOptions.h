@@ -24,6 +24,7 @@
 #include "llvm/ADT/FloatingPointMode.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
+#include <array>
 #include <string>
 #include <vector>
 
@@ -287,8 +288,19 @@ public:
     ExtendTo64
   };
 
+  //! version of the emitted floor function info
+  //! v5: adds per entry point resource usage entries (function type 101)
+  static constexpr const uint32_t floor_function_info_version { 5u };
   std::fstream* floor_function_info { nullptr };
   unsigned int floor_image_capabilities { 0 };
+  //! constant work-group sizes for which kernel variants should be emitted
+  std::vector<std::array<uint32_t, 3>> floor_work_group_size_variants;
+  //! host-compute: emit work-group loop nest variants of kernels
+  bool floor_host_compute_work_group_loops { false };
+  //! Metal/Vulkan: demote float dataflow feeding into unorm image writes/fragment outputs to half
+  bool floor_relaxed_precision { false };
+  //! Metal/Vulkan: also demote float dataflow feeding into fragment outputs to half
+  bool floor_relaxed_precision_fragment_outputs { false };
   bool metal_soft_printf { false };
   bool vulkan_soft_printf { false };
 
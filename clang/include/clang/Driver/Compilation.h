@@ -129,6 +129,9 @@ class Compilation {
   /// Whether to keep temporary files regardless of -save-temps.
   bool ForceKeepTempFiles = false;
 
+  /// The max number of independent jobs that are executed in parallel.
+  unsigned MaxParallelJobs = 1;
+
 public:
   Compilation(const Driver &D, const ToolChain &DefaultToolChain,
               llvm::opt::InputArgList *Args,
@@ -225,6 +228,12 @@ public:
     PostCallback = CB;
   }
 
+  /// Sets the max number of independent jobs (e.g. the compilation of
+  /// different inputs) that may be executed in parallel.
+  void setMaxParallelJobs(unsigned N) { MaxParallelJobs = N; }
+
+  unsigned getMaxParallelJobs() const { return MaxParallelJobs; }
+
   /// Returns the sysroot path.
   StringRef getSysRoot() const;
 
@@ -320,6 +329,20 @@ public:
   /// of three. The inferior process's stdin(0), stdout(1), and stderr(2) will
   /// be redirected to the corresponding paths, if provided (not llvm::None).
   void Redirect(ArrayRef<Optional<StringRef>> Redirects);
+
+private:
+  /// PrintCommand - Print the command line of \p C if requested (-v or
+  /// CC_PRINT_OPTIONS).
+  ///
+  /// \return Whether printing succeeded.
+  bool PrintCommand(const Command &C) const;
+
+  /// ExecuteJobsInParallel - Execute up to MaxParallelJobs jobs at the same
+  /// time, with each job only starting once all jobs it depends on are done.
+  /// The output of each job is captured and forwarded in job order.
+  void ExecuteJobsInParallel(
+      const JobList &Jobs,
+      SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const;
 };
 
 } // namespace driver
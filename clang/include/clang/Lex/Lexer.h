@@ -290,6 +290,15 @@ public:
   /// end of the buffer), false otherwise.
   bool skipOver(unsigned NumBytes);
 
+  /// Quickly skip over the lines of an excluded conditional block that can't
+  /// contain a preprocessor directive, without forming any tokens.
+  ///
+  /// This stops at the start of the next line that may begin with a '#' or at
+  /// any construct that requires real lexing (string and character literals,
+  /// escaped newlines, trigraphs, ...), so that the next token can be lexed
+  /// from there. Must only be called in raw mode between two tokens.
+  void skipExcludedConditionalLines();
+
   /// Stringify - Convert the specified string into a C string by i) escaping
   /// '\\' and " characters and ii) replacing newline character(s) with "\\n".
   /// If Charify is true, this escapes the ' character instead of ".
@@ -0,0 +1,78 @@
+//===--- ConstexprCallCache.h - Memoized constexpr calls --------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Defines the cache of constexpr function call results that is used by the
+// constant evaluator with -fconstexpr-call-cache.
+//
+// A call is only cached if its result depends on nothing but the callee and
+// the values of its arguments, see HandleFunctionCall in ExprConstant.cpp.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_AST_CONSTEXPRCALLCACHE_H
+#define LLVM_CLANG_LIB_AST_CONSTEXPRCALLCACHE_H
+
+#include "clang/AST/APValue.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace clang {
+
+class ConstexprCallCache {
+public:
+  /// Returns the cached result of the call identified by \p Key, or nullptr
+  /// if the call has not been cached yet.
+  const APValue *lookup(const llvm::FoldingSetNodeID &Key) {
+    void *InsertPos = nullptr;
+    if (Entry *E = Entries.FindNodeOrInsertPos(Key, InsertPos)) {
+      ++NumHits;
+      return &E->Result;
+    }
+    ++NumMisses;
+    return nullptr;
+  }
+
+  /// Caches \p Result as the result of the call identified by \p Key.
+  void insert(const llvm::FoldingSetNodeID &Key, const APValue &Result) {
+    void *InsertPos = nullptr;
+    if (Entries.FindNodeOrInsertPos(Key, InsertPos))
+      return;
+    Entries.InsertNode(new (Allocator.Allocate()) Entry(Key, Result),
+                       InsertPos);
+  }
+
+  void PrintStats() const {
+    llvm::errs() << "\n*** Constexpr Call Cache Stats:\n";
+    llvm::errs() << "  " << Entries.size() << " calls cached.\n";
+    llvm::errs() << "  " << NumHits << " cache hits.\n";
+    llvm::errs() << "  " << NumMisses << " cache misses.\n";
+  }
+
+private:
+  struct Entry : llvm::FoldingSetNode {
+    Entry(const llvm::FoldingSetNodeID &Key, const APValue &Result)
+        : Key(Key), Result(Result) {}
+
+    void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddNodeID(Key); }
+
+    llvm::FoldingSetNodeID Key;
+    APValue Result;
+  };
+
+  llvm::FoldingSet<Entry> Entries;
+  /// Owns the entries, and destroys their results with the cache.
+  llvm::SpecificBumpPtrAllocator<Entry> Allocator;
+
+  unsigned NumHits = 0;
+  unsigned NumMisses = 0;
+};
+
+} // namespace clang
+
+#endif
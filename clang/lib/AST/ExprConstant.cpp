@@ -32,6 +32,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ConstexprCallCache.h"
 #include "Interp/Context.h"
 #include "Interp/Frame.h"
 #include "Interp/State.h"
@@ -851,6 +852,22 @@ namespace {
     /// The number of heap allocations performed so far in this evaluation.
     unsigned NumHeapAllocs = 0;
 
+    /// A function call whose result may be memoized in the ConstexprCallCache.
+    struct CacheableCall {
+      /// The call frames of the call and of everything it calls have an index
+      /// of at least this.
+      unsigned FirstCallIndex;
+      /// The arguments of the call.
+      CallRef Arguments;
+      /// Whether the call accessed an object that may change during the
+      /// evaluation and that it did not create itself.
+      bool AccessedOutsideState = false;
+    };
+
+    /// The innermost function call that is being evaluated and whose result
+    /// may be memoized, if any.
+    CacheableCall *CurrentCacheableCall = nullptr;
+
     struct EvaluatingConstructorRAII {
       EvalInfo &EI;
       ObjectUnderConstruction Object;
@@ -3956,6 +3973,33 @@ static bool AreElementsOfSameArray(QualType ObjType,
   return CommonLength >= A.Entries.size() - IsArray;
 }
 
+/// Note an access to the object \p LVal, which belongs to \p Frame, while
+/// evaluating a function call whose result may be memoized. Its result only
+/// depends on its arguments if it accesses nothing but its parameters, the
+/// objects it creates and constants.
+static void noteCacheableCallAccess(EvalInfo &Info, const LValue &LVal,
+                                    CallStackFrame *Frame) {
+  EvalInfo::CacheableCall &Call = *Info.CurrentCacheableCall;
+  if (Frame) {
+    if (Frame->Index >= Call.FirstCallIndex)
+      return;
+    // The arguments are stored in the frame of the caller.
+    const ValueDecl *VD = LVal.Base.dyn_cast<const ValueDecl *>();
+    if (VD && isa<ParmVarDecl>(VD) &&
+        Frame->Index == Call.Arguments.CallIndex &&
+        LVal.getLValueVersion() == Call.Arguments.Version)
+      return;
+    Call.AccessedOutsideState = true;
+    return;
+  }
+
+  // Apart from constants, an object without a frame is the variable being
+  // initialized, a temporary extended by it, or a dynamic allocation, all of
+  // which may change during the evaluation.
+  if (lifetimeStartedInEvaluation(Info, LVal.Base))
+    Call.AccessedOutsideState = true;
+}
+
 /// Find the complete object to which an LValue refers.
 static CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E,
                                          AccessKinds AK, const LValue &LVal,
@@ -3983,6 +4027,9 @@ static CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E,
     }
   }
 
+  if (Info.CurrentCacheableCall)
+    noteCacheableCallAccess(Info, LVal, Frame);
+
   bool IsAccess = isAnyAccess(AK);
 
   // C++11 DR1311: An lvalue-to-rvalue conversion on a volatile-qualified type
@@ -6096,6 +6143,91 @@ static bool handleTrivialCopy(EvalInfo &Info, const ParmVarDecl *Param,
       CopyObjectRepresentation);
 }
 
+/// Whether \p Value can be used as the key or the result of a memoized call.
+/// Values that refer to objects cannot.
+static bool isCacheableValue(const APValue &Value) {
+  switch (Value.getKind()) {
+  case APValue::None:
+  case APValue::Indeterminate:
+  case APValue::Int:
+  case APValue::Float:
+  case APValue::FixedPoint:
+  case APValue::ComplexInt:
+  case APValue::ComplexFloat:
+  case APValue::Vector:
+    return true;
+  case APValue::LValue:
+  case APValue::MemberPointer:
+  case APValue::AddrLabelDiff:
+    return false;
+  case APValue::Array:
+    for (unsigned I = 0, N = Value.getArrayInitializedElts(); I != N; ++I)
+      if (!isCacheableValue(Value.getArrayInitializedElt(I)))
+        return false;
+    return !Value.hasArrayFiller() ||
+           isCacheableValue(Value.getArrayFiller());
+  case APValue::Struct:
+    for (unsigned I = 0, N = Value.getStructNumBases(); I != N; ++I)
+      if (!isCacheableValue(Value.getStructBase(I)))
+        return false;
+    for (unsigned I = 0, N = Value.getStructNumFields(); I != N; ++I)
+      if (!isCacheableValue(Value.getStructField(I)))
+        return false;
+    return true;
+  case APValue::Union:
+    return !Value.getUnionField() || isCacheableValue(Value.getUnionValue());
+  }
+  llvm_unreachable("unknown APValue kind");
+}
+
+/// Whether the evaluation has not noted any side effects, undefined behavior
+/// or diagnostics so far.
+static bool hasCleanEvalStatus(const EvalInfo &Info) {
+  const Expr::EvalStatus &Status = Info.EvalStatus;
+  return !Status.HasSideEffects && !Status.HasUndefinedBehavior &&
+         (!Status.Diag || Status.Diag->empty());
+}
+
+/// Determine whether the result of a call to \p Callee may be memoized, and
+/// compute the key of the call in the ConstexprCallCache if so. Only calls of
+/// functions without a 'this' pointer whose arguments are plain values are
+/// considered.
+static bool profileCacheableCall(EvalInfo &Info, const FunctionDecl *Callee,
+                                 const LValue *This, CallRef Call,
+                                 llvm::FoldingSetNodeID &Key) {
+  if (!Info.getLangOpts().ConstexprCallCache || This || Callee->isVariadic())
+    return false;
+  if (const auto *MD = dyn_cast<CXXMethodDecl>(Callee))
+    if (MD->isInstance())
+      return false;
+  if (Info.checkingPotentialConstantExpression() ||
+      Info.checkingForUndefinedBehavior() || !hasCleanEvalStatus(Info))
+    return false;
+  if (!Call && Callee->getNumParams())
+    return false;
+
+  // Diagnostics that do not stop the evaluation are only noted if there is
+  // somewhere to put them, so results evaluated without notes cannot be reused
+  // by evaluations with notes.
+  Key.AddPointer(Callee);
+  Key.AddInteger(Info.EvalMode);
+  Key.AddBoolean(Info.InConstantContext);
+  Key.AddBoolean(Info.EvalStatus.Diag);
+  for (const ParmVarDecl *PVD : Callee->parameters()) {
+    const APValue *Arg = Info.getParamSlot(Call, PVD);
+    if (!Arg || !isCacheableValue(*Arg))
+      return false;
+    Arg->Profile(Key);
+  }
+  return true;
+}
+
+static bool EvaluateFunctionCall(SourceLocation CallLoc,
+                                 const FunctionDecl *Callee, const LValue *This,
+                                 ArrayRef<const Expr *> Args, CallRef Call,
+                                 const Stmt *Body, EvalInfo &Info,
+                                 APValue &Result, const LValue *ResultSlot);
+
 /// Evaluate a function call.
 static bool HandleFunctionCall(SourceLocation CallLoc,
                                const FunctionDecl *Callee, const LValue *This,
@@ -6105,6 +6237,44 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   if (!Info.CheckCallLimit(CallLoc))
     return false;
 
+  // With -fconstexpr-call-cache, reuse the result of an earlier evaluation of
+  // the same call, or cache the result of this one if it turns out to depend
+  // only on the arguments.
+  llvm::FoldingSetNodeID CacheKey;
+  if (!profileCacheableCall(Info, Callee, This, Call, CacheKey))
+    return EvaluateFunctionCall(CallLoc, Callee, This, Args, Call, Body, Info,
+                                Result, ResultSlot);
+
+  ConstexprCallCache &Cache = Info.Ctx.getConstexprCallCache();
+  if (const APValue *Cached = Cache.lookup(CacheKey)) {
+    Result = *Cached;
+    return true;
+  }
+
+  EvalInfo::CacheableCall CacheableCall = {Info.NextCallIndex, Call};
+  EvalInfo::CacheableCall *OuterCall = Info.CurrentCacheableCall;
+  Info.CurrentCacheableCall = &CacheableCall;
+  size_t NumHeapAllocs = Info.HeapAllocs.size();
+  bool Success = EvaluateFunctionCall(CallLoc, Callee, This, Args, Call, Body,
+                                      Info, Result, ResultSlot);
+  Info.CurrentCacheableCall = OuterCall;
+
+  if (CacheableCall.AccessedOutsideState) {
+    if (OuterCall)
+      OuterCall->AccessedOutsideState = true;
+  } else if (Success && hasCleanEvalStatus(Info) &&
+             Info.HeapAllocs.size() == NumHeapAllocs &&
+             isCacheableValue(Result)) {
+    Cache.insert(CacheKey, Result);
+  }
+  return Success;
+}
+
+static bool EvaluateFunctionCall(SourceLocation CallLoc,
+                                 const FunctionDecl *Callee, const LValue *This,
+                                 ArrayRef<const Expr *> Args, CallRef Call,
+                                 const Stmt *Body, EvalInfo &Info,
+                                 APValue &Result, const LValue *ResultSlot) {
   CallStackFrame Frame(Info, CallLoc, Callee, This, Call);
 
   // For a trivial copy or move assignment, perform an APValue copy. This is
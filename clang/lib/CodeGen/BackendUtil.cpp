@@ -139,6 +139,21 @@ class EmitAssemblyHelper {
 
   void CreatePasses(legacy::PassManager &MPM, legacy::FunctionPassManager &FPM);
 
+  /// Closes the floor function info file once all optimization passes have run
+  /// (the resource usage info is appended by the last pass in the pipeline).
+  bool FloorFunctionInfoClosed = false;
+  void CloseFloorFunctionInfo() {
+    if (FloorFunctionInfoClosed)
+      return;
+    FloorFunctionInfoClosed = true;
+    if ((LangOpts.Metal || LangOpts.CUDA || LangOpts.OpenCL ||
+         LangOpts.Vulkan || LangOpts.FloorHostCompute) &&
+        LangOpts.floor_function_info != nullptr) {
+      LangOpts.floor_function_info->close();
+      delete LangOpts.floor_function_info;
+    }
+  }
+
   /// Generates the TargetMachine.
   /// Leaves TM unchanged if it is unable to create the target machine.
   /// Some of our clang tests specify triples which are not built
@@ -185,6 +200,8 @@ public:
         CodeGenerationTime("codegen", "Code Generation Time") {}
 
   ~EmitAssemblyHelper() {
+    // in case of an early exit
+    CloseFloorFunctionInfo();
     if (CodeGenOpts.DisableFree)
       BuryPointer(std::move(TM));
   }
@@ -449,6 +466,20 @@ static TargetLibraryInfoImpl *createTLII(llvm::Triple &TargetTriple,
     TLII->addVectorizableFunctionsFromVecLib(
         TargetLibraryInfoImpl::DarwinLibSystemM);
     break;
+  case CodeGenOptions::LLVMLibc:
+    switch (TargetTriple.getArch()) {
+    default:
+      break;
+    case llvm::Triple::x86_64:
+      TLII->addVectorizableFunctionsFromVecLib(
+          TargetLibraryInfoImpl::LLVMLIBC_X86);
+      break;
+    case llvm::Triple::aarch64:
+      TLII->addVectorizableFunctionsFromVecLib(
+          TargetLibraryInfoImpl::LLVMLIBC_AARCH64);
+      break;
+    }
+    break;
   default:
     break;
   }
@@ -767,14 +798,39 @@ void EmitAssemblyHelper::CreatePasses(legacy::PassManager &MPM,
 
   MPM.add(new TargetLibraryInfoWrapperPass(*TLII));
 
-  // close floor function info file, this is no longer needed
+  // append the static resource usage of all entry points to the floor function info,
+  // the file itself is closed once all passes have run (-> CloseFloorFunctionInfo)
   if ((LangOpts.Metal || LangOpts.CUDA || LangOpts.OpenCL || LangOpts.Vulkan || LangOpts.FloorHostCompute) &&
       LangOpts.floor_function_info != nullptr) {
-    LangOpts.floor_function_info->close();
-    delete LangOpts.floor_function_info;
+    PMBuilder.floor_resource_usage_cb = [&file = *LangOpts.floor_function_info](const llvm::Function& F,
+                                                                                 const llvm::FloorResourceUsageInfo& usage) {
+      // #0: info version
+      file << LangOptions::floor_function_info_version << ",";
+      // #1: function name
+      file << F.getName().str() << ",";
+      // #2: function type (resource usage)
+      file << "101,";
+      // #3: function flags (none)
+      file << "0,";
+      // #4,5,6: unused
+      file << "0,0,0,";
+      // #7+: local memory size, private memory size, #barriers, #atomics, estimated #registers
+      file << usage.local_memory_size << ",";
+      file << usage.private_memory_size << ",";
+      file << usage.barrier_count << ",";
+      file << usage.atomic_count << ",";
+      file << usage.register_count << ",";
+      file << "\n";
+    };
   }
   
   PMBuilder.floor_image_capabilities = LangOpts.floor_image_capabilities;
+  if ((LangOpts.Metal || LangOpts.CUDA || LangOpts.OpenCL || LangOpts.Vulkan) && !LangOpts.FloorHostCompute) {
+    PMBuilder.floor_work_group_size_variants = LangOpts.floor_work_group_size_variants;
+  }
+  PMBuilder.EnableHostComputeWorkGroupLoops = LangOpts.FloorHostCompute && LangOpts.floor_host_compute_work_group_loops;
+  PMBuilder.EnableRelaxedPrecisionDemotion = (LangOpts.Metal || LangOpts.Vulkan) && LangOpts.floor_relaxed_precision;
+  PMBuilder.EnableRelaxedPrecisionFragmentOutputs = LangOpts.floor_relaxed_precision_fragment_outputs;
   
   PMBuilder.EnableAddressSpaceFix = LangOpts.OpenCL;
   if (PMBuilder.EnableAddressSpaceFix && CodeGenOpts.OptimizationLevel == 0) {
@@ -1233,6 +1289,9 @@ void EmitAssemblyHelper::EmitAssemblyWithLegacyPassManager(
     PerModulePasses.run(*TheModule);
   }
 
+  // all resource usage info has been written at this point
+  CloseFloorFunctionInfo();
+
   {
     PrettyStackTraceString CrashInfo("Code generation");
     llvm::TimeTraceScope TimeScope("CodeGenPasses");
@@ -1747,6 +1806,7 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   std::unique_ptr<llvm::ToolOutputFile> ThinLinkOS, DwoOS;
   RunOptimizationPipeline(Action, OS, ThinLinkOS);
+  CloseFloorFunctionInfo();
   RunCodegenPipeline(Action, OS, DwoOS);
 
   if (ThinLinkOS)
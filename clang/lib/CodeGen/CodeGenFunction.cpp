@@ -45,6 +45,7 @@
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/Support/CRC.h"
+#include "llvm/Transforms/LibFloor/FloorUtils.h"
 #include "llvm/Transforms/Scalar/LowerExpectIntrinsic.h"
 #include "llvm/Transforms/Utils/PromoteMemToReg.h"
 
@@ -652,13 +653,8 @@ void CodeGenFunction::EmitOpenCLKernelMetadata(const FunctionDecl *FD,
     Fn->setMetadata("work_group_size_hint", llvm::MDNode::get(Context, AttrMDArgs));
   }
 
-  if (const ReqdWorkGroupSizeAttr *A = FD->getAttr<ReqdWorkGroupSizeAttr>()) {
-    llvm::Metadata *AttrMDArgs[] = {
-        llvm::ConstantAsMetadata::get(Builder.getInt32(A->getXDim())),
-        llvm::ConstantAsMetadata::get(Builder.getInt32(A->getYDim())),
-        llvm::ConstantAsMetadata::get(Builder.getInt32(A->getZDim()))};
-    Fn->setMetadata("reqd_work_group_size", llvm::MDNode::get(Context, AttrMDArgs));
-  }
+  // NOTE: reqd_work_group_size metadata is emitted for all backends in
+  // StartFunction
 
   if (const OpenCLIntelReqdSubGroupSizeAttr *A =
           FD->getAttr<OpenCLIntelReqdSubGroupSizeAttr>()) {
@@ -1087,6 +1083,12 @@ void CodeGenFunction::StartFunction(GlobalDecl GD, QualType RetTy,
 
   // emit compute metadata
   if (FD && (getLangOpts().OpenCL || getLangOpts().CUDA || getLangOpts().FloorHostCompute)) {
+    // required work-group size (all backends): this is what the libfloor
+    // passes and the floor function info use to identify such kernels
+    if (const ReqdWorkGroupSizeAttr *A = FD->getAttr<ReqdWorkGroupSizeAttr>()) {
+      libfloor_utils::set_required_work_group_size(*Fn, {{ A->getXDim(), A->getYDim(), A->getZDim() }});
+    }
+
     // add floor specific metadata for kernel functions
     EmitFloorKernelMetadata(FD, Fn, Args, FnInfo, CGM);
     
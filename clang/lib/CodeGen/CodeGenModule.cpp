@@ -66,6 +66,7 @@
 #include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/X86TargetParser.h"
 #include "llvm/Transforms/LibFloor/FloorImageType.h"
+#include "llvm/Transforms/LibFloor/FloorUtils.h"
 
 #include <sstream>
 #include <unordered_set>
@@ -3951,7 +3952,7 @@ void CodeGenFunction::EmitFloorKernelMetadata(const FunctionDecl *FD,
 	const PrintingPolicy &Policy = getContext().getPrintingPolicy();
 	
 	// #0: info version
-	constexpr const uint32_t floor_info_version { 4u };
+	constexpr const uint32_t floor_info_version { LangOptions::floor_function_info_version };
 	info << floor_info_version << ",";
 	// #1: function name
 	info << Fn->getName().str() << ",";
@@ -4570,6 +4571,43 @@ void CodeGenFunction::EmitFloorKernelMetadata(const FunctionDecl *FD,
 	file << info.str();
 	file << arg_buf_info.str();
 	
+	// constant work-group size kernel variants: these are identical to the original kernel, apart from the name and local size
+	// NOTE: the actual kernel variants are created by the KernelWorkGroupSizeVariants pass (which needs the LLVM pipeline),
+	//       which uses the same predicate to skip kernels that already have a required work-group size
+	if (is_kernel && !libfloor_utils::get_required_work_group_size(*Fn) && !getLangOpts().FloorHostCompute &&
+		!CGM.getCodeGenOpts().DisableLLVMPasses) {
+		// replaces #1 (function name) and optionally #4,5,6 (local size) in all lines of "info_lines"
+		const auto make_variant_info = [](const std::string& info_lines, const std::string& variant_name,
+										  const std::array<uint32_t, 3>* local_size) {
+			std::stringstream variant_info;
+			SmallVector<StringRef, 4> lines;
+			StringRef(info_lines).split(lines, '\n', -1, false);
+			for (const auto& line : lines) {
+				SmallVector<StringRef, 16> fields;
+				line.split(fields, ',');
+				for (size_t i = 0; i < fields.size(); ++i) {
+					if (i == 1) {
+						variant_info << variant_name;
+					} else if (local_size != nullptr && i >= 4 && i <= 6) {
+						variant_info << (*local_size)[i - 4];
+					} else {
+						variant_info << fields[i].str();
+					}
+					if (i + 1 < fields.size()) {
+						variant_info << ",";
+					}
+				}
+				variant_info << "\n";
+			}
+			return variant_info.str();
+		};
+		for (const auto& wg_size : getLangOpts().floor_work_group_size_variants) {
+			const auto variant_name = Fn->getName().str() + libfloor_utils::get_work_group_size_variant_suffix(wg_size);
+			file << make_variant_info(info.str(), variant_name, &wg_size);
+			file << make_variant_info(arg_buf_info.str(), variant_name, nullptr);
+		}
+	}
+	
 #if 0 // for debugging purposes
 	printf("floor function info: %s", info.str().c_str()); fflush(stdout);
 #endif
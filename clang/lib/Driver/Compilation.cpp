@@ -15,19 +15,29 @@
 #include "clang/Driver/Options.h"
 #include "clang/Driver/ToolChain.h"
 #include "clang/Driver/Util.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/OptSpecifier.h"
 #include "llvm/Option/Option.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <system_error>
 #include <utility>
+#include <vector>
 
 using namespace clang;
 using namespace driver;
@@ -161,8 +171,7 @@ bool Compilation::CleanupFileMap(const ArgStringMap &Files,
   return Success;
 }
 
-int Compilation::ExecuteCommand(const Command &C,
-                                const Command *&FailingCommand) const {
+bool Compilation::PrintCommand(const Command &C) const {
   if ((getDriver().CCPrintOptions ||
        getArgs().hasArg(options::OPT_v)) && !getDriver().CCGenDiagnostics) {
     raw_ostream *OS = &llvm::errs();
@@ -179,8 +188,7 @@ int Compilation::ExecuteCommand(const Command &C,
       if (EC) {
         getDriver().Diag(diag::err_drv_cc_print_options_failure)
             << EC.message();
-        FailingCommand = &C;
-        return 1;
+        return false;
       }
       OS = OwnedStream.get();
     }
@@ -190,6 +198,15 @@ int Compilation::ExecuteCommand(const Command &C,
 
     C.Print(*OS, "\n", /*Quote=*/getDriver().CCPrintOptions);
   }
+  return true;
+}
+
+int Compilation::ExecuteCommand(const Command &C,
+                                const Command *&FailingCommand) const {
+  if (!PrintCommand(C)) {
+    FailingCommand = &C;
+    return 1;
+  }
 
   std::string Error;
   bool ExecutionFailed;
@@ -238,6 +255,16 @@ static bool InputsOk(const Command &C,
 
 void Compilation::ExecuteJobs(const JobList &Jobs,
                               FailingCommandList &FailingCommands) const {
+  // Independent jobs can be executed in parallel, unless the output of this
+  // compilation is redirected, a job is executed in-process or the cl driver
+  // has to bail as soon as one command fails.
+  if (MaxParallelJobs > 1 && Jobs.size() > 1 && llvm::llvm_is_multithreaded() &&
+      Redirects.empty() && !TheDriver.IsCLMode() &&
+      llvm::none_of(Jobs, [](const Command &Job) { return Job.InProcess; })) {
+    ExecuteJobsInParallel(Jobs, FailingCommands);
+    return;
+  }
+
   // According to UNIX standard, driver need to continue compiling all the
   // inputs on the command line even one of them failed.
   // In all but CLMode, execute all the jobs unless the necessary inputs for the
@@ -255,6 +282,172 @@ void Compilation::ExecuteJobs(const JobList &Jobs,
   }
 }
 
+/// Returns whether \p Job has to wait for \p Prev to finish, i.e. whether it
+/// consumes the action or any of the output files of \p Prev.
+static bool DependsOn(const Command &Job, const Command &Prev,
+                      const llvm::SmallPtrSetImpl<const Action *> &JobActions) {
+  if (JobActions.count(&Prev.getSource()))
+    return true;
+  for (const auto &Input : Job.getInputInfos())
+    if (Input.isFilename() &&
+        llvm::is_contained(Prev.getOutputFilenames(), Input.getFilename()))
+      return true;
+  return false;
+}
+
+void Compilation::ExecuteJobsInParallel(
+    const JobList &Jobs, FailingCommandList &FailingCommands) const {
+  SmallVector<const Command *, 16> Cmds;
+  for (const auto &Job : Jobs)
+    Cmds.push_back(&Job);
+  const size_t NumJobs = Cmds.size();
+
+  // Collect the earlier jobs each job depends on.
+  std::vector<SmallVector<size_t, 4>> Deps(NumJobs);
+  for (size_t I = 0; I < NumJobs; ++I) {
+    llvm::SmallPtrSet<const Action *, 16> JobActions;
+    SmallVector<const Action *, 16> Worklist{&Cmds[I]->getSource()};
+    while (!Worklist.empty()) {
+      const Action *A = Worklist.pop_back_val();
+      if (JobActions.insert(A).second)
+        Worklist.append(A->input_begin(), A->input_end());
+    }
+    for (size_t J = 0; J < I; ++J)
+      if (DependsOn(*Cmds[I], *Cmds[J], JobActions))
+        Deps[I].push_back(J);
+  }
+
+  enum class JobState { Pending, Running, Finished, Skipped };
+  struct JobInfo {
+    JobState State = JobState::Pending;
+    bool Executed = false;
+    int Res = 0;
+    std::string Error;
+    bool ExecutionFailed = false;
+    // Captured stdout/stderr of the job, empty if it couldn't be captured.
+    SmallString<128> OutputPath;
+    SmallString<128> ErrorPath;
+  };
+  std::vector<JobInfo> Infos(NumJobs);
+
+  std::mutex FinishedMutex;
+  std::condition_variable FinishedCV;
+  SmallVector<size_t, 16> FinishedJobs;
+
+  const size_t NumFailingCommands = FailingCommands.size();
+  size_t NumRunning = 0;
+  size_t NextToReport = 0;
+  // If the driver was started by a jobserver (e.g. make -jN), each running job
+  // holds a job slot, which the command inherits as its implicit slot.
+  llvm::ThreadPoolStrategy Strategy =
+      llvm::hardware_concurrency(MaxParallelJobs);
+  Strategy.UseJobserver = true;
+  llvm::ThreadPool Pool(Strategy);
+  while (true) {
+    // Start all pending jobs whose dependencies are done.
+    for (size_t I = NextToReport; I < NumJobs && NumRunning < MaxParallelJobs;
+         ++I) {
+      JobInfo &Info = Infos[I];
+      if (Info.State != JobState::Pending ||
+          llvm::any_of(Deps[I], [&Infos](size_t Dep) {
+            return Infos[Dep].State == JobState::Pending ||
+                   Infos[Dep].State == JobState::Running;
+          }))
+        continue;
+      if (!InputsOk(*Cmds[I], FailingCommands)) {
+        Info.State = JobState::Skipped;
+        continue;
+      }
+      if (!PrintCommand(*Cmds[I])) {
+        Info.State = JobState::Finished;
+        FailingCommands.push_back(std::make_pair(1, Cmds[I]));
+        continue;
+      }
+
+      // Capture the output, so that it can be forwarded without interleaving
+      // with the output of other jobs.
+      if (llvm::sys::fs::createTemporaryFile("driver-job", "out",
+                                             Info.OutputPath) ||
+          llvm::sys::fs::createTemporaryFile("driver-job", "err",
+                                             Info.ErrorPath)) {
+        if (!Info.OutputPath.empty())
+          llvm::sys::fs::remove(Info.OutputPath);
+        Info.OutputPath.clear();
+        Info.ErrorPath.clear();
+      }
+
+      Info.State = JobState::Running;
+      Info.Executed = true;
+      ++NumRunning;
+      Pool.async([&Infos, &Cmds, &FinishedMutex, &FinishedCV, &FinishedJobs,
+                  I] {
+        JobInfo &RunInfo = Infos[I];
+        SmallVector<Optional<StringRef>, 3> JobRedirects;
+        if (!RunInfo.OutputPath.empty())
+          JobRedirects = {None, StringRef(RunInfo.OutputPath),
+                          StringRef(RunInfo.ErrorPath)};
+        RunInfo.Res = Cmds[I]->Execute(JobRedirects, &RunInfo.Error,
+                                       &RunInfo.ExecutionFailed);
+
+        std::lock_guard<std::mutex> Lock(FinishedMutex);
+        FinishedJobs.push_back(I);
+        FinishedCV.notify_one();
+      });
+    }
+
+    // Forward the output and diagnostics of all done jobs in order.
+    for (; NextToReport < NumJobs; ++NextToReport) {
+      JobInfo &Info = Infos[NextToReport];
+      if (Info.State == JobState::Pending || Info.State == JobState::Running)
+        break;
+      if (!Info.Executed)
+        continue;
+      if (!Info.OutputPath.empty()) {
+        for (auto Stream : {std::make_pair(&Info.OutputPath, &llvm::outs()),
+                            std::make_pair(&Info.ErrorPath, &llvm::errs())}) {
+          if (auto Buffer = llvm::MemoryBuffer::getFile(*Stream.first))
+            *Stream.second << (*Buffer)->getBuffer();
+          Stream.second->flush();
+          llvm::sys::fs::remove(*Stream.first);
+        }
+      }
+
+      if (PostCallback)
+        PostCallback(*Cmds[NextToReport], Info.Res);
+      if (!Info.Error.empty()) {
+        assert(Info.Res && "Error string set with 0 result code!");
+        getDriver().Diag(diag::err_drv_command_failure) << Info.Error;
+      }
+    }
+    if (NextToReport == NumJobs)
+      break;
+
+    // Wait for at least one running job to finish.
+    assert(NumRunning > 0 && "No running job to wait for!");
+    std::unique_lock<std::mutex> Lock(FinishedMutex);
+    FinishedCV.wait(Lock, [&FinishedJobs] { return !FinishedJobs.empty(); });
+    for (size_t I : FinishedJobs) {
+      JobInfo &Info = Infos[I];
+      Info.State = JobState::Finished;
+      --NumRunning;
+      if (int Res = Info.ExecutionFailed ? 1 : Info.Res)
+        FailingCommands.push_back(std::make_pair(Res, Cmds[I]));
+    }
+    FinishedJobs.clear();
+  }
+
+  // Report failures in job order, independent of the order they finished in.
+  llvm::DenseMap<const Command *, size_t> JobIndices;
+  for (size_t I = 0; I < NumJobs; ++I)
+    JobIndices[Cmds[I]] = I;
+  std::stable_sort(FailingCommands.begin() + NumFailingCommands,
+                   FailingCommands.end(),
+                   [&JobIndices](const std::pair<int, const Command *> &LHS,
+                                 const std::pair<int, const Command *> &RHS) {
+                     return JobIndices[LHS.second] < JobIndices[RHS.second];
+                   });
+}
+
 void Compilation::initCompilationForDiagnostics() {
   ForDiagnostics = true;
 
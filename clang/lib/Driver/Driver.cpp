@@ -83,12 +83,14 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/Jobserver.h"
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/StringSaver.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 #include <map>
@@ -4335,6 +4337,21 @@ void Driver::BuildJobs(Compilation &C) const {
     for (auto &J : C.getJobs())
       J.InProcess = false;
 
+  // Run independent jobs in parallel if requested, or if a jobserver limits
+  // the number of jobs anyway.
+  if (const Arg *A = C.getArgs().getLastArg(options::OPT_fdriver_jobs_EQ)) {
+    unsigned NumJobs = 0;
+    if (StringRef(A->getValue()).getAsInteger(10, NumJobs))
+      Diag(diag::err_drv_invalid_int_value)
+          << A->getAsString(C.getArgs()) << A->getValue();
+    else
+      C.setMaxParallelJobs(
+          NumJobs == 0 ? llvm::hardware_concurrency().compute_thread_count()
+                       : NumJobs);
+  } else if (llvm::JobserverClient::getInstance()) {
+    C.setMaxParallelJobs(llvm::hardware_concurrency().compute_thread_count());
+  }
+
   if (CCPrintProcessStats) {
     C.setPostCallback([=](const Command &Cmd, int Res) {
       Optional<llvm::sys::ProcessStatistics> ProcStat =
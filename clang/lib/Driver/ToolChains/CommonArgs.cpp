@@ -286,13 +286,14 @@ void tools::addLinkerCompressDebugSectionsOption(
     const ToolChain &TC, const llvm::opt::ArgList &Args,
     llvm::opt::ArgStringList &CmdArgs) {
   // GNU ld supports --compress-debug-sections=none|zlib|zlib-gnu|zlib-gabi
-  // whereas zlib is an alias to zlib-gabi and zlib-gnu is obsoleted. Therefore
-  // -gz=none|zlib are translated to --compress-debug-sections=none|zlib. -gz
-  // is not translated since ld --compress-debug-sections option requires an
-  // argument.
+  // (and zstd since binutils 2.40) whereas zlib is an alias to zlib-gabi and
+  // zlib-gnu is obsoleted. ld.lld supports none|zlib|zstd. Therefore
+  // -gz=none|zlib|zstd are translated to
+  // --compress-debug-sections=none|zlib|zstd. -gz is not translated since ld
+  // --compress-debug-sections option requires an argument.
   if (const Arg *A = Args.getLastArg(options::OPT_gz_EQ)) {
     StringRef V = A->getValue();
-    if (V == "none" || V == "zlib")
+    if (V == "none" || V == "zlib" || V == "zstd")
       CmdArgs.push_back(Args.MakeArgString("--compress-debug-sections=" + V));
     else
       TC.getDriver().Diag(diag::err_drv_unsupported_option_argument)
@@ -3789,6 +3789,36 @@ bool CompilerInvocation::ParseLangArgs(LangOptions &Opts, ArgList &Args,
     Opts.floor_image_capabilities = (unsigned int)std::stoul(image_caps.str());
   }
 
+  // extract libfloor kernel work-group size variants ("<x>[x<y>[x<z>]]")
+  for (StringRef wg_size_str : Args.getAllArgValues(OPT_floor_work_group_size_variants)) {
+    SmallVector<StringRef, 3> dims;
+    wg_size_str.split(dims, 'x');
+    std::array<uint32_t, 3> wg_size {{ 1, 1, 1 }};
+    bool valid = (!dims.empty() && dims.size() <= 3);
+    for (size_t i = 0; valid && i < dims.size(); ++i) {
+      valid = (!dims[i].getAsInteger(10, wg_size[i]) && wg_size[i] > 0);
+    }
+    if (!valid) {
+      Diags.Report(diag::err_drv_invalid_value)
+        << "-floor-work-group-size-variants=" << wg_size_str;
+      continue;
+    }
+    Opts.floor_work_group_size_variants.emplace_back(wg_size);
+  }
+
+  // host-compute lang options
+  if (Args.hasArg(OPT_floor_host_compute_work_group_loops)) {
+    Opts.floor_host_compute_work_group_loops = true;
+  }
+
+  // metal/vulkan lang options
+  if (Args.hasArg(OPT_floor_relaxed_precision)) {
+    Opts.floor_relaxed_precision = true;
+  }
+  if (Args.hasArg(OPT_floor_relaxed_precision_fragment_outputs)) {
+    Opts.floor_relaxed_precision_fragment_outputs = true;
+  }
+
   // metal lang options
   if (Args.hasArg(OPT_metal_soft_printf)) {
     Opts.metal_soft_printf = true;
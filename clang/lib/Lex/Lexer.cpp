@@ -2621,6 +2621,8 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
 #elif __ALTIVEC__
 #include <altivec.h>
 #undef bool
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
 #endif
 
 /// We have just read from input the / and * characters that started a comment.
@@ -2794,6 +2796,188 @@ bool Lexer::SkipBlockComment(Token &Result, const char *CurPtr,
   return false;
 }
 
+/// Returns a pointer to the first character at or after \p CurPtr that is one
+/// of \p Chars. \p Chars must include '\0', so that the scan stops at the end
+/// of the buffer at the latest.
+template <char... Chars>
+static const char *findFirstCharOf(const char *CurPtr, const char *BufferEnd) {
+  const char CharList[] = {Chars...};
+#ifdef __SSE2__
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Data = _mm_loadu_si128((const __m128i *)CurPtr);
+    __m128i Matches = _mm_setzero_si128();
+    for (char Char : CharList)
+      Matches =
+          _mm_or_si128(Matches, _mm_cmpeq_epi8(Data, _mm_set1_epi8(Char)));
+    if (unsigned Mask = _mm_movemask_epi8(Matches))
+      return CurPtr + llvm::countTrailingZeros(Mask);
+    CurPtr += 16;
+  }
+#elif defined(__ARM_NEON)
+  while (CurPtr + 16 <= BufferEnd) {
+    uint8x16_t Data = vld1q_u8((const uint8_t *)CurPtr);
+    uint8x16_t Matches = vdupq_n_u8(0);
+    for (char Char : CharList)
+      Matches = vorrq_u8(Matches, vceqq_u8(Data, vdupq_n_u8(uint8_t(Char))));
+    // Narrow each 0x00/0xFF byte to 4 bits, there is no movemask in NEON.
+    uint64_t Mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Matches), 4)), 0);
+    if (Mask)
+      return CurPtr + llvm::countTrailingZeros(Mask) / 4;
+    CurPtr += 16;
+  }
+#endif
+  while (!llvm::is_contained(CharList, *CurPtr))
+    ++CurPtr;
+  return CurPtr;
+}
+
+void Lexer::skipExcludedConditionalLines() {
+  assert(LexingRawMode && "Skipping excluded lines outside of raw mode?");
+
+  // The code-completion point and empty lines must be found by real lexing.
+  if (PP && (PP->getCodeCompletionFileLoc() == FileLoc ||
+             PP->getEmptylineHandler()))
+    return;
+
+  // "//" is lexed as "/" in some corner cases without line comments.
+  const bool LineCommentIsComment =
+      LangOpts.LineComment && (LangOpts.CPlusPlus || !LangOpts.TraditionalCPP);
+
+  const char *CurPtr = BufferPtr;
+  bool AtStartOfLine = IsAtStartOfLine;
+  bool AtPhysicalStartOfLine = IsAtPhysicalStartOfLine;
+
+  // The last position at which lexing can safely continue, i.e. one that isn't
+  // inside of a comment.
+  const char *ResumePtr = CurPtr;
+  bool ResumeAtStartOfLine = AtStartOfLine;
+  bool ResumeAtPhysicalStartOfLine = AtPhysicalStartOfLine;
+
+  while (true) {
+    const char C = *CurPtr;
+    switch (C) {
+    case '\n':
+    case '\r':
+      ++CurPtr;
+      if (C == '\r' && *CurPtr == '\n')
+        ++CurPtr;
+      AtStartOfLine = AtPhysicalStartOfLine = true;
+      ResumePtr = CurPtr;
+      ResumeAtStartOfLine = ResumeAtPhysicalStartOfLine = true;
+      continue;
+
+    case ' ':
+    case '\t':
+    case '\f':
+    case '\v':
+      ++CurPtr;
+      continue;
+
+    case '#':
+      // Possible directive.
+      if (AtStartOfLine)
+        goto Done;
+      break;
+
+    case '%':
+      // Possible directive via the "%:" digraph.
+      if (AtStartOfLine && LangOpts.Digraphs && CurPtr[1] == ':')
+        goto Done;
+      break;
+
+    case '<':
+    case '>':
+    case '=':
+    case '|':
+      // Possible version control conflict marker, which the lexer handles as a
+      // whole.
+      if (CurPtr[1] == C &&
+          (CurPtr == BufferStart || isVerticalWhitespace(CurPtr[-1])))
+        goto Done;
+      break;
+
+    case '/':
+      if (CurPtr[1] == '/') {
+        if (!LineCommentIsComment)
+          goto Done;
+
+        // Line comment: only an escaped newline can continue it on the next
+        // line.
+        const char *CommentPtr = CurPtr + 2;
+        while (true) {
+          CommentPtr = findFirstCharOf<'\n', '\r', '\\', '?', '\0'>(CommentPtr,
+                                                                    BufferEnd);
+          if ((*CommentPtr == '\\' && isWhitespace(CommentPtr[1])) ||
+              (*CommentPtr == '?' && LangOpts.Trigraphs) || *CommentPtr == '\0')
+            goto Done;
+          if (isVerticalWhitespace(*CommentPtr))
+            break;
+          ++CommentPtr;
+        }
+        CurPtr = CommentPtr;
+        continue;
+      }
+
+      if (CurPtr[1] == '*') {
+        // Block comment: scan for the terminating "*/", the first '/' after
+        // "/*" doesn't end it.
+        const char *CommentPtr = CurPtr + 2;
+        if (*CommentPtr == '/')
+          ++CommentPtr;
+        while (true) {
+          CommentPtr =
+              findFirstCharOf<'/', '\\', '?', '\0'>(CommentPtr, BufferEnd);
+          if (*CommentPtr == '/' && CommentPtr[-1] == '*')
+            break;
+          // An escaped newline could be between the terminating '*' and '/'.
+          if ((*CommentPtr == '\\' && CommentPtr[-1] == '*') ||
+              (*CommentPtr == '?' && LangOpts.Trigraphs) || *CommentPtr == '\0')
+            goto Done;
+          ++CommentPtr;
+        }
+        // Comments don't change whether the next token is at the start of a
+        // line.
+        CurPtr = CommentPtr + 1;
+        ResumePtr = CurPtr;
+        ResumeAtStartOfLine = AtStartOfLine;
+        ResumeAtPhysicalStartOfLine = AtPhysicalStartOfLine;
+        continue;
+      }
+      break;
+
+    case '?':
+      if (LangOpts.Trigraphs)
+        goto Done;
+      break;
+
+    case '"':
+    case '\'':
+    case '\\':
+    case '\0':
+      // Literals, escaped newlines, UCNs and the end of the buffer.
+      goto Done;
+
+    default:
+      break;
+    }
+
+    // This starts a token that can't be a directive, so nothing but newlines,
+    // comments and the characters above are interesting until the next line.
+    AtStartOfLine = AtPhysicalStartOfLine = false;
+    CurPtr = findFirstCharOf<'\n', '\r', '/', '"', '\'', '\\', '?', '\0'>(
+        CurPtr + 1, BufferEnd);
+  }
+
+Done:
+  if (ResumePtr == BufferPtr)
+    return;
+  BufferPtr = ResumePtr;
+  IsAtStartOfLine = ResumeAtStartOfLine;
+  IsAtPhysicalStartOfLine = ResumeAtPhysicalStartOfLine;
+  NewLinePtr = nullptr;
+}
+
 //===----------------------------------------------------------------------===//
 // Primary Lexing Entry Points
 //===----------------------------------------------------------------------===//
@@ -466,6 +466,8 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation HashTokenLoc,
   }
   SourceLocation endLoc;
   while (true) {
+    // Skip over all lines that can't contain a directive without lexing them.
+    CurLexer->skipExcludedConditionalLines();
     CurLexer->Lex(Tok);
 
     if (Tok.is(tok::code_completion)) {
@@ -0,0 +1 @@
+int header_function(void) {}
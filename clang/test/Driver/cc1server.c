@@ -0,0 +1,27 @@
+// Compile the same file twice through the compile server: the second
+// compilation reuses the preamble and must still report its diagnostics. The
+// socket must only be accessible by the current user.
+// REQUIRES: shell
+// UNSUPPORTED: system-windows
+
+// RUN: rm -rf %t && mkdir %t
+// RUN: cd %t && sh -c '%clang -cc1server s.sock -idle-timeout=60 -v < /dev/null > server.log 2>&1 & echo $! > server.pid'
+// RUN: cd %t && for i in $(seq 100); do test -S s.sock && break; sleep 0.1; done
+// RUN: cd %t && ls -l s.sock | FileCheck --check-prefix=MODE %s
+// RUN: cd %t && env CLANG_CC1_SERVER=s.sock %clang -fsyntax-only -I %S/Inputs %s 2>&1 | FileCheck %s
+// RUN: cd %t && env CLANG_CC1_SERVER=s.sock %clang -fsyntax-only -I %S/Inputs %s 2>&1 | FileCheck %s
+// RUN: cd %t && kill $(cat server.pid)
+// RUN: FileCheck --check-prefix=SERVER %s < %t/server.log
+
+// CHECK: cc1server-header.h:1:{{[0-9]+}}: warning: non-void function does not return a value
+// CHECK-NEXT: int header_function(void) {}
+// CHECK: cc1server.c:[[@LINE+4]]:{{[0-9]+}}: warning: non-void function does not return a value
+// CHECK: 2 warnings generated.
+
+#include "cc1server-header.h"
+int main_function(void) {}
+
+// SERVER: cc1server: built preamble for '{{.*}}cc1server.c'
+// SERVER-NEXT: cc1server: reused preamble for '{{.*}}cc1server.c'
+
+// MODE: srw-------
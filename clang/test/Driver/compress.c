@@ -29,6 +29,11 @@
 // CHECK-OPT_GZ_EQ_ZLIB: {{.* "-cc1(as)?".* "--compress-debug-sections=zlib"}}
 // CHECK-OPT_GZ_EQ_ZLIB: "--compress-debug-sections=zlib"
 
+// The linker is asked to compress its output with zstd as well.
+// RUN: %clang -### -target x86_64-unknown-linux-gnu -gz=zstd %s 2>&1 | FileCheck -check-prefix CHECK-OPT_GZ_EQ_ZSTD %s
+// CHECK-OPT_GZ_EQ_ZSTD: "-cc1"
+// CHECK-OPT_GZ_EQ_ZSTD-NEXT: "--compress-debug-sections=zstd"
+
 // RUN: %clang -### -fintegrated-as -gz=invalid -x assembler -c %s 2>&1 | FileCheck -check-prefix CHECK-OPT_GZ_EQ_INVALID %s
 // RUN: %clang -### -fintegrated-as -gz=invalid -c %s 2>&1 | FileCheck -check-prefix CHECK-OPT_GZ_EQ_INVALID %s
 // CHECK-OPT_GZ_EQ_INVALID: error: unsupported argument 'invalid' to option 'gz='
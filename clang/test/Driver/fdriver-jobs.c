@@ -0,0 +1,27 @@
+// RUN: %clang -fdriver-jobs=4 -fsyntax-only -### %s 2>&1 \
+// RUN:     | FileCheck %s --check-prefix=VALID
+// VALID-NOT: argument unused during compilation
+
+// RUN: not %clang -fdriver-jobs=four -fsyntax-only -### %s 2>&1 \
+// RUN:     | FileCheck %s --check-prefix=INVALID
+// INVALID: error: invalid integral value 'four' in '-fdriver-jobs=four'
+
+// The output of each job is forwarded as a whole, in the order of the inputs.
+// RUN: %clang -fno-integrated-cc1 -fdriver-jobs=2 -fsyntax-only \
+// RUN:     %S/Inputs/fdriver-jobs-first.c %S/Inputs/fdriver-jobs-second.c 2>&1 \
+// RUN:     | FileCheck %s --check-prefix=FIRST-SECOND
+// RUN: %clang -fno-integrated-cc1 -fdriver-jobs=0 -fsyntax-only \
+// RUN:     %S/Inputs/fdriver-jobs-first.c %S/Inputs/fdriver-jobs-second.c 2>&1 \
+// RUN:     | FileCheck %s --check-prefix=FIRST-SECOND
+// FIRST-SECOND: fdriver-jobs-first.c:1:2: warning: first
+// FIRST-SECOND-NEXT: {{^}}#warning first
+// FIRST-SECOND: fdriver-jobs-second.c:1:2: warning: second
+// FIRST-SECOND-NEXT: {{^}}#warning second
+
+// RUN: %clang -fno-integrated-cc1 -fdriver-jobs=2 -fsyntax-only \
+// RUN:     %S/Inputs/fdriver-jobs-second.c %S/Inputs/fdriver-jobs-first.c 2>&1 \
+// RUN:     | FileCheck %s --check-prefix=SECOND-FIRST
+// SECOND-FIRST: fdriver-jobs-second.c:1:2: warning: second
+// SECOND-FIRST-NEXT: {{^}}#warning second
+// SECOND-FIRST: fdriver-jobs-first.c:1:2: warning: first
+// SECOND-FIRST-NEXT: {{^}}#warning first
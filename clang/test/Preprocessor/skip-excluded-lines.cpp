@@ -0,0 +1,56 @@
+// RUN: %clang_cc1 -E -std=c++11 %s | FileCheck --strict-whitespace %s
+// RUN: %clang_cc1 -E -std=c++11 -trigraphs %s | FileCheck --strict-whitespace %s
+// Lines in excluded conditional blocks are skipped without lexing them where
+// possible, make sure all constructs that hide or form directives still work.
+
+#if 0
+plain line with / division and ? question marks
+// line comment
+#else
+// CHECK: {{^}}plain_else{{$}}
+plain_else
+#endif
+
+#if 0
+/* block comment
+#else
+*/ /* another one */ #else
+// CHECK: {{^}}else_after_comment{{$}}
+else_after_comment
+#endif
+
+#if 0
+// line comment with an escaped newline \
+#else
+x = "string # with a hash" 'c';
+#else
+// CHECK: {{^}}else_after_literals{{$}}
+else_after_literals
+#endif
+
+#if 0
+const char *s = R"raw(
+#else
+)raw";
+#else
+// CHECK: {{^}}else_after_raw_string{{$}}
+else_after_raw_string
+#endif
+
+#if 0
+int a = 1 \
+#else
+  ;
+  %:else
+// CHECK: {{^}}else_digraph{{$}}
+else_digraph
+#endif
+
+#if 0
+  #if 1
+  #else
+  #endif
+/**/ # /* comment */ else
+// CHECK: {{^}}nested_else{{$}}
+nested_else
+#endif
@@ -0,0 +1,61 @@
+// RUN: %clang_cc1 -std=c++20 -fsyntax-only -verify -fconstexpr-call-cache -fconstexpr-steps=1000 %s
+// RUN: %clang_cc1 -std=c++20 -fsyntax-only -verify=expected,nocache -fconstexpr-steps=1000 %s
+// RUN: %clang_cc1 -std=c++20 -fsyntax-only -fconstexpr-call-cache -fconstexpr-steps=1000 -DSTATS -print-stats %s 2>&1 | FileCheck %s
+
+// CHECK: *** Constexpr Call Cache Stats:
+// CHECK: calls cached.
+// CHECK: cache hits.
+
+// Without the cache, this takes exponentially many steps.
+constexpr unsigned long long fib(unsigned n) {
+  if (n < 2)
+    return n;
+  return fib(n - 1) + fib(n - 2); // nocache-note@* {{step limit}} nocache-note@* 0+ {{call}}
+}
+#ifndef STATS
+static_assert(fib(60) == 1548008755920); // nocache-error {{constant expression}}
+#endif
+
+struct Pair {
+  int First;
+  int Second[2];
+};
+constexpr Pair makePair(int N) { return {N, {N + 1, N + 2}}; }
+static_assert(makePair(1).Second[1] == 3);
+static_assert(makePair(1).First == 1);
+static_assert(makePair(2).Second[0] == 3);
+
+constexpr int evaluated(int N) {
+  return __builtin_is_constant_evaluated() ? N : -N;
+}
+static_assert(evaluated(1) == 1);
+static_assert(evaluated(1) == 1);
+
+// Calls that allocate or refer to objects are not cached.
+constexpr int allocate(int N) {
+  int *P = new int(N);
+  int Result = *P;
+  delete P;
+  return Result;
+}
+static_assert(allocate(3) == 3);
+static_assert(allocate(3) == 3);
+
+constexpr int increment(int &N) { return ++N; }
+constexpr int incrementTwice() {
+  int N = 0;
+  increment(N);
+  return increment(N);
+}
+static_assert(incrementTwice() == 2);
+
+#ifndef STATS
+// Failing calls are not cached, and are diagnosed every time.
+constexpr int mustBeZero(int N) {
+  return N ? throw 0 : 0; // expected-note 2{{subexpression not valid}}
+}
+static_assert(mustBeZero(1) == 0); // expected-error {{constant expression}} \
+                                   // expected-note {{in call to}}
+static_assert(mustBeZero(1) == 0); // expected-error {{constant expression}} \
+                                   // expected-note {{in call to}}
+#endif
@@ -0,0 +1,609 @@
+//===-- cc1server_main.cpp - Clang CC1 Compile Server ---------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This is the entry point to the clang -cc1server functionality: a long-lived
+// process that executes -cc1 invocations received over a local socket and
+// keeps the precompiled preambles (the leading #include block of the main file
+// and all -include files) of previous compilations in memory. Compilations
+// with the same target, language and preprocessor options and the same
+// preamble only parse the remainder of the main file.
+//
+// If the CLANG_CC1_SERVER environment variable is set to the socket path of a
+// running server, in-process -cc1 invocations of the driver are forwarded to
+// it. If the server is not reachable, the invocation is executed locally.
+//
+// With -idle-timeout=<seconds>, the server exits once it hasn't received an
+// invocation for that long.
+//
+// The socket is only accessible by the user that started the server, and
+// connections from other users are rejected. Invocations from a driver of a
+// different clang version are declined, so the driver executes them locally.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/Version.h"
+#include "clang/CodeGen/ObjectFilePCHContainerOperations.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/PrecompiledPreamble.h"
+#include "clang/Frontend/TextDiagnosticBuffer.h"
+#include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "clang/FrontendTool/Utils.h"
+#include "clang/Lex/PreprocessorOptions.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Errno.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cerrno>
+#include <climits>
+#include <list>
+#include <memory>
+#include <string>
+
+#if LLVM_ON_UNIX
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace clang;
+
+namespace {
+
+/// Returned by the server if it won't execute an invocation (e.g. because it
+/// reads from stdin or writes to stdout, or because the client is a different
+/// clang version), in which case the client executes it locally.
+constexpr int32_t DeclinedResult = -1;
+
+/// Default maximum number of preambles kept in memory.
+constexpr unsigned DefaultMaxPreambles = 8;
+
+//===----------------------------------------------------------------------===//
+// Wire protocol
+//
+// Request:  the clang version of the client as a string, u32 argument count,
+//           then each argument as a string, then the working directory as a
+//           string.
+// Response: i32 result (exit code or DeclinedResult), then all diagnostics
+//           output as a string.
+// Strings are sent as a u32 size followed by the string data. All integers
+// are little-endian.
+//===----------------------------------------------------------------------===//
+
+#if LLVM_ON_UNIX
+bool writeAll(int FD, const void *Data, size_t Size) {
+  const char *Ptr = static_cast<const char *>(Data);
+  while (Size > 0) {
+    ssize_t Written = ::write(FD, Ptr, Size);
+    if (Written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    Ptr += Written;
+    Size -= size_t(Written);
+  }
+  return true;
+}
+
+bool readAll(int FD, void *Data, size_t Size) {
+  char *Ptr = static_cast<char *>(Data);
+  while (Size > 0) {
+    ssize_t Read = ::read(FD, Ptr, Size);
+    if (Read < 0 && errno == EINTR)
+      continue;
+    if (Read <= 0)
+      return false;
+    Ptr += Read;
+    Size -= size_t(Read);
+  }
+  return true;
+}
+
+bool writeU32(int FD, uint32_t Value) {
+  char Buffer[4];
+  llvm::support::endian::write32le(Buffer, Value);
+  return writeAll(FD, Buffer, sizeof(Buffer));
+}
+
+bool readU32(int FD, uint32_t &Value) {
+  char Buffer[4];
+  if (!readAll(FD, Buffer, sizeof(Buffer)))
+    return false;
+  Value = llvm::support::endian::read32le(Buffer);
+  return true;
+}
+
+bool writeString(int FD, StringRef Str) {
+  return writeU32(FD, uint32_t(Str.size())) &&
+         writeAll(FD, Str.data(), Str.size());
+}
+
+bool readString(int FD, std::string &Str) {
+  uint32_t Size;
+  if (!readU32(FD, Size))
+    return false;
+  Str.resize(Size);
+  return readAll(FD, &Str[0], Size);
+}
+
+/// Returns true if the process at the other end of the connected socket \p FD
+/// runs as the same user as this process.
+bool isPeerSameUser(int FD) {
+#if defined(__linux__)
+  ucred Cred;
+  socklen_t Size = sizeof(Cred);
+  if (::getsockopt(FD, SOL_SOCKET, SO_PEERCRED, &Cred, &Size) ||
+      Size != sizeof(Cred))
+    return false;
+  return Cred.uid == ::geteuid();
+#else
+  uid_t UID;
+  gid_t GID;
+  if (::getpeereid(FD, &UID, &GID))
+    return false;
+  return UID == ::geteuid();
+#endif
+}
+
+/// Fills in the socket address for \p Path, returns false if the path is too
+/// long for a unix domain socket.
+bool getSocketAddress(StringRef Path, sockaddr_un &Addr) {
+  memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  if (Path.size() >= sizeof(Addr.sun_path))
+    return false;
+  memcpy(Addr.sun_path, Path.data(), Path.size());
+  return true;
+}
+#endif
+
+//===----------------------------------------------------------------------===//
+// Preamble cache
+//===----------------------------------------------------------------------===//
+
+/// The preamble must be usable for code generation, so function bodies in
+/// headers must not be skipped.
+class CodeGenPreambleCallbacks : public PreambleCallbacks {
+public:
+  bool shouldSkipFunctionBody(Decl *) override { return false; }
+};
+
+/// A TextDiagnosticPrinter that also counts the diagnostics of a cached
+/// preamble, which are replayed as text instead of being emitted again.
+class ServerDiagnosticPrinter : public TextDiagnosticPrinter {
+public:
+  using TextDiagnosticPrinter::TextDiagnosticPrinter;
+
+  void addReplayedWarnings(unsigned Count) { NumWarnings += Count; }
+};
+
+/// A precompiled preamble and the diagnostics that were emitted while building
+/// it. Parsing the main file with the preamble doesn't emit them again, so they
+/// are replayed for each compilation that uses the preamble.
+struct CachedPreamble {
+  std::shared_ptr<PrecompiledPreamble> Preamble;
+  std::string Diagnostics;
+  unsigned NumWarnings = 0;
+};
+
+/// Keeps the most recently used in-memory preambles.
+class PreambleCache {
+public:
+  explicit PreambleCache(unsigned MaxEntries) : MaxEntries(MaxEntries) {}
+
+  /// Returns a preamble for \p Invocation and \p MainFile, either a cached one
+  /// or a newly built one. Returns nullptr if no preamble can be used, e.g.
+  /// because the preamble has errors. \p Reused is set if the preamble was
+  /// taken from the cache.
+  const CachedPreamble *
+  get(const CompilerInvocation &Invocation, const llvm::MemoryBuffer &MainFile,
+      PreambleBounds Bounds, IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS,
+      std::shared_ptr<PCHContainerOperations> PCHOps, bool &Reused) {
+    Reused = false;
+    std::string Key = getKey(Invocation, MainFile, Bounds);
+    auto It = llvm::find_if(Entries, [&Key](const Entry &E) {
+      return E.Key == Key;
+    });
+    if (It != Entries.end()) {
+      if (It->Cached.Preamble->CanReuse(
+              Invocation, MainFile.getMemBufferRef(), Bounds, *VFS)) {
+        Entries.splice(Entries.begin(), Entries, It);
+        Reused = true;
+        return &It->Cached;
+      }
+      // One of the files in the preamble changed.
+      Entries.erase(It);
+    }
+
+    // The preamble gets its own diagnostics engine, so that its diagnostics
+    // can be stored with it. It uses the diagnostic options of the
+    // invocation, so warning flags and -Werror apply as usual.
+    CachedPreamble Cached;
+    llvm::raw_string_ostream DiagOS(Cached.Diagnostics);
+    DiagnosticOptions &DiagOpts = Invocation.getDiagnosticOpts();
+    IntrusiveRefCntPtr<DiagnosticsEngine> Diags =
+        CompilerInstance::createDiagnostics(
+            &DiagOpts, new TextDiagnosticPrinter(DiagOS, &DiagOpts));
+    CodeGenPreambleCallbacks Callbacks;
+    auto Preamble = PrecompiledPreamble::Build(
+        Invocation, &MainFile, Bounds, *Diags, VFS, std::move(PCHOps),
+        /*StoreInMemory=*/true, Callbacks);
+    // If the preamble has errors, the compilation runs without a preamble and
+    // reports them itself.
+    if (!Preamble || Diags->hasErrorOccurred())
+      return nullptr;
+    DiagOS.flush();
+    Cached.NumWarnings = Diags->getClient()->getNumWarnings();
+    Cached.Preamble =
+        std::make_shared<PrecompiledPreamble>(std::move(*Preamble));
+
+    Entries.push_front({std::move(Key), std::move(Cached)});
+    if (Entries.size() > MaxEntries)
+      Entries.pop_back();
+    return &Entries.front().Cached;
+  }
+
+private:
+  /// The key covers everything that affects how the preamble is parsed and
+  /// that PrecompiledPreamble::CanReuse doesn't check itself.
+  static std::string getKey(const CompilerInvocation &Invocation,
+                            const llvm::MemoryBuffer &MainFile,
+                            PreambleBounds Bounds) {
+    llvm::SHA1 Hasher;
+    // Target, language options, macros and system header configuration.
+    Hasher.update(Invocation.getModuleHash());
+    const HeaderSearchOptions &HSOpts = Invocation.getHeaderSearchOpts();
+    for (const auto &Entry : HSOpts.UserEntries) {
+      Hasher.update(Entry.Path);
+      Hasher.update(ArrayRef<uint8_t>(
+          {uint8_t(Entry.Group), uint8_t(Entry.IsFramework),
+           uint8_t(Entry.IgnoreSysRoot)}));
+    }
+    for (const auto &Include : Invocation.getPreprocessorOpts().Includes)
+      Hasher.update(Include);
+    Hasher.update(MainFile.getBuffer().take_front(Bounds.Size));
+    return Hasher.final().str();
+  }
+
+  struct Entry {
+    std::string Key;
+    CachedPreamble Cached;
+  };
+
+  unsigned MaxEntries;
+  std::list<Entry> Entries;
+};
+
+//===----------------------------------------------------------------------===//
+// Server
+//===----------------------------------------------------------------------===//
+
+/// Returns true if the invocation can be executed by the server.
+bool isServerInvocation(const CompilerInvocation &Invocation) {
+  const FrontendOptions &FEOpts = Invocation.getFrontendOpts();
+  if (FEOpts.Inputs.size() != 1 || !FEOpts.Inputs[0].isFile() ||
+      FEOpts.Inputs[0].getFile() == "-" || FEOpts.OutputFile == "-")
+    return false;
+  switch (FEOpts.ProgramAction) {
+  case frontend::EmitAssembly:
+  case frontend::EmitBC:
+  case frontend::EmitLLVM:
+  case frontend::EmitLLVMOnly:
+  case frontend::EmitCodeGenOnly:
+  case frontend::EmitObj:
+  case frontend::ParseSyntaxOnly:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Executes a single -cc1 invocation. Diagnostics are written to \p DiagOS.
+int executeInvocation(ArrayRef<const char *> Argv, const char *Argv0,
+                      void *MainAddr, PreambleCache &Preambles,
+                      bool Verbose, raw_ostream &DiagOS) {
+  // Options that are specified via -mllvm are parsed again for each
+  // invocation.
+  llvm::cl::ResetAllOptionOccurrences();
+
+  auto Clang = std::make_unique<CompilerInstance>();
+  auto PCHOps = Clang->getPCHContainerOperations();
+  PCHOps->registerWriter(std::make_unique<ObjectFilePCHContainerWriter>());
+  PCHOps->registerReader(std::make_unique<ObjectFilePCHContainerReader>());
+
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
+  IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
+  TextDiagnosticBuffer *DiagsBuffer = new TextDiagnosticBuffer;
+  DiagnosticsEngine Diags(DiagID, &*DiagOpts, DiagsBuffer);
+  bool Success = CompilerInvocation::CreateFromArgs(Clang->getInvocation(),
+                                                    Argv, Diags, Argv0);
+  if (Success && !isServerInvocation(Clang->getInvocation()))
+    return DeclinedResult;
+
+  // The server outlives the compilation, so everything must be freed.
+  Clang->getFrontendOpts().DisableFree = false;
+  Clang->getCodeGenOpts().DisableFree = false;
+
+  if (Clang->getHeaderSearchOpts().UseBuiltinIncludes &&
+      Clang->getHeaderSearchOpts().ResourceDir.empty())
+    Clang->getHeaderSearchOpts().ResourceDir =
+        CompilerInvocation::GetResourcesPath(Argv0, MainAddr);
+
+  auto *DiagPrinter =
+      new ServerDiagnosticPrinter(DiagOS, &Clang->getDiagnosticOpts());
+  Clang->createDiagnostics(DiagPrinter);
+  if (!Clang->hasDiagnostics())
+    return 1;
+  DiagsBuffer->FlushDiagnostics(Clang->getDiagnostics());
+  if (!Success) {
+    Clang->getDiagnosticClient().finish();
+    return 1;
+  }
+
+  CompilerInvocation &Invocation = Clang->getInvocation();
+  StringRef MainFilePath = Invocation.getFrontendOpts().Inputs[0].getFile();
+  IntrusiveRefCntPtr<llvm::vfs::FileSystem> VFS =
+      llvm::vfs::getRealFileSystem();
+  std::unique_ptr<llvm::MemoryBuffer> MainFile;
+  if (auto Buffer = VFS->getBufferForFile(MainFilePath))
+    MainFile = std::move(*Buffer);
+
+  // The preamble must stay alive until the compilation has finished.
+  std::shared_ptr<PrecompiledPreamble> Preamble;
+  if (MainFile) {
+    PreambleBounds Bounds = ComputePreambleBounds(
+        *Invocation.getLangOpts(), MainFile->getMemBufferRef(), 0);
+    bool Reused;
+    if (const CachedPreamble *Cached = Preambles.get(
+            Invocation, *MainFile, Bounds, VFS, PCHOps, Reused)) {
+      Preamble = Cached->Preamble;
+      DiagOS << Cached->Diagnostics;
+      DiagPrinter->addReplayedWarnings(Cached->NumWarnings);
+      if (Verbose)
+        llvm::errs() << "cc1server: " << (Reused ? "reused" : "built")
+                     << " preamble for '" << MainFilePath << "'\n";
+    }
+    if (Preamble) {
+      Invocation.getPreprocessorOpts().RetainRemappedFileBuffers = true;
+      Preamble->AddImplicitPreamble(Invocation, VFS, MainFile.get());
+      Clang->createFileManager(VFS);
+    }
+  }
+
+  Success = ExecuteCompilerInvocation(Clang.get());
+
+  llvm::TimerGroup::printAll(DiagOS);
+  llvm::TimerGroup::clearAll();
+  return !Success;
+}
+
+} // namespace
+
+int cc1server_main(ArrayRef<const char *> Argv, const char *Argv0,
+                   void *MainAddr) {
+#if LLVM_ON_UNIX
+  StringRef SocketPath;
+  unsigned MaxPreambles = DefaultMaxPreambles;
+  unsigned IdleTimeout = 0;
+  bool Verbose = false;
+  for (StringRef Arg : Argv) {
+    if (Arg.consume_front("-max-preambles=")) {
+      if (Arg.getAsInteger(10, MaxPreambles) || MaxPreambles == 0) {
+        llvm::errs() << "error: invalid -max-preambles value '" << Arg
+                     << "'\n";
+        return 1;
+      }
+    } else if (Arg.consume_front("-idle-timeout=")) {
+      if (Arg.getAsInteger(10, IdleTimeout) || IdleTimeout > INT_MAX / 1000) {
+        llvm::errs() << "error: invalid -idle-timeout value '" << Arg
+                     << "'\n";
+        return 1;
+      }
+    } else if (Arg == "-v") {
+      Verbose = true;
+    } else if (SocketPath.empty() && !Arg.startswith("-")) {
+      SocketPath = Arg;
+    } else {
+      llvm::errs() << "error: unknown argument '" << Arg << "'\n";
+      return 1;
+    }
+  }
+  if (SocketPath.empty()) {
+    llvm::errs() << "usage: clang -cc1server <socket path> "
+                    "[-max-preambles=<n>] [-idle-timeout=<seconds>] [-v]\n";
+    return 1;
+  }
+
+  sockaddr_un Addr;
+  if (!getSocketAddress(SocketPath, Addr)) {
+    llvm::errs() << "error: socket path '" << SocketPath << "' is too long\n";
+    return 1;
+  }
+  int ServerFD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (ServerFD < 0) {
+    llvm::errs() << "error: failed to create socket: "
+                 << llvm::sys::StrError() << "\n";
+    return 1;
+  }
+  // Remove the socket of a previous server that is no longer running, but
+  // never remove anything that isn't a socket.
+  llvm::sys::fs::file_status Status;
+  if (!llvm::sys::fs::status(SocketPath, Status, /*Follow=*/false)) {
+    if (Status.type() != llvm::sys::fs::file_type::socket_file) {
+      llvm::errs() << "error: '" << SocketPath
+                   << "' exists and is not a socket\n";
+      ::close(ServerFD);
+      return 1;
+    }
+    int ProbeFD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    bool InUse = ProbeFD >= 0 &&
+                 !::connect(ProbeFD, reinterpret_cast<sockaddr *>(&Addr),
+                            sizeof(Addr));
+    if (ProbeFD >= 0)
+      ::close(ProbeFD);
+    if (InUse) {
+      llvm::errs() << "error: a server is already listening on '"
+                   << SocketPath << "'\n";
+      ::close(ServerFD);
+      return 1;
+    }
+    llvm::sys::fs::remove(SocketPath);
+  }
+  // Only the current user may connect: create the socket with mode 0600.
+  mode_t OldUmask = ::umask(S_IRWXG | S_IRWXO);
+  bool BindFailed =
+      ::bind(ServerFD, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr));
+  ::umask(OldUmask);
+  if (BindFailed || ::listen(ServerFD, SOMAXCONN)) {
+    llvm::errs() << "error: failed to listen on '" << SocketPath
+                 << "': " << llvm::sys::StrError() << "\n";
+    ::close(ServerFD);
+    return 1;
+  }
+
+  // Invocations change the working directory.
+  SmallString<256> AbsoluteSocketPath(SocketPath);
+  llvm::sys::fs::make_absolute(AbsoluteSocketPath);
+
+  llvm::InitializeAllTargets();
+  llvm::InitializeAllTargetMCs();
+  llvm::InitializeAllAsmPrinters();
+  llvm::InitializeAllAsmParsers();
+
+  // Invocations are executed one at a time: -cc1 relies on process-wide state
+  // (working directory, LLVM command line options).
+  PreambleCache Preambles(MaxPreambles);
+  int ExitCode = 1;
+  for (;;) {
+    if (IdleTimeout) {
+      pollfd PollFD = {ServerFD, POLLIN, 0};
+      int Ready = ::poll(&PollFD, 1, int(IdleTimeout * 1000));
+      if (Ready < 0 && errno == EINTR)
+        continue;
+      if (Ready == 0) {
+        ExitCode = 0;
+        break;
+      }
+    }
+    int FD = ::accept(ServerFD, nullptr, nullptr);
+    if (FD < 0) {
+      if (errno == EINTR)
+        continue;
+      llvm::errs() << "error: failed to accept connection: "
+                   << llvm::sys::StrError() << "\n";
+      break;
+    }
+    if (!isPeerSameUser(FD)) {
+      ::close(FD);
+      continue;
+    }
+
+    std::string ClientVersion;
+    uint32_t NumArgs;
+    std::vector<std::string> Args;
+    std::string WorkingDir;
+    bool Valid = readString(FD, ClientVersion) && readU32(FD, NumArgs);
+    for (uint32_t I = 0; Valid && I < NumArgs; ++I) {
+      Args.emplace_back();
+      Valid = readString(FD, Args.back());
+    }
+    Valid = Valid && readString(FD, WorkingDir);
+    if (!Valid) {
+      ::close(FD);
+      continue;
+    }
+
+    // The invocation was created by the driver of the client, which must
+    // match the frontend of the server.
+    int32_t Result = DeclinedResult;
+    std::string Diagnostics;
+    if (ClientVersion == getClangFullVersion() &&
+        !llvm::sys::fs::set_current_path(WorkingDir)) {
+      SmallVector<const char *, 64> ArgV;
+      for (const auto &Arg : Args)
+        ArgV.push_back(Arg.c_str());
+      llvm::raw_string_ostream DiagOS(Diagnostics);
+      Result = executeInvocation(ArgV, Argv0, MainAddr, Preambles, Verbose,
+                                 DiagOS);
+      DiagOS.flush();
+    }
+
+    char ResultBuffer[4];
+    llvm::support::endian::write32le(ResultBuffer, uint32_t(Result));
+    if (writeAll(FD, ResultBuffer, sizeof(ResultBuffer)))
+      writeString(FD, Diagnostics);
+    ::close(FD);
+  }
+
+  ::close(ServerFD);
+  llvm::sys::fs::remove(AbsoluteSocketPath);
+  return ExitCode;
+#else
+  llvm::errs() << "error: -cc1server is not supported on this platform\n";
+  return 1;
+#endif
+}
+
+/// Forwards a -cc1 invocation to the compile server listening on the socket
+/// specified by CLANG_CC1_SERVER. Returns None if there is no server or if it
+/// declined the invocation.
+llvm::Optional<int> cc1server_forward(ArrayRef<const char *> Argv) {
+#if LLVM_ON_UNIX
+  llvm::Optional<std::string> SocketPath =
+      llvm::sys::Process::GetEnv("CLANG_CC1_SERVER");
+  if (!SocketPath || SocketPath->empty())
+    return llvm::None;
+
+  SmallString<256> WorkingDir;
+  sockaddr_un Addr;
+  if (llvm::sys::fs::current_path(WorkingDir) ||
+      !getSocketAddress(*SocketPath, Addr))
+    return llvm::None;
+
+  int FD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (FD < 0)
+    return llvm::None;
+  if (::connect(FD, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr)) ||
+      !isPeerSameUser(FD)) {
+    ::close(FD);
+    return llvm::None;
+  }
+
+  bool Valid = writeString(FD, getClangFullVersion()) &&
+               writeU32(FD, uint32_t(Argv.size()));
+  for (const char *Arg : Argv)
+    Valid = Valid && writeString(FD, Arg);
+  Valid = Valid && writeString(FD, WorkingDir);
+
+  uint32_t Result;
+  std::string Diagnostics;
+  Valid = Valid && readU32(FD, Result) && readString(FD, Diagnostics);
+  ::close(FD);
+  if (!Valid || int32_t(Result) == DeclinedResult)
+    return llvm::None;
+
+  llvm::errs() << Diagnostics;
+  return int(int32_t(Result));
+#else
+  return llvm::None;
+#endif
+}
@@ -0,0 +1,164 @@
+//===-- Benchmark string scanning primitives ------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Compares the byte-at-a-time, word-at-a-time (SWAR) and SIMD implementations
+// of the string scanning primitives in src/string/string_utils.h.
+//
+//===----------------------------------------------------------------------===//
+
+#include "src/string/string_utils.h"
+#include "benchmark/benchmark.h"
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+using namespace __llvm_libc;
+
+// Alignment of the buffers, strings start at an offset of 1 so that the
+// unaligned head of the wide implementations is measured as well.
+constexpr size_t kBufferAlignment = 64;
+constexpr size_t kStringOffset = 1;
+
+struct StringBuffer {
+  explicit StringBuffer(size_t Length)
+      : Storage(Length + kStringOffset + 2 * kBufferAlignment, 'x') {
+    char *Aligned = reinterpret_cast<char *>(
+        (reinterpret_cast<uintptr_t>(Storage.data()) + kBufferAlignment - 1) &
+        ~uintptr_t(kBufferAlignment - 1));
+    Str = Aligned + kStringOffset;
+    Str[Length] = '\0';
+  }
+
+  std::vector<char> Storage;
+  char *Str;
+};
+
+void setCounters(benchmark::State &State) {
+  State.SetBytesProcessed(State.iterations() * State.range(0));
+}
+
+template <size_t (*Function)(const char *)>
+void BM_StringLength(benchmark::State &State) {
+  StringBuffer Buffer(State.range(0));
+  for (auto _ : State) {
+    benchmark::DoNotOptimize(Buffer.Str);
+    benchmark::DoNotOptimize(Function(Buffer.Str));
+  }
+  setCounters(State);
+}
+
+template <void *(*Function)(const unsigned char *, unsigned char, size_t)>
+void BM_FindFirstCharacter(benchmark::State &State) {
+  StringBuffer Buffer(State.range(0));
+  // Search for a character that is only found at the very end.
+  const size_t Size = State.range(0) + 1;
+  const auto *Src = reinterpret_cast<const unsigned char *>(Buffer.Str);
+  for (auto _ : State) {
+    benchmark::DoNotOptimize(Src);
+    benchmark::DoNotOptimize(Function(Src, '\0', Size));
+  }
+  setCounters(State);
+}
+
+template <char *(*Function)(const char *, char)>
+void BM_FindCharacter(benchmark::State &State) {
+  StringBuffer Buffer(State.range(0));
+  for (auto _ : State) {
+    benchmark::DoNotOptimize(Buffer.Str);
+    benchmark::DoNotOptimize(Function(Buffer.Str, '#'));
+  }
+  setCounters(State);
+}
+
+// The implementation of internal::complementary_span before the wide scans
+// were added.
+size_t complementarySpanBytewise(const char *Src, const char *Segment) {
+  const char *Initial = Src;
+  cpp::Bitset<256> Bitset;
+  for (; *Segment; ++Segment)
+    Bitset.set(static_cast<unsigned char>(*Segment));
+  for (; *Src && !Bitset.test(static_cast<unsigned char>(*Src)); ++Src)
+    ;
+  return Src - Initial;
+}
+
+constexpr char kOneCharacter[] = "#";
+constexpr char kFourCharacters[] = "#$%&";
+
+template <size_t (*Function)(const char *, const char *), const char *Segment>
+void BM_ComplementarySpan(benchmark::State &State) {
+  StringBuffer Buffer(State.range(0));
+  for (auto _ : State) {
+    benchmark::DoNotOptimize(Buffer.Str);
+    benchmark::DoNotOptimize(Function(Buffer.Str, Segment));
+  }
+  setCounters(State);
+}
+
+constexpr auto StringLengthSwar =
+    internal::string_length_wide<string_scan::Swar>;
+constexpr auto FindFirstCharacterSwar =
+    internal::find_first_character_wide<string_scan::Swar>;
+constexpr auto FindFirstCharacterOrTerminatorSwar =
+    internal::find_first_character_or_terminator_wide<string_scan::Swar>;
+constexpr auto FindLastCharacterSwar =
+    internal::find_last_character_wide<string_scan::Swar>;
+
+#define STRING_BENCHMARK(NAME, ...)                                            \
+  BENCHMARK(__VA_ARGS__)->Name(NAME)->RangeMultiplier(4)->Range(4, 16384)
+
+// strlen, strcpy, strcat, strdup, ...
+STRING_BENCHMARK("string_length/bytewise",
+                 BM_StringLength<internal::string_length_bytewise>);
+STRING_BENCHMARK("string_length/swar", BM_StringLength<StringLengthSwar>);
+STRING_BENCHMARK("string_length/default",
+                 BM_StringLength<internal::string_length>);
+
+// memchr, strnlen
+STRING_BENCHMARK(
+    "find_first_character/bytewise",
+    BM_FindFirstCharacter<internal::find_first_character_bytewise>);
+STRING_BENCHMARK("find_first_character/swar",
+                 BM_FindFirstCharacter<FindFirstCharacterSwar>);
+STRING_BENCHMARK("find_first_character/default",
+                 BM_FindFirstCharacter<internal::find_first_character>);
+
+// strchr, single character strcspn
+STRING_BENCHMARK(
+    "find_first_character_or_terminator/bytewise",
+    BM_FindCharacter<internal::find_first_character_or_terminator_bytewise>);
+STRING_BENCHMARK("find_first_character_or_terminator/swar",
+                 BM_FindCharacter<FindFirstCharacterOrTerminatorSwar>);
+STRING_BENCHMARK(
+    "find_first_character_or_terminator/default",
+    BM_FindCharacter<internal::find_first_character_or_terminator>);
+
+// strrchr
+STRING_BENCHMARK("find_last_character/bytewise",
+                 BM_FindCharacter<internal::find_last_character_bytewise>);
+STRING_BENCHMARK("find_last_character/swar",
+                 BM_FindCharacter<FindLastCharacterSwar>);
+STRING_BENCHMARK("find_last_character/default",
+                 BM_FindCharacter<internal::find_last_character>);
+
+// strcspn, strpbrk
+STRING_BENCHMARK(
+    "complementary_span/bytewise/1",
+    BM_ComplementarySpan<complementarySpanBytewise, kOneCharacter>);
+STRING_BENCHMARK(
+    "complementary_span/default/1",
+    BM_ComplementarySpan<internal::complementary_span, kOneCharacter>);
+STRING_BENCHMARK(
+    "complementary_span/bytewise/4",
+    BM_ComplementarySpan<complementarySpanBytewise, kFourCharacters>);
+STRING_BENCHMARK(
+    "complementary_span/default/4",
+    BM_ComplementarySpan<internal::complementary_span, kFourCharacters>);
+
+} // namespace
@@ -14,6 +14,12 @@ namespace __llvm_libc {
 // Lookup table for (1/f) where f = 1 + n*2^(-7), n = 0..127.
 extern const double ONE_OVER_F[128];
 
+// Lookup table for log(f) = log(1 + n*2^(-7)) where n = 0..127.
+extern const double LOG_F[128];
+
+// Lookup table for log2(f) = log2(1 + n*2^(-7)) where n = 0..127.
+extern const double LOG2_F[128];
+
 } // namespace __llvm_libc
 
 #endif // LLVM_LIBC_SRC_MATH_GENERIC_COMMON_CONSTANTS_H
@@ -0,0 +1,34 @@
+//===-- Vector variants of the single precision math functions ------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file is compiled once per vector ISA of the target, the variants are
+// selected by the compile options (see CMakeLists.txt).
+//
+//===----------------------------------------------------------------------===//
+
+#include "src/math/vector_math.h"
+#include "vector_math_utils.h"
+
+#include "src/__support/architectures.h"
+#include "src/__support/common.h"
+
+namespace __llvm_libc {
+
+#if defined(LLVM_LIBC_ARCH_X86_64) && defined(__AVX512F__)
+LLVM_LIBC_VECTOR_MATH_FUNCTIONS(e, 16)
+#elif defined(LLVM_LIBC_ARCH_X86_64) && defined(__AVX2__)
+LLVM_LIBC_VECTOR_MATH_FUNCTIONS(d, 8)
+#elif defined(LLVM_LIBC_ARCH_X86_64)
+LLVM_LIBC_VECTOR_MATH_FUNCTIONS(b, 4)
+#elif defined(LLVM_LIBC_ARCH_AARCH64)
+LLVM_LIBC_VECTOR_MATH_FUNCTIONS(n, 4)
+#else
+#error "No vector math functions for the target architecture"
+#endif
+
+} // namespace __llvm_libc
@@ -0,0 +1,335 @@
+//===-- Collection of utils for the vector math functions -------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Vector variants of expf, exp2f, logf, log2f, sinf, cosf and sincosf for any
+// number of lanes. They evaluate the range reductions, tables and polynomials
+// of the scalar functions in double precision lanes. Lanes that need special
+// handling (large, tiny, negative or non-finite inputs and the hard to round
+// cases of logf and log2f) are computed by the scalar functions, which also
+// set errno and raise the floating point exceptions for them.
+//
+// The results only differ from the scalar functions where the compiler fuses
+// a multiplication and an addition in one of them but not in the other, e.g.
+// the scalar logf and log2f always use FMA on x86-64 while the SSE2 variants
+// can't. The vector results are within 1 ULP of the scalar results.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIBC_SRC_MATH_GENERIC_VECTOR_MATH_UTILS_H
+#define LLVM_LIBC_SRC_MATH_GENERIC_VECTOR_MATH_UTILS_H
+
+#include "common_constants.h"
+#include "exp_utils.h"
+#include "math_utils.h"
+#include "sincosf_utils.h"
+
+#include "src/__support/common.h"
+#include "src/math/cosf.h"
+#include "src/math/exp2f.h"
+#include "src/math/expf.h"
+#include "src/math/log2f.h"
+#include "src/math/logf.h"
+#include "src/math/sincosf.h"
+#include "src/math/sinf.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace __llvm_libc {
+namespace vector_math {
+
+// Vector types with LANES lanes. These are specialized for every supported
+// number of lanes as not all compilers support vector sizes that depend on
+// template parameters.
+template <size_t LANES> struct VectorTypes;
+
+#define LLVM_LIBC_VECTOR_TYPES(LANES)                                          \
+  template <> struct VectorTypes<LANES> {                                      \
+    typedef float Float __attribute__((vector_size(LANES * sizeof(float))));   \
+    typedef double Double                                                      \
+        __attribute__((vector_size(LANES * sizeof(double))));                  \
+    typedef int32_t Int32                                                      \
+        __attribute__((vector_size(LANES * sizeof(int32_t))));                 \
+    typedef uint32_t UInt32                                                    \
+        __attribute__((vector_size(LANES * sizeof(uint32_t))));                \
+    typedef int64_t Int64                                                      \
+        __attribute__((vector_size(LANES * sizeof(int64_t))));                 \
+    typedef uint64_t UInt64                                                    \
+        __attribute__((vector_size(LANES * sizeof(uint64_t))));                \
+  };
+
+LLVM_LIBC_VECTOR_TYPES(4)
+LLVM_LIBC_VECTOR_TYPES(8)
+LLVM_LIBC_VECTOR_TYPES(16)
+
+#undef LLVM_LIBC_VECTOR_TYPES
+
+template <size_t LANES> struct VectorMath {
+  using Float = typename VectorTypes<LANES>::Float;
+  using Double = typename VectorTypes<LANES>::Double;
+  using Int32 = typename VectorTypes<LANES>::Int32;
+  using UInt32 = typename VectorTypes<LANES>::UInt32;
+  using Int64 = typename VectorTypes<LANES>::Int64;
+  using UInt64 = typename VectorTypes<LANES>::UInt64;
+
+  static Float splat(float value) { return Float{} + value; }
+  static Double splat(double value) { return Double{} + value; }
+
+  static UInt32 abstop12(Float x) { return ((UInt32)x >> 20) & 0x7ff; }
+
+  // Returns whether any lane of the comparison result 'mask' is set.
+  template <typename Mask> static bool any_lane(Mask mask) {
+    auto any = mask[0];
+    for (size_t i = 1; i < LANES; ++i)
+      any |= mask[i];
+    return any != 0;
+  }
+
+  template <typename Result, typename Index, typename T>
+  static Result gather(const T *table, Index index) {
+    Result result = {};
+    for (size_t i = 0; i < LANES; ++i)
+      result[i] = table[index[i]];
+    return result;
+  }
+
+  // Replaces the lanes of 'y' for which 'special' is set by the result of the
+  // scalar function 'f' for the corresponding lane of 'x'.
+  template <typename Function>
+  static Float fixup_special_lanes(Float x, Float y, Int32 special,
+                                   Function f) {
+    if (unlikely(any_lane(special))) {
+      for (size_t i = 0; i < LANES; ++i)
+        if (special[i])
+          y[i] = f(x[i]);
+    }
+    return y;
+  }
+
+  // Computes s * (C0*r^3 + C1*r^2 + C2*r + 1) with s = 2^(k/N) derived from
+  // 'ki', see expf and exp2f.
+  static Float exp2f_poly(UInt64 ki, Double r, const double *c) {
+    UInt64 t = gather<UInt64>(exp2f_data.tab,
+                              ki & ((1 << EXP2F_TABLE_BITS) - 1));
+    t += ki << (52 - EXP2F_TABLE_BITS);
+    Double s = (Double)t;
+    Double z = c[0] * r + c[1];
+    Double r2 = r * r;
+    Double y = c[2] * r + 1.0;
+    y = z * r2 + y;
+    y = y * s;
+    return __builtin_convertvector(y, Float);
+  }
+
+  static Float expf(Float x) {
+    // |x| >= 88 or x is nan.
+    Int32 special = abstop12(x) >= top12_bits(88.0f);
+    Double xd = __builtin_convertvector(special ? Float{} : x, Double);
+
+    // x*N/Ln2 = k + r with r in [-1/2, 1/2] and int k.
+    Double z = exp2f_data.invln2_scaled * xd;
+    Double kd = z + exp2f_data.shift;
+    UInt64 ki = (UInt64)kd;
+    kd -= exp2f_data.shift;
+    Double r = z - kd;
+
+    Float y = exp2f_poly(ki, r, exp2f_data.poly_scaled);
+    return fixup_special_lanes(x, y, special, __llvm_libc::expf);
+  }
+
+  static Float exp2f(Float x) {
+    // |x| >= 128 or x is nan.
+    Int32 special = abstop12(x) >= top12_bits(128.0f);
+    Double xd = __builtin_convertvector(special ? Float{} : x, Double);
+
+    // x = k/N + r with r in [-1/(2N), 1/(2N)] and int k.
+    Double kd = xd + exp2f_data.shift_scaled;
+    UInt64 ki = (UInt64)kd;
+    kd -= exp2f_data.shift_scaled; // k/N for int k.
+    Double r = xd - kd;
+
+    Float y = exp2f_poly(ki, r, exp2f_data.poly);
+    return fixup_special_lanes(x, y, special, __llvm_libc::exp2f);
+  }
+
+  // Computes m * log_2 + log_f[f_index] + P(d/f) for x = 2^m * 1.mant, see
+  // logf and log2f. Lanes of x must be positive normal numbers.
+  static Float log_poly(Float x, double log_2, const double *log_f,
+                        const double (&p)[5]) {
+    UInt32 xbits = (UInt32)x;
+    Double m = __builtin_convertvector((Int32)(xbits >> 23) - 127, Double);
+    // Set bits to 1.m and get the 7 highest bits of the mantissa.
+    xbits = (xbits & 0x007f'ffff) | 0x3f80'0000;
+    UInt32 f_index = xbits >> 16 & 0x7f;
+    // Clear the lowest 16 bits.
+    Float f = (Float)(xbits & ~0x0000'ffffu);
+
+    Double d = __builtin_convertvector((Float)xbits - f, Double);
+    d *= gather<Double>(ONE_OVER_F, f_index);
+
+    Double extra_factor = m * log_2 + gather<Double>(log_f, f_index);
+    Double r = splat(p[4]);
+    r = r * d + p[3];
+    r = r * d + p[2];
+    r = r * d + p[1];
+    r = r * d + p[0];
+    r = r * d + extra_factor;
+    return __builtin_convertvector(r, Float);
+  }
+
+  // Inputs that are not positive normal numbers.
+  static Int32 log_special(UInt32 xbits) {
+    return (xbits - 0x0080'0000) >= 0x7f00'0000;
+  }
+
+  static Float logf(Float x) {
+    // Hard to round values, see logf.
+    static constexpr uint32_t HARD_CASES[] = {
+        0x41178febU, 0x4c5d65a5U, 0x65d890d3U, 0x6f31a8ecU,
+        0x3f800001U, 0x500ffb03U, 0x7a17f30aU, 0x5cd69e88U};
+    static constexpr double POLY[5] = {
+        0x1.fffffffffffacp-1, -0x1.fffffffef9cb2p-2, 0x1.5555513bc679ap-2,
+        -0x1.fff4805ea441p-3, 0x1.930180dbde91ap-3};
+    constexpr double LOG_2 = 0x1.62e42fefa39efp-1;
+
+    UInt32 xbits = (UInt32)x;
+    Int32 special = log_special(xbits);
+    for (uint32_t hard_case : HARD_CASES)
+      special |= xbits == hard_case;
+
+    Float y = log_poly(special ? splat(1.0f) : x, LOG_2, LOG_F, POLY);
+    return fixup_special_lanes(x, y, special, __llvm_libc::logf);
+  }
+
+  static Float log2f(Float x) {
+    // Hard to round values, see log2f.
+    static constexpr uint32_t HARD_CASES[] = {0x3f81d0b5U, 0x3f7e3274U,
+                                              0x3f7d57f5U};
+    static constexpr double POLY[5] = {
+        0x1.71547652bd4fp+0, -0x1.7154769b978c7p-1, 0x1.ec71a99e349c8p-2,
+        -0x1.720d90e6aac6cp-2, 0x1.5132da3583dap-2};
+
+    UInt32 xbits = (UInt32)x;
+    Int32 special = log_special(xbits);
+    for (uint32_t hard_case : HARD_CASES)
+      special |= xbits == hard_case;
+
+    Float y = log_poly(special ? splat(1.0f) : x, 1.0, LOG2_F, POLY);
+    return fixup_special_lanes(x, y, special, __llvm_libc::log2f);
+  }
+
+  // Inputs outside of 2^-12 <= |y| < 120, where the scalar functions don't
+  // use the fast range reduction. Within PI/4 the fast range reduction
+  // returns the input unchanged, so one code path covers all other inputs.
+  static Int32 sincos_special(Float y) {
+    UInt32 abstop = abstop12(y);
+    return (abstop < __llvm_libc::abstop12(as_float(0x39800000))) |
+           (abstop >= __llvm_libc::abstop12(120.0f));
+  }
+
+  // Computes the sine and cosine of lanes that are not special, see
+  // reduce_fast and sincosf_poly.
+  static void sincosf_fast(Float y, Float &sinv, Float &cosv) {
+    const sincos_t *p = &SINCOSF_TABLE[0];
+    Double x = __builtin_convertvector(y, Double);
+
+    Double r = x * p->hpi_inv;
+    Int64 n = (__builtin_convertvector(r, Int64) + 0x800000) >> 24;
+    x = x - __builtin_convertvector(n, Double) * p->hpi;
+
+    // Setup the signs for sin and cos, sign[n & 3] is -1 in quadrants 1, 2.
+    Double s = ((n + 1) & 2) != 0 ? splat(-1.0) : splat(1.0);
+    // The cosine polynomial is negated in quadrants 2 and 3.
+    Int64 negate_cos = (n & 2) != 0;
+    const sincos_t *q = &SINCOSF_TABLE[1];
+    Double c0 = negate_cos ? splat(q->c0) : splat(p->c0);
+    Double c1 = negate_cos ? splat(q->c1) : splat(p->c1);
+    Double c2 = negate_cos ? splat(q->c2) : splat(p->c2);
+    Double c3 = negate_cos ? splat(q->c3) : splat(p->c3);
+    Double c4 = negate_cos ? splat(q->c4) : splat(p->c4);
+
+    Double x2 = x * x;
+    x *= s;
+
+    Double x3 = x2 * x;
+    Double x4 = x2 * x2;
+    Double s1 = p->s2 + x2 * p->s3;
+    Double x5 = x3 * x2;
+    Double sin_poly = x + x3 * p->s1;
+    sin_poly = sin_poly + x5 * s1;
+
+    Double cos_c2 = c3 + x2 * c4;
+    Double cos_c1 = c0 + x2 * c1;
+    Double x6 = x4 * x2;
+    Double cos_poly = cos_c1 + x4 * c2;
+    cos_poly = cos_poly + x6 * cos_c2;
+
+    // Swap sin/cos result based on quadrant.
+    Int64 swap = (n & 1) != 0;
+    sinv = __builtin_convertvector(swap ? cos_poly : sin_poly, Float);
+    cosv = __builtin_convertvector(swap ? sin_poly : cos_poly, Float);
+  }
+
+  static Float sinf(Float x) {
+    Int32 special = sincos_special(x);
+    Float sinv, cosv;
+    sincosf_fast(special ? splat(1.0f) : x, sinv, cosv);
+    return fixup_special_lanes(x, sinv, special, __llvm_libc::sinf);
+  }
+
+  static Float cosf(Float x) {
+    Int32 special = sincos_special(x);
+    Float sinv, cosv;
+    sincosf_fast(special ? splat(1.0f) : x, sinv, cosv);
+    return fixup_special_lanes(x, cosv, special, __llvm_libc::cosf);
+  }
+
+  static void sincosf(Float x, float *sinp, float *cosp) {
+    Int32 special = sincos_special(x);
+    Float sinv, cosv;
+    sincosf_fast(special ? splat(1.0f) : x, sinv, cosv);
+    if (unlikely(any_lane(special))) {
+      for (size_t i = 0; i < LANES; ++i)
+        if (special[i]) {
+          float sin_lane, cos_lane;
+          __llvm_libc::sincosf(x[i], &sin_lane, &cos_lane);
+          sinv[i] = sin_lane;
+          cosv[i] = cos_lane;
+        }
+    }
+    __builtin_memcpy(sinp, &sinv, sizeof(Float));
+    __builtin_memcpy(cosp, &cosv, sizeof(Float));
+  }
+};
+
+} // namespace vector_math
+} // namespace __llvm_libc
+
+// Defines the vector function ABI entry points with the ABI's ISA letter 'ISA'
+// and LANES lanes.
+#define LLVM_LIBC_VECTOR_MATH_FUNCTIONS(ISA, LANES)                            \
+  LLVM_LIBC_VECTOR_MATH_FUNCTION(ISA, LANES, expf)                             \
+  LLVM_LIBC_VECTOR_MATH_FUNCTION(ISA, LANES, exp2f)                            \
+  LLVM_LIBC_VECTOR_MATH_FUNCTION(ISA, LANES, logf)                             \
+  LLVM_LIBC_VECTOR_MATH_FUNCTION(ISA, LANES, log2f)                            \
+  LLVM_LIBC_VECTOR_MATH_FUNCTION(ISA, LANES, sinf)                             \
+  LLVM_LIBC_VECTOR_MATH_FUNCTION(ISA, LANES, cosf)                             \
+  LLVM_LIBC_FUNCTION(void, _ZGV##ISA##N##LANES##vl4l4_sincosf,                 \
+                     (vector_math::VectorMath<LANES>::Float x, float *sinp,    \
+                      float *cosp)) {                                          \
+    vector_math::VectorMath<LANES>::sincosf(x, sinp, cosp);                    \
+  }
+
+#define LLVM_LIBC_VECTOR_MATH_FUNCTION(ISA, LANES, NAME)                       \
+  LLVM_LIBC_FUNCTION(vector_math::VectorMath<LANES>::Float,                    \
+                     _ZGV##ISA##N##LANES##v_##NAME,                            \
+                     (vector_math::VectorMath<LANES>::Float x)) {              \
+    return vector_math::VectorMath<LANES>::NAME(x);                            \
+  }
+
+#endif // LLVM_LIBC_SRC_MATH_GENERIC_VECTOR_MATH_UTILS_H
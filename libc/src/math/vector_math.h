@@ -0,0 +1,51 @@
+//===-- Implementation header for the vector math functions -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Vector variants of the single precision math functions, named after the
+// vector function ABI of the target: _ZGV<isa>N<lanes>v_<function>, and
+// _ZGV<isa>N<lanes>vl4l4_sincosf for sincosf which stores the sines and cosines
+// of all lanes consecutively. These are the functions the loop vectorizer
+// calls with -fveclib=LLVMLibc.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIBC_SRC_MATH_VECTOR_MATH_H
+#define LLVM_LIBC_SRC_MATH_VECTOR_MATH_H
+
+#include "src/__support/architectures.h"
+
+namespace __llvm_libc {
+
+typedef float v4f32 __attribute__((vector_size(4 * sizeof(float))));
+typedef float v8f32 __attribute__((vector_size(8 * sizeof(float))));
+typedef float v16f32 __attribute__((vector_size(16 * sizeof(float))));
+
+#define LLVM_LIBC_DECLARE_VECTOR_MATH_FUNCTIONS(ISA, LANES, VECTOR)            \
+  VECTOR _ZGV##ISA##N##LANES##v_expf(VECTOR x);                                \
+  VECTOR _ZGV##ISA##N##LANES##v_exp2f(VECTOR x);                               \
+  VECTOR _ZGV##ISA##N##LANES##v_logf(VECTOR x);                                \
+  VECTOR _ZGV##ISA##N##LANES##v_log2f(VECTOR x);                               \
+  VECTOR _ZGV##ISA##N##LANES##v_sinf(VECTOR x);                                \
+  VECTOR _ZGV##ISA##N##LANES##v_cosf(VECTOR x);                                \
+  void _ZGV##ISA##N##LANES##vl4l4_sincosf(VECTOR x, float *sinp, float *cosp);
+
+#if defined(LLVM_LIBC_ARCH_X86_64)
+// SSE2, AVX2 and AVX-512 variants.
+LLVM_LIBC_DECLARE_VECTOR_MATH_FUNCTIONS(b, 4, v4f32)
+LLVM_LIBC_DECLARE_VECTOR_MATH_FUNCTIONS(d, 8, v8f32)
+LLVM_LIBC_DECLARE_VECTOR_MATH_FUNCTIONS(e, 16, v16f32)
+#elif defined(LLVM_LIBC_ARCH_AARCH64)
+// Advanced SIMD variants.
+LLVM_LIBC_DECLARE_VECTOR_MATH_FUNCTIONS(n, 4, v4f32)
+#endif
+
+#undef LLVM_LIBC_DECLARE_VECTOR_MATH_FUNCTIONS
+
+} // namespace __llvm_libc
+
+#endif // LLVM_LIBC_SRC_MATH_VECTOR_MATH_H
@@ -9,15 +9,14 @@
 #include "src/string/strchr.h"
 
 #include "src/__support/common.h"
+#include "src/string/string_utils.h"
 
 namespace __llvm_libc {
 
-// TODO: Look at performance benefits of comparing words.
 LLVM_LIBC_FUNCTION(char *, strchr, (const char *src, int c)) {
   const char ch = c;
-  for (; *src && *src != ch; ++src)
-    ;
-  return *src == ch ? const_cast<char *>(src) : nullptr;
+  char *result = internal::find_first_character_or_terminator(src, ch);
+  return *result == ch ? result : nullptr;
 }
 
 } // namespace __llvm_libc
@@ -0,0 +1,228 @@
+//===-- Elementary operations for string scanning ---------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Each element compares an aligned block of SIZE characters at once and
+// returns a mask with MASK_BITS_PER_CHAR bits per character, the bits of
+// matching characters being set. The character at index i of the block maps to
+// bits [i * MASK_BITS_PER_CHAR, (i + 1) * MASK_BITS_PER_CHAR).
+//
+// Aligned loads never cross a page boundary, so it is safe to read the whole
+// block containing the first or last character of a string even if the string
+// doesn't cover the block. Tools that check every byte access (e.g. address
+// sanitizer) don't know this, so the byte-at-a-time implementations are used
+// when such tools are enabled (LLVM_LIBC_STRING_SCAN_BYTEWISE).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIBC_SRC_STRING_STRING_SCAN_ELEMENTS_H
+#define LLVM_LIBC_SRC_STRING_STRING_SCAN_ELEMENTS_H
+
+#include "src/__support/architectures.h"
+
+#include <stddef.h> // size_t
+#include <stdint.h> // uint8_t, uint32_t, uint64_t, uintptr_t
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer) ||     \
+    __has_feature(hwaddress_sanitizer)
+#define LLVM_LIBC_STRING_SCAN_BYTEWISE
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define LLVM_LIBC_STRING_SCAN_BYTEWISE
+#endif
+
+#if defined(LLVM_LIBC_ARCH_X86) && defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(LLVM_LIBC_ARCH_AARCH64) && defined(__ARM_NEON) &&                  \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define LLVM_LIBC_STRING_SCAN_HAS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace __llvm_libc {
+namespace string_scan {
+
+// Word-at-a-time (SWAR) comparisons, available on all targets.
+struct Swar {
+  using Word = uintptr_t;
+  static constexpr size_t SIZE = sizeof(Word);
+  static constexpr size_t MASK_BITS_PER_CHAR = 8;
+
+  static Word load(const char *aligned) {
+    Word value;
+    __builtin_memcpy(&value, aligned, sizeof(Word));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    // Put the first character into the least significant byte.
+    if constexpr (sizeof(Word) == 8)
+      value = __builtin_bswap64(value);
+    else
+      value = __builtin_bswap32(value);
+#endif
+    return value;
+  }
+
+  static constexpr Word splat(unsigned char ch) {
+    return (~Word(0) / 0xff) * ch;
+  }
+
+  // Sets the most significant bit of each zero byte. Unlike the common
+  // "(v - 0x01..) & ~v & 0x80.." formulation, this never sets bits of
+  // non-zero bytes, which is required to find the last match.
+  static uint64_t zero_bytes(Word value) {
+    constexpr Word low_bits = splat(0x7f);
+    const Word t = (value & low_bits) + low_bits;
+    return ~(t | value | low_bits);
+  }
+
+  static uint64_t zero_mask(const char *aligned) {
+    return zero_bytes(load(aligned));
+  }
+
+  static uint64_t char_mask(const char *aligned, unsigned char ch) {
+    return zero_bytes(load(aligned) ^ splat(ch));
+  }
+
+  static uint64_t char_or_zero_mask(const char *aligned, unsigned char ch) {
+    const Word value = load(aligned);
+    return zero_bytes(value) | zero_bytes(value ^ splat(ch));
+  }
+};
+
+#if defined(LLVM_LIBC_ARCH_X86) && defined(__SSE2__)
+namespace x86 {
+
+struct Sse2 {
+  static constexpr size_t SIZE = 16;
+  static constexpr size_t MASK_BITS_PER_CHAR = 1;
+
+  static __m128i load(const char *aligned) {
+    return _mm_load_si128(reinterpret_cast<const __m128i *>(aligned));
+  }
+
+  static uint64_t to_mask(__m128i eq) {
+    return static_cast<uint32_t>(_mm_movemask_epi8(eq));
+  }
+
+  static uint64_t zero_mask(const char *aligned) {
+    return to_mask(_mm_cmpeq_epi8(load(aligned), _mm_setzero_si128()));
+  }
+
+  static uint64_t char_mask(const char *aligned, unsigned char ch) {
+    return to_mask(_mm_cmpeq_epi8(load(aligned), _mm_set1_epi8(ch)));
+  }
+
+  static uint64_t char_or_zero_mask(const char *aligned, unsigned char ch) {
+    const __m128i value = load(aligned);
+    return to_mask(_mm_or_si128(_mm_cmpeq_epi8(value, _mm_setzero_si128()),
+                                _mm_cmpeq_epi8(value, _mm_set1_epi8(ch))));
+  }
+};
+
+#ifdef __AVX2__
+struct Avx2 {
+  static constexpr size_t SIZE = 32;
+  static constexpr size_t MASK_BITS_PER_CHAR = 1;
+
+  static __m256i load(const char *aligned) {
+    return _mm256_load_si256(reinterpret_cast<const __m256i *>(aligned));
+  }
+
+  static uint64_t to_mask(__m256i eq) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+  }
+
+  static uint64_t zero_mask(const char *aligned) {
+    return to_mask(_mm256_cmpeq_epi8(load(aligned), _mm256_setzero_si256()));
+  }
+
+  static uint64_t char_mask(const char *aligned, unsigned char ch) {
+    return to_mask(_mm256_cmpeq_epi8(load(aligned), _mm256_set1_epi8(ch)));
+  }
+
+  static uint64_t char_or_zero_mask(const char *aligned, unsigned char ch) {
+    const __m256i value = load(aligned);
+    return to_mask(
+        _mm256_or_si256(_mm256_cmpeq_epi8(value, _mm256_setzero_si256()),
+                        _mm256_cmpeq_epi8(value, _mm256_set1_epi8(ch))));
+  }
+};
+#endif // __AVX2__
+
+} // namespace x86
+#endif // defined(LLVM_LIBC_ARCH_X86) && defined(__SSE2__)
+
+#ifdef LLVM_LIBC_STRING_SCAN_HAS_NEON
+namespace aarch64 {
+
+struct Neon {
+  static constexpr size_t SIZE = 16;
+  static constexpr size_t MASK_BITS_PER_CHAR = 4;
+
+  static uint8x16_t load(const char *aligned) {
+    return vld1q_u8(reinterpret_cast<const uint8_t *>(aligned));
+  }
+
+  // There is no movemask on NEON, narrowing each 16-bit lane by 4 bits
+  // produces a nibble per character instead.
+  static uint64_t to_mask(uint8x16_t eq) {
+    const uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+  }
+
+  static uint64_t zero_mask(const char *aligned) {
+    return to_mask(vceqzq_u8(load(aligned)));
+  }
+
+  static uint64_t char_mask(const char *aligned, unsigned char ch) {
+    return to_mask(vceqq_u8(load(aligned), vdupq_n_u8(ch)));
+  }
+
+  static uint64_t char_or_zero_mask(const char *aligned, unsigned char ch) {
+    const uint8x16_t value = load(aligned);
+    return to_mask(
+        vorrq_u8(vceqzq_u8(value), vceqq_u8(value, vdupq_n_u8(ch))));
+  }
+};
+
+} // namespace aarch64
+#endif // LLVM_LIBC_STRING_SCAN_HAS_NEON
+
+// The widest element available on the target.
+#if defined(LLVM_LIBC_ARCH_X86) && defined(__AVX2__)
+using Default = x86::Avx2;
+#elif defined(LLVM_LIBC_ARCH_X86) && defined(__SSE2__)
+using Default = x86::Sse2;
+#elif defined(LLVM_LIBC_STRING_SCAN_HAS_NEON)
+using Default = aarch64::Neon;
+#else
+using Default = Swar;
+#endif
+
+// Index of the first matching character in a non-zero mask.
+template <typename Element> static inline size_t first_index(uint64_t mask) {
+  return __builtin_ctzll(mask) / Element::MASK_BITS_PER_CHAR;
+}
+
+// Index of the last matching character in a non-zero mask.
+template <typename Element> static inline size_t last_index(uint64_t mask) {
+  return (63 - __builtin_clzll(mask)) / Element::MASK_BITS_PER_CHAR;
+}
+
+// Clears the mask bits of the first 'count' characters of a block.
+template <typename Element>
+static inline uint64_t skip_chars(uint64_t mask, size_t count) {
+  return mask & (~uint64_t(0) << (count * Element::MASK_BITS_PER_CHAR));
+}
+
+} // namespace string_scan
+} // namespace __llvm_libc
+
+#endif // LLVM_LIBC_SRC_STRING_STRING_SCAN_ELEMENTS_H
@@ -11,38 +11,189 @@
 
 #include "src/__support/CPP/Bitset.h"
 #include "src/__support/common.h"
+#include "src/string/string_scan_elements.h"
 #include <stddef.h> // size_t
+#include <stdint.h> // uint64_t, uintptr_t
 
 namespace __llvm_libc {
 namespace internal {
 
-// Returns the length of a string, denoted by the first occurrence
-// of a null terminator.
-static inline size_t string_length(const char *src) {
+// Byte-at-a-time implementations. These are used if wide reads are not
+// allowed (see string_scan_elements.h) and serve as the baseline in
+// benchmarks.
+
+static inline size_t string_length_bytewise(const char *src) {
   size_t length;
   for (length = 0; *src; ++src, ++length)
     ;
   return length;
 }
 
+static inline void *find_first_character_bytewise(const unsigned char *src,
+                                                  unsigned char ch, size_t n) {
+  for (; n && *src != ch; --n, ++src)
+    ;
+  return n ? const_cast<unsigned char *>(src) : nullptr;
+}
+
+static inline char *find_first_character_or_terminator_bytewise(const char *src,
+                                                                char ch) {
+  for (; *src && *src != ch; ++src)
+    ;
+  return const_cast<char *>(src);
+}
+
+static inline char *find_last_character_bytewise(const char *src, char ch) {
+  char *last_occurrence = nullptr;
+  for (;; ++src) {
+    if (*src == ch)
+      last_occurrence = const_cast<char *>(src);
+    if (!*src)
+      return last_occurrence;
+  }
+}
+
+// Block-at-a-time implementations using a string_scan element. All blocks are
+// read with aligned loads, see string_scan_elements.h.
+
+template <typename Element>
+static inline size_t string_length_wide(const char *src) {
+  const size_t misalignment = uintptr_t(src) % Element::SIZE;
+  const char *block = src - misalignment;
+  uint64_t mask = string_scan::skip_chars<Element>(Element::zero_mask(block),
+                                                   misalignment);
+  while (!mask) {
+    block += Element::SIZE;
+    mask = Element::zero_mask(block);
+  }
+  return block - src + string_scan::first_index<Element>(mask);
+}
+
+template <typename Element>
+static inline void *find_first_character_wide(const unsigned char *src,
+                                              unsigned char ch, size_t n) {
+  if (n == 0)
+    return nullptr;
+  const char *start = reinterpret_cast<const char *>(src);
+  const size_t misalignment = uintptr_t(start) % Element::SIZE;
+  const char *block = start - misalignment;
+  uint64_t mask = string_scan::skip_chars<Element>(
+      Element::char_mask(block, ch), misalignment);
+  // Number of characters of 'src' before the next block.
+  size_t scanned = Element::SIZE - misalignment;
+  while (!mask) {
+    if (scanned >= n)
+      return nullptr;
+    block += Element::SIZE;
+    scanned += Element::SIZE;
+    mask = Element::char_mask(block, ch);
+  }
+  const size_t index = block - start + string_scan::first_index<Element>(mask);
+  return index < n ? const_cast<unsigned char *>(src + index) : nullptr;
+}
+
+template <typename Element>
+static inline char *find_first_character_or_terminator_wide(const char *src,
+                                                            char ch) {
+  const size_t misalignment = uintptr_t(src) % Element::SIZE;
+  const char *block = src - misalignment;
+  uint64_t mask = string_scan::skip_chars<Element>(
+      Element::char_or_zero_mask(block, ch), misalignment);
+  while (!mask) {
+    block += Element::SIZE;
+    mask = Element::char_or_zero_mask(block, ch);
+  }
+  return const_cast<char *>(block + string_scan::first_index<Element>(mask));
+}
+
+template <typename Element>
+static inline char *find_last_character_wide(const char *src, char ch) {
+  if (ch == '\0')
+    return const_cast<char *>(src + string_length_wide<Element>(src));
+  const char *last_occurrence = nullptr;
+  const size_t misalignment = uintptr_t(src) % Element::SIZE;
+  const char *block = src - misalignment;
+  uint64_t zeros = string_scan::skip_chars<Element>(Element::zero_mask(block),
+                                                    misalignment);
+  uint64_t matches = string_scan::skip_chars<Element>(
+      Element::char_mask(block, ch), misalignment);
+  for (;;) {
+    if (zeros) {
+      // Only matches before the terminator count.
+      matches &= (zeros & (~zeros + 1)) - 1;
+      if (matches)
+        last_occurrence = block + string_scan::last_index<Element>(matches);
+      return const_cast<char *>(last_occurrence);
+    }
+    if (matches)
+      last_occurrence = block + string_scan::last_index<Element>(matches);
+    block += Element::SIZE;
+    zeros = Element::zero_mask(block);
+    matches = Element::char_mask(block, ch);
+  }
+}
+
+// Returns the length of a string, denoted by the first occurrence
+// of a null terminator.
+static inline size_t string_length(const char *src) {
+#ifdef LLVM_LIBC_STRING_SCAN_BYTEWISE
+  return string_length_bytewise(src);
+#else
+  return string_length_wide<string_scan::Default>(src);
+#endif
+}
+
 // Returns the first occurrence of 'ch' within the first 'n' characters of
 // 'src'. If 'ch' is not found, returns nullptr.
 static inline void *find_first_character(const unsigned char *src,
                                          unsigned char ch, size_t n) {
-  for (; n && *src != ch; --n, ++src)
-    ;
-  return n ? const_cast<unsigned char *>(src) : nullptr;
+#ifdef LLVM_LIBC_STRING_SCAN_BYTEWISE
+  return find_first_character_bytewise(src, ch, n);
+#else
+  return find_first_character_wide<string_scan::Default>(src, ch, n);
+#endif
+}
+
+// Returns the first occurrence of 'ch' in 'src' or the null terminator,
+// whichever comes first.
+static inline char *find_first_character_or_terminator(const char *src,
+                                                       char ch) {
+#ifdef LLVM_LIBC_STRING_SCAN_BYTEWISE
+  return find_first_character_or_terminator_bytewise(src, ch);
+#else
+  return find_first_character_or_terminator_wide<string_scan::Default>(src,
+                                                                       ch);
+#endif
+}
+
+// Returns the last occurrence of 'ch' in 'src', including the null terminator.
+// If 'ch' is not found, returns nullptr.
+static inline char *find_last_character(const char *src, char ch) {
+#ifdef LLVM_LIBC_STRING_SCAN_BYTEWISE
+  return find_last_character_bytewise(src, ch);
+#else
+  return find_last_character_wide<string_scan::Default>(src, ch);
+#endif
 }
 
 // Returns the maximum length span that contains only characters not found in
 // 'segment'. If no characters are found, returns the length of 'src'.
 static inline size_t complementary_span(const char *src, const char *segment) {
+  // Empty and single character segments are plain scans.
+  if (segment[0] == '\0')
+    return string_length(src);
+  if (segment[1] == '\0')
+    return find_first_character_or_terminator(src, segment[0]) - src;
+
   const char *initial = src;
   cpp::Bitset<256> bitset;
 
+  // The null terminator is part of the set, so that each character only needs
+  // a single test.
+  bitset.set(0);
   for (; *segment; ++segment)
-    bitset.set(*segment);
-  for (; *src && !bitset.test(*src); ++src)
+    bitset.set(static_cast<unsigned char>(*segment));
+  for (; !bitset.test(static_cast<unsigned char>(*src)); ++src)
     ;
   return src - initial;
 }
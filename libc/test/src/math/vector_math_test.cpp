@@ -0,0 +1,137 @@
+//===-- Unittests for the vector math functions ---------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "src/__support/FPUtil/FPBits.h"
+#include "src/__support/architectures.h"
+#include "src/math/cosf.h"
+#include "src/math/exp2f.h"
+#include "src/math/expf.h"
+#include "src/math/log2f.h"
+#include "src/math/logf.h"
+#include "src/math/sincosf.h"
+#include "src/math/sinf.h"
+#include "src/math/vector_math.h"
+#include "utils/UnitTest/Test.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+using FPBits = __llvm_libc::fputil::FPBits<float>;
+
+// Inputs that take the special paths of at least one of the functions.
+static constexpr uint32_t SPECIAL_INPUTS[] = {
+    0x0000'0000U, 0x8000'0000U, 0x0000'0001U, 0x8000'0001U, 0x007f'ffffU,
+    0x0080'0000U, 0x3980'0000U, 0x397f'ffffU, 0x3f80'0000U, 0x3f80'0001U,
+    0x3f49'0fdbU, 0x42f0'0000U, 0x42ef'ffffU, 0x42b0'0000U, 0x42af'ffffU,
+    0x42b1'7218U, 0xc2cf'f1b5U, 0x4300'0000U, 0xc315'0000U, 0x4b00'0000U,
+    0x7f7f'ffffU, 0xff7f'ffffU, 0x7f80'0000U, 0xff80'0000U, 0x7fc0'0000U,
+    0xffc0'0000U, 0x7f80'0001U, 0x4117'8febU, 0x3f81'd0b5U, 0x3f7d'57f5U};
+
+// The inputs of the lanes are spread over all floats and taken from different
+// ranges, so that most vectors mix lanes on the fast paths and special lanes.
+static constexpr uint32_t COUNT = 1'000'000;
+static constexpr uint32_t STEP = UINT32_MAX / COUNT;
+static constexpr uint32_t LANE_OFFSET = 0x1357'9bdfU;
+
+static constexpr size_t NUM_SPECIAL_INPUTS =
+    sizeof(SPECIAL_INPUTS) / sizeof(SPECIAL_INPUTS[0]);
+
+static float input(uint32_t i, size_t lane) {
+  if (i < NUM_SPECIAL_INPUTS)
+    return float(FPBits(SPECIAL_INPUTS[(i + lane) % NUM_SPECIAL_INPUTS]));
+  return float(FPBits(uint32_t(i * STEP + lane * LANE_OFFSET)));
+}
+
+// Returns the distance in ULP between 'a' and 'b', which is zero if both are
+// NaN.
+static uint32_t ulp_distance(float a, float b) {
+  FPBits a_bits(a), b_bits(b);
+  if (a_bits.is_nan() || b_bits.is_nan())
+    return a_bits.is_nan() && b_bits.is_nan() ? 0 : UINT32_MAX;
+  auto ordered = [](FPBits bits) {
+    int64_t magnitude = bits.uintval() & 0x7fff'ffffU;
+    return bits.get_sign() ? -magnitude : magnitude;
+  };
+  int64_t distance = ordered(a_bits) - ordered(b_bits);
+  return static_cast<uint32_t>(distance < 0 ? -distance : distance);
+}
+
+template <typename Vector>
+static void test_function(Vector (*vector_function)(Vector),
+                          float (*scalar_function)(float)) {
+  constexpr size_t LANES = sizeof(Vector) / sizeof(float);
+  for (uint32_t i = 0; i < COUNT; ++i) {
+    Vector x;
+    for (size_t lane = 0; lane < LANES; ++lane)
+      x[lane] = input(i, lane);
+    Vector y = vector_function(x);
+    for (size_t lane = 0; lane < LANES; ++lane)
+      ASSERT_LE(ulp_distance(y[lane], scalar_function(x[lane])), uint32_t(1));
+  }
+}
+
+template <typename Vector>
+static void test_sincosf(void (*vector_function)(Vector, float *, float *)) {
+  constexpr size_t LANES = sizeof(Vector) / sizeof(float);
+  for (uint32_t i = 0; i < COUNT; ++i) {
+    Vector x;
+    for (size_t lane = 0; lane < LANES; ++lane)
+      x[lane] = input(i, lane);
+    float sin_values[LANES], cos_values[LANES];
+    vector_function(x, sin_values, cos_values);
+    for (size_t lane = 0; lane < LANES; ++lane) {
+      float sin_value, cos_value;
+      __llvm_libc::sincosf(x[lane], &sin_value, &cos_value);
+      ASSERT_LE(ulp_distance(sin_values[lane], sin_value), uint32_t(1));
+      ASSERT_LE(ulp_distance(cos_values[lane], cos_value), uint32_t(1));
+    }
+  }
+}
+
+#define VECTOR_MATH_TESTS(NAME, ISA, LANES)                                    \
+  TEST(LlvmLibcVectorMathTest, Expf##NAME) {                                   \
+    test_function(__llvm_libc::_ZGV##ISA##N##LANES##v_expf,                    \
+                  __llvm_libc::expf);                                          \
+  }                                                                            \
+  TEST(LlvmLibcVectorMathTest, Exp2f##NAME) {                                  \
+    test_function(__llvm_libc::_ZGV##ISA##N##LANES##v_exp2f,                   \
+                  __llvm_libc::exp2f);                                         \
+  }                                                                            \
+  TEST(LlvmLibcVectorMathTest, Logf##NAME) {                                   \
+    test_function(__llvm_libc::_ZGV##ISA##N##LANES##v_logf,                    \
+                  __llvm_libc::logf);                                          \
+  }                                                                            \
+  TEST(LlvmLibcVectorMathTest, Log2f##NAME) {                                  \
+    test_function(__llvm_libc::_ZGV##ISA##N##LANES##v_log2f,                   \
+                  __llvm_libc::log2f);                                         \
+  }                                                                            \
+  TEST(LlvmLibcVectorMathTest, Sinf##NAME) {                                   \
+    test_function(__llvm_libc::_ZGV##ISA##N##LANES##v_sinf,                    \
+                  __llvm_libc::sinf);                                          \
+  }                                                                            \
+  TEST(LlvmLibcVectorMathTest, Cosf##NAME) {                                   \
+    test_function(__llvm_libc::_ZGV##ISA##N##LANES##v_cosf,                    \
+                  __llvm_libc::cosf);                                          \
+  }                                                                            \
+  TEST(LlvmLibcVectorMathTest, Sincosf##NAME) {                                \
+    test_sincosf(__llvm_libc::_ZGV##ISA##N##LANES##vl4l4_sincosf);             \
+  }
+
+// Only the variants the host can run are linked into the test, see
+// CMakeLists.txt.
+#if defined(LLVM_LIBC_ARCH_X86_64)
+VECTOR_MATH_TESTS(Sse2, b, 4)
+#ifdef __AVX2__
+VECTOR_MATH_TESTS(Avx2, d, 8)
+#endif
+#ifdef __AVX512F__
+VECTOR_MATH_TESTS(Avx512, e, 16)
+#endif
+#elif defined(LLVM_LIBC_ARCH_AARCH64)
+VECTOR_MATH_TESTS(Neon, n, 4)
+#endif
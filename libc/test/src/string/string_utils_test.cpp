@@ -0,0 +1,106 @@
+//===-- Unittests for string_utils ----------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "src/string/string_utils.h"
+#include "utils/UnitTest/Test.h"
+
+namespace __llvm_libc {
+
+// Large enough for all alignments and lengths covering several blocks of the
+// widest element.
+static constexpr size_t BUFFER_SIZE = 256;
+static constexpr size_t MAX_LENGTH = 160;
+
+struct alignas(64) Buffer {
+  char data[BUFFER_SIZE];
+};
+
+// Fills 'buffer' with non-zero characters, the string at 'offset' is
+// terminated after 'length' characters. Returns the string.
+static char *make_string(Buffer &buffer, size_t offset, size_t length) {
+  for (size_t i = 0; i < BUFFER_SIZE; ++i)
+    buffer.data[i] = static_cast<char>('a' + i % 26);
+  buffer.data[offset + length] = '\0';
+  return buffer.data + offset;
+}
+
+template <typename Element> static void test_string_length() {
+  Buffer buffer;
+  for (size_t offset = 0; offset < 64; ++offset) {
+    for (size_t length = 0; length < MAX_LENGTH; ++length) {
+      const char *str = make_string(buffer, offset, length);
+      ASSERT_EQ(internal::string_length_wide<Element>(str), length);
+    }
+  }
+}
+
+template <typename Element> static void test_find_first_character() {
+  Buffer buffer;
+  make_string(buffer, BUFFER_SIZE - 1, 0);
+  const auto *data = reinterpret_cast<const unsigned char *>(buffer.data);
+  for (size_t offset = 0; offset < 64; ++offset) {
+    for (size_t n = 0; n < MAX_LENGTH; ++n) {
+      for (unsigned char ch : {'a', 'k', 'z', '\0', '#'}) {
+        ASSERT_EQ(
+            internal::find_first_character_wide<Element>(data + offset, ch, n),
+            internal::find_first_character_bytewise(data + offset, ch, n));
+      }
+    }
+  }
+}
+
+template <typename Element> static void test_find_character() {
+  Buffer buffer;
+  for (size_t offset = 0; offset < 64; ++offset) {
+    for (size_t length = 0; length < MAX_LENGTH; ++length) {
+      const char *str = make_string(buffer, offset, length);
+      for (char ch : {'a', 'k', 'z', '\0', '#'}) {
+        ASSERT_EQ(
+            internal::find_first_character_or_terminator_wide<Element>(str, ch),
+            internal::find_first_character_or_terminator_bytewise(str, ch));
+        ASSERT_EQ(internal::find_last_character_wide<Element>(str, ch),
+                  internal::find_last_character_bytewise(str, ch));
+      }
+    }
+  }
+}
+
+#define STRING_SCAN_ELEMENT_TESTS(NAME, ELEMENT)                               \
+  TEST(LlvmLibcStringUtilsTest, StringLength##NAME) {                          \
+    test_string_length<ELEMENT>();                                             \
+  }                                                                            \
+  TEST(LlvmLibcStringUtilsTest, FindFirstCharacter##NAME) {                    \
+    test_find_first_character<ELEMENT>();                                      \
+  }                                                                            \
+  TEST(LlvmLibcStringUtilsTest, FindCharacter##NAME) {                         \
+    test_find_character<ELEMENT>();                                            \
+  }
+
+STRING_SCAN_ELEMENT_TESTS(Swar, string_scan::Swar)
+#if defined(LLVM_LIBC_ARCH_X86) && defined(__SSE2__)
+STRING_SCAN_ELEMENT_TESTS(Sse2, string_scan::x86::Sse2)
+#endif
+#if defined(LLVM_LIBC_ARCH_X86) && defined(__AVX2__)
+STRING_SCAN_ELEMENT_TESTS(Avx2, string_scan::x86::Avx2)
+#endif
+#ifdef LLVM_LIBC_STRING_SCAN_HAS_NEON
+STRING_SCAN_ELEMENT_TESTS(Neon, string_scan::aarch64::Neon)
+#endif
+
+TEST(LlvmLibcStringUtilsTest, ComplementarySpan) {
+  Buffer buffer;
+  const char *str = make_string(buffer, 3, 100);
+  ASSERT_EQ(internal::complementary_span(str, ""), size_t(100));
+  ASSERT_EQ(internal::complementary_span(str, "#"), size_t(100));
+  ASSERT_EQ(internal::complementary_span(str, "a"), size_t(23));
+  ASSERT_EQ(internal::complementary_span(str, "#a"), size_t(23));
+  ASSERT_EQ(internal::complementary_span(str, "ea"), size_t(1));
+  ASSERT_EQ(internal::complementary_span(str, "\xff#"), size_t(100));
+}
+
+} // namespace __llvm_libc
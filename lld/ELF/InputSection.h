@@ -142,6 +142,10 @@ public:
   // deleteFallThruJmpInsn.
   bool nopFiller = false;
 
+  // Whether the compressed contents in rawData are zstd (instead of zlib)
+  // compressed.
+  bool compressedWithZstd = false;
+
   void drop_back(unsigned num) {
     assert(bytesDropped + num < 256);
     bytesDropped += num;
@@ -227,6 +231,7 @@ protected:
   template <typename ELFT>
   void parseCompressedHeader();
   void uncompress() const;
+  llvm::Error uncompressData(char *buf, size_t &size) const;
 
   mutable ArrayRef<uint8_t> rawData;
 
@@ -55,6 +55,7 @@
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/Demangle/Demangle.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 
@@ -403,6 +404,70 @@ static void addCopyRelSymbol(SharedSymbol &ss) {
   }
 }
 
+// Undefined diagnostics are collected in a vector and emitted once all of
+// them are known, so that some postprocessing on the list of undefined symbols
+// can happen before lld emits diagnostics.
+struct UndefinedDiag {
+  Undefined *sym;
+  struct Loc {
+    InputSectionBase *sec;
+    uint64_t offset;
+  };
+  std::vector<Loc> locs;
+  bool isWarning;
+};
+
+static std::vector<UndefinedDiag> undefs;
+
+// Symbol flags set by the relocation scan, see ScanResult.
+enum ScanFlag : uint16_t {
+  NEEDS_COPY = 1 << 0,
+  NEEDS_GOT = 1 << 1,
+  NEEDS_PLT = 1 << 2,
+  NEEDS_TLSDESC = 1 << 3,
+  NEEDS_TLSGD = 1 << 4,
+  NEEDS_TLSGD_TO_IE = 1 << 5,
+  NEEDS_TLSLD = 1 << 6,
+  NEEDS_GOT_DTPREL = 1 << 7,
+  NEEDS_TLSIE = 1 << 8,
+  HAS_DIRECT_RELOC = 1 << 9,
+  EXPORT_DYNAMIC = 1 << 10,
+};
+
+static uint16_t getScanFlags(const Symbol &sym) {
+  return (sym.needsCopy ? NEEDS_COPY : 0) | (sym.needsGot ? NEEDS_GOT : 0) |
+         (sym.needsPlt ? NEEDS_PLT : 0) |
+         (sym.needsTlsDesc ? NEEDS_TLSDESC : 0) |
+         (sym.needsTlsGd ? NEEDS_TLSGD : 0) |
+         (sym.needsTlsGdToIe ? NEEDS_TLSGD_TO_IE : 0) |
+         (sym.needsTlsLd ? NEEDS_TLSLD : 0) |
+         (sym.needsGotDtprel ? NEEDS_GOT_DTPREL : 0) |
+         (sym.needsTlsIe ? NEEDS_TLSIE : 0) |
+         (sym.hasDirectReloc ? HAS_DIRECT_RELOC : 0) |
+         (sym.exportDynamic ? EXPORT_DYNAMIC : 0);
+}
+
+static void applyScanFlags(Symbol &sym, uint16_t flags) {
+  sym.needsCopy |= bool(flags & NEEDS_COPY);
+  sym.needsGot |= bool(flags & NEEDS_GOT);
+  sym.needsPlt |= bool(flags & NEEDS_PLT);
+  sym.needsTlsDesc |= bool(flags & NEEDS_TLSDESC);
+  sym.needsTlsGd |= bool(flags & NEEDS_TLSGD);
+  sym.needsTlsGdToIe |= bool(flags & NEEDS_TLSGD_TO_IE);
+  sym.needsTlsLd |= bool(flags & NEEDS_TLSLD);
+  sym.needsGotDtprel |= bool(flags & NEEDS_GOT_DTPREL);
+  sym.needsTlsIe |= bool(flags & NEEDS_TLSIE);
+  sym.hasDirectReloc |= bool(flags & HAS_DIRECT_RELOC);
+  sym.exportDynamic |= bool(flags & EXPORT_DYNAMIC);
+}
+
+// relrDyn sections don't support odd offsets. Also, relrDyn sections don't
+// store the addend values, so we must write it to the relocated address.
+static bool canUseRelr(Partition &part, InputSectionBase &isec,
+                       uint64_t offsetInSec) {
+  return part.relrDyn && isec.alignment >= 2 && offsetInSec % 2 == 0;
+}
+
 // .eh_frame sections are mergeable input sections, so their input
 // offsets are not linearly mapped to output section. For each input
 // offset, we need to find a section piece containing the offset and
@@ -448,17 +513,39 @@ private:
   size_t i = 0;
 };
 
+// A diagnostic reported while scanning a section.
+struct ScanDiag {
+  enum Kind : uint8_t { Error, ErrorOrWarn, Warn } kind;
+  std::string msg;
+};
+
+// Input sections are scanned in parallel. Everything the scan of a section
+// would change outside of the section itself (symbol flags, dynamic
+// relocations, diagnostics, ...) is recorded in a ScanResult instead, and the
+// results are applied by applyScanResult() in the order of the input sections.
+// This makes the output identical to a serial scan.
+struct ScanResult {
+  SmallVector<std::pair<Symbol *, uint16_t>, 0> symbolFlags;
+  SmallVector<std::pair<RelocationBaseSection *, DynamicReloc>, 0> dynRelocs;
+  SmallVector<std::pair<RelrBaseSection *, RelativeReloc>, 0> relrRelocs;
+  std::vector<UndefinedDiag> undefs;
+  SmallVector<ScanDiag, 0> diags;
+  bool hasGotOffRel = false;
+  bool hasGotPltOffRel = false;
+};
+
 // This class encapsulates states needed to scan relocations for one
 // InputSectionBase.
 class RelocationScanner {
 public:
-  explicit RelocationScanner(InputSectionBase &sec)
-      : sec(sec), getter(sec), config(elf::config.get()), target(*elf::target) {
-  }
+  RelocationScanner(InputSectionBase &sec, ScanResult &result)
+      : sec(sec), result(result), getter(sec), config(elf::config.get()),
+        target(*elf::target) {}
   template <class ELFT, class RelTy> void scan(ArrayRef<RelTy> rels);
 
 private:
   InputSectionBase &sec;
+  ScanResult &result;
   OffsetGetter getter;
   const Configuration *const config;
   const TargetInfo &target;
@@ -475,7 +562,30 @@ private:
                                 uint64_t relOff) const;
   void processAux(RelExpr expr, RelType type, uint64_t offset, Symbol &sym,
                   int64_t addend) const;
+  unsigned handleMipsTlsRelocation(RelType type, Symbol &sym, uint64_t offset,
+                                   int64_t addend, RelExpr expr) const;
+  unsigned handleTlsRelocation(RelType type, Symbol &sym, uint64_t offset,
+                               int64_t addend, RelExpr expr) const;
   template <class ELFT, class RelTy> void scanOne(RelTy *&i);
+
+  bool maybeReportUndefined(Undefined &sym, uint64_t offset) const;
+  void setFlags(Symbol &sym, uint16_t flags) const;
+  void addSymbolReloc(RelocationBaseSection &relSec, RelType dynType,
+                      uint64_t offset, Symbol &sym, int64_t addend,
+                      RelType addendRelType) const;
+  void addRelativeReloc(uint64_t offset, Symbol &sym, int64_t addend,
+                        RelExpr expr, RelType type) const;
+
+  // Diagnostics are recorded in the ScanResult, see ScanDiag.
+  void error(const Twine &msg) const {
+    result.diags.push_back({ScanDiag::Error, msg.str()});
+  }
+  void errorOrWarn(const Twine &msg) const {
+    result.diags.push_back({ScanDiag::ErrorOrWarn, msg.str()});
+  }
+  void warn(const Twine &msg) const {
+    result.diags.push_back({ScanDiag::Warn, msg.str()});
+  }
 };
 } // namespace
 
@@ -572,21 +682,6 @@ static std::string maybeReportDiscarded(Undefined &sym) {
   return msg;
 }
 
-// Undefined diagnostics are collected in a vector and emitted once all of
-// them are known, so that some postprocessing on the list of undefined symbols
-// can happen before lld emits diagnostics.
-struct UndefinedDiag {
-  Undefined *sym;
-  struct Loc {
-    InputSectionBase *sec;
-    uint64_t offset;
-  };
-  std::vector<Loc> locs;
-  bool isWarning;
-};
-
-static std::vector<UndefinedDiag> undefs;
-
 // Check whether the definition name def is a mangled function name that matches
 // the reference name ref.
 static bool canSuggestExternCForCXX(StringRef ref, StringRef def) {
@@ -810,12 +905,12 @@ template <class ELFT> void elf::reportUndefinedSymbols() {
 
 // Report an undefined symbol if necessary.
 // Returns true if the undefined symbol will produce an error message.
-static bool maybeReportUndefined(Undefined &sym, InputSectionBase &sec,
-                                 uint64_t offset) {
+bool RelocationScanner::maybeReportUndefined(Undefined &sym,
+                                             uint64_t offset) const {
   // If versioned, issue an error (even if the symbol is weak) because we don't
   // know the defining filename which is required to construct a Verneed entry.
   if (sym.hasVersionSuffix) {
-    undefs.push_back({&sym, {{&sec, offset}}, false});
+    result.undefs.push_back({&sym, {{&sec, offset}}, false});
     return true;
   }
   if (sym.isWeak())
@@ -840,10 +935,53 @@ static bool maybeReportUndefined(Undefined &sym, InputSectionBase &sec,
   bool isWarning =
       (config->unresolvedSymbols == UnresolvedPolicy::Warn && canBeExternal) ||
       config->noinhibitExec;
-  undefs.push_back({&sym, {{&sec, offset}}, isWarning});
+  result.undefs.push_back({&sym, {{&sec, offset}}, isWarning});
   return !isWarning;
 }
 
+// Records that the flags of a symbol need to be set. The symbols are only
+// modified by applyScanResult() once all sections are scanned, so they can be
+// read here without synchronization.
+void RelocationScanner::setFlags(Symbol &sym, uint16_t flags) const {
+  if ((getScanFlags(sym) & flags) == flags)
+    return;
+  if (!result.symbolFlags.empty() && result.symbolFlags.back().first == &sym)
+    result.symbolFlags.back().second |= flags;
+  else
+    result.symbolFlags.push_back({&sym, flags});
+}
+
+void RelocationScanner::addSymbolReloc(RelocationBaseSection &relSec,
+                                       RelType dynType, uint64_t offset,
+                                       Symbol &sym, int64_t addend,
+                                       RelType addendRelType) const {
+  result.dynRelocs.push_back(
+      {&relSec,
+       RelocationBaseSection::makeReloc(DynamicReloc::AgainstSymbol, dynType,
+                                        sec, offset, sym, addend, R_ADDEND,
+                                        addendRelType)});
+}
+
+// Same as the addRelativeReloc() below, but for a relocation of the scanned
+// section.
+void RelocationScanner::addRelativeReloc(uint64_t offset, Symbol &sym,
+                                         int64_t addend, RelExpr expr,
+                                         RelType type) const {
+  Partition &part = sec.getPartition();
+  if (canUseRelr(part, sec, offset)) {
+    sec.relocations.push_back({expr, type, offset, addend, &sym});
+    result.relrRelocs.push_back({part.relrDyn.get(), {&sec, offset}});
+    return;
+  }
+  assert((!sym.isPreemptible || expr == R_GOT) &&
+         "cannot add relative relocation against preemptible symbol");
+  result.dynRelocs.push_back(
+      {part.relaDyn.get(),
+       RelocationBaseSection::makeReloc(DynamicReloc::AddendOnlyWithTargetVA,
+                                        target.relativeRel, sec, offset, sym,
+                                        addend, expr, type)});
+}
+
 // MIPS N32 ABI treats series of successive relocations with the same offset
 // as a single relocation. The similar approach used by N64 ABI, but this ABI
 // packs all relocations into the single relocation record. Here we emulate
@@ -868,10 +1006,7 @@ static void addRelativeReloc(InputSectionBase &isec, uint64_t offsetInSec,
   // Add a relative relocation. If relrDyn section is enabled, and the
   // relocation offset is guaranteed to be even, add the relocation to
   // the relrDyn section, otherwise add it to the relaDyn section.
-  // relrDyn sections don't support odd offsets. Also, relrDyn sections
-  // don't store the addend values, so we must write it to the relocated
-  // address.
-  if (part.relrDyn && isec.alignment >= 2 && offsetInSec % 2 == 0) {
+  if (canUseRelr(part, isec, offsetInSec)) {
     isec.relocations.push_back({expr, type, offsetInSec, addend, &sym});
     part.relrDyn->relocs.push_back({&isec, offsetInSec});
     return;
@@ -1046,13 +1181,13 @@ void RelocationScanner::processAux(RelExpr expr, RelType type, uint64_t offset,
   if (canWrite) {
     RelType rel = target.getDynRel(type);
     if (expr == R_GOT || (rel == target.symbolicRel && !sym.isPreemptible)) {
-      addRelativeReloc(sec, offset, sym, addend, expr, type);
+      addRelativeReloc(offset, sym, addend, expr, type);
       return;
     } else if (rel != 0) {
       if (config->emachine == EM_MIPS && rel == target.symbolicRel)
         rel = target.relativeRel;
-      sec.getPartition().relaDyn->addSymbolReloc(rel, sec, offset, sym, addend,
-                                                 type);
+      addSymbolReloc(*sec.getPartition().relaDyn, rel, offset, sym, addend,
+                     type);
 
       // MIPS ABI turns using of GOT and dynamic relocations inside out.
       // While regular ABI uses dynamic relocations to fill up GOT entries
@@ -1092,7 +1227,7 @@ void RelocationScanner::processAux(RelExpr expr, RelType type, uint64_t offset,
                 " against symbol '" + toString(*ss) +
                 "'; recompile with -fPIC or remove '-z nocopyreloc'" +
                 getLocation(sec, sym, offset));
-        sym.needsCopy = true;
+        setFlags(sym, NEEDS_COPY);
       }
       sec.relocations.push_back({expr, type, offset, addend, &sym});
       return;
@@ -1130,8 +1265,7 @@ void RelocationScanner::processAux(RelExpr expr, RelType type, uint64_t offset,
         errorOrWarn("symbol '" + toString(sym) +
                     "' cannot be preempted; recompile with -fPIE" +
                     getLocation(sec, sym, offset));
-      sym.needsCopy = true;
-      sym.needsPlt = true;
+      setFlags(sym, NEEDS_COPY | NEEDS_PLT);
       sec.relocations.push_back({expr, type, offset, addend, &sym});
       return;
     }
@@ -1149,17 +1283,18 @@ void RelocationScanner::processAux(RelExpr expr, RelType type, uint64_t offset,
 // pollute other `handleTlsRelocation` by MIPS `ifs` statements.
 // Mips has a custom MipsGotSection that handles the writing of GOT entries
 // without dynamic relocations.
-static unsigned handleMipsTlsRelocation(RelType type, Symbol &sym,
-                                        InputSectionBase &c, uint64_t offset,
-                                        int64_t addend, RelExpr expr) {
+unsigned RelocationScanner::handleMipsTlsRelocation(RelType type, Symbol &sym,
+                                                    uint64_t offset,
+                                                    int64_t addend,
+                                                    RelExpr expr) const {
   if (expr == R_MIPS_TLSLD) {
-    in.mipsGot->addTlsIndex(*c.file);
-    c.relocations.push_back({expr, type, offset, addend, &sym});
+    in.mipsGot->addTlsIndex(*sec.file);
+    sec.relocations.push_back({expr, type, offset, addend, &sym});
     return 1;
   }
   if (expr == R_MIPS_TLSGD) {
-    in.mipsGot->addDynTlsEntry(*c.file, sym);
-    c.relocations.push_back({expr, type, offset, addend, &sym});
+    in.mipsGot->addDynTlsEntry(*sec.file, sym);
+    sec.relocations.push_back({expr, type, offset, addend, &sym});
     return 1;
   }
   return 0;
@@ -1172,21 +1307,21 @@ static unsigned handleMipsTlsRelocation(RelType type, Symbol &sym,
 // symbol in TLS block.
 //
 // Returns the number of relocations processed.
-static unsigned handleTlsRelocation(RelType type, Symbol &sym,
-                                    InputSectionBase &c, uint64_t offset,
-                                    int64_t addend, RelExpr expr) {
+unsigned RelocationScanner::handleTlsRelocation(RelType type, Symbol &sym,
+                                                uint64_t offset, int64_t addend,
+                                                RelExpr expr) const {
   if (!sym.isTls())
     return 0;
 
   if (config->emachine == EM_MIPS)
-    return handleMipsTlsRelocation(type, sym, c, offset, addend, expr);
+    return handleMipsTlsRelocation(type, sym, offset, addend, expr);
 
   if (oneof<R_AARCH64_TLSDESC_PAGE, R_TLSDESC, R_TLSDESC_CALL, R_TLSDESC_PC,
             R_TLSDESC_GOTPLT>(expr) &&
       config->shared) {
     if (expr != R_TLSDESC_CALL) {
-      sym.needsTlsDesc = true;
-      c.relocations.push_back({expr, type, offset, addend, &sym});
+      setFlags(sym, NEEDS_TLSDESC);
+      sec.relocations.push_back({expr, type, offset, addend, &sym});
     }
     return 1;
   }
@@ -1197,7 +1332,7 @@ static unsigned handleTlsRelocation(RelType type, Symbol &sym,
   bool toExecRelax = !config->shared && config->emachine != EM_ARM &&
                      config->emachine != EM_HEXAGON &&
                      config->emachine != EM_RISCV &&
-                     !c.file->ppc64DisableTLSRelax;
+                     !sec.file->ppc64DisableTLSRelax;
 
   // If we are producing an executable and the symbol is non-preemptable, it
   // must be defined and the code sequence can be relaxed to use Local-Exec.
@@ -1216,55 +1351,55 @@ static unsigned handleTlsRelocation(RelType type, Symbol &sym,
           expr)) {
     // Local-Dynamic relocs can be relaxed to Local-Exec.
     if (toExecRelax) {
-      c.relocations.push_back(
-          {target->adjustTlsExpr(type, R_RELAX_TLS_LD_TO_LE), type, offset,
+      sec.relocations.push_back(
+          {target.adjustTlsExpr(type, R_RELAX_TLS_LD_TO_LE), type, offset,
            addend, &sym});
-      return target->getTlsGdRelaxSkip(type);
+      return target.getTlsGdRelaxSkip(type);
     }
     if (expr == R_TLSLD_HINT)
       return 1;
-    sym.needsTlsLd = true;
-    c.relocations.push_back({expr, type, offset, addend, &sym});
+    setFlags(sym, NEEDS_TLSLD);
+    sec.relocations.push_back({expr, type, offset, addend, &sym});
     return 1;
   }
 
   // Local-Dynamic relocs can be relaxed to Local-Exec.
   if (expr == R_DTPREL) {
     if (toExecRelax)
-      expr = target->adjustTlsExpr(type, R_RELAX_TLS_LD_TO_LE);
-    c.relocations.push_back({expr, type, offset, addend, &sym});
+      expr = target.adjustTlsExpr(type, R_RELAX_TLS_LD_TO_LE);
+    sec.relocations.push_back({expr, type, offset, addend, &sym});
     return 1;
   }
 
   // Local-Dynamic sequence where offset of tls variable relative to dynamic
   // thread pointer is stored in the got. This cannot be relaxed to Local-Exec.
   if (expr == R_TLSLD_GOT_OFF) {
-    sym.needsGotDtprel = true;
-    c.relocations.push_back({expr, type, offset, addend, &sym});
+    setFlags(sym, NEEDS_GOT_DTPREL);
+    sec.relocations.push_back({expr, type, offset, addend, &sym});
     return 1;
   }
 
   if (oneof<R_AARCH64_TLSDESC_PAGE, R_TLSDESC, R_TLSDESC_CALL, R_TLSDESC_PC,
             R_TLSDESC_GOTPLT, R_TLSGD_GOT, R_TLSGD_GOTPLT, R_TLSGD_PC>(expr)) {
     if (!toExecRelax) {
-      sym.needsTlsGd = true;
-      c.relocations.push_back({expr, type, offset, addend, &sym});
+      setFlags(sym, NEEDS_TLSGD);
+      sec.relocations.push_back({expr, type, offset, addend, &sym});
       return 1;
     }
 
     // Global-Dynamic relocs can be relaxed to Initial-Exec or Local-Exec
     // depending on the symbol being locally defined or not.
     if (sym.isPreemptible) {
-      sym.needsTlsGdToIe = true;
-      c.relocations.push_back(
-          {target->adjustTlsExpr(type, R_RELAX_TLS_GD_TO_IE), type, offset,
+      setFlags(sym, NEEDS_TLSGD_TO_IE);
+      sec.relocations.push_back(
+          {target.adjustTlsExpr(type, R_RELAX_TLS_GD_TO_IE), type, offset,
            addend, &sym});
     } else {
-      c.relocations.push_back(
-          {target->adjustTlsExpr(type, R_RELAX_TLS_GD_TO_LE), type, offset,
+      sec.relocations.push_back(
+          {target.adjustTlsExpr(type, R_RELAX_TLS_GD_TO_LE), type, offset,
            addend, &sym});
     }
-    return target->getTlsGdRelaxSkip(type);
+    return target.getTlsGdRelaxSkip(type);
   }
 
   if (oneof<R_GOT, R_GOTPLT, R_GOT_PC, R_AARCH64_GOT_PAGE_PC, R_GOT_OFF,
@@ -1272,15 +1407,15 @@ static unsigned handleTlsRelocation(RelType type, Symbol &sym,
     // Initial-Exec relocs can be relaxed to Local-Exec if the symbol is locally
     // defined.
     if (toExecRelax && isLocalInExecutable) {
-      c.relocations.push_back(
+      sec.relocations.push_back(
           {R_RELAX_TLS_IE_TO_LE, type, offset, addend, &sym});
     } else if (expr != R_TLSIE_HINT) {
-      sym.needsTlsIe = true;
+      setFlags(sym, NEEDS_TLSIE);
       // R_GOT needs a relative relocation for PIC on i386 and Hexagon.
-      if (expr == R_GOT && config->isPic && !target->usesOnlyLowPageBits(type))
-        addRelativeReloc(c, offset, sym, addend, expr, type);
+      if (expr == R_GOT && config->isPic && !target.usesOnlyLowPageBits(type))
+        addRelativeReloc(offset, sym, addend, expr, type);
       else
-        c.relocations.push_back({expr, type, offset, addend, &sym});
+        sec.relocations.push_back({expr, type, offset, addend, &sym});
     }
     return 1;
   }
@@ -1310,7 +1445,7 @@ template <class ELFT, class RelTy> void RelocationScanner::scanOne(RelTy *&i) {
   // Error if the target symbol is undefined. Symbol index 0 may be used by
   // marker relocations, e.g. R_*_NONE and R_ARM_V4BX. Don't error on them.
   if (sym.isUndefined() && symIndex != 0 &&
-      maybeReportUndefined(cast<Undefined>(sym), sec, offset))
+      maybeReportUndefined(cast<Undefined>(sym), offset))
     return;
 
   const uint8_t *relocatedAddr = sec.data().begin() + offset;
@@ -1363,10 +1498,10 @@ template <class ELFT, class RelTy> void RelocationScanner::scanOne(RelTy *&i) {
   // The 5 types that relative GOTPLT are all x86 and x86-64 specific.
   if (oneof<R_GOTPLTONLY_PC, R_GOTPLTREL, R_GOTPLT, R_PLT_GOTPLT,
             R_TLSDESC_GOTPLT, R_TLSGD_GOTPLT>(expr)) {
-    in.gotPlt->hasGotPltOffRel = true;
+    result.hasGotPltOffRel = true;
   } else if (oneof<R_GOTONLY_PC, R_GOTREL, R_PPC32_PLTREL, R_PPC64_TOCBASE,
                    R_PPC64_RELAX_TOC>(expr)) {
-    in.got->hasGotOffRel = true;
+    result.hasGotOffRel = true;
   }
 
   // Process TLS relocations, including relaxing TLS relocations. Note that
@@ -1379,7 +1514,7 @@ template <class ELFT, class RelTy> void RelocationScanner::scanOne(RelTy *&i) {
       return;
     }
   } else if (unsigned processed =
-                 handleTlsRelocation(type, sym, sec, offset, addend, expr)) {
+                 handleTlsRelocation(type, sym, offset, addend, expr)) {
     i += (processed - 1);
     return;
   }
@@ -1413,8 +1548,8 @@ template <class ELFT, class RelTy> void RelocationScanner::scanOne(RelTy *&i) {
   // We were asked not to generate PLT entries for ifuncs. Instead, pass the
   // direct relocation on through.
   if (sym.isGnuIFunc() && config->zIfuncNoplt) {
-    sym.exportDynamic = true;
-    mainPart->relaDyn->addSymbolReloc(type, sec, offset, sym, addend, type);
+    setFlags(sym, EXPORT_DYNAMIC);
+    addSymbolReloc(*mainPart->relaDyn, type, offset, sym, addend, type);
     return;
   }
 
@@ -1429,12 +1564,12 @@ template <class ELFT, class RelTy> void RelocationScanner::scanOne(RelTy *&i) {
       // ftp://www.linux-mips.org/pub/linux/mips/doc/ABI/mipsabi.pdf
       in.mipsGot->addEntry(*sec.file, sym, addend, expr);
     } else {
-      sym.needsGot = true;
+      setFlags(sym, NEEDS_GOT);
     }
   } else if (needsPlt(expr)) {
-    sym.needsPlt = true;
+    setFlags(sym, NEEDS_PLT);
   } else {
-    sym.hasDirectReloc = true;
+    setFlags(sym, HAS_DIRECT_RELOC);
   }
 
   processAux(expr, type, offset, sym, addend);
@@ -1506,8 +1641,9 @@ void RelocationScanner::scan(ArrayRef<RelTy> rels) {
                       });
 }
 
-template <class ELFT> void elf::scanRelocations(InputSectionBase &s) {
-  RelocationScanner scanner(s);
+template <class ELFT>
+static void scanSection(InputSectionBase &s, ScanResult &result) {
+  RelocationScanner scanner(s, result);
   const RelsOrRelas<ELFT> rels = s.template relsOrRelas<ELFT>();
   if (rels.areRelocsRel())
     scanner.template scan<ELFT>(rels.rels);
@@ -1515,6 +1651,79 @@ template <class ELFT> void elf::scanRelocations(InputSectionBase &s) {
     scanner.template scan<ELFT>(rels.relas);
 }
 
+static void applyScanResult(ScanResult &result) {
+  for (const ScanDiag &diag : result.diags) {
+    switch (diag.kind) {
+    case ScanDiag::Error:
+      error(diag.msg);
+      break;
+    case ScanDiag::ErrorOrWarn:
+      errorOrWarn(diag.msg);
+      break;
+    case ScanDiag::Warn:
+      warn(diag.msg);
+      break;
+    }
+  }
+  for (const std::pair<Symbol *, uint16_t> &p : result.symbolFlags)
+    applyScanFlags(*p.first, p.second);
+  for (const std::pair<RelocationBaseSection *, DynamicReloc> &p :
+       result.dynRelocs)
+    p.first->addReloc(p.second);
+  for (const std::pair<RelrBaseSection *, RelativeReloc> &p :
+       result.relrRelocs)
+    p.first->relocs.push_back(p.second);
+  undefs.insert(undefs.end(), std::make_move_iterator(result.undefs.begin()),
+                std::make_move_iterator(result.undefs.end()));
+  if (result.hasGotOffRel)
+    in.got->hasGotOffRel = true;
+  if (result.hasGotPltOffRel)
+    in.gotPlt->hasGotPltOffRel = true;
+}
+
+template <class ELFT> void elf::scanRelocations() {
+  // Scan all relocations. Each relocation goes through a series of tests to
+  // determine if it needs special treatment, such as creating GOT, PLT,
+  // copy relocations, etc. Note that relocations for non-alloc sections are
+  // directly processed by InputSection::relocateNonAlloc.
+  SmallVector<InputSectionBase *, 0> sections;
+  for (InputSectionBase *sec : inputSections)
+    if (sec->isLive() && isa<InputSection>(sec) && (sec->flags & SHF_ALLOC))
+      sections.push_back(sec);
+  for (Partition &part : partitions) {
+    for (EhInputSection *sec : part.ehFrame->sections)
+      sections.push_back(sec);
+    if (part.armExidx && part.armExidx->isLive())
+      for (InputSection *sec : part.armExidx->exidxSections)
+        sections.push_back(sec);
+  }
+
+  // The MIPS GOT and the PPC64 TOC relaxation state (ppc64noTocRelax and the
+  // per-file flags) are updated directly while scanning, so scan these
+  // serially.
+  if (config->emachine == EM_MIPS || config->emachine == EM_PPC64) {
+    for (InputSectionBase *sec : sections) {
+      ScanResult result;
+      scanSection<ELFT>(*sec, result);
+      applyScanResult(result);
+    }
+    return;
+  }
+
+  // Scan consecutive sections into the same result, so that the number of
+  // results stays small for links with many small sections.
+  constexpr size_t sectionsPerShard = 64;
+  const size_t numShards = divideCeil(sections.size(), sectionsPerShard);
+  std::vector<ScanResult> results(numShards);
+  parallelForEachN(0, numShards, [&](size_t i) {
+    size_t end = std::min((i + 1) * sectionsPerShard, sections.size());
+    for (size_t j = i * sectionsPerShard; j != end; ++j)
+      scanSection<ELFT>(*sections[j], results[i]);
+  });
+  for (ScanResult &result : results)
+    applyScanResult(result);
+}
+
 static bool handleNonPreemptibleIfunc(Symbol &sym) {
   // Handle a reference to a non-preemptible ifunc. These are special in a
   // few ways:
@@ -2217,10 +2426,10 @@ void elf::hexagonTLSSymbolUpdate(ArrayRef<OutputSection *> outputSections) {
       });
 }
 
-template void elf::scanRelocations<ELF32LE>(InputSectionBase &);
-template void elf::scanRelocations<ELF32BE>(InputSectionBase &);
-template void elf::scanRelocations<ELF64LE>(InputSectionBase &);
-template void elf::scanRelocations<ELF64BE>(InputSectionBase &);
+template void elf::scanRelocations<ELF32LE>();
+template void elf::scanRelocations<ELF32BE>();
+template void elf::scanRelocations<ELF64LE>();
+template void elf::scanRelocations<ELF64BE>();
 template void elf::reportUndefinedSymbols<ELF32LE>();
 template void elf::reportUndefinedSymbols<ELF32BE>();
 template void elf::reportUndefinedSymbols<ELF64LE>();
@@ -123,10 +123,11 @@ struct JumpInstrMod {
   unsigned size;
 };
 
-// This function writes undefined symbol diagnostics to an internal buffer.
-// Call reportUndefinedSymbols() after calling scanRelocations() to emit
-// the diagnostics.
-template <class ELFT> void scanRelocations(InputSectionBase &);
+// Scans the relocations of all allocatable input sections in parallel. This
+// function writes undefined symbol diagnostics to an internal buffer. Call
+// reportUndefinedSymbols() after calling scanRelocations() to emit the
+// diagnostics.
+template <class ELFT> void scanRelocations();
 void postScanRelocations();
 
 template <class ELFT> void reportUndefinedSymbols();
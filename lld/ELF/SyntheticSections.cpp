@@ -1640,12 +1640,22 @@ void RelocationBaseSection::addReloc(DynamicReloc::Kind kind, RelType dynType,
                                      uint64_t offsetInSec, Symbol &sym,
                                      int64_t addend, RelExpr expr,
                                      RelType addendRelType) {
+  addReloc(makeReloc(kind, dynType, inputSec, offsetInSec, sym, addend, expr,
+                     addendRelType));
+}
+
+DynamicReloc RelocationBaseSection::makeReloc(DynamicReloc::Kind kind,
+                                              RelType dynType,
+                                              InputSectionBase &inputSec,
+                                              uint64_t offsetInSec, Symbol &sym,
+                                              int64_t addend, RelExpr expr,
+                                              RelType addendRelType) {
   // Write the addends to the relocated address if required. We skip
   // it if the written value would be zero.
   if (config->writeAddends && (expr != R_ADDEND || addend != 0))
     inputSec.relocations.push_back(
         {expr, addendRelType, offsetInSec, addend, &sym});
-  addReloc({dynType, &inputSec, offsetInSec, kind, sym, addend, expr});
+  return {dynType, &inputSec, offsetInSec, kind, sym, addend, expr};
 }
 
 void RelocationBaseSection::partitionRels() {
@@ -534,6 +534,15 @@ public:
   void addReloc(DynamicReloc::Kind kind, RelType dynType,
                 InputSectionBase &inputSec, uint64_t offsetInSec, Symbol &sym,
                 int64_t addend, RelExpr expr, RelType addendRelType);
+  /// Write the addend to the relocated address if required like addReloc(),
+  /// but return the dynamic relocation instead of adding it. This is used by
+  /// the relocation scan, which adds the relocations of all input sections in
+  /// a deterministic order once the (parallel) scan is done.
+  static DynamicReloc makeReloc(DynamicReloc::Kind kind, RelType dynType,
+                                InputSectionBase &inputSec,
+                                uint64_t offsetInSec, Symbol &sym,
+                                int64_t addend, RelExpr expr,
+                                RelType addendRelType);
   bool isNeeded() const override { return !relocs.empty(); }
   size_t getSize() const override { return relocs.size() * this->entsize; }
   size_t getRelativeRelocCount() const { return numRelativeRelocs; }
@@ -0,0 +1,33 @@
+# REQUIRES: x86, zstd
+## --compress-debug-sections=zstd compresses non-SHF_ALLOC .debug_* sections
+## into a zstd stream with an ELFCOMPRESS_ZSTD header.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+# RUN: ld.lld %t.o --compress-debug-sections=zstd -o %t
+# RUN: llvm-readelf -S %t | FileCheck %s --check-prefix=SEC
+# RUN: llvm-objdump -s -j .debug_str %t | FileCheck %s --check-prefix=HEX
+# RUN: llvm-dwarfdump --debug-str %t | FileCheck %s --check-prefix=STR
+
+# SEC: .debug_str PROGBITS {{[0-9a-f]+}} {{[0-9a-f]+}} {{[0-9a-f]+}} 01 MSC 0 0 1
+
+## ch_type = ELFCOMPRESS_ZSTD, followed by ch_size, ch_addralign and the zstd
+## frame magic number.
+# HEX:      Contents of section .debug_str:
+# HEX-NEXT: 0000 02000000 00000000 3a000000 00000000
+# HEX-NEXT: 0010 01000000 00000000 28b52ffd
+
+# STR:      .debug_str contents:
+# STR-NEXT: 0x00000000: "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
+# STR-NEXT: 0x0000002f: "BBBBBBBBBB"
+
+# RUN: not ld.lld %t.o --compress-debug-sections=foo -o /dev/null 2>&1 | \
+# RUN:   FileCheck %s --check-prefix=ERR
+# ERR: error: unknown --compress-debug-sections value: foo
+
+.globl _start
+_start:
+  ret
+
+.section .debug_str,"MS",@progbits,1
+  .asciz "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
+  .asciz "BBBBBBBBBB"
@@ -0,0 +1,29 @@
+# REQUIRES: x86
+## Relocations are scanned in parallel, but diagnostics are reported in the
+## order of the input sections regardless of the number of threads.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+# RUN: not ld.lld -shared --error-limit=0 --threads=1 %t.o -o /dev/null 2> %t1.txt
+# RUN: not ld.lld -shared --error-limit=0 --threads=4 %t.o -o /dev/null 2> %t4.txt
+# RUN: cmp %t1.txt %t4.txt
+# RUN: FileCheck %s < %t4.txt
+
+# CHECK:      error: relocation R_X86_64_32 cannot be used against symbol 'foo'; recompile with -fPIC
+# CHECK-NEXT: >>> defined in {{.*}}.o
+# CHECK-NEXT: >>> referenced by {{.*}}.o:(.rodata.0+0x0)
+# CHECK:      >>> referenced by {{.*}}.o:(.rodata.1+0x0)
+# CHECK:      >>> referenced by {{.*}}.o:(.rodata.64+0x0)
+# CHECK:      >>> referenced by {{.*}}.o:(.rodata.255+0x0)
+# CHECK-NOT:  error:
+
+.globl foo
+foo:
+
+.macro sec
+.section .rodata.\@,"a"
+.long foo
+.endm
+
+.rept 256
+sec
+.endr
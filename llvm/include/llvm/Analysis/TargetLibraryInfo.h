@@ -91,6 +91,8 @@ public:
     Accelerate,       // Use Accelerate framework.
     DarwinLibSystemM, // Use Darwin's libsystem_m.
     LIBMVEC_X86,      // GLIBC Vector Math library.
+    LLVMLIBC_X86,     // LLVM libc vector math functions for x86-64.
+    LLVMLIBC_AARCH64, // LLVM libc vector math functions for AArch64.
     MASSV,            // IBM MASS vector library.
     SVML              // Intel short vector math library.
   };
@@ -0,0 +1,94 @@
+//===- FloorHostComputeJIT.h - JIT for host-compute kernels -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// An LLJIT-based in-process JIT for floor host-compute kernel modules (modules
+// with a Triple::FloorHostCompute target triple), with an optional on-disk
+// cache of the compiled objects.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_EXECUTIONENGINE_ORC_FLOORHOSTCOMPUTEJIT_H
+#define LLVM_EXECUTIONENGINE_ORC_FLOORHOSTCOMPUTEJIT_H
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Support/Error.h"
+#include <memory>
+#include <string>
+
+namespace llvm {
+namespace orc {
+
+class LLJIT;
+class FloorHostComputeObjectCache;
+
+/// JIT-compiles floor host-compute kernel modules in-process and resolves
+/// their entry points by kernel name.
+///
+/// Objects are linked with the JITLink-based ObjectLinkingLayer. If a cache
+/// directory is specified, compiled objects are stored in it, keyed by a hash
+/// of the module bitcode and the target configuration, and are reused instead
+/// of compiling the module again.
+class FloorHostComputeJIT {
+public:
+  struct Options {
+    /// Target triple, defaults to the host triple with a FloorHostCompute
+    /// environment.
+    Optional<Triple> TargetTriple;
+    /// Target CPU, defaults to the host CPU.
+    std::string CPU;
+    /// Target features, defaults to the host features.
+    std::string Features;
+    CodeGenOpt::Level OptLevel = CodeGenOpt::Aggressive;
+    /// Number of threads used to compile modules (0: compile on the thread
+    /// that looks up a kernel).
+    unsigned NumCompileThreads = 0;
+    /// If non-empty, compiled objects are cached in this directory.
+    std::string CacheDir;
+  };
+
+  static Expected<std::unique_ptr<FloorHostComputeJIT>> Create(Options Opts);
+  static Expected<std::unique_ptr<FloorHostComputeJIT>> Create() {
+    return Create(Options());
+  }
+
+  ~FloorHostComputeJIT();
+
+  /// Defines symbols (e.g. host-compute runtime functions) that kernels may
+  /// reference, in addition to all symbols of the current process.
+  Error addRuntimeSymbols(const StringMap<void *> &Symbols);
+
+  /// Adds a host-compute module. The module is compiled (or loaded from the
+  /// object cache) when one of its kernels is looked up first.
+  Error addModule(ThreadSafeModule TSM);
+
+  /// Returns the address of the kernel with the specified (IR) name.
+  Expected<void *> getKernel(StringRef Name);
+
+  /// Returns the cache key of a module, i.e. a hash of its bitcode and the
+  /// target configuration of this JIT.
+  std::string getCacheKey(const Module &M) const;
+
+  LLJIT &getLLJIT() { return *J; }
+
+private:
+  FloorHostComputeJIT(Options Opts);
+
+  Options Opts;
+  std::unique_ptr<FloorHostComputeObjectCache> Cache;
+  std::unique_ptr<LLJIT> J;
+};
+
+} // end namespace orc
+} // end namespace llvm
+
+#endif // LLVM_EXECUTIONENGINE_ORC_FLOORHOSTCOMPUTEJIT_H
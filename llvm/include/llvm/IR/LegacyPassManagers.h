@@ -308,6 +308,12 @@ public:
   /// verifyPreservedAnalysis -- Verify analysis presreved by pass P.
   void verifyPreservedAnalysis(Pass *P);
 
+  /// Incrementally verify the IR changed by pass P (the specified functions
+  /// and, if M is non-null, the module-level IR of M), if enabled by
+  /// -verify-each-incremental.
+  void verifyChangedIR(Pass *P, ArrayRef<const Function *> Fs,
+                       const Module *M = nullptr);
+
   /// Remove Analysis that is not preserved by the pass
   void removeNotPreservedAnalysis(Pass *P);
 
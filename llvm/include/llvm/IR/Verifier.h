@@ -20,6 +20,7 @@
 #ifndef LLVM_IR_VERIFIER_H
 #define LLVM_IR_VERIFIER_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/PassManager.h"
 #include <utility>
@@ -87,6 +88,21 @@ public:
 /// returned.
 bool verifyFunction(const Function &F, raw_ostream *OS = nullptr);
 
+/// Check the specified functions for errors, verifying independent functions
+/// in parallel.
+///
+/// All functions must belong to modules that are not modified concurrently.
+/// Error messages are written to OS (if non-null) in the order of \p Fs.
+/// \return true if any of the functions is broken.
+bool verifyFunctions(ArrayRef<const Function *> Fs, raw_ostream *OS = nullptr);
+
+/// Check the module-level IR (globals, aliases, named metadata, debug info
+/// compile units, ...) of a module for errors, without verifying the bodies
+/// of its functions.
+///
+/// \return true if the module-level IR is broken.
+bool verifyModuleGlobals(const Module &M, raw_ostream *OS = nullptr);
+
 /// Check a module for errors.
 ///
 /// If there are no errors, the function returns false. If an error is
@@ -490,6 +490,18 @@ void initializeVulkanPreFinalPass(PassRegistry&);
 void initializeVulkanFinalModuleCleanupPass(PassRegistry&);
 void initializePropagateRangeInfoPass(PassRegistry&);
 void initializeFMACombinerPass(PassRegistry&);
+void initializeFloorResourceUsagePass(PassRegistry&);
+void initializeLocalMemoryOverlayPass(PassRegistry&);
+void initializeKernelWorkGroupSizeVariantsPass(PassRegistry&);
+void initializeConstantLocalSizePass(PassRegistry&);
+void initializeHostComputeWorkGroupLoopsPass(PassRegistry&);
+void initializeSubGroupAtomicAggregationPass(PassRegistry&);
+void initializePromotePrivateArraysPass(PassRegistry&);
+void initializeRelaxedPrecisionDemotionPass(PassRegistry&);
+void initializeRegisterPressureSinkingPass(PassRegistry&);
+void initializeMemoryCoalescingAnalysisPass(PassRegistry&);
+void initializeLocalMemoryBankConflictsPass(PassRegistry&);
+void initializeVulkanStructuredCleanupPass(PassRegistry&);
 
 } // end namespace llvm
 
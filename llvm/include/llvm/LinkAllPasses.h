@@ -270,6 +270,18 @@ namespace {
       (void) llvm::createVulkanFinalModuleCleanupPass();
       (void) llvm::createPropagateRangeInfoPass();
       (void) llvm::createFMACombinerPass();
+      (void) llvm::createFloorResourceUsagePass();
+      (void) llvm::createLocalMemoryOverlayPass();
+      (void) llvm::createKernelWorkGroupSizeVariantsPass();
+      (void) llvm::createConstantLocalSizePass();
+      (void) llvm::createHostComputeWorkGroupLoopsPass();
+      (void) llvm::createSubGroupAtomicAggregationPass();
+      (void) llvm::createPromotePrivateArraysPass();
+      (void) llvm::createRelaxedPrecisionDemotionPass();
+      (void) llvm::createRegisterPressureSinkingPass();
+      (void) llvm::createMemoryCoalescingAnalysisPass();
+      (void) llvm::createLocalMemoryBankConflictsPass();
+      (void) llvm::createVulkanStructuredCleanupPass();
     }
   } ForcePassLinking; // Force link by creating a global definition.
 }
@@ -58,6 +58,8 @@ private:
 
   StringRef SectionData;
   uint64_t DecompressedSize;
+  /// ELF::ELFCOMPRESS_ZLIB or ELF::ELFCOMPRESS_ZSTD.
+  uint32_t CompressionType;
 };
 
 } // end namespace object
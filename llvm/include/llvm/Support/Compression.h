@@ -41,8 +41,47 @@ Error uncompress(StringRef InputBuffer,
 
 uint32_t crc32(StringRef Buffer);
 
+/// Chunked compression: each chunk of the input is compressed independently
+/// (and may thus be compressed concurrently) into a sequence of raw deflate
+/// blocks. A valid zlib stream is formed by ChunkedHeader, followed by all
+/// compressed chunks in order (the last one with \p IsLastChunk set), followed
+/// by the big-endian adler32 checksum of the whole input.
+static constexpr char ChunkedHeader[2] = {0x78, 0x01};
+
+Error compressChunk(StringRef Chunk, SmallVectorImpl<char> &CompressedChunk,
+                    bool IsLastChunk, int Level = DefaultCompression);
+
+uint32_t adler32(StringRef Buffer);
+
+/// Combines the adler32 checksums of two consecutive buffers, where
+/// \p Length2 is the size of the second buffer.
+uint32_t adler32Combine(uint32_t Adler1, uint32_t Adler2, size_t Length2);
+
 }  // End of namespace zlib
 
+namespace zstd {
+
+static constexpr int BestSpeedCompression = 1;
+static constexpr int DefaultCompression = 5;
+static constexpr int BestSizeCompression = 12;
+
+bool isAvailable();
+
+/// Compresses InputBuffer into a single zstd frame. Multiple concatenated
+/// frames form a valid zstd stream, so the input may be compressed in
+/// independent (concurrently compressed) chunks.
+Error compress(StringRef InputBuffer, SmallVectorImpl<char> &CompressedBuffer,
+               int Level = DefaultCompression);
+
+Error uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                 size_t &UncompressedSize);
+
+Error uncompress(StringRef InputBuffer,
+                 SmallVectorImpl<char> &UncompressedBuffer,
+                 size_t UncompressedSize);
+
+}  // End of namespace zstd
+
 } // End of namespace llvm
 
 #endif
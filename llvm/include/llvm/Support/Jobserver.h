@@ -0,0 +1,128 @@
+//===--- Jobserver.h - GNU make jobserver client ----------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file declares the llvm::JobserverClient class.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_JOBSERVER_H
+#define LLVM_SUPPORT_JOBSERVER_H
+
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <condition_variable>
+#include <mutex>
+
+namespace llvm {
+
+/// A client of a GNU make compatible jobserver, as advertised to child
+/// processes via "--jobserver-auth=" (or "--jobserver-fds=") in the MAKEFLAGS
+/// environment variable. Supported are the "R,W" pipe and "fifo:PATH" styles
+/// on Unix and named semaphores on Windows.
+///
+/// Every process started by the jobserver owns one implicit job slot, which is
+/// shared by all thread pools of the process. Any additional concurrent job
+/// must acquire a token from the jobserver first and release it once it is
+/// done. Threads outside of the thread pools (e.g. the main thread) don't hold
+/// a slot, they are expected to mostly wait for the pools while these are busy.
+///
+/// All tokens that are still held are returned to the jobserver on
+/// llvm_shutdown(), so that they don't get lost when exiting via _exit().
+class JobserverClient {
+public:
+  /// Returns the jobserver client of this process, or nullptr if this process
+  /// was not started by a (usable) jobserver or LLVM is configured with
+  /// LLVM_ENABLE_THREADS=OFF.
+  static JobserverClient *getInstance();
+
+  /// Acquires a job slot for the calling thread, blocking until either the
+  /// implicit slot or a token from the jobserver is available. Returns false
+  /// without a slot once \p Cancelled returns true, which is checked (with an
+  /// internal lock held) before blocking and whenever wakeWaiters() is called.
+  /// After shutdown(), this always succeeds without limiting anything.
+  bool acquire(function_ref<bool()> Cancelled);
+
+  /// Returns a slot previously acquired via acquire().
+  void release();
+
+  /// Wakes all threads blocked in acquire(), so that they recheck their
+  /// cancellation condition.
+  void wakeWaiters();
+
+  /// Returns all tokens that are currently held to the jobserver and stops
+  /// limiting the number of jobs. This is called on llvm_shutdown().
+  void shutdown();
+
+  /// Returns the value of the jobserver option in \p MakeFlags (the contents
+  /// of the MAKEFLAGS environment variable), or an empty string if there is
+  /// none.
+  static StringRef getJobserverAuth(StringRef MakeFlags);
+
+  /// Temporarily releases the job slot held by the calling thread (if any)
+  /// while it is blocked waiting for other threads, which may need the slot to
+  /// make progress. The slot is reacquired on destruction.
+  class LentSlot {
+  public:
+    LentSlot();
+    ~LentSlot();
+
+  private:
+    JobserverClient *Client = nullptr;
+  };
+
+  JobserverClient(const JobserverClient &) = delete;
+  JobserverClient &operator=(const JobserverClient &) = delete;
+  ~JobserverClient();
+
+private:
+  JobserverClient() = default;
+
+  enum class ReadResult { Token, Interrupted, Error };
+
+  /// Connects to the jobserver specified by \p Auth. Returns false if the
+  /// jobserver can't be used.
+  bool connect(StringRef Auth);
+
+  /// Blocks until a token could be read from the jobserver or until
+  /// interruptRead() is called.
+  ReadResult readToken(char &Token);
+
+  /// Writes \p Token back to the jobserver.
+  void writeToken(char Token);
+
+  /// Wakes up a thread blocked in readToken().
+  void interruptRead();
+
+  std::mutex Mutex;
+  std::condition_variable WaiterCond;
+  // Tokens read from the jobserver, these must be written back unmodified.
+  SmallVector<char, 16> Tokens;
+  bool ImplicitSlotTaken = false;
+  // Set while a thread is blocked in readToken(), all other threads waiting
+  // for a slot wait on WaiterCond.
+  bool HasReader = false;
+  unsigned NumBlocked = 0;
+  // Set once reading from the jobserver failed, only the implicit slot is
+  // used from then on.
+  bool IsBroken = false;
+  bool IsShutDown = false;
+  int ReadFD = -1;
+  int WriteFD = -1;
+  // Set if ReadFD (and WriteFD for a fifo) has been opened by us.
+  bool OwnsReadFD = false;
+  // Self-pipe used by interruptRead().
+  int WakeFDs[2] = {-1, -1};
+  void *Semaphore = nullptr;
+  void *WakeEvent = nullptr;
+};
+
+} // end namespace llvm
+
+#endif
@@ -9,6 +9,7 @@
 #ifndef LLVM_SUPPORT_PARALLEL_H
 #define LLVM_SUPPORT_PARALLEL_H
 
+#include "llvm/ADT/FunctionExtras.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Error.h"
@@ -16,6 +17,7 @@
 #include "llvm/Support/Threading.h"
 
 #include <algorithm>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
@@ -60,8 +62,23 @@ public:
     std::unique_lock<std::mutex> lock(Mutex);
     Cond.wait(lock, [&] { return Count == 0; });
   }
+
+  /// Waits at most \p Timeout for the count to reach zero. Returns true if it
+  /// did.
+  bool syncFor(std::chrono::microseconds Timeout) const {
+    std::unique_lock<std::mutex> lock(Mutex);
+    return Cond.wait_for(lock, Timeout, [&] { return Count == 0; });
+  }
+
+  bool isDone() const {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Count == 0;
+  }
 };
 
+/// A group of tasks that are run on the default executor. TaskGroups may be
+/// nested: a worker thread waiting for a group (sync() or the destructor) runs
+/// pending tasks instead of blocking.
 class TaskGroup {
   Latch L;
   bool Parallel;
@@ -70,9 +87,9 @@ public:
   TaskGroup();
   ~TaskGroup();
 
-  void spawn(std::function<void()> f);
+  void spawn(unique_function<void()> f);
 
-  void sync() const { L.sync(); }
+  void sync() const;
 };
 
 const ptrdiff_t MinParallelSize = 1024;
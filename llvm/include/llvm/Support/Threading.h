@@ -132,6 +132,14 @@ bool llvm_is_multithreaded();
     // threads, or hardware cores.
     bool Limit = false;
 
+    // If set and this process was started by a GNU make compatible jobserver
+    // (see JobserverClient), the threads of a pool must acquire a job slot
+    // (the implicit slot of the process or a job token) before running tasks.
+    // Slots are released again when a thread runs out of work, so the
+    // effective number of threads follows the budget granted by the build
+    // system.
+    bool UseJobserver = false;
+
     /// Retrieves the max available threads for the current strategy. This
     /// accounts for affinity masks and takes advantage of all CPU sockets.
     unsigned compute_thread_count() const;
@@ -152,6 +160,8 @@ bool llvm_is_multithreaded();
   /// strategy, we attempt to equally allocate the threads on all CPU sockets.
   /// "0" or an empty string will return the \p Default strategy.
   /// "all" for using all hardware threads.
+  /// "jobserver" for using all hardware threads, limited by the job tokens
+  /// granted by a GNU make compatible jobserver (if there is one).
   Optional<ThreadPoolStrategy>
   get_threadpool_strategy(StringRef Num, ThreadPoolStrategy Default = {});
 
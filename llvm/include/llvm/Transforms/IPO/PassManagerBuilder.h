@@ -15,6 +15,7 @@
 #define LLVM_TRANSFORMS_IPO_PASSMANAGERBUILDER_H
 
 #include "llvm-c/Transforms/PassManagerBuilder.h"
+#include "llvm/Transforms/LibFloor.h"
 #include <functional>
 #include <memory>
 #include <string>
@@ -194,10 +195,26 @@ public:
   bool EnableVerifySPIR;
   bool EnableVulkanPasses;
   bool EnableVulkanLLVMPreStructurizationPass;
+  // host-compute: create work-group loop nest variants of all kernels and
+  // optimize them with Polly (if linked in)
+  bool EnableHostComputeWorkGroupLoops;
+  // Metal/Vulkan: demote float dataflow feeding into low precision sinks
+  // (unorm image writes, fragment outputs) to half precision
+  bool EnableRelaxedPrecisionDemotion;
+  // Metal/Vulkan: also treat fragment shader outputs as low precision sinks
+  bool EnableRelaxedPrecisionFragmentOutputs;
 
   // can't rely on clang header here, so just use a uint32_t
   unsigned int floor_image_capabilities { 0 };
 
+  // if set, the static resource usage of all entry points is computed at the
+  // end of the pipeline and reported through this callback
+  FloorResourceUsageCallback floor_resource_usage_cb;
+
+  // for each kernel without a required work-group size, a specialized variant
+  // is created for each of these constant work-group sizes
+  std::vector<std::array<uint32_t, 3>> floor_work_group_size_variants;
+
 private:
   /// ExtensionList - This is list of all of the extensions that are registered.
   std::vector<std::pair<ExtensionPointTy, ExtensionFn>> Extensions;
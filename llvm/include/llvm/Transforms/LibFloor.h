@@ -29,6 +29,8 @@
 #include "llvm/Transforms/Utils/SimplifyCFGOptions.h"
 #include <functional>
 #include <cstdint>
+#include <array>
+#include <vector>
 
 namespace llvm {
 
@@ -138,6 +140,14 @@ FunctionPass *createVulkanPreFinalPass();
 //
 ModulePass *createVulkanFinalModuleCleanupPass();
 
+//===----------------------------------------------------------------------===//
+//
+// VulkanStructuredCleanup - This pass performs structure-preserving cleanups
+// and optimizations (LICM, load/store forwarding, PHI and ladder block
+// simplification) after CFG structurization.
+//
+FunctionPass *createVulkanStructuredCleanupPass();
+
 //===----------------------------------------------------------------------===//
 //
 // PropagateRangeInfo - This pass propagates range metadata info.
@@ -151,6 +161,107 @@ FunctionPass *createPropagateRangeInfoPass();
 //
 FunctionPass *createFMACombinerPass();
 
+//===----------------------------------------------------------------------===//
+//
+// FloorResourceUsage - This pass computes the static resource usage of each
+// kernel/shader entry point (local/private memory, barriers, atomics and an
+// estimated register count) and reports it through the specified callback.
+//
+struct FloorResourceUsageInfo {
+  //! static local/threadgroup memory size in bytes
+  uint64_t local_memory_size { 0u };
+  //! static private/stack memory size in bytes
+  uint64_t private_memory_size { 0u };
+  //! number of barrier calls
+  uint32_t barrier_count { 0u };
+  //! number of atomic operations
+  uint32_t atomic_count { 0u };
+  //! estimated register pressure (max #32-bit registers live at any point)
+  uint32_t register_count { 0u };
+};
+using FloorResourceUsageCallback = std::function<void(const Function&, const FloorResourceUsageInfo&)>;
+ModulePass *createFloorResourceUsagePass(FloorResourceUsageCallback usage_cb = {});
+
+//===----------------------------------------------------------------------===//
+//
+// LocalMemoryOverlay - This pass overlays local memory variables of a kernel
+// whose barrier-delimited lifetimes don't overlap into a single local memory
+// allocation.
+//
+ModulePass *createLocalMemoryOverlayPass();
+
+//===----------------------------------------------------------------------===//
+//
+// KernelWorkGroupSizeVariants - This pass creates a specialized clone of each
+// kernel without a required work-group size for each specified work-group size.
+//
+ModulePass *createKernelWorkGroupSizeVariantsPass(const std::vector<std::array<uint32_t, 3>>& wg_sizes = {});
+
+//===----------------------------------------------------------------------===//
+//
+// ConstantLocalSize - This pass replaces local size builtins in kernels with a
+// required work-group size by constants.
+//
+FunctionPass *createConstantLocalSizePass();
+
+//===----------------------------------------------------------------------===//
+//
+// HostComputeWorkGroupLoops - This pass creates a variant of each host-compute
+// kernel without barriers that executes all work-items of a work-group in a
+// single loop nest.
+//
+ModulePass *createHostComputeWorkGroupLoopsPass();
+
+//===----------------------------------------------------------------------===//
+//
+// SubGroupAtomicAggregation - This pass combines atomic operations on uniform
+// addresses within each sub-group, so that only a single atomic is performed
+// per sub-group.
+//
+FunctionPass *createSubGroupAtomicAggregationPass();
+
+//===----------------------------------------------------------------------===//
+//
+// PromotePrivateArrays - This pass promotes dynamically indexed private arrays
+// in kernels/shaders to registers or work-group local memory.
+// NOTE: each dynamic access of an array promoted to registers costs a select
+// chain over all of its elements (scaling with "register_budget").
+//
+FunctionPass *createPromotePrivateArraysPass(const uint32_t register_budget = 16u,
+                                             const uint32_t local_memory_budget = 16384u);
+
+//===----------------------------------------------------------------------===//
+//
+// RelaxedPrecisionDemotion - This pass demotes float dataflow that feeds into
+// low precision sinks (unorm image writes and, if enabled, fragment outputs) to
+// half precision.
+//
+FunctionPass *createRelaxedPrecisionDemotionPass(const bool fragment_outputs_are_sinks = false);
+
+//===----------------------------------------------------------------------===//
+//
+// RegisterPressureSinking - This pass sinks and rematerializes cheap values
+// next to their uses to reduce the register pressure (Metal/Vulkan).
+//
+FunctionPass *createRegisterPressureSinkingPass(const uint32_t register_target = 64u);
+
+//===----------------------------------------------------------------------===//
+//
+// MemoryCoalescingAnalysis - This pass classifies the access pattern of global
+// memory loads/stores across work-items and emits analysis remarks.
+//
+FunctionPass *createMemoryCoalescingAnalysisPass();
+
+//===----------------------------------------------------------------------===//
+//
+// LocalMemoryBankConflicts - This pass predicts bank conflicts of local memory
+// accesses, emits analysis remarks and optionally pads local memory arrays to
+// avoid them (bank count/width of 0 = backend default).
+//
+ModulePass *createLocalMemoryBankConflictsPass(const bool enable_padding = false,
+                                               const uint32_t bank_count = 0u,
+                                               const uint32_t bank_width = 0u);
+
 } // End llvm namespace
 
 #endif
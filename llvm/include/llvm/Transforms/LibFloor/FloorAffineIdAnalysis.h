@@ -0,0 +1,98 @@
+//===- FloorAffineIdAnalysis.h - affine work-item id analysis ---------------===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the decomposition of values/addresses into affine
+// functions of the work-item id builtins of all GPU backends (CUDA, Metal,
+// OpenCL/SPIR and Vulkan) using SCEV.
+//
+// The "fast" id is the id that differs between neighboring work-items of a
+// sub-group (x dim of the local/global id, sub-group local id), its
+// coefficient determines how neighboring work-items access memory.
+//
+// NOTE: the id builtins are replaced by the final backend passes, so this can
+//       only be used before these have run
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_LIBFLOOR_FLOORAFFINEIDANALYSIS_H
+#define LLVM_TRANSFORMS_LIBFLOOR_FLOORAFFINEIDANALYSIS_H
+
+#include <cstdint>
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/IR/Value.h"
+
+namespace llvm {
+	//! kind of a work-item builtin
+	enum class FLOOR_ID_KIND : uint32_t {
+		//! not an id builtin
+		NONE,
+		//! varies between neighboring work-items in a sub-group (x dim local/global id, sub-group local id)
+		FAST,
+		//! varies between work-items in a work-group, but not between neighboring ones (y/z dim local/global id)
+		SLOW,
+		//! uniform across the work-group/sub-group (group id, sizes, sub-group id)
+		UNIFORM,
+	};
+
+	//! returns the kind of id builtin "V" is (for any backend)
+	FLOOR_ID_KIND get_floor_id_kind(const Value& V);
+
+	//! affine decomposition of a value in terms of the work-item ids
+	struct floor_affine_id_info {
+		//! coefficient of the fast id
+		int64_t fast_stride { 0 };
+		//! fast id coefficient is multiplied by a uniform value that is not known at compile-time
+		bool dynamic_stride { false };
+		//! value depends on the y/z ids
+		bool has_slow_ids { false };
+		//! value is not an affine function of the ids
+		bool non_affine { false };
+
+		bool is_fast_varying() const {
+			return (fast_stride != 0 || dynamic_stride);
+		}
+		bool is_uniform() const {
+			return (!is_fast_varying() && !has_slow_ids && !non_affine);
+		}
+		//! returns true if the fast stride is known at compile-time
+		bool has_const_fast_stride() const {
+			return (!dynamic_stride && !non_affine);
+		}
+		floor_affine_id_info& operator+=(const floor_affine_id_info& info) {
+			fast_stride += info.fast_stride;
+			dynamic_stride |= info.dynamic_stride;
+			has_slow_ids |= info.has_slow_ids;
+			non_affine |= info.non_affine;
+			return *this;
+		}
+	};
+
+	//! decomposes the SCEV expression "S" into an affine function of the ids
+	floor_affine_id_info analyze_floor_affine_id_scev(const SCEV* S);
+
+	//! decomposes the integer value "V" into an affine function of the ids
+	floor_affine_id_info analyze_floor_affine_id_value(ScalarEvolution& SE, Value& V);
+
+	//! decomposes the byte offset of "ptr" relative to its base pointer into an affine function of the ids,
+	//! the base pointer itself must be uniform
+	floor_affine_id_info analyze_floor_affine_id_pointer(ScalarEvolution& SE, Value& ptr);
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_LIBFLOOR_FLOORAFFINEIDANALYSIS_H
@@ -242,8 +242,8 @@ public:
 	InstructionCost getArithmeticReductionCost(unsigned Opcode, VectorType *Ty,
 											   Optional<FastMathFlags> FMF,
 											   TTI::TargetCostKind CostKind) {
-		// for now: penalize reduction ops (TODO: all fadd/fmul to combine to dot product)
-		return crtp_base_class::getArithmeticReductionCost(Opcode, Ty, FMF, CostKind) * 1024;
+		// NOTE: reductions are lowered by MetalFinal/SPIRFinal/VulkanFinal (fadd -> dot product on Metal)
+		return crtp_base_class::getArithmeticReductionCost(Opcode, Ty, FMF, CostKind);
 	}
 	
 	InstructionCost
@@ -0,0 +1,54 @@
+//===- FloorIntrinsicLowering.h - Metal/OpenCL/Vulkan intrinsic lowering --===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the lowering of LLVM intrinsics that are formed by the
+// mid-level optimizer (InstCombine, SLP and loop vectorizer), but that can't
+// be consumed by the Metal, OpenCL/SPIR or Vulkan backends as-is.
+//
+// Each intrinsic is either mapped onto the corresponding backend builtin
+// (air.* for Metal, mangled OpenCL C builtins for SPIR), kept as-is if the
+// backend handles it natively (Vulkan/SPIR-V), or expanded into plain IR.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_LIBFLOOR_FLOORINTRINSICLOWERING_H
+#define LLVM_TRANSFORMS_LIBFLOOR_FLOORINTRINSICLOWERING_H
+
+#include <cstdint>
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/IRBuilder.h"
+
+namespace llvm {
+	enum class FLOOR_INTRINSIC_TARGET : uint32_t {
+		METAL,
+		SPIR,
+		VULKAN,
+	};
+
+	//! lowers the intrinsic "I" for the specified target: on success, "I" has either been replaced and erased,
+	//! or it has been kept as-is, because the target handles it natively
+	//! NOTE: returns false if the intrinsic is not handled for the target or has an unexpected type,
+	//!       in which case "I" is left untouched
+	bool lower_floor_intrinsic(IntrinsicInst &I,
+	                           IRBuilder<> &builder,
+	                           const FLOOR_INTRINSIC_TARGET target);
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_LIBFLOOR_FLOORINTRINSICLOWERING_H
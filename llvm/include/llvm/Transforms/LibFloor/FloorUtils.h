@@ -26,8 +26,21 @@
 #define LLVM_TRANSFORMS_LIBFLOOR_FLOORUTILS_H
 
 #include <functional>
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/Value.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/IntrinsicsNVPTX.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Metadata.h"
 
 namespace libfloor_utils {
 
@@ -201,6 +214,375 @@ static inline bool simplify_gep_indices(llvm::LLVMContext& ctx, llvm::GetElement
 }
 // TODO: should do the same for extractelement/insertelement/extractvalue/insertvalue
 
+//! address space of work-group local/threadgroup/shared memory (identical for CUDA, Metal, OpenCL/SPIR and Vulkan)
+static constexpr const uint32_t local_address_space { 3u };
+//! address space of constant memory (identical for Metal, OpenCL/SPIR and Vulkan)
+static constexpr const uint32_t constant_address_space { 2u };
+
+//! returns true if "F" is a kernel or shader entry point
+static inline bool is_entry_point(const llvm::Function& F) {
+	switch (F.getCallingConv()) {
+		case llvm::CallingConv::FLOOR_KERNEL:
+		case llvm::CallingConv::FLOOR_VERTEX:
+		case llvm::CallingConv::FLOOR_FRAGMENT:
+		case llvm::CallingConv::FLOOR_TESS_CONTROL:
+		case llvm::CallingConv::FLOOR_TESS_EVAL:
+			return true;
+		default:
+			break;
+	}
+	return false;
+}
+
+//! returns true if "CB" is a work-group/sub-group barrier call for any of the floor backends
+static inline bool is_barrier_call(const llvm::CallBase& CB) {
+	if (auto II = dyn_cast<llvm::IntrinsicInst>(&CB); II) {
+		switch (II->getIntrinsicID()) {
+			case llvm::Intrinsic::nvvm_barrier0:
+			case llvm::Intrinsic::nvvm_barrier_sync:
+			case llvm::Intrinsic::nvvm_barrier_sync_cnt:
+			case llvm::Intrinsic::nvvm_bar_sync:
+			case llvm::Intrinsic::nvvm_bar_warp_sync:
+				return true;
+			default:
+				return false;
+		}
+	}
+	const auto called_func = CB.getCalledFunction();
+	if (!called_func || !called_func->hasName()) {
+		return false;
+	}
+	const auto func_name = called_func->getName();
+	return (func_name == "_Z7barrierj" /* OpenCL/SPIR, Vulkan */ ||
+			func_name.startswith("air.wg.barrier") ||
+			func_name.startswith("air.simdgroup.barrier") ||
+			func_name.startswith("floor.barrier") ||
+			func_name.startswith("floor.sub_group_barrier") ||
+			func_name.startswith("host_compute_barrier"));
+}
+
+//! returns true if "CB" is a work-group barrier call (i.e. synchronizes all work-items in a work-group, not just a sub-group)
+static inline bool is_work_group_barrier_call(const llvm::CallBase& CB) {
+	if (!is_barrier_call(CB)) {
+		return false;
+	}
+	if (auto II = dyn_cast<llvm::IntrinsicInst>(&CB); II) {
+		return (II->getIntrinsicID() != llvm::Intrinsic::nvvm_bar_warp_sync);
+	}
+	const auto func_name = CB.getCalledFunction()->getName();
+	return (!func_name.startswith("air.simdgroup.barrier") &&
+			!func_name.startswith("floor.sub_group_barrier"));
+}
+
+//! returns true if "CB" is a work-group barrier call that is known to order local/threadgroup/shared memory accesses,
+//! NOTE: barriers with non-constant or unknown memory fence flags are not considered local memory barriers
+static inline bool is_local_memory_barrier_call(const llvm::CallBase& CB) {
+	if (!is_work_group_barrier_call(CB)) {
+		return false;
+	}
+	if (llvm::isa<llvm::IntrinsicInst>(&CB)) {
+		// CUDA: bar.sync/barrier.sync always order all memory accesses of the CTA
+		return true;
+	}
+	const auto func_name = CB.getCalledFunction()->getName();
+	if (func_name.startswith("host_compute_barrier")) {
+		// Host-Compute: all memory is coherent at a barrier
+		return true;
+	}
+	const auto get_const_flags = [&CB]() -> std::optional<uint64_t> {
+		if (CB.arg_size() == 0) {
+			return {};
+		}
+		if (const auto flags = llvm::dyn_cast<llvm::ConstantInt>(CB.getArgOperand(0)); flags) {
+			return flags->getZExtValue();
+		}
+		return {};
+	};
+	if (func_name == "_Z7barrierj") {
+		// OpenCL/SPIR, Vulkan: CLK_LOCAL_MEM_FENCE == 1
+		const auto flags = get_const_flags();
+		return (flags && (*flags & 0x1u) != 0u);
+	}
+	if (func_name.startswith("air.wg.barrier")) {
+		// Metal: mem_flags::mem_threadgroup == 2
+		const auto flags = get_const_flags();
+		return (flags && (*flags & 0x2u) != 0u);
+	}
+	// unknown semantics
+	return false;
+}
+
+//! returns true if "I" is a CFG structurization header marker call (floor.loop_merge or floor.selection_merge),
+//! NOTE: these must always directly precede the terminator of their block
+static inline bool is_cfg_header_marker_call(const llvm::Instruction& I) {
+	const auto CI = dyn_cast<llvm::CallInst>(&I);
+	if (!CI || !CI->getCalledFunction()) {
+		return false;
+	}
+	const auto func_name = CI->getCalledFunction()->getName();
+	return (func_name == "floor.loop_merge" || func_name == "floor.selection_merge");
+}
+
+//! returns true if "I" is any CFG structurization marker call (loop/selection merge, merge block or continue block marker)
+static inline bool is_cfg_marker_call(const llvm::Instruction& I) {
+	if (is_cfg_header_marker_call(I)) {
+		return true;
+	}
+	const auto CI = dyn_cast<llvm::CallInst>(&I);
+	if (!CI || !CI->getCalledFunction()) {
+		return false;
+	}
+	const auto func_name = CI->getCalledFunction()->getName();
+	return (func_name == "floor.merge_block" || func_name == "floor.continue_block");
+}
+
+//! returns true if "BB" is referenced by a CFG structurization marker (i.e. is a merge or continue block)
+static inline bool is_cfg_marker_referenced(const llvm::BasicBlock& BB) {
+	for (const auto user : BB.users()) {
+		if (const auto instr = dyn_cast<llvm::Instruction>(user); instr && is_cfg_header_marker_call(*instr)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//! returns the instruction before which new instructions can be inserted at the end of "BB"
+//! (i.e. before any trailing CFG structurization marker calls, or the terminator otherwise)
+static inline llvm::Instruction* get_cfg_marker_safe_insert_point(llvm::BasicBlock& BB) {
+	llvm::Instruction* insert_point = BB.getTerminator();
+	while (auto prev = insert_point->getPrevNode()) {
+		if (!is_cfg_marker_call(*prev)) {
+			break;
+		}
+		insert_point = prev;
+	}
+	return insert_point;
+}
+
+//! returns true if "BB" ends in a CFG structurization marker call (directly before its terminator)
+static inline bool has_trailing_cfg_marker(const llvm::BasicBlock& BB) {
+	const auto term = BB.getTerminator();
+	const auto prev = (term ? term->getPrevNode() : nullptr);
+	return (prev && is_cfg_marker_call(*prev));
+}
+
+//! returns true if "I" is an atomic memory operation (either an LLVM atomic instruction or a backend atomic function call)
+static inline bool is_atomic_op(const llvm::Instruction& I) {
+	if (isa<llvm::AtomicRMWInst>(I) || isa<llvm::AtomicCmpXchgInst>(I)) {
+		return true;
+	}
+	if (auto LI = dyn_cast<llvm::LoadInst>(&I); LI) {
+		return LI->isAtomic();
+	}
+	if (auto SI = dyn_cast<llvm::StoreInst>(&I); SI) {
+		return SI->isAtomic();
+	}
+	if (auto CB = dyn_cast<llvm::CallBase>(&I); CB) {
+		const auto called_func = CB->getCalledFunction();
+		if (!called_func || !called_func->hasName()) {
+			return false;
+		}
+		const auto func_name = called_func->getName();
+		return (func_name.startswith("air.atomic.") ||
+				func_name.startswith("floor.atomic") ||
+				func_name.startswith("llvm.nvvm.atomic.") ||
+				(func_name.startswith("_Z") && func_name.contains("atomic_") /* OpenCL/SPIR, Vulkan */));
+	}
+	return false;
+}
+
+//! returns the number of 32-bit registers that are necessary to hold a value of type "type" (0 if none)
+static inline uint32_t get_register_count(const llvm::Type* type) {
+	if (type->isVoidTy() || type->isLabelTy() || type->isMetadataTy() || type->isTokenTy()) {
+		return 0;
+	}
+	if (auto vec_type = dyn_cast<llvm::FixedVectorType>(type); vec_type) {
+		return vec_type->getNumElements() * get_register_count(vec_type->getElementType());
+	}
+	if (auto arr_type = dyn_cast<llvm::ArrayType>(type); arr_type) {
+		return uint32_t(arr_type->getNumElements()) * get_register_count(arr_type->getElementType());
+	}
+	if (auto st_type = dyn_cast<llvm::StructType>(type); st_type) {
+		uint32_t count = 0;
+		for (const auto elem_type : st_type->elements()) {
+			count += get_register_count(elem_type);
+		}
+		return count;
+	}
+	if (type->isPointerTy()) {
+		return 2;
+	}
+	const auto bit_width = type->getPrimitiveSizeInBits().getFixedSize();
+	return std::max(1u, uint32_t((bit_width + 31u) / 32u));
+}
+
+//! returns true if the value "V" must be held in a register
+static inline bool is_register_value(const llvm::Value* V) {
+	return ((isa<llvm::Instruction>(V) || isa<llvm::Argument>(V)) && get_register_count(V->getType()) > 0);
+}
+
+//! register liveness of a single block
+struct block_liveness_t {
+	llvm::DenseSet<const llvm::Value*> live_in;
+	llvm::DenseSet<const llvm::Value*> live_out;
+	//! max number of 32-bit registers that are live at any point in the block
+	uint32_t max_register_count { 0u };
+};
+
+//! register liveness of a whole function
+struct function_liveness_t {
+	//! liveness of all blocks that are reachable from the entry block
+	llvm::DenseMap<const llvm::BasicBlock*, block_liveness_t> blocks;
+	//! max number of 32-bit registers that are live at any point in the function
+	uint32_t max_register_count { 0u };
+};
+
+//! computes the liveness of all register values in "F" and estimates the register pressure,
+//! i.e. the max number of 32-bit registers that are live at any point in each block
+//! NOTE: PHI operands are treated as uses at the end of the corresponding incoming block
+static inline function_liveness_t compute_register_liveness(const llvm::Function& F) {
+	using namespace llvm;
+	
+	// compute per-block upward-exposed uses and defs
+	struct block_info_t {
+		DenseSet<const Value*> uses;
+		DenseSet<const Value*> defs;
+	};
+	DenseMap<const BasicBlock*, block_info_t> block_infos;
+	for (const auto& BB : F) {
+		auto& info = block_infos[&BB];
+		for (const auto& I : BB) {
+			if (!isa<PHINode>(I)) {
+				for (const auto& op : I.operands()) {
+					if (is_register_value(op) && !info.defs.contains(op)) {
+						info.uses.insert(op);
+					}
+				}
+			}
+			if (is_register_value(&I)) {
+				info.defs.insert(&I);
+			}
+		}
+	}
+	
+	// iterate liveness to a fixed point (in post-order for faster convergence)
+	function_liveness_t ret;
+	std::vector<const BasicBlock*> blocks_in_post_order;
+	for (const auto BB : post_order(&F.getEntryBlock())) {
+		blocks_in_post_order.emplace_back(BB);
+		ret.blocks[BB];
+	}
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (const auto BB : blocks_in_post_order) {
+			const auto& info = block_infos[BB];
+			auto& liveness = ret.blocks[BB];
+			DenseSet<const Value*> live_out;
+			for (const auto succ : successors(BB)) {
+				const auto& succ_liveness = ret.blocks[succ];
+				for (const auto V : succ_liveness.live_in) {
+					// values defined by succ PHIs are not live-out of this block
+					if (auto phi = dyn_cast<PHINode>(V); phi && phi->getParent() == succ) {
+						continue;
+					}
+					live_out.insert(V);
+				}
+				for (const auto& phi : succ->phis()) {
+					const auto incoming_val = phi.getIncomingValueForBlock(BB);
+					if (incoming_val && is_register_value(incoming_val)) {
+						live_out.insert(incoming_val);
+					}
+				}
+			}
+			
+			DenseSet<const Value*> live_in(info.uses);
+			for (const auto V : live_out) {
+				if (!info.defs.contains(V)) {
+					live_in.insert(V);
+				}
+			}
+			
+			if (live_out.size() != liveness.live_out.size() || live_in.size() != liveness.live_in.size()) {
+				changed = true;
+			}
+			liveness.live_out = std::move(live_out);
+			liveness.live_in = std::move(live_in);
+		}
+	}
+	
+	// walk each block backwards, starting at its live-out set, and track the max register count
+	for (const auto BB : blocks_in_post_order) {
+		auto& liveness = ret.blocks[BB];
+		DenseSet<const Value*> live(liveness.live_out);
+		uint32_t reg_count = 0;
+		for (const auto V : live) {
+			reg_count += get_register_count(V->getType());
+		}
+		uint32_t max_reg_count = reg_count;
+		
+		for (auto instr_iter = BB->rbegin(); instr_iter != BB->rend(); ++instr_iter) {
+			const auto& I = *instr_iter;
+			if (isa<PHINode>(I)) {
+				// PHIs are defined at block entry, they are handled by live-in
+				break;
+			}
+			if (live.erase(&I)) {
+				reg_count -= get_register_count(I.getType());
+			}
+			for (const auto& op : I.operands()) {
+				if (is_register_value(op) && live.insert(op).second) {
+					reg_count += get_register_count(op->getType());
+				}
+			}
+			// the result of "I" and its operands are live at the same time
+			const auto def_reg_count = (is_register_value(&I) ? get_register_count(I.getType()) : 0u);
+			max_reg_count = std::max(max_reg_count, reg_count + def_reg_count);
+		}
+		liveness.max_register_count = max_reg_count;
+		ret.max_register_count = std::max(ret.max_register_count, max_reg_count);
+	}
+	return ret;
+}
+
+//! returns the required work-group size of kernel "F" if it has one,
+//! NOTE: this is specified via "reqd_work_group_size" function metadata, which clang emits for all backends
+static inline std::optional<std::array<uint32_t, 3>> get_required_work_group_size(const llvm::Function& F) {
+	const auto wg_size_node = F.getMetadata("reqd_work_group_size");
+	if (!wg_size_node || wg_size_node->getNumOperands() != 3) {
+		return {};
+	}
+	std::array<uint32_t, 3> wg_size {{ 1, 1, 1 }};
+	for (uint32_t dim = 0; dim < 3; ++dim) {
+		if (const auto size = llvm::mdconst::dyn_extract<llvm::ConstantInt>(wg_size_node->getOperand(dim)); size) {
+			wg_size[dim] = std::max(uint32_t(1u), uint32_t(size->getZExtValue()));
+		}
+	}
+	return wg_size;
+}
+
+//! sets the required work-group size of kernel "F" (see get_required_work_group_size)
+static inline void set_required_work_group_size(llvm::Function& F, const std::array<uint32_t, 3>& wg_size) {
+	auto& ctx = F.getContext();
+	const auto wg_size_md = [&ctx](const uint32_t size) {
+		return llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), size));
+	};
+	F.setMetadata("reqd_work_group_size", llvm::MDNode::get(ctx, {
+		wg_size_md(wg_size[0]), wg_size_md(wg_size[1]), wg_size_md(wg_size[2])
+	}));
+}
+
+//! returns the name suffix of a kernel variant with the specified constant work-group size (-> "__wg_<x>x<y>x<z>")
+//! NOTE: this must only contain characters that are valid in identifiers for all backends
+static inline std::string get_work_group_size_variant_suffix(const std::array<uint32_t, 3>& wg_size) {
+	return ("__wg_" + std::to_string(wg_size[0]) + "x" + std::to_string(wg_size[1]) + "x" + std::to_string(wg_size[2]));
+}
+
+//! returns the name suffix of the host-compute variant of a kernel that executes a whole work-group in a single loop nest
+static inline const char* get_host_compute_work_group_suffix() {
+	return "__work_group";
+}
+
 } // namespace libfloor_utils
 
 #endif
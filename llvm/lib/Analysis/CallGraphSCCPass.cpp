@@ -164,6 +164,14 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
       RefreshCallGraph(CurSCC, CG, true);
 #endif
 
+    if (Changed) {
+      SmallVector<const Function *, 4> Fs;
+      for (CallGraphNode *CGN : CurSCC)
+        if (Function *F = CGN->getFunction(); F && !F->isDeclaration())
+          Fs.push_back(F);
+      verifyChangedIR(P, Fs);
+    }
+
     return Changed;
   }
 
@@ -28,6 +28,11 @@ static cl::opt<TargetLibraryInfoImpl::VectorLibrary> ClVectorLibrary(
                           "Darwin_libsystem_m", "Darwin libsystem_m"),
                clEnumValN(TargetLibraryInfoImpl::LIBMVEC_X86, "LIBMVEC-X86",
                           "GLIBC Vector Math library"),
+               clEnumValN(TargetLibraryInfoImpl::LLVMLIBC_X86, "LLVMLibc-X86",
+                          "LLVM libc vector math functions for x86-64"),
+               clEnumValN(TargetLibraryInfoImpl::LLVMLIBC_AARCH64,
+                          "LLVMLibc-AArch64",
+                          "LLVM libc vector math functions for AArch64"),
                clEnumValN(TargetLibraryInfoImpl::MASSV, "MASSV",
                           "IBM MASS vector library"),
                clEnumValN(TargetLibraryInfoImpl::SVML, "SVML",
@@ -1866,6 +1871,22 @@ void TargetLibraryInfoImpl::addVectorizableFunctionsFromVecLib(
     addVectorizableFunctions(VecFuncs);
     break;
   }
+  case LLVMLIBC_X86: {
+    const VecDesc VecFuncs[] = {
+    #define TLI_DEFINE_LLVMLIBC_X86_VECFUNCS
+    #include "llvm/Analysis/VecFuncs.def"
+    };
+    addVectorizableFunctions(VecFuncs);
+    break;
+  }
+  case LLVMLIBC_AARCH64: {
+    const VecDesc VecFuncs[] = {
+    #define TLI_DEFINE_LLVMLIBC_AARCH64_VECFUNCS
+    #include "llvm/Analysis/VecFuncs.def"
+    };
+    addVectorizableFunctions(VecFuncs);
+    break;
+  }
   case MASSV: {
     const VecDesc VecFuncs[] = {
     #define TLI_DEFINE_MASSV_VECFUNCS
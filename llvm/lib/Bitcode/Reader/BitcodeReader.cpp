@@ -69,6 +69,7 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -91,6 +92,11 @@ static cl::opt<bool> PrintSummaryGUIDs(
     cl::desc(
         "Print the global id for each value when reading the module summary"));
 
+static cl::opt<bool> ParallelFunctionDecoding(
+    "bitcode-parallel-function-decoding", cl::init(false), cl::Hidden,
+    cl::desc("When materializing a whole module, decode the records of all "
+             "function bodies in parallel before building their IR"));
+
 namespace {
 
 enum {
@@ -533,6 +539,28 @@ class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   /// where to find deferred function body in the stream.
   DenseMap<Function*, uint64_t> DeferredFunctionInfo;
 
+  /// The records of a function block, as decoded by decodeFunctionBodies().
+  /// Sub-blocks and the end of the block are not decoded, instead their
+  /// position in the stream is recorded, so that they can be read from the
+  /// stream as usual.
+  struct DecodedFunctionBody {
+    struct Entry {
+      /// Bit position of a sub-block or the end of the block (!IsRecord).
+      uint64_t BitNo = 0;
+      unsigned Code = 0;
+      unsigned OpsBegin = 0;
+      unsigned NumOps = 0;
+      bool IsRecord = false;
+    };
+    std::vector<Entry> Entries;
+    /// The operands of all records.
+    std::vector<uint64_t> Ops;
+  };
+
+  /// Function bodies that have already been decoded by decodeFunctionBodies()
+  /// and are waiting to be parsed.
+  DenseMap<Function *, DecodedFunctionBody> DecodedFunctionBodies;
+
   /// When Metadata block is initially scanned when parsing the module, we may
   /// choose to defer parsing of the metadata. This vector contains info about
   /// which Metadata blocks are deferred.
@@ -718,6 +746,9 @@ private:
   /// Save the positions of the Metadata blocks and skip parsing the blocks.
   Error rememberAndSkipMetadata();
   Error typeCheckLoadStoreInst(Type *ValType, Type *PtrType);
+  static bool decodeFunctionBody(BitstreamCursor &Cursor, uint64_t BitNo,
+                                 DecodedFunctionBody &Body);
+  void decodeFunctionBodies();
   Error parseFunctionBody(Function *F);
   Error globalCleanup();
   Error resolveGlobalAndIndirectSymbolInits();
@@ -3995,14 +4026,40 @@ Error BitcodeReader::parseFunctionBody(Function *F) {
 
   std::vector<OperandBundleDef> OperandBundles;
 
+  // If the records of this function have already been decoded, use them
+  // instead of reading them from the stream.
+  DecodedFunctionBody DecodedBody;
+  bool UseDecodedBody = false;
+  unsigned NextDecodedEntry = 0;
+  auto DecodedIt = DecodedFunctionBodies.find(F);
+  if (DecodedIt != DecodedFunctionBodies.end()) {
+    DecodedBody = std::move(DecodedIt->second);
+    DecodedFunctionBodies.erase(DecodedIt);
+    UseDecodedBody = true;
+  }
+
   // Read all the records.
   SmallVector<uint64_t, 64> Record;
 
   while (true) {
-    Expected<llvm::BitstreamEntry> MaybeEntry = Stream.advance();
-    if (!MaybeEntry)
-      return MaybeEntry.takeError();
-    llvm::BitstreamEntry Entry = MaybeEntry.get();
+    const DecodedFunctionBody::Entry *DecodedRecord = nullptr;
+    if (UseDecodedBody) {
+      assert(NextDecodedEntry < DecodedBody.Entries.size() &&
+             "Decoded function body must end with the end of the block");
+      const auto &DecodedEntry = DecodedBody.Entries[NextDecodedEntry++];
+      if (DecodedEntry.IsRecord)
+        DecodedRecord = &DecodedEntry;
+      else if (Error JumpFailed = Stream.JumpToBit(DecodedEntry.BitNo))
+        return JumpFailed;
+    }
+
+    llvm::BitstreamEntry Entry = BitstreamEntry::getRecord(0);
+    if (!DecodedRecord) {
+      Expected<llvm::BitstreamEntry> MaybeEntry = Stream.advance();
+      if (!MaybeEntry)
+        return MaybeEntry.takeError();
+      Entry = MaybeEntry.get();
+    }
 
     switch (Entry.Kind) {
     case BitstreamEntry::Error:
@@ -4050,7 +4107,13 @@ Error BitcodeReader::parseFunctionBody(Function *F) {
     // Read a record.
     Record.clear();
     Instruction *I = nullptr;
-    Expected<unsigned> MaybeBitCode = Stream.readRecord(Entry.ID, Record);
+    if (DecodedRecord)
+      Record.append(DecodedBody.Ops.begin() + DecodedRecord->OpsBegin,
+                    DecodedBody.Ops.begin() + DecodedRecord->OpsBegin +
+                        DecodedRecord->NumOps);
+    Expected<unsigned> MaybeBitCode =
+        DecodedRecord ? Expected<unsigned>(DecodedRecord->Code)
+                      : Stream.readRecord(Entry.ID, Record);
     if (!MaybeBitCode)
       return MaybeBitCode.takeError();
     switch (unsigned BitCode = MaybeBitCode.get()) {
@@ -5548,6 +5611,106 @@ OutOfRecordLoop:
   return Error::success();
 }
 
+/// Decodes the records of the function block at \p BitNo (the position stored
+/// in DeferredFunctionInfo) into \p Body, using \p Cursor. This only does
+/// abbreviation expansion and VBR decoding and doesn't touch any IR, so it can
+/// run in parallel for multiple function bodies. Returns false if the function
+/// body can't be decoded, it is then read from the stream as usual (which also
+/// takes care of reporting any errors).
+bool BitcodeReader::decodeFunctionBody(BitstreamCursor &Cursor, uint64_t BitNo,
+                                       DecodedFunctionBody &Body) {
+  if (Error JumpFailed = Cursor.JumpToBit(BitNo)) {
+    consumeError(std::move(JumpFailed));
+    return false;
+  }
+  if (Error Err = Cursor.EnterSubBlock(bitc::FUNCTION_BLOCK_ID)) {
+    consumeError(std::move(Err));
+    return false;
+  }
+
+  SmallVector<uint64_t, 64> Record;
+  while (true) {
+    const uint64_t EntryBitNo = Cursor.GetCurrentBitNo();
+    Expected<BitstreamEntry> MaybeEntry = Cursor.advance();
+    if (!MaybeEntry) {
+      consumeError(MaybeEntry.takeError());
+      return false;
+    }
+    BitstreamEntry Entry = MaybeEntry.get();
+
+    DecodedFunctionBody::Entry DecodedEntry;
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return false;
+    case BitstreamEntry::EndBlock:
+      // NOTE: parseFunctionBody() will read the end of the block (and any
+      // abbreviation definitions before it) from the stream again.
+      DecodedEntry.BitNo = EntryBitNo;
+      Body.Entries.push_back(DecodedEntry);
+      return true;
+    case BitstreamEntry::SubBlock:
+      // Sub-blocks are parsed from the stream by parseFunctionBody().
+      DecodedEntry.BitNo = EntryBitNo;
+      Body.Entries.push_back(DecodedEntry);
+      if (Error Err = Cursor.SkipBlock()) {
+        consumeError(std::move(Err));
+        return false;
+      }
+      continue;
+    case BitstreamEntry::Record:
+      break;
+    }
+
+    Record.clear();
+    StringRef Blob;
+    Expected<unsigned> MaybeBitCode =
+        Cursor.readRecord(Entry.ID, Record, &Blob);
+    if (!MaybeBitCode) {
+      consumeError(MaybeBitCode.takeError());
+      return false;
+    }
+    // Function records never have a blob.
+    if (!Blob.empty())
+      return false;
+    DecodedEntry.Code = MaybeBitCode.get();
+    DecodedEntry.OpsBegin = Body.Ops.size();
+    DecodedEntry.NumOps = Record.size();
+    DecodedEntry.IsRecord = true;
+    Body.Entries.push_back(DecodedEntry);
+    Body.Ops.insert(Body.Ops.end(), Record.begin(), Record.end());
+  }
+}
+
+/// Decodes the records of all function bodies whose position in the stream is
+/// known in parallel, so that parseFunctionBody() only has to build the IR.
+void BitcodeReader::decodeFunctionBodies() {
+  std::vector<std::pair<Function *, uint64_t>> Functions;
+  for (Function &F : *TheModule) {
+    if (!F.isMaterializable() || DecodedFunctionBodies.count(&F))
+      continue;
+    auto DFII = DeferredFunctionInfo.find(&F);
+    if (DFII == DeferredFunctionInfo.end() || DFII->second == 0)
+      continue;
+    Functions.emplace_back(&F, DFII->second);
+  }
+  if (Functions.size() < 2)
+    return;
+
+  std::vector<DecodedFunctionBody> Bodies(Functions.size());
+  // NOTE: each task uses its own copy of the cursor, these only share the
+  // (at this point immutable) bitcode buffer, block info and abbreviations.
+  std::vector<BitstreamCursor> Cursors(Functions.size(), Stream);
+  parallelForEachN(0, Functions.size(), [&](size_t I) {
+    if (!decodeFunctionBody(Cursors[I], Functions[I].second, Bodies[I]))
+      Bodies[I] = DecodedFunctionBody();
+  });
+
+  for (size_t I = 0, E = Functions.size(); I != E; ++I) {
+    if (!Bodies[I].Entries.empty())
+      DecodedFunctionBodies[Functions[I].first] = std::move(Bodies[I]);
+  }
+}
+
 /// Find the function body in the bitcode stream
 Error BitcodeReader::findFunctionInStream(
     Function *F,
@@ -5689,6 +5852,9 @@ Error BitcodeReader::materializeModule() {
   // Promise to materialize all forward references.
   WillMaterializeAllForwardRefs = true;
 
+  if (ParallelFunctionDecoding)
+    decodeFunctionBodies();
+
   // Iterate over the module, deserializing any functions that are still on
   // disk.
   for (Function &F : *TheModule) {
@@ -0,0 +1,238 @@
+//===- FloorHostComputeJIT.cpp - JIT for host-compute kernels -------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ExecutionEngine/Orc/FloorHostComputeJIT.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ExecutionEngine/JITLink/EHFrameSupport.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+#define DEBUG_TYPE "orc"
+
+using namespace llvm;
+using namespace llvm::orc;
+
+namespace llvm {
+namespace orc {
+
+/// Stores compiled objects as "<key>.o" files in a cache directory. The cache
+/// key of a module is attached to the module itself (see setKey()), so no
+/// per-module state is kept here: modules that are never compiled don't leave
+/// anything behind, and a module can never be confused with an earlier one.
+class FloorHostComputeObjectCache : public ObjectCache {
+public:
+  FloorHostComputeObjectCache(std::string Dir) : Dir(std::move(Dir)) {}
+
+  /// Attaches the cache key \p Key to \p M. Modules without a key are not
+  /// cached.
+  static void setKey(Module &M, StringRef Key) {
+    NamedMDNode *KeyMD = M.getOrInsertNamedMetadata(KeyMDName);
+    KeyMD->clearOperands();
+    KeyMD->addOperand(
+        MDNode::get(M.getContext(), MDString::get(M.getContext(), Key)));
+  }
+
+  std::unique_ptr<MemoryBuffer> getObject(const Module *M) override {
+    SmallString<128> Path;
+    if (!getObjectPath(*M, Path))
+      return nullptr;
+
+    auto Obj = MemoryBuffer::getFile(Path, /*IsText=*/false,
+                                     /*RequiresNullTerminator=*/false);
+    if (!Obj)
+      return nullptr;
+
+    LLVM_DEBUG(dbgs() << "FloorHostComputeJIT: using cached object " << Path
+                      << "\n");
+    return std::move(*Obj);
+  }
+
+  void notifyObjectCompiled(const Module *M, MemoryBufferRef Obj) override {
+    SmallString<128> Path;
+    if (!getObjectPath(*M, Path))
+      return;
+
+    // Write to a unique temporary file first and rename it afterwards, so that
+    // concurrent processes sharing the cache never see a partial object.
+    int FD;
+    SmallString<128> TmpPath;
+    if (sys::fs::createUniqueFile(Path + ".tmp-%%%%%%%%", FD, TmpPath))
+      return;
+    {
+      raw_fd_ostream OS(FD, /*shouldClose=*/true);
+      OS << Obj.getBuffer();
+      OS.close();
+      if (OS.has_error()) {
+        OS.clear_error();
+        sys::fs::remove(TmpPath);
+        return;
+      }
+    }
+    if (sys::fs::rename(TmpPath, Path))
+      sys::fs::remove(TmpPath);
+  }
+
+private:
+  static constexpr const char *KeyMDName = "floor.host_compute.cache_key";
+
+  bool getObjectPath(const Module &M, SmallString<128> &Path) const {
+    const NamedMDNode *KeyMD = M.getNamedMetadata(KeyMDName);
+    if (!KeyMD || KeyMD->getNumOperands() != 1)
+      return false;
+    const MDNode *KeyNode = KeyMD->getOperand(0);
+    const auto *Key = KeyNode->getNumOperands() == 1
+                          ? dyn_cast<MDString>(KeyNode->getOperand(0))
+                          : nullptr;
+    if (!Key)
+      return false;
+    Path = Dir;
+    sys::path::append(Path, Key->getString() + ".o");
+    return true;
+  }
+
+  std::string Dir;
+};
+
+} // end namespace orc
+} // end namespace llvm
+
+FloorHostComputeJIT::FloorHostComputeJIT(Options Opts)
+    : Opts(std::move(Opts)) {}
+
+FloorHostComputeJIT::~FloorHostComputeJIT() = default;
+
+Expected<std::unique_ptr<FloorHostComputeJIT>>
+FloorHostComputeJIT::Create(Options Opts) {
+  auto JTMB = JITTargetMachineBuilder::detectHost();
+  if (!JTMB)
+    return JTMB.takeError();
+
+  if (Opts.TargetTriple)
+    JTMB->getTargetTriple() = *Opts.TargetTriple;
+  else
+    JTMB->getTargetTriple().setEnvironment(Triple::FloorHostCompute);
+  if (!Opts.CPU.empty())
+    JTMB->setCPU(Opts.CPU);
+  if (!Opts.Features.empty())
+    JTMB->setFeatures(Opts.Features);
+  JTMB->setCodeGenOptLevel(Opts.OptLevel);
+
+  // Store the resolved target configuration, it is part of the cache key.
+  Opts.TargetTriple = JTMB->getTargetTriple();
+  Opts.CPU = JTMB->getCPU();
+  Opts.Features = JTMB->getFeatures().getString();
+
+  std::unique_ptr<FloorHostComputeJIT> HCJ(
+      new FloorHostComputeJIT(std::move(Opts)));
+  const Options &O = HCJ->Opts;
+
+  if (!O.CacheDir.empty()) {
+    if (auto EC = sys::fs::create_directories(O.CacheDir))
+      return createFileError(O.CacheDir, EC);
+    HCJ->Cache = std::make_unique<FloorHostComputeObjectCache>(O.CacheDir);
+  }
+
+  ObjectCache *Cache = HCJ->Cache.get();
+  bool Concurrent = O.NumCompileThreads > 0;
+  auto J =
+      LLJITBuilder()
+          .setJITTargetMachineBuilder(std::move(*JTMB))
+          .setNumCompileThreads(O.NumCompileThreads)
+          .setObjectLinkingLayerCreator(
+              [](ExecutionSession &ES,
+                 const Triple &) -> Expected<std::unique_ptr<ObjectLayer>> {
+                auto ObjLinkingLayer = std::make_unique<ObjectLinkingLayer>(ES);
+                ObjLinkingLayer->addPlugin(
+                    std::make_unique<EHFrameRegistrationPlugin>(
+                        ES,
+                        std::make_unique<jitlink::InProcessEHFrameRegistrar>()));
+                return std::move(ObjLinkingLayer);
+              })
+          .setCompileFunctionCreator(
+              [Cache, Concurrent](JITTargetMachineBuilder JTMB)
+                  -> Expected<std::unique_ptr<IRCompileLayer::IRCompiler>> {
+                if (Concurrent)
+                  return std::make_unique<ConcurrentIRCompiler>(
+                      std::move(JTMB), Cache);
+                auto TM = JTMB.createTargetMachine();
+                if (!TM)
+                  return TM.takeError();
+                return std::make_unique<TMOwningSimpleCompiler>(std::move(*TM),
+                                                                Cache);
+              })
+          .create();
+  if (!J)
+    return J.takeError();
+  HCJ->J = std::move(*J);
+
+  // Kernels may call into anything that is linked into the current process.
+  auto ProcessSymbols = DynamicLibrarySearchGenerator::GetForCurrentProcess(
+      HCJ->J->getDataLayout().getGlobalPrefix());
+  if (!ProcessSymbols)
+    return ProcessSymbols.takeError();
+  HCJ->J->getMainJITDylib().addGenerator(std::move(*ProcessSymbols));
+
+  return std::move(HCJ);
+}
+
+Error FloorHostComputeJIT::addRuntimeSymbols(
+    const StringMap<void *> &Symbols) {
+  SymbolMap Map;
+  for (const auto &Sym : Symbols)
+    Map[J->mangleAndIntern(Sym.getKey())] = JITEvaluatedSymbol::fromPointer(
+        Sym.getValue(), JITSymbolFlags::Exported | JITSymbolFlags::Callable);
+  return J->getMainJITDylib().define(absoluteSymbols(std::move(Map)));
+}
+
+Error FloorHostComputeJIT::addModule(ThreadSafeModule TSM) {
+  if (Cache) {
+    TSM.withModuleDo([this](Module &M) {
+      // The data layout is part of the bitcode and therefore of the key, so
+      // apply the JIT data layout first (as LLJIT would do otherwise).
+      if (M.getDataLayout().isDefault())
+        M.setDataLayout(J->getDataLayout());
+      FloorHostComputeObjectCache::setKey(M, getCacheKey(M));
+    });
+  }
+  return J->addIRModule(std::move(TSM));
+}
+
+Expected<void *> FloorHostComputeJIT::getKernel(StringRef Name) {
+  auto Sym = J->lookup(Name);
+  if (!Sym)
+    return Sym.takeError();
+  return jitTargetAddressToPointer<void *>(Sym->getAddress());
+}
+
+std::string FloorHostComputeJIT::getCacheKey(const Module &M) const {
+  SmallVector<char, 0> Bitcode;
+  raw_svector_ostream OS(Bitcode);
+  WriteBitcodeToFile(M, OS);
+
+  SHA1 Hasher;
+  Hasher.update(StringRef(Bitcode.data(), Bitcode.size()));
+  Hasher.update(Opts.TargetTriple ? Opts.TargetTriple->str() : "");
+  Hasher.update(Opts.CPU);
+  Hasher.update(Opts.Features);
+  Hasher.update(utostr(unsigned(Opts.OptLevel)));
+  Hasher.update(LLVM_VERSION_STRING);
+  return toHex(Hasher.final(), /*LowerCase=*/true);
+}
@@ -19,6 +19,7 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/PassTimingInfo.h"
 #include "llvm/IR/PrintPasses.h"
+#include "llvm/IR/Verifier.h"
 #include "llvm/Support/Chrono.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
@@ -35,6 +36,10 @@
 
 using namespace llvm;
 
+namespace llvm {
+extern cl::opt<bool> VerifyEachIncremental;
+} // namespace llvm
+
 // See PassManagers.h for Pass Manager infrastructure overview.
 
 //===----------------------------------------------------------------------===//
@@ -922,6 +927,21 @@ void PMDataManager::verifyPreservedAnalysis(Pass *P) {
   }
 }
 
+/// Incrementally verify the IR changed by pass P.
+void PMDataManager::verifyChangedIR(Pass *P, ArrayRef<const Function *> Fs,
+                                    const Module *M) {
+  if (!VerifyEachIncremental)
+    return;
+
+  bool Broken = verifyFunctions(Fs, &errs());
+  if (M)
+    Broken |= verifyModuleGlobals(*M, &errs());
+  if (Broken)
+    report_fatal_error("Broken IR found after pass '" + P->getPassName() +
+                           "'!",
+                       false);
+}
+
 /// Remove Analysis not preserved by Pass P
 void PMDataManager::removeNotPreservedAnalysis(Pass *P) {
   AnalysisUsage *AnUsage = TPM->findAnalysisUsage(P);
@@ -1458,8 +1478,10 @@ bool FPPassManager::runOnFunction(Function &F) {
     }
 
     Changed |= LocalChanged;
-    if (LocalChanged)
+    if (LocalChanged) {
       dumpPassInfo(FP, MODIFICATION_MSG, ON_FUNCTION_MSG, F.getName());
+      verifyChangedIR(FP, &F);
+    }
     dumpPreservedSet(FP);
     dumpUsedSet(FP);
 
@@ -1567,9 +1589,20 @@ MPPassManager::runOnModule(Module &M) {
     }
 
     Changed |= LocalChanged;
-    if (LocalChanged)
+    if (LocalChanged) {
       dumpPassInfo(MP, MODIFICATION_MSG, ON_MODULE_MSG,
                    M.getModuleIdentifier());
+      // Nested pass managers have already verified the functions changed by
+      // their passes, only the module-level IR remains to be verified.
+      if (VerifyEachIncremental) {
+        SmallVector<const Function *, 0> Fs;
+        if (!MP->getAsPMDataManager())
+          for (const Function &F : M)
+            if (!F.isDeclaration())
+              Fs.push_back(&F);
+        verifyChangedIR(MP, Fs, &M);
+      }
+    }
     dumpPreservedSet(MP);
     dumpUsedSet(MP);
 
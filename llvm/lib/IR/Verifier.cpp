@@ -103,16 +103,34 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 
 using namespace llvm;
 
+namespace llvm {
+cl::opt<bool> VerifyEachIncremental(
+    "verify-each-incremental", cl::Hidden, cl::init(false),
+    cl::desc("Verify the functions (and module-level IR) that a pass reports "
+             "as changed after each pass, verifying independent functions "
+             "in parallel"));
+} // namespace llvm
+
+/// Serializes the few places in function verification that may modify
+/// LLVMContext state (uniquing types/constants, unique intrinsic names), so
+/// that multiple functions of the same module can be verified concurrently.
+static std::mutex &getSharedContextMutex() {
+  static std::mutex Mutex;
+  return Mutex;
+}
+
 static cl::opt<bool> VerifyNoAliasScopeDomination(
     "verify-noalias-scope-decl-dom", cl::Hidden, cl::init(false),
     cl::desc("Ensure that llvm.experimental.noalias.scope.decl for identical "
@@ -342,13 +360,31 @@ class Verifier : public InstVisitor<Verifier>, VerifierSupport {
 
   SmallVector<IntrinsicInst *, 4> NoAliasScopeDecls;
 
+  /// Whether other verifiers may concurrently verify functions of the same
+  /// LLVMContext.
+  bool SharedContext = false;
+
   void checkAtomicMemAccessSize(Type *Ty, const Instruction *I);
 
+  /// Locks the shared context mutex if this verifier runs concurrently with
+  /// other verifiers.
+  std::unique_lock<std::mutex> lockContext() const {
+    if (!SharedContext)
+      return std::unique_lock<std::mutex>();
+    return std::unique_lock<std::mutex>(getSharedContextMutex());
+  }
+
+  ConstantTokenNone *getTokenNone(LLVMContext &Context) const {
+    auto Lock = lockContext();
+    return ConstantTokenNone::get(Context);
+  }
+
 public:
   explicit Verifier(raw_ostream *OS, bool ShouldTreatBrokenDebugInfoAsError,
-                    const Module &M)
+                    const Module &M, bool SharedContext = false)
       : VerifierSupport(OS, M), LandingPadResultTy(nullptr),
-        SawFrameEscape(false), TBAAVerifyHelper(this) {
+        SawFrameEscape(false), TBAAVerifyHelper(this),
+        SharedContext(SharedContext) {
     TreatBrokenDebugInfoAsError = ShouldTreatBrokenDebugInfoAsError;
   }
 
@@ -3133,9 +3169,8 @@ void Verifier::visitCallBase(CallBase &Call) {
     Assert(Call.getArgOperand(i)->getType() == FTy->getParamType(i) ||
            (Call.getArgOperand(i)->getType()->isPointerTy() &&
             FTy->getParamType(i)->isPointerTy() &&
-            PointerType::get(Call.getArgOperand(i)->getType()->getPointerElementType(),
-                             FTy->getParamType(i)->getPointerAddressSpace()) ==
-            FTy->getParamType(i)),
+            cast<PointerType>(FTy->getParamType(i))->hasSameElementTypeAs(
+                cast<PointerType>(Call.getArgOperand(i)->getType()))),
            "Call parameter type does not match function signature!",
 		   Call.getArgOperand(i), FTy->getParamType(i), Call);
   }
@@ -3409,7 +3444,7 @@ static AttrBuilder getParameterABIAttributes(LLVMContext& C, unsigned I, Attribu
   if (Attrs.hasParamAttr(I, Attribute::Alignment) &&
       (Attrs.hasParamAttr(I, Attribute::ByVal) ||
        Attrs.hasParamAttr(I, Attribute::ByRef)))
-    Copy.addAlignmentAttr(Attrs.getParamAlignment(I));
+    Copy.addAttribute(Attrs.getParamAttr(I, Attribute::Alignment));
   return Copy;
 }
 
@@ -3987,7 +4022,7 @@ void Verifier::visitEHPadPredecessors(Instruction &I) {
       if (auto Bundle = II->getOperandBundle(LLVMContext::OB_funclet))
         FromPad = Bundle->Inputs[0];
       else
-        FromPad = ConstantTokenNone::get(II->getContext());
+        FromPad = getTokenNone(II->getContext());
     } else if (auto *CRI = dyn_cast<CleanupReturnInst>(TI)) {
       FromPad = CRI->getOperand(0);
       Assert(FromPad != ToPadParent, "A cleanupret must exit its cleanup", CRI);
@@ -4202,7 +4237,7 @@ void Verifier::visitFuncletPadInst(FuncletPadInst &FPI) {
         } while (!isa<ConstantTokenNone>(ExitedPad));
       } else {
         // Unwinding to caller exits all pads.
-        UnwindPad = ConstantTokenNone::get(FPI.getContext());
+        UnwindPad = getTokenNone(FPI.getContext());
         ExitsFPI = true;
         UnresolvedAncestorPad = &FPI;
       }
@@ -4272,7 +4307,7 @@ void Verifier::visitFuncletPadInst(FuncletPadInst &FPI) {
       if (SwitchUnwindDest)
         SwitchUnwindPad = SwitchUnwindDest->getFirstNonPHI();
       else
-        SwitchUnwindPad = ConstantTokenNone::get(FPI.getContext());
+        SwitchUnwindPad = getTokenNone(FPI.getContext());
       Assert(SwitchUnwindPad == FirstUnwindPad,
              "Unwind edges out of a catch must have the same unwind dest as "
              "the parent catchswitch",
@@ -4690,6 +4725,10 @@ void Verifier::visitIntrinsicCall(Intrinsic::ID ID, CallBase &Call) {
   getIntrinsicInfoTableEntries(ID, Table);
   ArrayRef<Intrinsic::IITDescriptor> TableRef = Table;
 
+  // Matching the signature and mangling the name may create new types or
+  // unique intrinsic names, so this must not race with other verifiers.
+  auto Lock = lockContext();
+
   // Walk the descriptors to extract overloaded types.
   SmallVector<Type *, 4> ArgTys;
   Intrinsic::MatchIntrinsicTypesResult Res =
@@ -5935,6 +5974,41 @@ bool llvm::verifyFunction(const Function &f, raw_ostream *OS) {
   return !V.verify(F);
 }
 
+bool llvm::verifyFunctions(ArrayRef<const Function *> Fs, raw_ostream *OS) {
+  if (Fs.size() < 2) {
+    bool Broken = false;
+    for (const Function *F : Fs)
+      Broken |= verifyFunction(*F, OS);
+    return Broken;
+  }
+
+  // Each function is verified by its own verifier into its own buffer, the
+  // output is then printed in-order.
+  std::vector<std::string> Messages(Fs.size());
+  std::vector<char> Results(Fs.size(), 0);
+  parallelForEachN(0, Fs.size(), [&](size_t I) {
+    Function &F = const_cast<Function &>(*Fs[I]);
+    raw_string_ostream MsgOS(Messages[I]);
+    Verifier V(OS ? &MsgOS : nullptr,
+               /*ShouldTreatBrokenDebugInfoAsError=*/true, *F.getParent(),
+               /*SharedContext=*/true);
+    Results[I] = !V.verify(F);
+  });
+
+  bool Broken = false;
+  for (size_t I = 0, E = Fs.size(); I != E; ++I) {
+    if (OS)
+      *OS << Messages[I];
+    Broken |= Results[I] != 0;
+  }
+  return Broken;
+}
+
+bool llvm::verifyModuleGlobals(const Module &M, raw_ostream *OS) {
+  Verifier V(OS, /*ShouldTreatBrokenDebugInfoAsError=*/true, M);
+  return !V.verify();
+}
+
 bool llvm::verifyModule(const Module &M, raw_ostream *OS,
                         bool *BrokenDebugInfo) {
   // Don't use a raw_null_ostream.  Printing IR is expensive.
@@ -49,11 +49,13 @@
 #include "llvm/Support/SMLoc.h"
 #include "llvm/Support/StringSaver.h"
 #include "llvm/Support/SwapByteOrder.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <future>
 #include <map>
 #include <memory>
 #include <string>
@@ -146,9 +148,51 @@ struct ELFWriter {
 
   uint64_t align(unsigned Alignment);
 
-  bool maybeWriteCompression(uint64_t Size,
-                             SmallVectorImpl<char> &CompressedContents,
-                             bool ZLibStyle, unsigned Alignment);
+  bool maybeWriteCompression(DebugCompressionType Type, uint64_t Size,
+                             uint64_t CompressedSize, unsigned Alignment);
+
+  /// Debug sections are compressed in independent chunks of this size.
+  static constexpr size_t CompressionChunkSize = 1024 * 1024;
+  /// At most this much uncompressed debug section data is held in memory at
+  /// once (unless a single section is larger than this).
+  static constexpr uint64_t MaxCompressionBytesInFlight = 64 * 1024 * 1024;
+
+  /// A debug section that is compressed asynchronously, while the preceding
+  /// sections are written.
+  struct CompressedSection {
+    /// Uncompressed section size, as accounted in CompressionBytesInFlight.
+    uint64_t Size = 0;
+    /// Uncompressed section contents.
+    SmallVector<char, 0> Data;
+    /// Compressed chunks of Data, in order.
+    std::vector<SmallVector<char, 0>> Chunks;
+    /// adler32 checksum of each chunk (zlib only).
+    std::vector<uint32_t> ChunkChecksums;
+    /// Set for each chunk that failed to compress.
+    std::vector<char> ChunkFailed;
+    std::vector<std::shared_future<void>> ChunkFutures;
+
+    ~CompressedSection() {
+      // The compression tasks reference this section.
+      for (const auto &Future : ChunkFutures)
+        Future.wait();
+    }
+  };
+  DenseMap<const MCSectionELF *, std::unique_ptr<CompressedSection>>
+      CompressedSections;
+  /// All debug sections to compress, in the order they are written.
+  std::vector<const MCSectionELF *> CompressionQueue;
+  /// Index of the next section in CompressionQueue to start compressing.
+  size_t NextCompressedSection = 0;
+  /// Uncompressed size of all started sections that have not been written yet.
+  uint64_t CompressionBytesInFlight = 0;
+
+  bool isCompressedDebugSection(const MCAssembler &Asm,
+                                const MCSectionELF &Section) const;
+  void startDebugSectionCompression(const MCAssembler &Asm,
+                                    const MCAsmLayout &Layout);
+  void scheduleDebugSectionCompression(const MCAssembler &Asm,
+                                       const MCAsmLayout &Layout);
 
 public:
   ELFWriter(ELFObjectWriter &OWriter, raw_pwrite_stream &OS,
@@ -834,24 +878,27 @@ MCSectionELF *ELFWriter::createRelocationSection(MCContext &Ctx,
 }
 
 // Include the debug info compression header.
-bool ELFWriter::maybeWriteCompression(
-    uint64_t Size, SmallVectorImpl<char> &CompressedContents, bool ZLibStyle,
-    unsigned Alignment) {
-  if (ZLibStyle) {
+bool ELFWriter::maybeWriteCompression(DebugCompressionType Type, uint64_t Size,
+                                      uint64_t CompressedSize,
+                                      unsigned Alignment) {
+  if (Type != DebugCompressionType::GNU) {
     uint64_t HdrSize =
         is64Bit() ? sizeof(ELF::Elf32_Chdr) : sizeof(ELF::Elf64_Chdr);
-    if (Size <= HdrSize + CompressedContents.size())
+    if (Size <= HdrSize + CompressedSize)
       return false;
+    const unsigned ChType = Type == DebugCompressionType::Zstd
+                                ? ELF::ELFCOMPRESS_ZSTD
+                                : ELF::ELFCOMPRESS_ZLIB;
     // Platform specific header is followed by compressed data.
     if (is64Bit()) {
       // Write Elf64_Chdr header.
-      write(static_cast<ELF::Elf64_Word>(ELF::ELFCOMPRESS_ZLIB));
+      write(static_cast<ELF::Elf64_Word>(ChType));
       write(static_cast<ELF::Elf64_Word>(0)); // ch_reserved field.
       write(static_cast<ELF::Elf64_Xword>(Size));
       write(static_cast<ELF::Elf64_Xword>(Alignment));
     } else {
       // Write Elf32_Chdr header otherwise.
-      write(static_cast<ELF::Elf32_Word>(ELF::ELFCOMPRESS_ZLIB));
+      write(static_cast<ELF::Elf32_Word>(ChType));
       write(static_cast<ELF::Elf32_Word>(Size));
       write(static_cast<ELF::Elf32_Word>(Alignment));
     }
@@ -861,58 +908,162 @@ bool ELFWriter::maybeWriteCompression(
   // "ZLIB" followed by 8 bytes representing the uncompressed size of the section,
   // useful for consumers to preallocate a buffer to decompress into.
   const StringRef Magic = "ZLIB";
-  if (Size <= Magic.size() + sizeof(Size) + CompressedContents.size())
+  if (Size <= Magic.size() + sizeof(Size) + CompressedSize)
     return false;
   W.OS << Magic;
   support::endian::write(W.OS, Size, support::big);
   return true;
 }
 
+bool ELFWriter::isCompressedDebugSection(const MCAssembler &Asm,
+                                         const MCSectionELF &Section) const {
+  // Compressing debug_frame requires handling alignment fragments which is
+  // more work (possibly generalizing MCAssembler.cpp:writeFragment to allow
+  // for writing to arbitrary buffers) for little benefit.
+  const auto &MAI = Asm.getContext().getAsmInfo();
+  StringRef SectionName = Section.getName();
+  return MAI->compressDebugSections() != DebugCompressionType::None &&
+         SectionName.startswith(".debug_") && SectionName != ".debug_frame";
+}
+
+// The thread pool used for debug section compression, shared by all ELF
+// writers of the process. If the compiler was started by a jobserver (e.g.
+// make -jN), compression threads only run while they hold a job slot, so that
+// parallel compiles don't oversubscribe the machine.
+static ThreadPool &getCompressionPool() {
+  static ThreadPool Pool([] {
+    ThreadPoolStrategy Strategy = hardware_concurrency();
+    Strategy.UseJobserver = true;
+    return Strategy;
+  }());
+  return Pool;
+}
+
+// Collect all debug sections that will be written by this writer and start
+// compressing the first ones. Each section is split into chunks that are
+// compressed independently on a thread pool, so that the compression of large
+// sections is parallelized and overlaps with writing the sections that precede
+// them.
+void ELFWriter::startDebugSectionCompression(const MCAssembler &Asm,
+                                             const MCAsmLayout &Layout) {
+  const auto Type = Asm.getContext().getAsmInfo()->compressDebugSections();
+  if (Type == DebugCompressionType::None)
+    return;
+  assert((Type == DebugCompressionType::Z ||
+          Type == DebugCompressionType::GNU ||
+          Type == DebugCompressionType::Zstd) &&
+         "expected zlib, zlib-gnu or zstd style compression");
+
+  for (const MCSection &Sec : Asm) {
+    const auto &Section = static_cast<const MCSectionELF &>(Sec);
+    if ((Mode == NonDwoOnly && isDwoSection(Section)) ||
+        (Mode == DwoOnly && !isDwoSection(Section)) ||
+        !isCompressedDebugSection(Asm, Section))
+      continue;
+    CompressionQueue.push_back(&Section);
+  }
+  scheduleDebugSectionCompression(Asm, Layout);
+}
+
+// Start compressing the next sections in CompressionQueue, as long as the
+// uncompressed data in flight stays below MaxCompressionBytesInFlight. At least
+// one section is always in flight, so the next section to be written has
+// always been started.
+void ELFWriter::scheduleDebugSectionCompression(const MCAssembler &Asm,
+                                                const MCAsmLayout &Layout) {
+  const auto Type = Asm.getContext().getAsmInfo()->compressDebugSections();
+  while (NextCompressedSection != CompressionQueue.size()) {
+    const MCSectionELF &Section = *CompressionQueue[NextCompressedSection];
+    const uint64_t Size = Layout.getSectionAddressSize(&Section);
+    if (CompressionBytesInFlight != 0 &&
+        CompressionBytesInFlight + Size > MaxCompressionBytesInFlight)
+      break;
+    ++NextCompressedSection;
+    CompressionBytesInFlight += Size;
+
+    auto CS = std::make_unique<CompressedSection>();
+    CS->Size = Size;
+    raw_svector_ostream VecOS(CS->Data);
+    Asm.writeSectionData(VecOS, &Section, Layout);
+    const size_t NumChunks = std::max<uint64_t>(
+        divideCeil(CS->Data.size(), CompressionChunkSize), 1);
+    CS->Chunks.resize(NumChunks);
+    CS->ChunkChecksums.resize(NumChunks);
+    CS->ChunkFailed.resize(NumChunks);
+
+    for (size_t I = 0; I != NumChunks; ++I) {
+      auto CompressChunk = [CS = CS.get(), I, NumChunks, Type] {
+        StringRef Data(CS->Data.data(), CS->Data.size());
+        StringRef Chunk = Data.substr(I * CompressionChunkSize,
+                                      CompressionChunkSize);
+        Error Err = Error::success();
+        if (Type == DebugCompressionType::Zstd) {
+          Err = zstd::compress(Chunk, CS->Chunks[I]);
+        } else {
+          Err = zlib::compressChunk(Chunk, CS->Chunks[I], I + 1 == NumChunks);
+          CS->ChunkChecksums[I] = zlib::adler32(Chunk);
+        }
+        if (Err) {
+          consumeError(std::move(Err));
+          CS->ChunkFailed[I] = 1;
+        }
+      };
+      // Only use threads if there is more than one chunk to compress.
+      if (NumChunks > 1 || CompressionQueue.size() > 1)
+        CS->ChunkFutures.push_back(getCompressionPool().async(CompressChunk));
+      else
+        CompressChunk();
+    }
+    CompressedSections[&Section] = std::move(CS);
+  }
+}
+
 void ELFWriter::writeSectionData(const MCAssembler &Asm, MCSection &Sec,
                                  const MCAsmLayout &Layout) {
   MCSectionELF &Section = static_cast<MCSectionELF &>(Sec);
   StringRef SectionName = Section.getName();
 
-  auto &MC = Asm.getContext();
-  const auto &MAI = MC.getAsmInfo();
+  // Keep the compression of the following debug sections going.
+  scheduleDebugSectionCompression(Asm, Layout);
 
-  // Compressing debug_frame requires handling alignment fragments which is
-  // more work (possibly generalizing MCAssembler.cpp:writeFragment to allow
-  // for writing to arbitrary buffers) for little benefit.
-  bool CompressionEnabled =
-      MAI->compressDebugSections() != DebugCompressionType::None;
-  if (!CompressionEnabled || !SectionName.startswith(".debug_") ||
-      SectionName == ".debug_frame") {
+  auto It = CompressedSections.find(&Section);
+  if (It == CompressedSections.end()) {
     Asm.writeSectionData(W.OS, &Section, Layout);
     return;
   }
 
-  assert((MAI->compressDebugSections() == DebugCompressionType::Z ||
-          MAI->compressDebugSections() == DebugCompressionType::GNU) &&
-         "expected zlib or zlib-gnu style compression");
-
-  SmallVector<char, 128> UncompressedData;
-  raw_svector_ostream VecOS(UncompressedData);
-  Asm.writeSectionData(VecOS, &Section, Layout);
-
-  SmallVector<char, 128> CompressedContents;
-  if (Error E = zlib::compress(
-          StringRef(UncompressedData.data(), UncompressedData.size()),
-          CompressedContents)) {
-    consumeError(std::move(E));
+  auto &MC = Asm.getContext();
+  const auto Type = MC.getAsmInfo()->compressDebugSections();
+
+  // Wait until all chunks of this section have been compressed.
+  std::unique_ptr<CompressedSection> CSOwner = std::move(It->second);
+  CompressedSections.erase(It);
+  CompressedSection &CS = *CSOwner;
+  for (const auto &Future : CS.ChunkFutures)
+    Future.wait();
+  CompressionBytesInFlight -= CS.Size;
+
+  const StringRef UncompressedData(CS.Data.data(), CS.Data.size());
+  if (is_contained(CS.ChunkFailed, 1)) {
     W.OS << UncompressedData;
     return;
   }
 
-  bool ZlibStyle = MAI->compressDebugSections() == DebugCompressionType::Z;
-  if (!maybeWriteCompression(UncompressedData.size(), CompressedContents,
-                             ZlibStyle, Sec.getAlignment())) {
+  // zlib: the chunks are wrapped by the zlib header and the adler32 checksum
+  // of the whole section.
+  const bool IsZlib = Type != DebugCompressionType::Zstd;
+  uint64_t CompressedSize = IsZlib ? sizeof(zlib::ChunkedHeader) + 4 : 0;
+  for (const auto &Chunk : CS.Chunks)
+    CompressedSize += Chunk.size();
+
+  if (!maybeWriteCompression(Type, UncompressedData.size(), CompressedSize,
+                             Sec.getAlignment())) {
     W.OS << UncompressedData;
     return;
   }
 
-  if (ZlibStyle) {
-    // Set the compressed flag. That is zlib style.
+  if (Type != DebugCompressionType::GNU) {
+    // Set the compressed flag. That is zlib/zstd style.
     Section.setFlags(Section.getFlags() | ELF::SHF_COMPRESSED);
     // Alignment field should reflect the requirements of
     // the compressed section header.
@@ -921,7 +1072,23 @@ void ELFWriter::writeSectionData(const MCAssembler &Asm, MCSection &Sec,
     // Add "z" prefix to section name. This is zlib-gnu style.
     MC.renameELFSection(&Section, (".z" + SectionName.drop_front(1)).str());
   }
-  W.OS << CompressedContents;
+
+  if (IsZlib) {
+    W.OS << StringRef(zlib::ChunkedHeader, sizeof(zlib::ChunkedHeader));
+    uint32_t Checksum = zlib::adler32(StringRef());
+    for (size_t I = 0, E = CS.Chunks.size(); I != E; ++I) {
+      W.OS << StringRef(CS.Chunks[I].data(), CS.Chunks[I].size());
+      const size_t ChunkSize =
+          std::min(CompressionChunkSize,
+                   UncompressedData.size() - I * CompressionChunkSize);
+      Checksum =
+          zlib::adler32Combine(Checksum, CS.ChunkChecksums[I], ChunkSize);
+    }
+    support::endian::write(W.OS, Checksum, support::big);
+  } else {
+    for (const auto &Chunk : CS.Chunks)
+      W.OS << StringRef(Chunk.data(), Chunk.size());
+  }
 }
 
 void ELFWriter::WriteSecHdrEntry(uint32_t Name, uint32_t Type, uint64_t Flags,
@@ -1109,6 +1276,9 @@ uint64_t ELFWriter::writeObject(MCAssembler &Asm, const MCAsmLayout &Layout) {
   // Write out the ELF header ...
   writeHeader(Asm);
 
+  // ... start compressing the debug sections in the background ...
+  startDebugSectionCompression(Asm, Layout);
+
   // ... then the sections ...
   SectionOffsetsTy SectionOffsets;
   std::vector<MCSectionELF *> Groups;
@@ -41,6 +41,10 @@
 
 using namespace llvm;
 
+namespace llvm {
+extern cl::opt<bool> VerifyEachIncremental;
+} // namespace llvm
+
 cl::opt<bool> PreservedCFGCheckerInstrumentation::VerifyPreservedCFG(
     "verify-cfg-preserved", cl::Hidden,
 #ifdef NDEBUG
@@ -1177,6 +1181,9 @@ void VerifyInstrumentation::registerCallbacks(
       [this](StringRef P, Any IR, const PreservedAnalyses &PassPA) {
         if (isIgnored(P) || P == "VerifierPass")
           return;
+        // In incremental mode, only IR a pass reported as changed is verified.
+        if (VerifyEachIncremental && PassPA.areAllPreserved())
+          return;
         if (any_isa<const Function *>(IR) || any_isa<const Loop *>(IR)) {
           const Function *F;
           if (any_isa<const Loop *>(IR))
@@ -1188,6 +1195,18 @@ void VerifyInstrumentation::registerCallbacks(
 
           if (verifyFunction(*F))
             report_fatal_error("Broken function found, compilation aborted!");
+        } else if (VerifyEachIncremental &&
+                   any_isa<const LazyCallGraph::SCC *>(IR)) {
+          SmallVector<const Function *, 4> Fs;
+          for (const LazyCallGraph::Node &N :
+               *any_cast<const LazyCallGraph::SCC *>(IR))
+            Fs.push_back(&N.getFunction());
+          if (DebugLogging)
+            dbgs() << "Verifying " << Fs.size() << " functions of SCC "
+                   << *any_cast<const LazyCallGraph::SCC *>(IR) << "\n";
+
+          if (verifyFunctions(Fs))
+            report_fatal_error("Broken function found, compilation aborted!");
         } else if (any_isa<const Module *>(IR) ||
                    any_isa<const LazyCallGraph::SCC *>(IR)) {
           const Module *M;
@@ -1201,7 +1220,14 @@ void VerifyInstrumentation::registerCallbacks(
           if (DebugLogging)
             dbgs() << "Verifying module " << M->getName() << "\n";
 
-          if (verifyModule(*M))
+          if (VerifyEachIncremental) {
+            SmallVector<const Function *, 0> Fs;
+            for (const Function &F : *M)
+              if (!F.isDeclaration())
+                Fs.push_back(&F);
+            if (verifyFunctions(Fs) || verifyModuleGlobals(*M))
+              report_fatal_error("Broken module found, compilation aborted!");
+          } else if (verifyModule(*M))
             report_fatal_error("Broken module found, compilation aborted!");
         }
       });
@@ -2128,7 +2154,7 @@ void StandardInstrumentations::registerCallbacks(
     PreservedCFGChecker.registerCallbacks(PIC, *FAM);
   PrintChangedIR.registerCallbacks(PIC);
   PseudoProbeVerification.registerCallbacks(PIC);
-  if (VerifyEach)
+  if (VerifyEach || VerifyEachIncremental)
     Verify.registerCallbacks(PIC);
   PrintChangedDiff.registerCallbacks(PIC);
   WebsiteChangeReporter.registerCallbacks(PIC);
@@ -20,13 +20,19 @@
 #if LLVM_ENABLE_ZLIB
 #include <zlib.h>
 #endif
+#if LLVM_ENABLE_ZSTD
+#include <zstd.h>
+#endif
 
 using namespace llvm;
 
-#if LLVM_ENABLE_ZLIB
+#if LLVM_ENABLE_ZLIB || LLVM_ENABLE_ZSTD
 static Error createError(StringRef Err) {
   return make_error<StringError>(Err, inconvertibleErrorCode());
 }
+#endif
+
+#if LLVM_ENABLE_ZLIB
 
 static StringRef convertZlibCodeToString(int Code) {
   switch (Code) {
@@ -85,6 +91,46 @@ uint32_t zlib::crc32(StringRef Buffer) {
   return ::crc32(0, (const Bytef *)Buffer.data(), Buffer.size());
 }
 
+Error zlib::compressChunk(StringRef Chunk,
+                          SmallVectorImpl<char> &CompressedChunk,
+                          bool IsLastChunk, int Level) {
+  z_stream Stream = {};
+  // Negative window bits: raw deflate without zlib header and trailer.
+  int Res = ::deflateInit2(&Stream, Level, Z_DEFLATED, -MAX_WBITS,
+                           /*memLevel=*/8, Z_DEFAULT_STRATEGY);
+  if (Res != Z_OK)
+    return createError(convertZlibCodeToString(Res));
+
+  // Non-last chunks end with a full flush, so that the next chunk can be
+  // appended without depending on the state of this one. Only the last chunk
+  // may contain the final block.
+  unsigned long Bound = ::deflateBound(&Stream, Chunk.size()) + 16;
+  CompressedChunk.resize_for_overwrite(Bound);
+  Stream.next_in = (Bytef *)Chunk.data();
+  Stream.avail_in = Chunk.size();
+  Stream.next_out = (Bytef *)CompressedChunk.data();
+  Stream.avail_out = Bound;
+  Res = ::deflate(&Stream, IsLastChunk ? Z_FINISH : Z_FULL_FLUSH);
+  size_t CompressedSize = Bound - Stream.avail_out;
+  ::deflateEnd(&Stream);
+  __msan_unpoison(CompressedChunk.data(), CompressedSize);
+  CompressedChunk.truncate(CompressedSize);
+  if (Res != (IsLastChunk ? Z_STREAM_END : Z_OK) || Stream.avail_in != 0 ||
+      Stream.avail_out == 0)
+    return createError("zlib error: failed to compress chunk");
+  return Error::success();
+}
+
+uint32_t zlib::adler32(StringRef Buffer) {
+  return ::adler32(::adler32(0, nullptr, 0), (const Bytef *)Buffer.data(),
+                   Buffer.size());
+}
+
+uint32_t zlib::adler32Combine(uint32_t Adler1, uint32_t Adler2,
+                              size_t Length2) {
+  return ::adler32_combine(Adler1, Adler2, Length2);
+}
+
 #else
 bool zlib::isAvailable() { return false; }
 Error zlib::compress(StringRef InputBuffer,
@@ -103,4 +149,80 @@ Error zlib::uncompress(StringRef InputBuffer,
 uint32_t zlib::crc32(StringRef Buffer) {
   llvm_unreachable("zlib::crc32 is unavailable");
 }
+Error zlib::compressChunk(StringRef Chunk,
+                          SmallVectorImpl<char> &CompressedChunk,
+                          bool IsLastChunk, int Level) {
+  llvm_unreachable("zlib::compressChunk is unavailable");
+}
+uint32_t zlib::adler32(StringRef Buffer) {
+  llvm_unreachable("zlib::adler32 is unavailable");
+}
+uint32_t zlib::adler32Combine(uint32_t Adler1, uint32_t Adler2,
+                              size_t Length2) {
+  llvm_unreachable("zlib::adler32Combine is unavailable");
+}
+#endif
+
+#if LLVM_ENABLE_ZSTD
+
+bool zstd::isAvailable() { return true; }
+
+Error zstd::compress(StringRef InputBuffer,
+                     SmallVectorImpl<char> &CompressedBuffer, int Level) {
+  size_t CompressedBufferSize = ::ZSTD_compressBound(InputBuffer.size());
+  CompressedBuffer.resize_for_overwrite(CompressedBufferSize);
+  size_t CompressedSize =
+      ::ZSTD_compress(CompressedBuffer.data(), CompressedBufferSize,
+                      InputBuffer.data(), InputBuffer.size(), Level);
+  if (::ZSTD_isError(CompressedSize)) {
+    CompressedBuffer.clear();
+    return createError(::ZSTD_getErrorName(CompressedSize));
+  }
+  // Tell MemorySanitizer that zstd output buffer is fully initialized.
+  // This avoids a false report when running LLVM with uninstrumented zstd.
+  __msan_unpoison(CompressedBuffer.data(), CompressedSize);
+  CompressedBuffer.truncate(CompressedSize);
+  return Error::success();
+}
+
+Error zstd::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                       size_t &UncompressedSize) {
+  // NOTE: this handles multiple concatenated frames.
+  const size_t Res =
+      ::ZSTD_decompress(UncompressedBuffer, UncompressedSize,
+                        InputBuffer.data(), InputBuffer.size());
+  if (::ZSTD_isError(Res))
+    return createError(::ZSTD_getErrorName(Res));
+  UncompressedSize = Res;
+  // Tell MemorySanitizer that zstd output buffer is fully initialized.
+  // This avoids a false report when running LLVM with uninstrumented zstd.
+  __msan_unpoison(UncompressedBuffer, UncompressedSize);
+  return Error::success();
+}
+
+Error zstd::uncompress(StringRef InputBuffer,
+                       SmallVectorImpl<char> &UncompressedBuffer,
+                       size_t UncompressedSize) {
+  UncompressedBuffer.resize_for_overwrite(UncompressedSize);
+  Error E =
+      uncompress(InputBuffer, UncompressedBuffer.data(), UncompressedSize);
+  UncompressedBuffer.truncate(UncompressedSize);
+  return E;
+}
+
+#else
+bool zstd::isAvailable() { return false; }
+Error zstd::compress(StringRef InputBuffer,
+                     SmallVectorImpl<char> &CompressedBuffer, int Level) {
+  llvm_unreachable("zstd::compress is unavailable");
+}
+Error zstd::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                       size_t &UncompressedSize) {
+  llvm_unreachable("zstd::uncompress is unavailable");
+}
+Error zstd::uncompress(StringRef InputBuffer,
+                       SmallVectorImpl<char> &UncompressedBuffer,
+                       size_t UncompressedSize) {
+  llvm_unreachable("zstd::uncompress is unavailable");
+}
 #endif
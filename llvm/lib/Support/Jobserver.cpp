@@ -0,0 +1,192 @@
+//===---- Jobserver.cpp - Implement JobserverClient -------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the JobserverClient class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/Jobserver.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Process.h"
+
+using namespace llvm;
+
+StringRef JobserverClient::getJobserverAuth(StringRef MakeFlags) {
+  // Newer versions of make use "--jobserver-auth=", older ones
+  // "--jobserver-fds=". If specified multiple times, the last one wins.
+  StringRef Auth;
+  SmallVector<StringRef, 8> Args;
+  MakeFlags.split(Args, ' ', -1, false);
+  for (StringRef Arg : Args) {
+    if (Arg.consume_front("--jobserver-auth=") ||
+        Arg.consume_front("--jobserver-fds="))
+      Auth = Arg;
+  }
+  return Auth;
+}
+
+#if LLVM_ENABLE_THREADS
+// The connected client, handed to the ManagedStatic below.
+static JobserverClient *ConnectedClient = nullptr;
+
+namespace {
+struct ClientCreator {
+  static void *call() { return ConnectedClient; }
+};
+struct ClientDeleter {
+  static void call(void *Ptr) {
+    static_cast<JobserverClient *>(Ptr)->shutdown();
+  }
+};
+} // namespace
+
+// NOTE: the client itself is intentionally leaked, since worker threads may
+// still use it during shutdown. llvm_shutdown() only returns all tokens.
+static ManagedStatic<JobserverClient, ClientCreator, ClientDeleter>
+    ManagedClient;
+#endif
+
+// The number of job slots held by the current thread.
+static LLVM_THREAD_LOCAL unsigned HeldSlots = 0;
+
+JobserverClient *JobserverClient::getInstance() {
+#if LLVM_ENABLE_THREADS
+  static JobserverClient *Instance = []() -> JobserverClient * {
+    Optional<std::string> MakeFlags = sys::Process::GetEnv("MAKEFLAGS");
+    if (!MakeFlags)
+      return nullptr;
+    StringRef Auth = getJobserverAuth(*MakeFlags);
+    if (Auth.empty())
+      return nullptr;
+    JobserverClient *Client = new JobserverClient();
+    if (!Client->connect(Auth)) {
+      delete Client;
+      return nullptr;
+    }
+    ConnectedClient = Client;
+    (void)*ManagedClient;
+    return Client;
+  }();
+  return Instance;
+#else
+  return nullptr;
+#endif
+}
+
+bool JobserverClient::acquire(function_ref<bool()> Cancelled) {
+  std::unique_lock<std::mutex> Lock(Mutex);
+  while (true) {
+    if (IsShutDown)
+      break;
+    if (Cancelled())
+      return false;
+    if (!ImplicitSlotTaken) {
+      ImplicitSlotTaken = true;
+      break;
+    }
+    if (HasReader || IsBroken) {
+      // Only a single thread waits on the jobserver itself, all others wait
+      // for it (or for the implicit slot to become available).
+      ++NumBlocked;
+      WaiterCond.wait(Lock);
+      --NumBlocked;
+      continue;
+    }
+
+    HasReader = true;
+    Lock.unlock();
+    char Token;
+    ReadResult Res = readToken(Token);
+    Lock.lock();
+    HasReader = false;
+    // Let the next waiter take over reading from the jobserver.
+    WaiterCond.notify_all();
+    if (Res == ReadResult::Token) {
+      if (IsShutDown) {
+        // All other tokens have already been returned, return this one too.
+        Lock.unlock();
+        writeToken(Token);
+        Lock.lock();
+        break;
+      }
+      Tokens.push_back(Token);
+      break;
+    }
+    if (Res == ReadResult::Error)
+      IsBroken = true;
+  }
+  ++HeldSlots;
+  return true;
+}
+
+void JobserverClient::release() {
+  assert(HeldSlots > 0 && "no job slot to release");
+  --HeldSlots;
+  std::unique_lock<std::mutex> Lock(Mutex);
+  if (IsShutDown)
+    return; // All tokens have already been returned.
+  if (!Tokens.empty()) {
+    char Token = Tokens.pop_back_val();
+    Lock.unlock();
+    writeToken(Token);
+    return;
+  }
+  assert(ImplicitSlotTaken && "no job slot to release");
+  ImplicitSlotTaken = false;
+  if (NumBlocked != 0)
+    WaiterCond.notify_all();
+  if (HasReader)
+    interruptRead();
+}
+
+void JobserverClient::wakeWaiters() {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  WaiterCond.notify_all();
+  if (HasReader)
+    interruptRead();
+}
+
+void JobserverClient::shutdown() {
+  SmallVector<char, 16> Returned;
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (IsShutDown)
+      return;
+    IsShutDown = true;
+    Returned.swap(Tokens);
+    WaiterCond.notify_all();
+    if (HasReader)
+      interruptRead();
+  }
+  for (char Token : Returned)
+    writeToken(Token);
+}
+
+JobserverClient::LentSlot::LentSlot() {
+  if (HeldSlots == 0)
+    return;
+  Client = getInstance();
+  if (Client)
+    Client->release();
+}
+
+JobserverClient::LentSlot::~LentSlot() {
+  if (Client)
+    Client->acquire([] { return false; });
+}
+
+// Include the platform-specific parts of this class.
+#ifdef LLVM_ON_UNIX
+#include "Unix/Jobserver.inc"
+#endif
+#ifdef _WIN32
+#include "Windows/Jobserver.inc"
+#endif
@@ -8,12 +8,14 @@
 
 #include "llvm/Support/Parallel.h"
 #include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Jobserver.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Threading.h"
 
 #include <atomic>
+#include <deque>
 #include <future>
-#include <stack>
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -27,21 +29,142 @@ namespace detail {
 
 namespace {
 
+using Task = unique_function<void()>;
+
 /// An abstract class that takes closures and runs them asynchronously.
 class Executor {
 public:
   virtual ~Executor() = default;
-  virtual void add(std::function<void()> func) = 0;
+  virtual void add(Task F) = 0;
+
+  /// Runs one pending task on the calling thread if it is a worker thread of
+  /// this executor. Returns false if no pending task could be run.
+  virtual bool runPendingTask() = 0;
 
   static Executor *getDefaultExecutor();
 };
 
-/// An implementation of an Executor that runs closures on a thread pool
-///   in filo order.
+/// A Chase-Lev work-stealing deque of heap-allocated tasks ("Dynamic Circular
+/// Work-Stealing Deque", Chase and Lev 2005; memory orderings as per "Correct
+/// and Efficient Work-Stealing for Weak Memory Models", Le et al. 2013).
+/// Only the owning thread may push() and pop() at the bottom, any thread may
+/// steal() from the top.
+class WorkStealingDeque {
+  class Buffer {
+    int64_t Mask;
+    std::unique_ptr<std::atomic<Task *>[]> Slots;
+
+  public:
+    explicit Buffer(int64_t Capacity)
+        : Mask(Capacity - 1), Slots(new std::atomic<Task *>[Capacity]) {}
+
+    int64_t capacity() const { return Mask + 1; }
+    Task *get(int64_t I) const {
+      return Slots[I & Mask].load(std::memory_order_relaxed);
+    }
+    void put(int64_t I, Task *T) {
+      Slots[I & Mask].store(T, std::memory_order_relaxed);
+    }
+  };
+
+  alignas(64) std::atomic<int64_t> Top{0};
+  alignas(64) std::atomic<int64_t> Bottom{0};
+  std::atomic<Buffer *> Buf;
+  // Thieves may still read from a buffer after it has been replaced by a
+  // bigger one, so all buffers are kept alive until the deque is destroyed.
+  std::vector<std::unique_ptr<Buffer>> Buffers;
+
+public:
+  WorkStealingDeque() {
+    Buffers.push_back(std::make_unique<Buffer>(256));
+    Buf.store(Buffers.back().get(), std::memory_order_relaxed);
+  }
+
+  ~WorkStealingDeque() {
+    Buffer *B = Buf.load(std::memory_order_relaxed);
+    for (int64_t I = Top.load(std::memory_order_relaxed),
+                 E = Bottom.load(std::memory_order_relaxed);
+         I < E; ++I)
+      delete B->get(I);
+  }
+
+  void push(Task *T) {
+    int64_t B = Bottom.load(std::memory_order_relaxed);
+    int64_t TopIdx = Top.load(std::memory_order_acquire);
+    Buffer *A = Buf.load(std::memory_order_relaxed);
+    if (B - TopIdx > A->capacity() - 1) {
+      Buffers.push_back(std::make_unique<Buffer>(A->capacity() * 2));
+      Buffer *Grown = Buffers.back().get();
+      for (int64_t I = TopIdx; I != B; ++I)
+        Grown->put(I, A->get(I));
+      Buf.store(Grown, std::memory_order_release);
+      A = Grown;
+    }
+    A->put(B, T);
+    std::atomic_thread_fence(std::memory_order_release);
+    Bottom.store(B + 1, std::memory_order_relaxed);
+  }
+
+  Task *pop() {
+    int64_t B = Bottom.load(std::memory_order_relaxed) - 1;
+    Buffer *A = Buf.load(std::memory_order_relaxed);
+    Bottom.store(B, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t TopIdx = Top.load(std::memory_order_relaxed);
+    if (TopIdx > B) {
+      // Empty.
+      Bottom.store(B + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    Task *T = A->get(B);
+    if (TopIdx == B) {
+      // Last element, race against thieves.
+      if (!Top.compare_exchange_strong(TopIdx, TopIdx + 1,
+                                       std::memory_order_seq_cst,
+                                       std::memory_order_relaxed))
+        T = nullptr;
+      Bottom.store(B + 1, std::memory_order_relaxed);
+    }
+    return T;
+  }
+
+  Task *steal() {
+    int64_t TopIdx = Top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t B = Bottom.load(std::memory_order_acquire);
+    if (TopIdx >= B)
+      return nullptr;
+    Buffer *A = Buf.load(std::memory_order_acquire);
+    Task *T = A->get(TopIdx);
+    if (!Top.compare_exchange_strong(TopIdx, TopIdx + 1,
+                                     std::memory_order_seq_cst,
+                                     std::memory_order_relaxed))
+      return nullptr;
+    return T;
+  }
+};
+
+class ThreadPoolExecutor;
+
+// The executor and worker index of the current thread, if it is a worker.
+static LLVM_THREAD_LOCAL ThreadPoolExecutor *CurrentExecutor = nullptr;
+static LLVM_THREAD_LOCAL unsigned CurrentWorker = 0;
+// The number of tasks the current worker is running while waiting for a
+// TaskGroup.
+static LLVM_THREAD_LOCAL unsigned HelpDepth = 0;
+
+/// An implementation of an Executor that runs closures on a thread pool.
+/// Each worker has its own work-stealing deque: tasks added by a worker are
+/// pushed onto its own deque and run in filo order, idle workers steal the
+/// oldest tasks of other workers. Tasks added by any other thread go through
+/// a shared fifo queue.
 class ThreadPoolExecutor : public Executor {
 public:
   explicit ThreadPoolExecutor(ThreadPoolStrategy S = hardware_concurrency()) {
     unsigned ThreadCount = S.compute_thread_count();
+    Deques.reserve(ThreadCount);
+    for (unsigned I = 0; I < ThreadCount; ++I)
+      Deques.push_back(std::make_unique<WorkStealingDeque>());
     // Spawn all but one of the threads in another thread as spawning threads
     // can take a while.
     Threads.reserve(ThreadCount);
@@ -66,6 +189,9 @@ public:
       Stop = true;
     }
     Cond.notify_all();
+    // Workers blocked waiting for a job slot must notice the stop as well.
+    if (JobserverClient *Jobserver = JobserverClient::getInstance())
+      Jobserver->wakeWaiters();
     ThreadsCreated.get_future().wait();
   }
 
@@ -77,6 +203,8 @@ public:
         T.detach();
       else
         T.join();
+    for (Task *T : Injected)
+      delete T;
   }
 
   struct Creator {
@@ -86,31 +214,130 @@ public:
     static void call(void *Ptr) { ((ThreadPoolExecutor *)Ptr)->stop(); }
   };
 
-  void add(std::function<void()> F) override {
-    {
-      std::lock_guard<std::mutex> Lock(Mutex);
-      WorkStack.push(F);
+  void add(Task F) override {
+    Task *T = new Task(std::move(F));
+    // Count the task before publishing it: once it is pushed, another worker
+    // may take it (and decrement PendingTasks) right away.
+    PendingTasks.fetch_add(1);
+    if (CurrentExecutor == this) {
+      Deques[CurrentWorker]->push(T);
+    } else {
+      std::lock_guard<std::mutex> Lock(InjectedMutex);
+      Injected.push_back(T);
+      NumInjected.fetch_add(1);
+    }
+    // Only take the lock if a worker may be sleeping. This pairs with the
+    // NumSleeping increment / PendingTasks check in work(): either the adding
+    // thread sees the sleeper or the sleeper sees the new task.
+    if (NumSleeping.load() != 0) {
+      { std::lock_guard<std::mutex> Lock(Mutex); }
+      Cond.notify_one();
     }
-    Cond.notify_one();
+  }
+
+  bool runPendingTask() override {
+    if (CurrentExecutor != this)
+      return false;
+    // Tasks run while helping are nested on the stack of the waiting task.
+    // Once this gets deep, only run tasks from the own deque, which are
+    // (transitively) spawned by the waiting task, and don't steal unrelated
+    // (and potentially deeply nesting) tasks from other threads.
+    Task *T = HelpDepth < MaxHelpDepth ? findTask()
+                                       : Deques[CurrentWorker]->pop();
+    if (!T)
+      return false;
+    if (HelpDepth >= MaxHelpDepth)
+      PendingTasks.fetch_sub(1);
+    ++HelpDepth;
+    run(T);
+    --HelpDepth;
+    return true;
   }
 
 private:
+  static constexpr unsigned MaxHelpDepth = 32;
+
+  void run(Task *T) {
+    std::unique_ptr<Task> Owned(T);
+    (*Owned)();
+  }
+
+  /// Finds a pending task for the calling thread: first from its own deque
+  /// (if it is a worker), then from the shared queue, then by stealing from
+  /// the other workers.
+  Task *findTask() {
+    const bool IsWorker = CurrentExecutor == this;
+    Task *T = nullptr;
+    if (IsWorker)
+      T = Deques[CurrentWorker]->pop();
+    if (!T && NumInjected.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> Lock(InjectedMutex);
+      if (!Injected.empty()) {
+        T = Injected.front();
+        Injected.pop_front();
+        NumInjected.fetch_sub(1);
+      }
+    }
+    if (!T) {
+      // Start at a different victim on every attempt to spread contention.
+      const size_t NumDeques = Deques.size();
+      const size_t Start = NextVictim.fetch_add(1, std::memory_order_relaxed);
+      for (size_t I = 0; I < NumDeques && !T; ++I) {
+        const size_t Victim = (Start + I) % NumDeques;
+        if (IsWorker && Victim == CurrentWorker)
+          continue;
+        T = Deques[Victim]->steal();
+      }
+    }
+    if (T)
+      PendingTasks.fetch_sub(1);
+    return T;
+  }
+
   void work(ThreadPoolStrategy S, unsigned ThreadID) {
     S.apply_thread_strategy(ThreadID);
-    while (true) {
+    CurrentExecutor = this;
+    CurrentWorker = ThreadID;
+    // With a jobserver, workers must hold a job slot while running tasks.
+    JobserverClient *Jobserver =
+        S.UseJobserver ? JobserverClient::getInstance() : nullptr;
+    bool HasSlot = false;
+    while (!Stop) {
+      if (Jobserver && !HasSlot && PendingTasks.load() != 0) {
+        // This blocks until a slot is available, or gives up once there is
+        // nothing left to do.
+        HasSlot = Jobserver->acquire(
+            [this] { return Stop || PendingTasks.load() == 0; });
+      }
+      if (!Jobserver || HasSlot) {
+        if (Task *T = findTask()) {
+          run(T);
+          continue;
+        }
+      }
+      // Out of work: return the slot, so that other jobs can use it.
+      if (HasSlot) {
+        Jobserver->release();
+        HasSlot = false;
+      }
       std::unique_lock<std::mutex> Lock(Mutex);
-      Cond.wait(Lock, [&] { return Stop || !WorkStack.empty(); });
-      if (Stop)
-        break;
-      auto Task = WorkStack.top();
-      WorkStack.pop();
-      Lock.unlock();
-      Task();
+      NumSleeping.fetch_add(1);
+      Cond.wait(Lock, [&] { return Stop || PendingTasks.load() != 0; });
+      NumSleeping.fetch_sub(1);
     }
+    if (HasSlot)
+      Jobserver->release();
   }
 
   std::atomic<bool> Stop{false};
-  std::stack<std::function<void()>> WorkStack;
+  // Number of tasks that have been added but not yet taken by any thread.
+  std::atomic<size_t> PendingTasks{0};
+  std::atomic<unsigned> NumSleeping{0};
+  std::atomic<size_t> NextVictim{0};
+  std::vector<std::unique_ptr<WorkStealingDeque>> Deques;
+  std::deque<Task *> Injected;
+  std::atomic<size_t> NumInjected{0};
+  std::mutex InjectedMutex;
   std::mutex Mutex;
   std::condition_variable Cond;
   std::promise<void> ThreadsCreated;
@@ -135,6 +362,9 @@ Executor *Executor::getDefaultExecutor() {
   // are more frequent with the debug static runtime.
   //
   // This also prevents intermittent deadlocks on exit with the MinGW runtime.
+  //
+  // Since the worker threads are not joined on a fast exit, job slots they may
+  // still hold are returned by the JobserverClient on llvm_shutdown() itself.
 
   static ManagedStatic<ThreadPoolExecutor, ThreadPoolExecutor::Creator,
                        ThreadPoolExecutor::Deleter>
@@ -144,24 +374,16 @@ Executor *Executor::getDefaultExecutor() {
 }
 } // namespace
 
-static std::atomic<int> TaskGroupInstances;
-
-// Latch::sync() called by the dtor may cause one thread to block. If is a dead
-// lock if all threads in the default executor are blocked. To prevent the dead
-// lock, only allow the first TaskGroup to run tasks parallelly. In the scenario
-// of nested parallel_for_each(), only the outermost one runs parallelly.
-TaskGroup::TaskGroup() : Parallel(TaskGroupInstances++ == 0) {}
-TaskGroup::~TaskGroup() {
-  // We must ensure that all the workloads have finished before decrementing the
-  // instances count.
-  L.sync();
-  --TaskGroupInstances;
-}
+// A worker thread waiting for a TaskGroup runs pending tasks instead of
+// blocking, so nested TaskGroups (e.g. a parallel_for_each() inside a
+// parallel_for_each()) can run in parallel without deadlocking the executor.
+TaskGroup::TaskGroup() : Parallel(strategy.ThreadsRequested != 1) {}
+TaskGroup::~TaskGroup() { sync(); }
 
-void TaskGroup::spawn(std::function<void()> F) {
+void TaskGroup::spawn(unique_function<void()> F) {
   if (Parallel) {
     L.inc();
-    Executor::getDefaultExecutor()->add([&, F] {
+    Executor::getDefaultExecutor()->add([&, F = std::move(F)]() mutable {
       F();
       L.dec();
     });
@@ -170,6 +392,26 @@ void TaskGroup::spawn(std::function<void()> F) {
   }
 }
 
+void TaskGroup::sync() const {
+  if (!Parallel)
+    return;
+  if (!CurrentExecutor) {
+    // This may be a thread of another pool that holds a job slot, which the
+    // workers running the tasks of this group may need.
+    JobserverClient::LentSlot Lent;
+    L.sync();
+    return;
+  }
+  Executor *Exec = Executor::getDefaultExecutor();
+  while (!L.isDone()) {
+    // If there is nothing left to run, the remaining tasks of this group are
+    // running on other threads, which may still spawn nested tasks, so only
+    // wait for a short amount of time.
+    if (!Exec->runPendingTask())
+      L.syncFor(std::chrono::microseconds(100));
+  }
+}
+
 } // namespace detail
 } // namespace parallel
 } // namespace llvm
@@ -178,9 +420,7 @@ void TaskGroup::spawn(std::function<void()> F) {
 void llvm::parallelForEachN(size_t Begin, size_t End,
                             llvm::function_ref<void(size_t)> Fn) {
   // If we have zero or one items, then do not incur the overhead of spinning up
-  // a task group.  They are surprisingly expensive, and because they do not
-  // support nested parallelism, a single entry task group can block parallel
-  // execution underneath them.
+  // a task group.  They are surprisingly expensive.
 #if LLVM_ENABLE_THREADS
   auto NumItems = End - Begin;
   if (NumItems > 1 && parallel::strategy.ThreadsRequested != 1) {
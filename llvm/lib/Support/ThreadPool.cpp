@@ -15,6 +15,7 @@
 #include "llvm/Config/llvm-config.h"
 
 #if LLVM_ENABLE_THREADS
+#include "llvm/Support/Jobserver.h"
 #include "llvm/Support/Threading.h"
 #else
 #include "llvm/Support/raw_ostream.h"
@@ -36,16 +37,37 @@ void ThreadPool::grow(int requested) {
     int ThreadID = Threads.size();
     Threads.emplace_back([this, ThreadID] {
       Strategy.apply_thread_strategy(ThreadID);
+      // With a jobserver, threads must hold a job slot while running tasks.
+      JobserverClient *Jobserver =
+          Strategy.UseJobserver ? JobserverClient::getInstance() : nullptr;
+      bool HasSlot = false;
       while (true) {
         std::function<void()> Task;
         {
           std::unique_lock<std::mutex> LockGuard(QueueLock);
+          // Out of work: return the slot, so that other jobs can use it.
+          if (HasSlot && Tasks.empty()) {
+            LockGuard.unlock();
+            Jobserver->release();
+            HasSlot = false;
+            LockGuard.lock();
+          }
           // Wait for tasks to be pushed in the queue
           QueueCondition.wait(LockGuard,
                               [&] { return !EnableFlag || !Tasks.empty(); });
           // Exit condition
           if (!EnableFlag && Tasks.empty())
             return;
+          if (Jobserver && !HasSlot) {
+            // Don't hold the queue lock while waiting for a slot, give up if
+            // other threads have taken all tasks in the meantime.
+            LockGuard.unlock();
+            HasSlot = Jobserver->acquire([this] {
+              std::lock_guard<std::mutex> LockGuard(QueueLock);
+              return Tasks.empty();
+            });
+            continue;
+          }
           // Yeah, we have a task, grab it and release the lock on the queue
 
           // We first need to signal that we are active before popping the queue
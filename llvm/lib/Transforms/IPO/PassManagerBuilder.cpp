@@ -193,6 +193,57 @@ cl::opt<AttributorRunOption> AttributorRun(
 extern cl::opt<bool> EnableKnowledgeRetention;
 } // namespace llvm
 
+static cl::opt<bool> EnableFloorLocalMemoryOverlay(
+    "floor-local-memory-overlay", cl::init(true), cl::Hidden,
+    cl::desc("Overlay local memory variables with disjoint barrier-delimited "
+             "lifetimes (CUDA/Metal/OpenCL)"));
+
+static cl::opt<bool> EnableFloorSubGroupAtomicAggregation(
+    "floor-sub-group-atomic-aggregation", cl::init(false), cl::Hidden,
+    cl::desc("Combine atomics on sub-group uniform addresses into a single "
+             "atomic per sub-group (CUDA)"));
+
+static cl::opt<bool> EnableFloorPrivateArrayPromotion(
+    "floor-private-array-promotion", cl::init(true), cl::Hidden,
+    cl::desc("Promote dynamically indexed private arrays to registers or "
+             "work-group local memory (CUDA/Metal/OpenCL/Vulkan)"));
+
+static cl::opt<unsigned> FloorPrivateArrayRegisterBudget(
+    "floor-private-array-register-budget", cl::init(16), cl::Hidden,
+    cl::desc("Max number of 32-bit registers a private array promoted to "
+             "registers may occupy (each dynamic store to an array with N "
+             "elements expands to N loads, selects and stores)"));
+
+static cl::opt<unsigned> FloorPrivateArrayLocalMemoryBudget(
+    "floor-private-array-local-memory-budget", cl::init(16384), cl::Hidden,
+    cl::desc("Max amount of local memory (in bytes) a kernel may use after "
+             "promoting private arrays to local memory"));
+
+static cl::opt<bool> EnableFloorRegisterPressureSinking(
+    "floor-register-pressure-sinking", cl::init(true), cl::Hidden,
+    cl::desc("Sink and rematerialize cheap values next to their uses in "
+             "high register pressure functions (Metal/Vulkan)"));
+
+static cl::opt<unsigned> FloorRegisterPressureTarget(
+    "floor-register-pressure-target", cl::init(64), cl::Hidden,
+    cl::desc("Max number of 32-bit registers that should be live at any "
+             "point before sinking/rematerializing values"));
+
+static cl::opt<bool> EnableFloorLocalMemoryPadding(
+    "floor-local-memory-padding", cl::init(false), cl::Hidden,
+    cl::desc("Pad the innermost dimension of local memory arrays to avoid "
+             "bank conflicts (CUDA/Metal/OpenCL/Vulkan)"));
+
+static cl::opt<unsigned> FloorLocalMemoryBankCount(
+    "floor-local-memory-bank-count", cl::init(0), cl::Hidden,
+    cl::desc("Number of local memory banks used for bank conflict analysis "
+             "(0 = backend default)"));
+
+static cl::opt<unsigned> FloorLocalMemoryBankWidth(
+    "floor-local-memory-bank-width", cl::init(0), cl::Hidden,
+    cl::desc("Width of each local memory bank in bytes used for bank conflict "
+             "analysis (0 = backend default)"));
+
 PassManagerBuilder::PassManagerBuilder() {
     OptLevel = 2;
     SizeLevel = 0;
@@ -232,6 +283,9 @@ PassManagerBuilder::PassManagerBuilder() {
     EnableVerifySPIR = false;
     EnableVulkanPasses = false;
     EnableVulkanLLVMPreStructurizationPass = false;
+    EnableHostComputeWorkGroupLoops = false;
+    EnableRelaxedPrecisionDemotion = false;
+    EnableRelaxedPrecisionFragmentOutputs = false;
 }
 
 PassManagerBuilder::~PassManagerBuilder() {
@@ -735,6 +789,11 @@ void PassManagerBuilder::populateModulePassManager(
   }
   // if(EnableSPIRPasses) --none
 
+  // create constant work-group size kernel variants before any other optimizations are run on them
+  if (!floor_work_group_size_variants.empty()) {
+    MPM.add(createKernelWorkGroupSizeVariantsPass(floor_work_group_size_variants));
+  }
+
   // run this before any other major optimizations (it will be helpful to them)
   MPM.add(createPropagateRangeInfoPass());
 
@@ -896,6 +955,19 @@ void PassManagerBuilder::populateModulePassManager(
   // with constants potentially changing/improving the behavior and allowing
   // additional checking (like oob offsets).
   if(EnableCUDAPasses || EnableMetalPasses || EnableSPIRPasses) {
+    // with everything inlined, local size builtins can now be replaced by constants (if known)
+    MPM.add(createConstantLocalSizePass());
+
+    // report how global memory accesses are coalesced (only if remarks are enabled, must run before the id builtins are replaced)
+    if (OptLevel > 0) {
+      MPM.add(createMemoryCoalescingAnalysisPass());
+    }
+
+    // demote float dataflow feeding into low precision sinks to half (before image functions are lowered)
+    if (EnableRelaxedPrecisionDemotion && OptLevel > 0 && (EnableMetalPasses || EnableVulkanPasses)) {
+      MPM.add(createRelaxedPrecisionDemotionPass(EnableRelaxedPrecisionFragmentOutputs));
+    }
+
     if(EnableCUDAPasses) MPM.add(createCUDAImagePass(floor_image_capabilities));
     if(EnableMetalPasses) MPM.add(createMetalImagePass(floor_image_capabilities));
     if(EnableSPIRPasses) {
@@ -918,6 +990,23 @@ void PassManagerBuilder::populateModulePassManager(
     MPM.add(createCFGSimplificationPass());
     MPM.add(createInstructionCombiningPass(EnableVulkanPasses));
     addExtensionsToPM(EP_Peephole, MPM);
+
+    // with everything inlined and unrolled, any remaining private arrays are dynamically indexed
+    // -> move them out of private memory
+    if (EnableFloorPrivateArrayPromotion && OptLevel > 0) {
+      MPM.add(createPromotePrivateArraysPass(FloorPrivateArrayRegisterBudget,
+                                             FloorPrivateArrayLocalMemoryBudget));
+      MPM.add(createInstructionCombiningPass(EnableVulkanPasses));
+    }
+  }
+
+  // with everything inlined, host-compute kernels can be put into a work-group loop nest,
+  // which is then tiled/interchanged by Polly (before the vectorizer) and vectorized
+  if (EnableHostComputeWorkGroupLoops && OptLevel > 0) {
+    MPM.add(createHostComputeWorkGroupLoopsPass());
+    // hoist the uniform id/size loads out of the loop nest
+    MPM.add(createLICMPass());
+    MPM.add(createInstructionCombiningPass());
   }
 
   if (RunPartialInlining)
@@ -1081,6 +1170,25 @@ void PassManagerBuilder::populateModulePassManager(
 
   addExtensionsToPM(EP_OptimizerLast, MPM);
 
+  // report local memory bank conflicts and pad local memory arrays to avoid them
+  // NOTE: must run before the id builtins are replaced and before local memory variables are overlaid
+  if (OptLevel > 0 && (EnableCUDAPasses || EnableMetalPasses || EnableSPIRPasses)) {
+    MPM.add(createLocalMemoryBankConflictsPass(EnableFloorLocalMemoryPadding, FloorLocalMemoryBankCount,
+                                               FloorLocalMemoryBankWidth));
+  }
+
+  // overlay local memory variables with non-overlapping lifetimes
+  // NOTE: not possible with Vulkan/SPIR-V, since reinterpreting workgroup memory is not allowed there
+  if (EnableFloorLocalMemoryOverlay && OptLevel > 0 &&
+      (EnableCUDAPasses || EnableMetalPasses || (EnableSPIRPasses && !EnableVulkanPasses))) {
+    MPM.add(createLocalMemoryOverlayPass());
+  }
+
+  // combine atomics on uniform addresses within each sub-group
+  if (EnableFloorSubGroupAtomicAggregation && OptLevel > 0 && EnableCUDAPasses) {
+    MPM.add(createSubGroupAtomicAggregationPass());
+  }
+
   // run backend final passes at the very end, no IR should change after this point!
   if (EnableCUDAPasses) MPM.add(createCUDAFinalPass());
   if (EnableSPIRPasses) {
@@ -1150,11 +1258,23 @@ void PassManagerBuilder::populateModulePassManager(
     MPM.add(createInstructionCombiningPass(true /* Vulkan */));
     // NOTE: use new GVN here, b/c it doesn't change basic blocks
     MPM.add(createNewGVNPass());
+    // remove structurization residue, while keeping the structured CFG (merge/continue markers) intact
+    MPM.add(createVulkanStructuredCleanupPass());
+    MPM.add(createInstructionCombiningPass(true /* Vulkan */));
     MPM.add(createAggressiveDCEPass(false /* don't allow CFG removal */));
   }
 
+  // sink/rematerialize cheap values next to their uses to reduce the peak register pressure
+  // NOTE: must run after all cleanup passes, since GVN/CSE would undo this
+  if (EnableFloorRegisterPressureSinking && OptLevel > 0 && (EnableMetalPasses || EnableVulkanPasses)) {
+    MPM.add(createRegisterPressureSinkingPass(FloorRegisterPressureTarget));
+  }
+
   if (EnableVerifySPIR) MPM.add(createSpirValidationPass());
 
+  // must run last, after all backend passes have finished
+  if (floor_resource_usage_cb) MPM.add(createFloorResourceUsagePass(floor_resource_usage_cb));
+
   if (PrepareForLTO) {
     MPM.add(createCanonicalizeAliasesPass());
     // Rename anon globals to be able to handle them in the summary
@@ -137,7 +137,8 @@ namespace {
 			
 			translator.cfg_to_llvm_ir(structurizer.get_entry_block(), true);
 			
-#if !defined(NDEBUG) || 1 // TODO: disable in release mode later on - for now, always keep it on
+			// NOTE: in release mode, use -verify-each-incremental to verify all functions that were changed by this pass
+#if !defined(NDEBUG)
 			const auto verify_failed = verifyFunction(F, &errs());
 			if (verify_failed) {
 				errs().flush();
@@ -0,0 +1,275 @@
+//===- FloorAffineIdAnalysis.cpp - affine work-item id analysis -----------===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the decomposition of values/addresses into affine
+// functions of the work-item id builtins of all GPU backends.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/IntrinsicsNVPTX.h"
+#include "llvm/Transforms/LibFloor/FloorAffineIdAnalysis.h"
+using namespace llvm;
+
+namespace {
+	//! returns true if "V" is uniform across all work-items of a work-group
+	//! NOTE: this is a conservative approximation that doesn't consider control flow (divergent PHIs are not uniform)
+	bool is_uniform_value(const Value& V, SmallPtrSetImpl<const Value*>& visited, const uint32_t depth = 0) {
+		if (isa<Constant>(V) || isa<Argument>(V)) {
+			return true;
+		}
+		if (depth > 8u || !visited.insert(&V).second) {
+			return false;
+		}
+		const auto I = dyn_cast<Instruction>(&V);
+		if (!I || isa<PHINode>(I) || isa<AllocaInst>(I)) {
+			return false;
+		}
+		if (isa<CallBase>(I)) {
+			return (get_floor_id_kind(*I) == FLOOR_ID_KIND::UNIFORM);
+		}
+		if (I->mayHaveSideEffects()) {
+			return false;
+		}
+		// NOTE: this includes loads from uniform addresses
+		return all_of(I->operands(), [&visited, &depth](const Use& op) {
+			return is_uniform_value(*op.get(), visited, depth + 1u);
+		});
+	}
+} // namespace
+
+FLOOR_ID_KIND llvm::get_floor_id_kind(const Value& V) {
+	const auto CI = dyn_cast<CallInst>(&V);
+	if (!CI) {
+		return FLOOR_ID_KIND::NONE;
+	}
+	if (const auto II = dyn_cast<IntrinsicInst>(CI); II) {
+		switch (II->getIntrinsicID()) {
+			case Intrinsic::nvvm_read_ptx_sreg_tid_x:
+			case Intrinsic::nvvm_read_ptx_sreg_laneid:
+				return FLOOR_ID_KIND::FAST;
+			case Intrinsic::nvvm_read_ptx_sreg_tid_y:
+			case Intrinsic::nvvm_read_ptx_sreg_tid_z:
+				return FLOOR_ID_KIND::SLOW;
+			case Intrinsic::nvvm_read_ptx_sreg_ctaid_x:
+			case Intrinsic::nvvm_read_ptx_sreg_ctaid_y:
+			case Intrinsic::nvvm_read_ptx_sreg_ctaid_z:
+			case Intrinsic::nvvm_read_ptx_sreg_ntid_x:
+			case Intrinsic::nvvm_read_ptx_sreg_ntid_y:
+			case Intrinsic::nvvm_read_ptx_sreg_ntid_z:
+			case Intrinsic::nvvm_read_ptx_sreg_nctaid_x:
+			case Intrinsic::nvvm_read_ptx_sreg_nctaid_y:
+			case Intrinsic::nvvm_read_ptx_sreg_nctaid_z:
+			case Intrinsic::nvvm_read_ptx_sreg_warpid:
+				return FLOOR_ID_KIND::UNIFORM;
+			default:
+				return FLOOR_ID_KIND::NONE;
+		}
+	}
+
+	const auto called_func = CI->getCalledFunction();
+	if (!called_func || !called_func->hasName()) {
+		return FLOOR_ID_KIND::NONE;
+	}
+	const auto func_name = called_func->getName();
+	// dim-dependent ids: x dim is fast, y/z dims are slow, unknown dims are treated as slow
+	if (func_name == "floor.get_global_id.i32" /* Metal */ ||
+		func_name == "floor.get_local_id.i32" /* Metal */ ||
+		func_name == "floor.builtin.global_id.i32" /* Vulkan */ ||
+		func_name == "floor.builtin.local_id.i32" /* Vulkan */ ||
+		func_name == "_Z13get_global_idj" /* OpenCL/SPIR */ ||
+		func_name == "_Z12get_local_idj" /* OpenCL/SPIR */) {
+		if (const auto dim = dyn_cast<ConstantInt>(CI->getArgOperand(0)); dim && dim->isZero()) {
+			return FLOOR_ID_KIND::FAST;
+		}
+		return FLOOR_ID_KIND::SLOW;
+	}
+	if (func_name == "floor.get_sub_group_local_id.i32" /* Metal */ ||
+		func_name == "floor.builtin.sub_group_local_id.i32" /* Vulkan */ ||
+		func_name == "_Z22get_sub_group_local_idv" /* OpenCL/SPIR */) {
+		return FLOOR_ID_KIND::FAST;
+	}
+	if (func_name.startswith("floor.get_group_id.") ||
+		func_name.startswith("floor.get_local_size.") ||
+		func_name.startswith("floor.get_global_size.") ||
+		func_name.startswith("floor.get_group_size.") ||
+		func_name.startswith("floor.get_sub_group_id.") ||
+		func_name.startswith("floor.get_sub_group_size.") ||
+		func_name.startswith("floor.get_num_sub_groups.") ||
+		func_name.startswith("floor.get_work_dim.") ||
+		func_name == "floor.builtin.group_id.i32" ||
+		func_name == "floor.builtin.local_size.i32" ||
+		func_name == "floor.builtin.global_size.i32" ||
+		func_name == "floor.builtin.group_size.i32" ||
+		func_name == "floor.builtin.sub_group_id.i32" ||
+		func_name == "floor.builtin.sub_group_size.i32" ||
+		func_name == "floor.builtin.num_sub_groups.i32" ||
+		func_name == "floor.builtin.work_dim.i32" ||
+		func_name == "_Z12get_group_idj" ||
+		func_name == "_Z14get_local_sizej" ||
+		func_name == "_Z23get_enqueued_local_sizej" ||
+		func_name == "_Z15get_global_sizej" ||
+		func_name == "_Z14get_num_groupsj" ||
+		func_name == "_Z12get_work_dimv" ||
+		func_name == "_Z16get_sub_group_idv" ||
+		func_name == "_Z18get_sub_group_sizev" ||
+		func_name == "_Z18get_num_sub_groupsv") {
+		return FLOOR_ID_KIND::UNIFORM;
+	}
+	return FLOOR_ID_KIND::NONE;
+}
+
+floor_affine_id_info llvm::analyze_floor_affine_id_scev(const SCEV* S) {
+	floor_affine_id_info info;
+	switch (S->getSCEVType()) {
+		case scConstant:
+			return info;
+		case scUnknown: {
+			const auto V = cast<SCEVUnknown>(S)->getValue();
+			switch (get_floor_id_kind(*V)) {
+				case FLOOR_ID_KIND::FAST:
+					info.fast_stride = 1;
+					return info;
+				case FLOOR_ID_KIND::SLOW:
+					info.has_slow_ids = true;
+					return info;
+				case FLOOR_ID_KIND::UNIFORM:
+					return info;
+				case FLOOR_ID_KIND::NONE:
+					break;
+			}
+			SmallPtrSet<const Value*, 16> visited;
+			info.non_affine = !is_uniform_value(*V, visited);
+			return info;
+		}
+		case scTruncate:
+		case scZeroExtend:
+		case scSignExtend:
+		case scPtrToInt:
+			// NOTE: assume that id computations don't overflow
+			return analyze_floor_affine_id_scev(cast<SCEVCastExpr>(S)->getOperand());
+		case scAddExpr:
+			for (const auto op : cast<SCEVAddExpr>(S)->operands()) {
+				info += analyze_floor_affine_id_scev(op);
+			}
+			return info;
+		case scMulExpr: {
+			// at most one operand may depend on the ids, all others must be uniform
+			int64_t const_factor = 1;
+			bool has_uniform_factor = false;
+			Optional<floor_affine_id_info> varying_info;
+			for (const auto op : cast<SCEVMulExpr>(S)->operands()) {
+				if (const auto const_op = dyn_cast<SCEVConstant>(op); const_op) {
+					const_factor *= const_op->getAPInt().getSExtValue();
+					continue;
+				}
+				const auto op_info = analyze_floor_affine_id_scev(op);
+				if (op_info.is_uniform()) {
+					has_uniform_factor = true;
+					continue;
+				}
+				if (varying_info) {
+					// product of id-dependent values
+					info.non_affine = true;
+					return info;
+				}
+				varying_info = op_info;
+			}
+			if (!varying_info) {
+				return info;
+			}
+			info = *varying_info;
+			info.fast_stride *= const_factor;
+			if (has_uniform_factor && info.is_fast_varying()) {
+				info.dynamic_stride = true;
+			}
+			return info;
+		}
+		case scAddRecExpr: {
+			// loop induction: the start determines the per work-item offset, the step must be uniform
+			const auto add_rec = cast<SCEVAddRecExpr>(S);
+			info = analyze_floor_affine_id_scev(add_rec->getStart());
+			for (size_t i = 1, count = add_rec->getNumOperands(); i < count; ++i) {
+				if (!analyze_floor_affine_id_scev(add_rec->getOperand(i)).is_uniform()) {
+					info.non_affine = true;
+				}
+			}
+			return info;
+		}
+		case scUDivExpr: {
+			const auto udiv = cast<SCEVUDivExpr>(S);
+			info.non_affine = (!analyze_floor_affine_id_scev(udiv->getLHS()).is_uniform() ||
+							   !analyze_floor_affine_id_scev(udiv->getRHS()).is_uniform());
+			return info;
+		}
+		case scUMaxExpr:
+		case scSMaxExpr:
+		case scUMinExpr:
+		case scSMinExpr:
+		case scSequentialUMinExpr:
+			// only affine if all operands are uniform
+			for (const auto op : cast<SCEVNAryExpr>(S)->operands()) {
+				if (!analyze_floor_affine_id_scev(op).is_uniform()) {
+					info.non_affine = true;
+					break;
+				}
+			}
+			return info;
+		default:
+			info.non_affine = true;
+			return info;
+	}
+}
+
+floor_affine_id_info llvm::analyze_floor_affine_id_value(ScalarEvolution& SE, Value& V) {
+	if (!SE.isSCEVable(V.getType())) {
+		floor_affine_id_info info;
+		info.non_affine = true;
+		return info;
+	}
+	return analyze_floor_affine_id_scev(SE.getSCEV(&V));
+}
+
+floor_affine_id_info llvm::analyze_floor_affine_id_pointer(ScalarEvolution& SE, Value& ptr) {
+	const auto ptr_scev = SE.getSCEV(&ptr);
+	const auto base = SE.getPointerBase(ptr_scev);
+	floor_affine_id_info info;
+	if (isa<SCEVCouldNotCompute>(base) || !isa<SCEVUnknown>(base)) {
+		info.non_affine = true;
+		return info;
+	}
+	// the base pointer itself must be uniform (e.g. a kernel parameter)
+	SmallPtrSet<const Value*, 16> visited;
+	if (!is_uniform_value(*cast<SCEVUnknown>(base)->getValue(), visited)) {
+		info.non_affine = true;
+		return info;
+	}
+	const auto offset = SE.removePointerBase(ptr_scev);
+	if (isa<SCEVCouldNotCompute>(offset)) {
+		info.non_affine = true;
+		return info;
+	}
+	return analyze_floor_affine_id_scev(offset);
+}
@@ -0,0 +1,529 @@
+//===- FloorIntrinsicLowering.cpp - Metal/OpenCL/Vulkan intrinsic lowering ===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the lowering of LLVM intrinsics for Metal/AIR,
+// OpenCL/SPIR and Vulkan/SPIR-V.
+//
+// Lowering tables:
+//  * Metal: abs/fabs, min/max, fma/fmuladd, ctpop, ctlz, cttz, bitreverse,
+//    add/sub_sat and rotates are mapped onto the air.* builtins
+//  * SPIR: same as Metal, but mapped onto the mangled OpenCL C builtins,
+//    cttz and bitreverse are expanded (not available in OpenCL 1.2)
+//  * Vulkan: intrinsics with a direct SPIR-V or GLSL.std.450 equivalent
+//    (abs/fabs, min/max, fma, ctpop, bitreverse) are kept as-is and are handled
+//    by the SPIR-V translator, everything else is expanded
+//  * all: non-rotate funnel shifts are expanded into shifts, vector reductions
+//    are expanded into extractelement + scalar op sequences (Metal: fast
+//    float fadd reductions use air.dot)
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Transforms/LibFloor/FloorIntrinsicLowering.h"
+#include <optional>
+#include <string>
+using namespace llvm;
+
+namespace {
+	class floor_intrinsic_lowering {
+	public:
+		floor_intrinsic_lowering(IRBuilder<>& builder_, Module& M_, const FLOOR_INTRINSIC_TARGET target_) :
+		builder(builder_), M(M_), target(target_) {}
+
+		//! lowers "I", returns the replacement value or nullptr if "I" can't be lowered
+		Value* lower(IntrinsicInst& I) {
+			builder.SetInsertPoint(&I);
+			if (isa<FPMathOperator>(&I)) {
+				builder.setFastMathFlags(I.getFastMathFlags());
+			} else {
+				builder.clearFastMathFlags();
+			}
+
+			const auto id = I.getIntrinsicID();
+			if (is_native_intrinsic(id)) {
+				// nothing to do
+				return &I;
+			}
+			switch (id) {
+				// NOTE: this drops the "is_int_min_poison"/"is_zero_poison" flag of abs/ctlz/cttz (always handled)
+				case Intrinsic::abs:
+				case Intrinsic::ctlz:
+				case Intrinsic::cttz:
+				case Intrinsic::fabs:
+				case Intrinsic::ctpop:
+				case Intrinsic::bitreverse:
+					return emit(id, { I.getOperand(0) });
+				case Intrinsic::umin:
+				case Intrinsic::smin:
+				case Intrinsic::umax:
+				case Intrinsic::smax:
+				case Intrinsic::minnum:
+				case Intrinsic::maxnum:
+				case Intrinsic::sadd_sat:
+				case Intrinsic::uadd_sat:
+				case Intrinsic::ssub_sat:
+				case Intrinsic::usub_sat:
+					return emit(id, { I.getOperand(0), I.getOperand(1) });
+				case Intrinsic::fma:
+				// we're allowed to fuse -> always fuse
+				case Intrinsic::fmuladd:
+					return emit(Intrinsic::fma, { I.getOperand(0), I.getOperand(1), I.getOperand(2) });
+				case Intrinsic::fshl:
+				case Intrinsic::fshr:
+					return emit(id, { I.getOperand(0), I.getOperand(1), I.getOperand(2) });
+				case Intrinsic::vector_reduce_fadd:
+				case Intrinsic::vector_reduce_fmul:
+					return lower_reduction(id, I.getOperand(1), I.getOperand(0), !I.getFastMathFlags().allowReassoc());
+				case Intrinsic::vector_reduce_add:
+				case Intrinsic::vector_reduce_mul:
+				case Intrinsic::vector_reduce_and:
+				case Intrinsic::vector_reduce_or:
+				case Intrinsic::vector_reduce_xor:
+				case Intrinsic::vector_reduce_smax:
+				case Intrinsic::vector_reduce_smin:
+				case Intrinsic::vector_reduce_umax:
+				case Intrinsic::vector_reduce_umin:
+				case Intrinsic::vector_reduce_fmax:
+				case Intrinsic::vector_reduce_fmin:
+					return lower_reduction(id, I.getOperand(0), nullptr, false);
+				default:
+					break;
+			}
+			return nullptr;
+		}
+
+	protected:
+		IRBuilder<>& builder;
+		Module& M;
+		const FLOOR_INTRINSIC_TARGET target;
+
+		//! AIR builtin type suffix, e.g. ".f32", ".s.i32" or ".v4u.i16"
+		static std::optional<std::string> get_air_suffix(llvm::Type* type, const bool is_signed) {
+			std::string ret = ".";
+			auto elem_type = type;
+			if (auto vec_type = dyn_cast_or_null<FixedVectorType>(type); vec_type) {
+				elem_type = vec_type->getElementType();
+				ret += "v" + std::to_string(vec_type->getNumElements());
+			}
+			switch (elem_type->getTypeID()) {
+				case llvm::Type::IntegerTyID:
+					ret += (is_signed ? "s." : "u.");
+					ret += "i" + std::to_string(cast<IntegerType>(elem_type)->getBitWidth());
+					break;
+				// NOTE: we generally omit the ".f" here, because it's usually not wanted
+				case llvm::Type::HalfTyID:
+					ret += "f16";
+					break;
+				case llvm::Type::FloatTyID:
+					ret += "f32";
+					break;
+				case llvm::Type::DoubleTyID:
+					ret += "f64";
+					break;
+				default:
+					return {};
+			}
+			return ret;
+		}
+
+		//! Itanium mangling of an OpenCL C builtin type, e.g. "j" (uint) or "Dv4_f" (float4)
+		static std::optional<std::string> get_cl_mangled_type(llvm::Type* type, const bool is_signed) {
+			std::string ret;
+			auto elem_type = type;
+			if (auto vec_type = dyn_cast_or_null<FixedVectorType>(type); vec_type) {
+				elem_type = vec_type->getElementType();
+				ret += "Dv" + std::to_string(vec_type->getNumElements()) + "_";
+			}
+			switch (elem_type->getTypeID()) {
+				case llvm::Type::IntegerTyID:
+					switch (cast<IntegerType>(elem_type)->getBitWidth()) {
+						case 8: ret += (is_signed ? "c" : "h"); break;
+						case 16: ret += (is_signed ? "s" : "t"); break;
+						case 32: ret += (is_signed ? "i" : "j"); break;
+						case 64: ret += (is_signed ? "l" : "m"); break;
+						default: return {};
+					}
+					break;
+				case llvm::Type::HalfTyID:
+					ret += "Dh";
+					break;
+				case llvm::Type::FloatTyID:
+					ret += "f";
+					break;
+				case llvm::Type::DoubleTyID:
+					ret += "d";
+					break;
+				default:
+					return {};
+			}
+			return ret;
+		}
+
+		//! returns the target builtin name of "base_name" for an "arg_count" arguments call with args of type "type"
+		std::optional<std::string> get_builtin_name(const std::string& base_name, llvm::Type* type,
+													const bool is_signed, const uint32_t arg_count) const {
+			switch (target) {
+				case FLOOR_INTRINSIC_TARGET::METAL: {
+					const auto suffix = get_air_suffix(type, is_signed);
+					if (!suffix) {
+						return {};
+					}
+					return "air." + base_name + *suffix;
+				}
+				case FLOOR_INTRINSIC_TARGET::SPIR: {
+					const auto mangled_type = get_cl_mangled_type(type, is_signed);
+					if (!mangled_type) {
+						return {};
+					}
+					std::string ret = "_Z" + std::to_string(base_name.size()) + base_name + *mangled_type;
+					for (uint32_t i = 1; i < arg_count; ++i) {
+						// builtin scalar types are not substitution candidates, vector types are
+						ret += (type->isVectorTy() ? "S_" : *mangled_type);
+					}
+					return ret;
+				}
+				case FLOOR_INTRINSIC_TARGET::VULKAN:
+					break;
+			}
+			return {};
+		}
+
+		//! returns the base name of the target builtin that implements "id" (if there is one)
+		std::optional<std::string> get_builtin_base_name(const Intrinsic::ID id, llvm::Type* type, bool& is_signed) const {
+			if (target == FLOOR_INTRINSIC_TARGET::VULKAN) {
+				return {};
+			}
+
+			const bool is_metal = (target == FLOOR_INTRINSIC_TARGET::METAL);
+			// Metal: use the fast variant for f32
+			const bool is_fast = (is_metal && type->getScalarType()->isFloatTy());
+			is_signed = false;
+			switch (id) {
+				case Intrinsic::abs:
+					is_signed = true;
+					return std::string("abs");
+				case Intrinsic::fabs:
+					return std::string(is_fast ? "fast_fabs" : "fabs");
+				case Intrinsic::smin:
+					is_signed = true;
+					return std::string("min");
+				case Intrinsic::umin:
+					return std::string("min");
+				case Intrinsic::smax:
+					is_signed = true;
+					return std::string("max");
+				case Intrinsic::umax:
+					return std::string("max");
+				case Intrinsic::minnum:
+					return std::string(is_fast ? "fast_fmin" : "fmin");
+				case Intrinsic::maxnum:
+					return std::string(is_fast ? "fast_fmax" : "fmax");
+				case Intrinsic::fma:
+					is_signed = true;
+					return std::string("fma");
+				case Intrinsic::ctpop:
+					return std::string("popcount");
+				case Intrinsic::ctlz:
+					return std::string("clz");
+				case Intrinsic::cttz:
+					// NOTE: ctz only exists since OpenCL 2.0
+					if (is_metal) {
+						return std::string("ctz");
+					}
+					break;
+				case Intrinsic::bitreverse:
+					if (is_metal) {
+						return std::string("reverse_bits");
+					}
+					break;
+				case Intrinsic::sadd_sat:
+					is_signed = true;
+					return std::string("add_sat");
+				case Intrinsic::uadd_sat:
+					return std::string("add_sat");
+				case Intrinsic::ssub_sat:
+					is_signed = true;
+					return std::string("sub_sat");
+				case Intrinsic::usub_sat:
+					return std::string("sub_sat");
+				default:
+					break;
+			}
+			return {};
+		}
+
+		//! returns true if the target backend can handle the intrinsic "id" as-is
+		bool is_native_intrinsic(const Intrinsic::ID id) const {
+			if (target != FLOOR_INTRINSIC_TARGET::VULKAN) {
+				return false;
+			}
+			switch (id) {
+				case Intrinsic::abs:
+				case Intrinsic::fabs:
+				case Intrinsic::umin:
+				case Intrinsic::smin:
+				case Intrinsic::umax:
+				case Intrinsic::smax:
+				case Intrinsic::minnum:
+				case Intrinsic::maxnum:
+				case Intrinsic::fma:
+				case Intrinsic::ctpop:
+				case Intrinsic::bitreverse:
+					return true;
+				default:
+					break;
+			}
+			return false;
+		}
+
+		//! creates a call to the specified target builtin
+		Value* create_builtin_call(const std::string& func_name, llvm::Type* ret_type, ArrayRef<Value*> ops) {
+			SmallVector<llvm::Type*, 3> param_types;
+			for (const auto& op : ops) {
+				param_types.emplace_back(op->getType());
+			}
+			const auto func_type = llvm::FunctionType::get(ret_type, param_types, false);
+			auto call = builder.CreateCall(M.getOrInsertFunction(func_name, func_type), ops);
+			call->setDoesNotThrow();
+			call->setDoesNotAccessMemory();
+			return call;
+		}
+
+		//! emits the operation "id" on "ops" for the target: either a builtin call, the intrinsic itself if it is
+		//! natively supported or a plain IR expansion
+		Value* emit(const Intrinsic::ID id, ArrayRef<Value*> ops) {
+			const auto type = ops[0]->getType();
+			bool is_signed = false;
+			if (const auto base_name = get_builtin_base_name(id, type, is_signed); base_name) {
+				if (const auto func_name = get_builtin_name(*base_name, type, is_signed, ops.size()); func_name) {
+					return create_builtin_call(*func_name, type, ops);
+				}
+				return nullptr;
+			}
+			if (is_native_intrinsic(id)) {
+				SmallVector<Value*, 3> args(ops.begin(), ops.end());
+				if (id == Intrinsic::abs) {
+					args.emplace_back(builder.getFalse());
+				}
+				return builder.CreateIntrinsic(id, { type }, args);
+			}
+			return expand(id, ops);
+		}
+
+		//! expands "id" into plain IR, only using ops/builtins that are supported by the target
+		Value* expand(const Intrinsic::ID id, ArrayRef<Value*> ops) {
+			const auto type = ops[0]->getType();
+			if (!type->isIntOrIntVectorTy()) {
+				return nullptr;
+			}
+			const auto bit_width = type->getScalarSizeInBits();
+			const auto get_const = [type](const APInt& val) {
+				return ConstantInt::get(type, val);
+			};
+			const auto get_const_u = [type](const uint64_t val) {
+				return ConstantInt::get(type, val);
+			};
+
+			switch (id) {
+				case Intrinsic::ctlz: {
+					// smear the highest set bit into all lower bits, then count the set bits
+					Value* val = ops[0];
+					for (uint32_t shift = 1; shift < bit_width; shift <<= 1) {
+						val = builder.CreateOr(val, builder.CreateLShr(val, get_const_u(shift)));
+					}
+					auto set_bits = emit(Intrinsic::ctpop, { val });
+					if (!set_bits) {
+						return nullptr;
+					}
+					return builder.CreateSub(get_const_u(bit_width), set_bits);
+				}
+				case Intrinsic::cttz: {
+					// count the set bits below the lowest set bit: ctpop(~x & (x - 1)), this is bit_width for x == 0
+					auto trailing_zeros = builder.CreateAnd(builder.CreateNot(ops[0]), builder.CreateSub(ops[0], get_const_u(1)));
+					return emit(Intrinsic::ctpop, { trailing_zeros });
+				}
+				case Intrinsic::bitreverse: {
+					if (!isPowerOf2_32(bit_width)) {
+						return nullptr;
+					}
+					// swap adjacent bits, then bit pairs, nibbles, bytes, ...
+					Value* val = ops[0];
+					for (uint32_t shift = 1; shift < bit_width; shift <<= 1) {
+						auto mask = get_const(APInt::getSplat(bit_width, APInt::getLowBitsSet(shift * 2, shift)));
+						val = builder.CreateOr(builder.CreateAnd(builder.CreateLShr(val, get_const_u(shift)), mask),
+											   builder.CreateShl(builder.CreateAnd(val, mask), get_const_u(shift)));
+					}
+					return val;
+				}
+				case Intrinsic::uadd_sat: {
+					auto sum = builder.CreateAdd(ops[0], ops[1]);
+					return builder.CreateSelect(builder.CreateICmpULT(sum, ops[0]),
+												get_const(APInt::getMaxValue(bit_width)), sum);
+				}
+				case Intrinsic::usub_sat: {
+					auto diff = builder.CreateSub(ops[0], ops[1]);
+					return builder.CreateSelect(builder.CreateICmpULT(ops[0], ops[1]), get_const_u(0), diff);
+				}
+				case Intrinsic::sadd_sat:
+				case Intrinsic::ssub_sat: {
+					// overflow if the sign of the result differs from the signs of both inputs (add),
+					// or if the inputs have different signs and the sign of the result differs from the lhs (sub)
+					const bool is_add = (id == Intrinsic::sadd_sat);
+					auto res = (is_add ? builder.CreateAdd(ops[0], ops[1]) : builder.CreateSub(ops[0], ops[1]));
+					auto overflow_bits = (is_add ?
+										  builder.CreateAnd(builder.CreateXor(ops[0], res), builder.CreateXor(ops[1], res)) :
+										  builder.CreateAnd(builder.CreateXor(ops[0], ops[1]), builder.CreateXor(ops[0], res)));
+					auto is_overflow = builder.CreateICmpSLT(overflow_bits, get_const_u(0));
+					auto sat_val = builder.CreateSelect(builder.CreateICmpSLT(ops[0], get_const_u(0)),
+														get_const(APInt::getSignedMinValue(bit_width)),
+														get_const(APInt::getSignedMaxValue(bit_width)));
+					return builder.CreateSelect(is_overflow, sat_val, res);
+				}
+				case Intrinsic::fshl:
+				case Intrinsic::fshr: {
+					const bool is_left = (id == Intrinsic::fshl);
+					auto bit_width_val = get_const_u(bit_width);
+					auto shift = builder.CreateURem(ops[2], bit_width_val);
+					auto inv_shift = builder.CreateSub(bit_width_val, shift);
+
+					// rotate if both inputs are the same and the target has a rotate builtin (always rotates left)
+					if (ops[0] == ops[1]) {
+						bool is_signed = false;
+						if (const auto func_name = get_builtin_name("rotate", type, is_signed, 2); func_name) {
+							return create_builtin_call(*func_name, type, { ops[0], is_left ? shift : inv_shift });
+						}
+					}
+
+					auto res = (is_left ?
+								builder.CreateOr(builder.CreateShl(ops[0], shift), builder.CreateLShr(ops[1], inv_shift)) :
+								builder.CreateOr(builder.CreateShl(ops[0], inv_shift), builder.CreateLShr(ops[1], shift)));
+					// shifting by bit_width is poison -> return the unshifted input for a zero shift
+					return builder.CreateSelect(builder.CreateICmpEQ(shift, get_const_u(0)), is_left ? ops[0] : ops[1], res);
+				}
+				default:
+					break;
+			}
+			return nullptr;
+		}
+
+		//! combines two reduction operands with the scalar operation of the reduction "id"
+		Value* reduce_op(const Intrinsic::ID id, Value* lhs, Value* rhs) {
+			switch (id) {
+				case Intrinsic::vector_reduce_add: return builder.CreateAdd(lhs, rhs);
+				case Intrinsic::vector_reduce_mul: return builder.CreateMul(lhs, rhs);
+				case Intrinsic::vector_reduce_and: return builder.CreateAnd(lhs, rhs);
+				case Intrinsic::vector_reduce_or: return builder.CreateOr(lhs, rhs);
+				case Intrinsic::vector_reduce_xor: return builder.CreateXor(lhs, rhs);
+				case Intrinsic::vector_reduce_fadd: return builder.CreateFAdd(lhs, rhs);
+				case Intrinsic::vector_reduce_fmul: return builder.CreateFMul(lhs, rhs);
+				case Intrinsic::vector_reduce_smax: return emit(Intrinsic::smax, { lhs, rhs });
+				case Intrinsic::vector_reduce_smin: return emit(Intrinsic::smin, { lhs, rhs });
+				case Intrinsic::vector_reduce_umax: return emit(Intrinsic::umax, { lhs, rhs });
+				case Intrinsic::vector_reduce_umin: return emit(Intrinsic::umin, { lhs, rhs });
+				case Intrinsic::vector_reduce_fmax: return emit(Intrinsic::maxnum, { lhs, rhs });
+				case Intrinsic::vector_reduce_fmin: return emit(Intrinsic::minnum, { lhs, rhs });
+				default:
+					break;
+			}
+			return nullptr;
+		}
+
+		//! lowers the reduction "id" of "vec" (with an optional "start" value)
+		//! NOTE: "is_ordered" reductions are performed sequentially, all others as a tree
+		Value* lower_reduction(const Intrinsic::ID id, Value* vec, Value* start, const bool is_ordered) {
+			const auto vec_type = dyn_cast_or_null<FixedVectorType>(vec->getType());
+			if (!vec_type) {
+				return nullptr;
+			}
+			const auto width = vec_type->getNumElements();
+
+			// Metal: unordered f32 fadd reduction -> dot product with a vector of all ones
+			if (target == FLOOR_INTRINSIC_TARGET::METAL && id == Intrinsic::vector_reduce_fadd && !is_ordered &&
+				vec_type->getElementType()->isFloatTy() && width >= 2 && width <= 4) {
+				SmallVector<Value*, 2> dot_args { vec, ConstantFP::get(vec_type, 1.0) };
+				Value* dot = create_builtin_call("air.dot.v" + std::to_string(width) + "f32", vec_type->getElementType(), dot_args);
+				if (auto start_fp = dyn_cast_or_null<ConstantFP>(start); start_fp && start_fp->isZero()) {
+					return dot;
+				}
+				return builder.CreateFAdd(start, dot);
+			}
+
+			SmallVector<Value*, 16> elems;
+			for (uint32_t i = 0; i < width; ++i) {
+				elems.emplace_back(builder.CreateExtractElement(vec, builder.getInt32(i)));
+			}
+
+			if (is_ordered) {
+				Value* res = start;
+				for (auto& elem : elems) {
+					res = reduce_op(id, res, elem);
+					if (!res) {
+						return nullptr;
+					}
+				}
+				return res;
+			}
+
+			while (elems.size() > 1) {
+				SmallVector<Value*, 16> next_elems;
+				for (size_t i = 0, count = elems.size(); i + 1 < count; i += 2) {
+					auto res = reduce_op(id, elems[i], elems[i + 1]);
+					if (!res) {
+						return nullptr;
+					}
+					next_elems.emplace_back(res);
+				}
+				if (elems.size() % 2u == 1u) {
+					next_elems.emplace_back(elems.back());
+				}
+				elems = std::move(next_elems);
+			}
+			if (start) {
+				return reduce_op(id, start, elems[0]);
+			}
+			return elems[0];
+		}
+
+	};
+} // namespace
+
+bool llvm::lower_floor_intrinsic(IntrinsicInst &I,
+                                 IRBuilder<> &builder,
+                                 const FLOOR_INTRINSIC_TARGET target) {
+	floor_intrinsic_lowering lowering(builder, *I.getModule(), target);
+	auto repl = lowering.lower(I);
+	builder.clearFastMathFlags();
+	if (!repl) {
+		return false;
+	}
+	if (repl == &I) {
+		return true;
+	}
+	I.replaceAllUsesWith(repl);
+	I.eraseFromParent();
+	return true;
+}
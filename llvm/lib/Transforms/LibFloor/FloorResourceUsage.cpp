@@ -0,0 +1,178 @@
+//===- FloorResourceUsage.cpp - per entry point resource usage ------------===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass computes the static resource usage of all kernel/shader entry
+// points after all backend passes have run:
+//  * static local/threadgroup memory size (local address space globals)
+//  * static private/stack memory size (static allocas)
+//  * number of barriers and atomic operations
+//  * estimated register pressure (max #32-bit registers live at any point)
+// The result is reported through a user-specified callback (e.g. used by clang
+// to emit it into the floor function info).
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/CallingConv.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/LibFloor/FloorUtils.h"
+#include <algorithm>
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "FloorResourceUsage"
+
+#if 1
+#define DBG(x)
+#else
+#define DBG(x) x
+#endif
+
+namespace {
+	// FloorResourceUsage
+	struct FloorResourceUsage : public ModulePass {
+		static char ID; // Pass identification, replacement for typeid
+
+		FloorResourceUsageCallback usage_cb;
+
+		FloorResourceUsage(FloorResourceUsageCallback usage_cb_ = {}) :
+		ModulePass(ID), usage_cb(usage_cb_) {
+			initializeFloorResourceUsagePass(*PassRegistry::getPassRegistry());
+		}
+
+		StringRef getPassName() const override {
+			return "floor resource usage";
+		}
+
+		void getAnalysisUsage(AnalysisUsage &AU) const override {
+			AU.setPreservesAll();
+		}
+
+		bool runOnModule(Module& M) override {
+			const auto& DL = M.getDataLayout();
+			for (auto& F : M) {
+				if (F.isDeclaration() || !libfloor_utils::is_entry_point(F)) {
+					continue;
+				}
+
+				// gather all defined functions that are reachable from this entry point
+				// NOTE: usually everything is inlined, but we can't rely on it
+				SmallPtrSet<const Function*, 16> funcs;
+				collect_functions(F, funcs);
+
+				FloorResourceUsageInfo usage {};
+				usage.local_memory_size = compute_local_memory_size(M, DL, funcs);
+				for (const auto& func : funcs) {
+					for (const auto& I : instructions(*func)) {
+						if (auto AI = dyn_cast<AllocaInst>(&I); AI && AI->isStaticAlloca()) {
+							if (auto alloc_size = AI->getAllocationSizeInBits(DL); alloc_size) {
+								usage.private_memory_size += (alloc_size->getFixedSize() + 7u) / 8u;
+							}
+						} else if (auto CB = dyn_cast<CallBase>(&I); CB && libfloor_utils::is_barrier_call(*CB)) {
+							++usage.barrier_count;
+						}
+						if (libfloor_utils::is_atomic_op(I)) {
+							++usage.atomic_count;
+						}
+					}
+					usage.register_count = std::max(usage.register_count, libfloor_utils::compute_register_liveness(*func).max_register_count);
+				}
+
+				DBG(errs() << F.getName() << ": local " << usage.local_memory_size << ", private " << usage.private_memory_size
+						   << ", barriers " << usage.barrier_count << ", atomics " << usage.atomic_count
+						   << ", registers " << usage.register_count << "\n";)
+				if (usage_cb) {
+					usage_cb(F, usage);
+				}
+			}
+			return false;
+		}
+
+		//! recursively collects "F" and all defined functions called by it
+		static void collect_functions(const Function& F, SmallPtrSet<const Function*, 16>& funcs) {
+			if (!funcs.insert(&F).second) {
+				return;
+			}
+			for (const auto& I : instructions(F)) {
+				if (auto CB = dyn_cast<CallBase>(&I); CB) {
+					if (auto called_func = CB->getCalledFunction(); called_func && !called_func->isDeclaration()) {
+						collect_functions(*called_func, funcs);
+					}
+				}
+			}
+		}
+
+		//! returns true if "val" is (transitively through constant expressions) used inside any of the specified functions
+		static bool is_used_in(const Value& val, const SmallPtrSet<const Function*, 16>& funcs) {
+			for (const auto user : val.users()) {
+				if (const auto instr = dyn_cast<Instruction>(user); instr) {
+					if (funcs.count(instr->getFunction()) > 0) {
+						return true;
+					}
+				} else if (const auto const_expr = dyn_cast<ConstantExpr>(user); const_expr) {
+					if (is_used_in(*const_expr, funcs)) {
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		//! computes the size of all local memory globals that are used by the specified functions
+		static uint64_t compute_local_memory_size(const Module& M, const DataLayout& DL,
+												  const SmallPtrSet<const Function*, 16>& funcs) {
+			uint64_t local_memory_size = 0;
+			for (const auto& GV : M.globals()) {
+				if (GV.getAddressSpace() != libfloor_utils::local_address_space) {
+					continue;
+				}
+				if (!is_used_in(GV, funcs)) {
+					continue;
+				}
+				// NOTE: respect alignment, since the backends will need to allocate these in-order
+				const auto align = DL.getValueOrABITypeAlignment(GV.getAlign(), GV.getValueType());
+				local_memory_size = alignTo(local_memory_size, align);
+				local_memory_size += DL.getTypeAllocSize(GV.getValueType()).getFixedSize();
+			}
+			return local_memory_size;
+		}
+	};
+
+}
+
+char FloorResourceUsage::ID = 0;
+ModulePass *llvm::createFloorResourceUsagePass(FloorResourceUsageCallback usage_cb) {
+	return new FloorResourceUsage(usage_cb);
+}
+INITIALIZE_PASS_BEGIN(FloorResourceUsage, "FloorResourceUsage", "FloorResourceUsage Pass", false, true)
+INITIALIZE_PASS_END(FloorResourceUsage, "FloorResourceUsage", "FloorResourceUsage Pass", false, true)
@@ -0,0 +1,370 @@
+//===- HostComputeWorkGroupLoops.cpp - host-compute work-group loop nests -===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// HostComputeWorkGroupLoops: for each host-compute kernel that can be executed
+// for all work-items of a work-group in sequence (no barriers or other
+// convergent operations, no calls that may access memory), this creates a
+// variant "<kernel>" + get_host_compute_work_group_suffix() with the same
+// signature that executes the whole work-group in a single z/y/x loop nest.
+//
+// Inside the loop nest, loads of the per work-item id globals provided by the
+// host-compute runtime (floor_global_idx, floor_local_idx) are replaced by the
+// loop induction variables, so that the kernel body and the work-item loops
+// form one loop nest that later loop optimizations (Polly, the loop vectorizer)
+// can tile, interchange and vectorize. The loop bounds are read from
+// floor_local_work_size and the work-group offset from floor_group_idx, which
+// the runtime sets once per work-group.
+//
+// The original kernel is left untouched: the runtime uses it as a fallback
+// whenever no work-group variant has been created for a kernel.
+//
+// This must run after inlining.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/CallingConv.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/LibFloor/FloorUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <array>
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "HostComputeWorkGroupLoops"
+
+#if 1
+#define DBG(x)
+#else
+#define DBG(x) x
+#endif
+
+namespace {
+	// HostComputeWorkGroupLoops
+	struct HostComputeWorkGroupLoops : public ModulePass {
+		static char ID; // Pass identification, replacement for typeid
+
+		//! per work-item ids (uint3), these are replaced inside the loop nest
+		static constexpr const char* global_idx_name { "floor_global_idx" };
+		static constexpr const char* local_idx_name { "floor_local_idx" };
+		//! per work-group ids/sizes (uint3), set by the runtime once per work-group
+		static constexpr const char* group_idx_name { "floor_group_idx" };
+		static constexpr const char* local_work_size_name { "floor_local_work_size" };
+		static constexpr std::array<const char*, 5> uniform_names {{
+			group_idx_name, local_work_size_name, "floor_global_work_size", "floor_group_size", "floor_work_dim"
+		}};
+
+		struct id_load {
+			LoadInst* load;
+			//! global or local id
+			bool is_global;
+			//! first loaded dimension
+			uint32_t dim;
+		};
+
+		HostComputeWorkGroupLoops() : ModulePass(ID) {
+			initializeHostComputeWorkGroupLoopsPass(*PassRegistry::getPassRegistry());
+		}
+
+		StringRef getPassName() const override {
+			return "host-compute work-group loops";
+		}
+
+		bool runOnModule(Module& M) override {
+			if (Triple(M.getTargetTriple()).getEnvironment() != Triple::FloorHostCompute) {
+				return false;
+			}
+
+			// gather all kernels first, since we're adding new functions
+			const auto suffix = libfloor_utils::get_host_compute_work_group_suffix();
+			std::vector<Function*> kernels;
+			for (auto& F : M) {
+				if (!F.isDeclaration() &&
+					F.getCallingConv() == CallingConv::FLOOR_KERNEL &&
+					!F.getName().endswith(suffix)) {
+					kernels.emplace_back(&F);
+				}
+			}
+
+			bool modified = false;
+			for (auto& kernel : kernels) {
+				std::vector<id_load> id_loads;
+				if (!can_loop_work_items(M, *kernel, id_loads)) {
+					DBG(errs() << "can't create work-group loops for " << kernel->getName() << "\n";)
+					continue;
+				}
+				create_work_group_function(M, *kernel, id_loads);
+				modified = true;
+			}
+			return modified;
+		}
+
+		//! calls "load_cb(LoadInst&, offset)" for each load of "GV" in "F" (at a constant byte offset from "GV"),
+		//! returns false if "GV" is used in any other way inside "F" or if "load_cb" returns false
+		template <typename F_load_cb>
+		static bool for_all_loads(const DataLayout& DL, Function& F, GlobalVariable& GV, F_load_cb&& load_cb) {
+			SmallVector<User*, 16> worklist(GV.users());
+			while (!worklist.empty()) {
+				auto user = worklist.pop_back_val();
+				if (auto CE = dyn_cast<ConstantExpr>(user)) {
+					worklist.append(CE->user_begin(), CE->user_end());
+					continue;
+				}
+				auto I = dyn_cast<Instruction>(user);
+				if (!I) {
+					// used in a global initializer -> can't track this
+					return false;
+				}
+				if (I->getFunction() != &F) {
+					continue;
+				}
+				if (isa<GetElementPtrInst>(I) || isa<BitCastInst>(I) || isa<AddrSpaceCastInst>(I)) {
+					worklist.append(I->user_begin(), I->user_end());
+					continue;
+				}
+
+				auto LI = dyn_cast<LoadInst>(I);
+				if (!LI || !LI->isSimple()) {
+					return false;
+				}
+				APInt offset(DL.getIndexTypeSizeInBits(LI->getPointerOperandType()), 0);
+				if (LI->getPointerOperand()->stripAndAccumulateConstantOffsets(DL, offset, true) != &GV ||
+					offset.isNegative()) {
+					return false;
+				}
+				if (!load_cb(*LI, offset.getZExtValue())) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//! returns true if all work-items of a work-group can be executed in sequence by a single loop nest,
+		//! fills "id_loads" with all loads of per work-item ids in "F"
+		static bool can_loop_work_items(Module& M, Function& F, std::vector<id_load>& id_loads) {
+			if (!F.getReturnType()->isVoidTy()) {
+				return false;
+			}
+
+			for (const auto& I : instructions(F)) {
+				// no barriers, and nothing that could access work-item state behind our back
+				if (const auto CB = dyn_cast<CallBase>(&I); CB) {
+					if (CB->isConvergent()) {
+						return false;
+					}
+					if (!isa<IntrinsicInst>(CB) && !CB->doesNotAccessMemory()) {
+						return false;
+					}
+				}
+				// dynamic allocas would grow the stack with each work-item
+				if (const auto AI = dyn_cast<AllocaInst>(&I); AI && !AI->isStaticAlloca()) {
+					return false;
+				}
+			}
+
+			const auto& DL = M.getDataLayout();
+			for (auto& GV : M.globals()) {
+				const auto name = GV.getName();
+				if (name == global_idx_name || name == local_idx_name) {
+					const bool is_global = (name == global_idx_name);
+					if (!for_all_loads(DL, F, GV, [&id_loads, is_global](LoadInst& LI, const uint64_t offset) {
+						// only i32 and <N x i32> loads of whole components are supported
+						auto type = LI.getType();
+						uint64_t count = 1;
+						if (const auto vec_type = dyn_cast<FixedVectorType>(type); vec_type) {
+							type = vec_type->getElementType();
+							count = vec_type->getNumElements();
+						}
+						if (!type->isIntegerTy(32) || (offset % 4u) != 0 || offset / 4u + count > 3u) {
+							return false;
+						}
+						id_loads.emplace_back(id_load { &LI, is_global, uint32_t(offset / 4u) });
+						return true;
+					})) {
+						return false;
+					}
+				} else if (llvm::is_contained(uniform_names, name)) {
+					// may be loaded, but not written
+					if (!for_all_loads(DL, F, GV, [](LoadInst&, const uint64_t) { return true; })) {
+						return false;
+					}
+				} else if (GV.isThreadLocal()) {
+					// any other thread-local state may be per work-item state that we don't know about
+					if (!for_all_loads(DL, F, GV, [](LoadInst&, const uint64_t) { return false; })) {
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		//! returns the id/size global "name" or creates an external declaration of it if it doesn't exist yet
+		static GlobalVariable& get_id_global(Module& M, const char* name) {
+			if (auto GV = M.getNamedGlobal(name); GV) {
+				return *GV;
+			}
+			// use the same thread-local mode as any other id global
+			auto tls_mode = GlobalValue::GeneralDynamicTLSModel;
+			for (const auto& other_name : { global_idx_name, local_idx_name, group_idx_name, local_work_size_name }) {
+				if (const auto other_GV = M.getNamedGlobal(other_name); other_GV) {
+					tls_mode = other_GV->getThreadLocalMode();
+					break;
+				}
+			}
+			auto& ctx = M.getContext();
+			return *new GlobalVariable(M, ArrayType::get(Type::getInt32Ty(ctx), 3), false, GlobalValue::ExternalLinkage,
+									   nullptr, name, nullptr, tls_mode);
+		}
+
+		//! creates the work-group variant of kernel "F", "id_loads" are all per work-item id loads in "F"
+		static void create_work_group_function(Module& M, Function& F, const std::vector<id_load>& id_loads) {
+			auto& ctx = M.getContext();
+			auto i32_type = Type::getInt32Ty(ctx);
+			auto& group_idx = get_id_global(M, group_idx_name);
+			auto& local_work_size = get_id_global(M, local_work_size_name);
+
+			ValueToValueMapTy VMap;
+			auto wg_func = CloneFunction(&F, VMap);
+			wg_func->setName(F.getName() + libfloor_utils::get_host_compute_work_group_suffix());
+			wg_func->setCallingConv(F.getCallingConv());
+			wg_func->setLinkage(F.getLinkage());
+			DBG(errs() << "creating work-group loops for " << F.getName() << "\n";)
+
+			auto body_entry = &wg_func->getEntryBlock();
+			SmallVector<AllocaInst*, 16> static_allocas;
+			for (auto& I : *body_entry) {
+				if (auto AI = dyn_cast<AllocaInst>(&I); AI && AI->isStaticAlloca()) {
+					static_allocas.emplace_back(AI);
+				}
+			}
+			SmallVector<ReturnInst*, 4> returns;
+			for (auto& BB : *wg_func) {
+				if (auto RI = dyn_cast<ReturnInst>(BB.getTerminator()); RI) {
+					returns.emplace_back(RI);
+				}
+			}
+
+			// entry: static allocas are only allocated once, the work-group offset and size are loaded once
+			auto entry = BasicBlock::Create(ctx, "work_group.entry", wg_func, body_entry);
+			for (auto& AI : static_allocas) {
+				AI->moveBefore(*entry, entry->end());
+			}
+			IRBuilder<> builder(entry);
+			const auto load_component = [&builder, &ctx, &i32_type](GlobalVariable& GV, const uint32_t dim, const Twine& name) {
+				const auto AS = GV.getType()->getAddressSpace();
+				auto ptr = builder.CreateBitCast(&GV, Type::getInt8PtrTy(ctx, AS));
+				ptr = builder.CreateConstInBoundsGEP1_32(Type::getInt8Ty(ctx), ptr, dim * 4u);
+				ptr = builder.CreateBitCast(ptr, i32_type->getPointerTo(AS));
+				return builder.CreateLoad(i32_type, ptr, name);
+			};
+			static constexpr const char* dim_names[] { "x", "y", "z" };
+			std::array<Value*, 3> local_size {};
+			std::array<Value*, 3> group_offset {};
+			for (uint32_t dim = 0; dim < 3; ++dim) {
+				local_size[dim] = load_component(local_work_size, dim, Twine("local_size.") + dim_names[dim]);
+				auto group_id = load_component(group_idx, dim, Twine("group_idx.") + dim_names[dim]);
+				group_offset[dim] = builder.CreateNUWMul(group_id, local_size[dim], Twine("group_offset.") + dim_names[dim]);
+			}
+
+			// z/y/x loop nest around the kernel body:
+			// header.<dim>: idx = phi [0, outer header], [idx + 1, latch.<dim>]; idx < local size ? inner : outer latch
+			std::array<BasicBlock*, 3> headers {}, latches {};
+			for (uint32_t dim = 3; dim > 0; --dim) {
+				headers[dim - 1] = BasicBlock::Create(ctx, Twine("work_group.header.") + dim_names[dim - 1], wg_func, body_entry);
+			}
+			for (uint32_t dim = 0; dim < 3; ++dim) {
+				latches[dim] = BasicBlock::Create(ctx, Twine("work_group.latch.") + dim_names[dim], wg_func);
+			}
+			auto exit = BasicBlock::Create(ctx, "work_group.exit", wg_func);
+			ReturnInst::Create(ctx, exit);
+			builder.CreateBr(headers[2]);
+
+			std::array<PHINode*, 3> local_idx {};
+			for (uint32_t dim = 3; dim > 0; --dim) {
+				const auto cur_dim = dim - 1;
+				builder.SetInsertPoint(headers[cur_dim]);
+				local_idx[cur_dim] = builder.CreatePHI(i32_type, 2, Twine("local_idx.") + dim_names[cur_dim]);
+				local_idx[cur_dim]->addIncoming(builder.getInt32(0), cur_dim == 2 ? entry : headers[cur_dim + 1]);
+				auto in_range = builder.CreateICmpULT(local_idx[cur_dim], local_size[cur_dim]);
+				builder.CreateCondBr(in_range,
+									 cur_dim == 0 ? body_entry : headers[cur_dim - 1],
+									 cur_dim == 2 ? exit : latches[cur_dim + 1]);
+
+				builder.SetInsertPoint(latches[cur_dim]);
+				auto next_idx = builder.CreateNUWAdd(local_idx[cur_dim], builder.getInt32(1));
+				local_idx[cur_dim]->addIncoming(next_idx, latches[cur_dim]);
+				builder.CreateBr(headers[cur_dim]);
+			}
+
+			// returning from the kernel body continues with the next work-item
+			for (auto& RI : returns) {
+				BranchInst::Create(latches[0], RI);
+				RI->eraseFromParent();
+			}
+
+			// replace all per work-item id loads with the loop induction variables
+			for (const auto& id : id_loads) {
+				auto LI = cast<LoadInst>(VMap[id.load]);
+				builder.SetInsertPoint(LI);
+				const auto get_id = [&](const uint32_t dim) -> Value* {
+					if (!id.is_global) {
+						return local_idx[dim];
+					}
+					return builder.CreateNUWAdd(group_offset[dim], local_idx[dim]);
+				};
+				Value* repl = nullptr;
+				if (const auto vec_type = dyn_cast<FixedVectorType>(LI->getType()); vec_type) {
+					repl = UndefValue::get(vec_type);
+					for (uint32_t i = 0; i < vec_type->getNumElements(); ++i) {
+						repl = builder.CreateInsertElement(repl, get_id(id.dim + i), i);
+					}
+				} else {
+					repl = get_id(id.dim);
+				}
+				LI->replaceAllUsesWith(repl);
+				LI->eraseFromParent();
+			}
+		}
+	};
+
+}
+
+char HostComputeWorkGroupLoops::ID = 0;
+ModulePass *llvm::createHostComputeWorkGroupLoopsPass() {
+	return new HostComputeWorkGroupLoops();
+}
+INITIALIZE_PASS_BEGIN(HostComputeWorkGroupLoops, "HostComputeWorkGroupLoops", "HostComputeWorkGroupLoops Pass", false, false)
+INITIALIZE_PASS_END(HostComputeWorkGroupLoops, "HostComputeWorkGroupLoops", "HostComputeWorkGroupLoops Pass", false, false)
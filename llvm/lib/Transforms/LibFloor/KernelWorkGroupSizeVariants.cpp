@@ -0,0 +1,279 @@
+//===- KernelWorkGroupSizeVariants.cpp - constant work-group size kernels -===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// KernelWorkGroupSizeVariants: creates a specialized clone of each kernel
+// without a required work-group size (see
+// libfloor_utils::get_required_work_group_size, clang uses the same predicate
+// when writing the function info) for each specified work-group size.
+// Each clone is named "<kernel>" + get_work_group_size_variant_suffix(size),
+// has "reqd_work_group_size" metadata and is added to all named kernel
+// metadata (opencl.kernels, air.kernel, nvvm.annotations, ...) the original
+// kernel is part of.
+//
+// ConstantLocalSize: replaces all local size builtin calls inside kernels that
+// have a required work-group size with the corresponding constant. This must
+// run after inlining.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/CallingConv.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/IntrinsicsNVPTX.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/LibFloor/FloorUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
+#include <array>
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "KernelWorkGroupSizeVariants"
+
+#if 1
+#define DBG(x)
+#else
+#define DBG(x) x
+#endif
+
+// for testing purposes: work-group sizes that are used if none are specified when creating the pass
+static cl::list<std::string> ClWorkGroupSizeVariants("floor-wg-size-variants", cl::Hidden, cl::CommaSeparated,
+													 cl::desc("constant work-group sizes (<x>x<y>x<z>) of kernel variants"));
+
+namespace {
+	// KernelWorkGroupSizeVariants
+	struct KernelWorkGroupSizeVariants : public ModulePass {
+		static char ID; // Pass identification, replacement for typeid
+
+		std::vector<std::array<uint32_t, 3>> wg_sizes;
+
+		KernelWorkGroupSizeVariants(const std::vector<std::array<uint32_t, 3>>& wg_sizes_ = {}) :
+		ModulePass(ID), wg_sizes(wg_sizes_) {
+			initializeKernelWorkGroupSizeVariantsPass(*PassRegistry::getPassRegistry());
+			if (wg_sizes.empty()) {
+				for (StringRef wg_size_str : ClWorkGroupSizeVariants) {
+					SmallVector<StringRef, 3> dims;
+					wg_size_str.split(dims, 'x');
+					std::array<uint32_t, 3> wg_size {{ 1, 1, 1 }};
+					for (size_t i = 0; i < std::min(dims.size(), size_t(3u)); ++i) {
+						if (dims[i].getAsInteger(10, wg_size[i]) || wg_size[i] == 0) {
+							wg_size[i] = 1;
+						}
+					}
+					wg_sizes.emplace_back(wg_size);
+				}
+			}
+		}
+
+		StringRef getPassName() const override {
+			return "kernel work-group size variants";
+		}
+
+		bool runOnModule(Module& M) override {
+			if (wg_sizes.empty()) {
+				return false;
+			}
+
+			// gather all kernels first, since we're adding new functions
+			std::vector<Function*> kernels;
+			for (auto& F : M) {
+				if (!F.isDeclaration() &&
+					F.getCallingConv() == CallingConv::FLOOR_KERNEL &&
+					!libfloor_utils::get_required_work_group_size(F)) {
+					kernels.emplace_back(&F);
+				}
+			}
+
+			for (auto& kernel : kernels) {
+				for (const auto& wg_size : wg_sizes) {
+					create_variant(M, *kernel, wg_size);
+				}
+			}
+			return !kernels.empty();
+		}
+
+		void create_variant(Module& M, Function& F, const std::array<uint32_t, 3>& wg_size) {
+			auto& ctx = M.getContext();
+
+			ValueToValueMapTy VMap;
+			auto variant = CloneFunction(&F, VMap);
+			variant->setName(F.getName() + libfloor_utils::get_work_group_size_variant_suffix(wg_size));
+			variant->setCallingConv(F.getCallingConv());
+			variant->setLinkage(F.getLinkage());
+			DBG(errs() << "creating kernel variant " << variant->getName() << "\n";)
+
+			const auto wg_size_md = [&ctx](const uint32_t size) {
+				return ConstantAsMetadata::get(ConstantInt::get(Type::getInt32Ty(ctx), size));
+			};
+			libfloor_utils::set_required_work_group_size(*variant, wg_size);
+
+			// duplicate all kernel metadata entries of the original kernel
+			for (auto& named_md : M.named_metadata()) {
+				SmallVector<MDNode*, 4> variant_nodes;
+				for (const auto node : named_md.operands()) {
+					if (node->getNumOperands() == 0) {
+						continue;
+					}
+					const auto func_md = dyn_cast_or_null<ValueAsMetadata>(node->getOperand(0).get());
+					if (!func_md || func_md->getValue()->stripPointerCasts() != &F) {
+						continue;
+					}
+
+					SmallVector<Metadata*, 8> ops { ValueAsMetadata::get(variant) };
+					for (uint32_t i = 1; i < node->getNumOperands(); ++i) {
+						const auto op = node->getOperand(i).get();
+						// drop any existing max work-group size info (will be replaced below)
+						if (const auto op_node = dyn_cast_or_null<MDNode>(op);
+							op_node && op_node->getNumOperands() > 0 && isa<MDString>(op_node->getOperand(0)) &&
+							cast<MDString>(op_node->getOperand(0))->getString() == "air.max_work_group_size") {
+							continue;
+						}
+						ops.emplace_back(op);
+					}
+
+					// Metal: also specify the max work-group size (equivalent to what is emitted for a reqd_work_group_size)
+					if (named_md.getName() == "air.kernel") {
+						ops.emplace_back(MDNode::get(ctx, {
+							MDString::get(ctx, "air.max_work_group_size"),
+							wg_size_md(wg_size[0] * wg_size[1] * wg_size[2])
+						}));
+					}
+					variant_nodes.emplace_back(MDNode::get(ctx, ops));
+				}
+				if (variant_nodes.empty()) {
+					continue;
+				}
+
+				// CUDA: specify the required number of threads
+				if (named_md.getName() == "nvvm.annotations") {
+					static constexpr const char* reqntid_names[] { "reqntidx", "reqntidy", "reqntidz" };
+					for (uint32_t dim = 0; dim < 3; ++dim) {
+						variant_nodes.emplace_back(MDNode::get(ctx, {
+							ValueAsMetadata::get(variant), MDString::get(ctx, reqntid_names[dim]), wg_size_md(wg_size[dim])
+						}));
+					}
+				}
+
+				for (const auto& node : variant_nodes) {
+					named_md.addOperand(node);
+				}
+			}
+		}
+	};
+
+	// ConstantLocalSize
+	struct ConstantLocalSize : public FunctionPass {
+		static char ID; // Pass identification, replacement for typeid
+
+		ConstantLocalSize() : FunctionPass(ID) {
+			initializeConstantLocalSizePass(*PassRegistry::getPassRegistry());
+		}
+
+		StringRef getPassName() const override {
+			return "constant local size";
+		}
+
+		void getAnalysisUsage(AnalysisUsage &AU) const override {
+			AU.setPreservesCFG();
+		}
+
+		bool runOnFunction(Function& F) override {
+			if (F.getCallingConv() != CallingConv::FLOOR_KERNEL) {
+				return false;
+			}
+			const auto wg_size = libfloor_utils::get_required_work_group_size(F);
+			if (!wg_size) {
+				return false;
+			}
+
+			std::vector<std::pair<CallInst*, uint64_t>> replacements;
+			for (auto& I : instructions(F)) {
+				auto CI = dyn_cast<CallInst>(&I);
+				if (!CI || !CI->getType()->isIntegerTy()) {
+					continue;
+				}
+				if (const auto dim = get_local_size_dim(*CI); dim) {
+					replacements.emplace_back(CI, *dim < 3 ? (*wg_size)[*dim] : 1u);
+				}
+			}
+
+			for (const auto& repl : replacements) {
+				repl.first->replaceAllUsesWith(ConstantInt::get(repl.first->getType(), repl.second));
+				repl.first->eraseFromParent();
+			}
+			return !replacements.empty();
+		}
+
+		//! if "CI" is a local size builtin call (for any backend) with a constant dim, returns its dim
+		static Optional<uint32_t> get_local_size_dim(const CallInst& CI) {
+			if (const auto II = dyn_cast<IntrinsicInst>(&CI); II) {
+				switch (II->getIntrinsicID()) {
+					case Intrinsic::nvvm_read_ptx_sreg_ntid_x: return 0u;
+					case Intrinsic::nvvm_read_ptx_sreg_ntid_y: return 1u;
+					case Intrinsic::nvvm_read_ptx_sreg_ntid_z: return 2u;
+					default: return None;
+				}
+			}
+			const auto called_func = CI.getCalledFunction();
+			if (!called_func || CI.arg_size() != 1) {
+				return None;
+			}
+			const auto func_name = called_func->getName();
+			if (func_name != "floor.get_local_size.i32" /* Metal */ &&
+				func_name != "floor.builtin.local_size.i32" /* Vulkan */ &&
+				func_name != "_Z14get_local_sizej" /* OpenCL/SPIR */ &&
+				func_name != "_Z23get_enqueued_local_sizej" /* OpenCL/SPIR */) {
+				return None;
+			}
+			if (const auto dim = dyn_cast<ConstantInt>(CI.getArgOperand(0)); dim) {
+				return uint32_t(std::min(dim->getZExtValue(), uint64_t(3u)));
+			}
+			return None;
+		}
+	};
+
+}
+
+char KernelWorkGroupSizeVariants::ID = 0;
+ModulePass *llvm::createKernelWorkGroupSizeVariantsPass(const std::vector<std::array<uint32_t, 3>>& wg_sizes) {
+	return new KernelWorkGroupSizeVariants(wg_sizes);
+}
+INITIALIZE_PASS_BEGIN(KernelWorkGroupSizeVariants, "KernelWorkGroupSizeVariants", "KernelWorkGroupSizeVariants Pass", false, false)
+INITIALIZE_PASS_END(KernelWorkGroupSizeVariants, "KernelWorkGroupSizeVariants", "KernelWorkGroupSizeVariants Pass", false, false)
+
+char ConstantLocalSize::ID = 0;
+FunctionPass *llvm::createConstantLocalSizePass() {
+	return new ConstantLocalSize();
+}
+INITIALIZE_PASS_BEGIN(ConstantLocalSize, "ConstantLocalSize", "ConstantLocalSize Pass", false, false)
+INITIALIZE_PASS_END(ConstantLocalSize, "ConstantLocalSize", "ConstantLocalSize Pass", false, false)
@@ -53,6 +53,18 @@ void llvm::initializeLibFloor(PassRegistry &Registry) {
   initializeVulkanFinalModuleCleanupPass(Registry);
   initializePropagateRangeInfoPass(Registry);
   initializeFMACombinerPass(Registry);
+  initializeFloorResourceUsagePass(Registry);
+  initializeLocalMemoryOverlayPass(Registry);
+  initializeKernelWorkGroupSizeVariantsPass(Registry);
+  initializeConstantLocalSizePass(Registry);
+  initializeHostComputeWorkGroupLoopsPass(Registry);
+  initializeSubGroupAtomicAggregationPass(Registry);
+  initializePromotePrivateArraysPass(Registry);
+  initializeRelaxedPrecisionDemotionPass(Registry);
+  initializeRegisterPressureSinkingPass(Registry);
+  initializeMemoryCoalescingAnalysisPass(Registry);
+  initializeLocalMemoryBankConflictsPass(Registry);
+  initializeVulkanStructuredCleanupPass(Registry);
 }
 
 void LLVMAddAddressSpaceFixPass(LLVMPassManagerRef PM) {
@@ -126,3 +138,51 @@ void LLVMAddPropagateRangeInfoPass(LLVMPassManagerRef PM) {
 void LLVMAddFMACombinerPass(LLVMPassManagerRef PM) {
   unwrap(PM)->add(createFMACombinerPass());
 }
+
+void LLVMAddFloorResourceUsagePass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createFloorResourceUsagePass());
+}
+
+void LLVMAddLocalMemoryOverlayPass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createLocalMemoryOverlayPass());
+}
+
+void LLVMAddKernelWorkGroupSizeVariantsPass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createKernelWorkGroupSizeVariantsPass());
+}
+
+void LLVMAddConstantLocalSizePass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createConstantLocalSizePass());
+}
+
+void LLVMAddHostComputeWorkGroupLoopsPass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createHostComputeWorkGroupLoopsPass());
+}
+
+void LLVMAddSubGroupAtomicAggregationPass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createSubGroupAtomicAggregationPass());
+}
+
+void LLVMAddPromotePrivateArraysPass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createPromotePrivateArraysPass());
+}
+
+void LLVMAddRelaxedPrecisionDemotionPass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createRelaxedPrecisionDemotionPass());
+}
+
+void LLVMAddRegisterPressureSinkingPass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createRegisterPressureSinkingPass());
+}
+
+void LLVMAddMemoryCoalescingAnalysisPass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createMemoryCoalescingAnalysisPass());
+}
+
+void LLVMAddLocalMemoryBankConflictsPass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createLocalMemoryBankConflictsPass());
+}
+
+void LLVMAddVulkanStructuredCleanupPass(LLVMPassManagerRef PM) {
+  unwrap(PM)->add(createVulkanStructuredCleanupPass());
+}
@@ -0,0 +1,607 @@
+//===- LocalMemoryBankConflicts.cpp - local memory bank conflicts ---------===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass predicts bank conflicts of local memory loads and stores and
+// optionally pads local memory arrays to avoid them.
+//
+// Local memory is split into a number of banks of a certain width (e.g. 32
+// banks of 4 bytes with CUDA), with consecutive words being assigned to
+// consecutive banks. If work-items of a sub-group access different words in
+// the same bank, these accesses are serialized. The address of each access is
+// expressed as an affine function of the work-item ids (see
+// FloorAffineIdAnalysis), and the banks that are accessed by the work-items
+// along the x dimension are simulated using the stride between neighboring
+// work-items.
+//
+// Conflicting accesses are reported as optimization analysis remarks
+// (-Rpass-analysis=LocalMemoryBankConflicts). If padding is enabled, the
+// innermost dimension of multi-dimensional local memory arrays (e.g. transpose
+// tiles) is padded by the least amount of elements that minimizes the
+// conflicts of all accesses to it, which is reported as an optimization remark.
+//
+// NOTE: padding changes the memory layout of the array, it is therefore only
+//       enabled on request and only performed if all accesses index the array
+//       through its dimensions (i.e. no flattened accesses through casts or
+//       pointer arithmetic on element pointers)
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GetElementPtrTypeIterator.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/LibFloor/FloorAffineIdAnalysis.h"
+#include "llvm/Transforms/LibFloor/FloorUtils.h"
+#include <memory>
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "LocalMemoryBankConflicts"
+
+#if 1
+#define DBG(x)
+#else
+#define DBG(x) x
+#endif
+
+// for testing purposes: enables padding if it wasn't enabled when creating the pass
+static cl::opt<bool> ClForceLocalMemoryPadding("floor-local-memory-force-padding", cl::Hidden, cl::init(false),
+											   cl::desc("pad local memory arrays to avoid bank conflicts"));
+
+namespace {
+	// LocalMemoryBankConflicts
+	struct LocalMemoryBankConflicts : public ModulePass {
+		static char ID; // Pass identification, replacement for typeid
+
+		//! pad local memory arrays to avoid bank conflicts
+		const bool enable_padding;
+		//! number of local memory banks (0 = backend default)
+		uint32_t bank_count;
+		//! width of each local memory bank in bytes (0 = backend default)
+		uint32_t bank_width;
+
+		LocalMemoryBankConflicts(const bool enable_padding_ = false, const uint32_t bank_count_ = 0u, const uint32_t bank_width_ = 0u) :
+		ModulePass(ID), enable_padding(enable_padding_ || ClForceLocalMemoryPadding), bank_count(bank_count_), bank_width(bank_width_) {
+			initializeLocalMemoryBankConflictsPass(*PassRegistry::getPassRegistry());
+		}
+
+		StringRef getPassName() const override {
+			return "local memory bank conflicts";
+		}
+
+		void getAnalysisUsage(AnalysisUsage &AU) const override {
+			AU.addRequired<ScalarEvolutionWrapperPass>();
+			AU.setPreservesCFG();
+		}
+
+		//! max relative size increase of a padded array (1/8th)
+		static constexpr const uint64_t max_padding_growth_divisor { 8u };
+
+		//! local memory array that is a candidate for padding
+		struct local_var_t {
+			GlobalVariable* GV { nullptr };
+			//! element counts of all array dimensions (outermost first)
+			SmallVector<uint64_t, 4> dims;
+			//! type at each indexing depth (depth 0 = the array itself, depth #dims = element type)
+			SmallVector<Type*, 5> types;
+			//! size of the (non-array) element type
+			uint64_t elem_size { 0u };
+			//! false if the array is accessed in a way that doesn't allow changing its layout
+			bool is_paddable { true };
+		};
+
+		//! single scaled GEP index of an access
+		struct index_term_t {
+			Value* index { nullptr };
+			//! indexing depth in the local memory array, or -1 if "fixed_size" is used (indexing below the array element type)
+			int32_t depth { -1 };
+			uint64_t fixed_size { 0u };
+			//! fast id coefficient of the index (filled in by the SCEV analysis)
+			int64_t coeff { 0 };
+		};
+
+		//! local memory load/store
+		struct access_t {
+			Instruction* I { nullptr };
+			uint32_t size { 0u };
+			//! number of work-items that access local memory at the same time
+			uint32_t lanes { 0u };
+			//! if non-null: array that is accessed through its dimensions via "terms"
+			local_var_t* var { nullptr };
+			SmallVector<index_term_t, 4> terms;
+			//! if the access isn't through an array: stride between neighboring work-items in bytes
+			int64_t stride { 0 };
+			//! false if the stride is unknown at compile-time
+			bool is_known { false };
+		};
+
+		bool runOnModule(Module& M) override {
+			const auto triple = Triple(M.getTargetTriple());
+			const bool is_cuda = triple.isNVPTX();
+			const bool is_metal = (triple.getArch() == Triple::air64);
+			const bool is_spir = triple.isSPIR(); // incl. Vulkan
+			const bool is_vulkan = (triple.getEnvironment() == Triple::Vulkan);
+			if (!is_cuda && !is_metal && !is_spir) {
+				return false;
+			}
+
+			// only run the analysis if anyone is interested in its results or we may pad
+			const bool emit_remarks = OptimizationRemarkEmitter::allowExtraAnalysis(M.getContext(), DEBUG_TYPE);
+			if (!emit_remarks && !enable_padding) {
+				return false;
+			}
+
+			// default banks: 32 x 4 bytes on NVIDIA/Apple/most Vulkan devices, 16 x 4 bytes is a safer assumption for OpenCL devices
+			if (bank_count == 0u) {
+				bank_count = (is_spir && !is_vulkan ? 16u : 32u);
+			}
+			if (bank_width == 0u) {
+				bank_width = 4u;
+			}
+			DL = &M.getDataLayout();
+
+			// gather arrays and their accesses through their dimensions
+			std::vector<std::unique_ptr<local_var_t>> vars;
+			std::vector<access_t> accesses;
+			for (auto& GV : M.globals()) {
+				if (GV.getAddressSpace() != libfloor_utils::local_address_space ||
+					GV.isDeclaration() || !GV.hasLocalLinkage() ||
+					!isa<UndefValue>(GV.getInitializer()) ||
+					!isa<ArrayType>(GV.getValueType())) {
+					continue;
+				}
+				if (enable_padding) {
+					// stale constant expressions would otherwise prevent padding
+					GV.removeDeadConstantUsers();
+				}
+				auto var = std::make_unique<local_var_t>();
+				var->GV = &GV;
+				Type* type = GV.getValueType();
+				var->types.emplace_back(type);
+				while (auto arr_type = dyn_cast<ArrayType>(type)) {
+					var->dims.emplace_back(arr_type->getNumElements());
+					type = arr_type->getElementType();
+					var->types.emplace_back(type);
+				}
+				var->elem_size = DL->getTypeAllocSize(type).getFixedSize();
+				if (var->elem_size == 0u) {
+					continue;
+				}
+				gather_accesses(*var, GV, 0, {}, accesses);
+				vars.emplace_back(std::move(var));
+			}
+			if (vars.empty() && !emit_remarks) {
+				return false;
+			}
+
+			// gather all other local memory accesses (only needed for remarks)
+			if (emit_remarks) {
+				DenseMap<const Instruction*, bool> known_accesses;
+				for (const auto& access : accesses) {
+					known_accesses[access.I] = true;
+				}
+				for (auto& F : M) {
+					for (auto& BB : F) {
+						for (auto& I : BB) {
+							auto ptr = get_access_pointer(I);
+							if (!ptr || ptr->getType()->getPointerAddressSpace() != libfloor_utils::local_address_space ||
+								known_accesses.count(&I) > 0) {
+								continue;
+							}
+							access_t access;
+							access.I = &I;
+							access.size = get_access_size(I);
+							accesses.emplace_back(std::move(access));
+						}
+					}
+				}
+			}
+			if (accesses.empty()) {
+				return false;
+			}
+
+			// analyze the accesses of each function
+			// NOTE: SCEV is only valid until it is requested for the next function
+			MapVector<Function*, SmallVector<access_t*, 16>> func_accesses;
+			for (auto& access : accesses) {
+				func_accesses[access.I->getFunction()].emplace_back(&access);
+			}
+			for (auto& func_and_accesses : func_accesses) {
+				auto& F = *func_and_accesses.first;
+				auto& SE = getAnalysis<ScalarEvolutionWrapperPass>(F).getSE();
+				const auto lanes = get_lane_count(F);
+				for (auto& access : func_and_accesses.second) {
+					access->lanes = lanes;
+					analyze_access(SE, *access);
+				}
+			}
+
+			// find the best padding for each array
+			DenseMap<const local_var_t*, uint64_t> var_padding;
+			if (enable_padding) {
+				for (auto& var : vars) {
+					if (!var->is_paddable || var->dims.size() < 2u) {
+						continue;
+					}
+					SmallVector<const access_t*, 16> var_accesses;
+					for (const auto& access : accesses) {
+						if (access.var == var.get()) {
+							var_accesses.emplace_back(&access);
+						}
+					}
+					const auto padding = find_padding(*var, var_accesses);
+					if (padding > 0u) {
+						var_padding[var.get()] = padding;
+					}
+				}
+			}
+
+			// report remaining conflicts and the padding
+			if (emit_remarks) {
+				DenseMap<const Function*, std::unique_ptr<OptimizationRemarkEmitter>> func_ores;
+				for (const auto& access : accesses) {
+					if (!access.is_known) {
+						continue;
+					}
+					const auto padding = (access.var && var_padding.count(access.var) > 0 ? var_padding[access.var] : 0u);
+					const auto stride = get_stride(access, padding);
+					const auto conflict = compute_bank_conflict(stride, access.size, access.lanes);
+					if (conflict.first <= conflict.second) {
+						continue;
+					}
+					auto& ORE = func_ores[access.I->getFunction()];
+					if (!ORE) {
+						ORE = std::make_unique<OptimizationRemarkEmitter>(access.I->getFunction());
+					}
+					ORE->emit([&]() {
+						return OptimizationRemarkAnalysis(DEBUG_TYPE, "LocalMemoryBankConflict", access.I)
+							<< (isa<LoadInst>(access.I) ? "local load" : "local store")
+							<< " of " << ore::NV("AccessSize", access.size) << " bytes has a "
+							<< ore::NV("ConflictDegree", conflict.first) << "-way bank conflict (stride of "
+							<< ore::NV("Stride", stride) << " bytes)";
+					});
+				}
+			}
+			for (auto& var : vars) {
+				if (var_padding.count(var.get()) == 0) {
+					continue;
+				}
+				const auto padding = var_padding[var.get()];
+				const auto first_access = find_if(accesses, [&var](const access_t& access) {
+					return access.var == var.get();
+				});
+				if (first_access != accesses.end()) {
+					OptimizationRemarkEmitter ORE(first_access->I->getFunction());
+					ORE.emit([&]() {
+						return OptimizationRemark(DEBUG_TYPE, "LocalMemoryPadding", first_access->I)
+							<< "padded the innermost dimension of local memory variable "
+							<< ore::NV("Variable", var->GV->getName()) << " by " << ore::NV("Padding", padding)
+							<< " elements to avoid bank conflicts (" << ore::NV("Size", get_padded_size(*var, 0, 0))
+							<< " -> " << ore::NV("PaddedSize", get_padded_size(*var, 0, padding)) << " bytes)";
+					});
+				}
+				pad_var(M, *var, padding);
+			}
+			return !var_padding.empty();
+		}
+
+	protected:
+		const DataLayout* DL { nullptr };
+
+		//! returns the pointer operand of "I" if it is a load or store
+		static Value* get_access_pointer(Instruction& I) {
+			if (auto LD = dyn_cast<LoadInst>(&I); LD) {
+				return LD->getPointerOperand();
+			} else if (auto ST = dyn_cast<StoreInst>(&I); ST) {
+				return ST->getPointerOperand();
+			}
+			return nullptr;
+		}
+
+		//! returns the size of the load or store "I" in bytes
+		uint32_t get_access_size(Instruction& I) const {
+			auto type = (isa<LoadInst>(&I) ? I.getType() : cast<StoreInst>(&I)->getValueOperand()->getType());
+			return uint32_t(DL->getTypeStoreSize(type).getFixedSize());
+		}
+
+		//! returns the size of the type at "depth" in "var" when its innermost dimension is padded by "padding" elements
+		static uint64_t get_padded_size(const local_var_t& var, const uint32_t depth, const uint64_t padding) {
+			const auto dim_count = uint32_t(var.dims.size());
+			if (depth >= dim_count) {
+				return var.elem_size;
+			}
+			uint64_t size = (var.dims[dim_count - 1u] + padding) * var.elem_size;
+			for (uint32_t dim = depth; dim < dim_count - 1u; ++dim) {
+				size *= var.dims[dim];
+			}
+			return size;
+		}
+
+		//! recursively gathers all loads/stores of "var" that are derived from "ptr" through GEPs,
+		//! "depth" is the indexing depth of "ptr", "terms" the GEP indices that led to it
+		void gather_accesses(local_var_t& var, Value& ptr, const uint32_t depth, const SmallVector<index_term_t, 4>& terms,
+							 std::vector<access_t>& accesses) {
+			const auto dim_count = uint32_t(var.dims.size());
+			for (auto user : ptr.users()) {
+				if (auto GEP = dyn_cast<GEPOperator>(user); GEP) {
+					if (depth <= dim_count && GEP->getSourceElementType() != var.types[depth]) {
+						// indexing through a different type, e.g. after a cast
+						var.is_paddable = false;
+						continue;
+					}
+					if (depth >= dim_count && GEP->getNumIndices() > 0u) {
+						// pointer arithmetic on an element pointer (e.g. &tile[0][0] + k) may cross rows of the
+						// innermost dimension, i.e. depends on the current layout
+						if (auto first_idx = dyn_cast<ConstantInt>(GEP->idx_begin()->get()); !first_idx || !first_idx->isZero()) {
+							var.is_paddable = false;
+						}
+					}
+					auto gep_terms = terms;
+					uint32_t idx_depth = depth;
+					for (auto GTI = gep_type_begin(GEP), GTE = gep_type_end(GEP); GTI != GTE; ++GTI, ++idx_depth) {
+						// NOTE: this includes all struct indices
+						if (isa<ConstantInt>(GTI.getOperand())) {
+							continue;
+						}
+						index_term_t term;
+						term.index = GTI.getOperand();
+						if (idx_depth <= dim_count) {
+							term.depth = int32_t(idx_depth);
+						} else {
+							term.fixed_size = DL->getTypeAllocSize(GTI.getIndexedType()).getFixedSize();
+						}
+						gep_terms.emplace_back(term);
+					}
+					gather_accesses(var, *GEP, depth + GEP->getNumIndices() - 1u, gep_terms, accesses);
+					continue;
+				}
+
+				auto I = dyn_cast<Instruction>(user);
+				if (!I) {
+					// used by another global or non-GEP constant expression
+					var.is_paddable = false;
+					continue;
+				}
+				if ((isa<LoadInst>(I) && cast<LoadInst>(I)->getPointerOperand() == &ptr) ||
+					(isa<StoreInst>(I) && cast<StoreInst>(I)->getPointerOperand() == &ptr)) {
+					if (depth < dim_count) {
+						// load/store of a whole (sub-)array
+						var.is_paddable = false;
+						continue;
+					}
+					access_t access;
+					access.I = I;
+					access.size = get_access_size(*I);
+					access.var = &var;
+					access.terms = terms;
+					accesses.emplace_back(std::move(access));
+					continue;
+				}
+				if (depth >= dim_count) {
+					// atomics or builtin calls on elements don't depend on the layout
+					if (auto RMW = dyn_cast<AtomicRMWInst>(I); RMW && RMW->getPointerOperand() == &ptr) {
+						continue;
+					}
+					if (auto CX = dyn_cast<AtomicCmpXchgInst>(I); CX && CX->getPointerOperand() == &ptr) {
+						continue;
+					}
+					if (auto CB = dyn_cast<CallBase>(I); CB && CB->getCalledFunction() &&
+						CB->getCalledFunction()->isDeclaration()) {
+						continue;
+					}
+				}
+				// casts, PHIs, escaping pointers, ...: we can't track how the array is accessed
+				var.is_paddable = false;
+			}
+		}
+
+		//! returns the number of work-items along the x dimension that access local memory at the same time
+		uint32_t get_lane_count(const Function& F) const {
+			if (const auto wg_size_node = F.getMetadata("reqd_work_group_size"); wg_size_node && wg_size_node->getNumOperands() == 3) {
+				if (const auto size_x = mdconst::dyn_extract<ConstantInt>(wg_size_node->getOperand(0)); size_x) {
+					return uint32_t(std::max(uint64_t(1u), std::min(uint64_t(bank_count), size_x->getZExtValue())));
+				}
+			}
+			return bank_count;
+		}
+
+		//! determines the fast id coefficients of all indices of "access" (or its stride if it isn't a known array access)
+		static void analyze_access(ScalarEvolution& SE, access_t& access) {
+			if (!access.var) {
+				const auto info = analyze_floor_affine_id_pointer(SE, *get_access_pointer(*access.I));
+				access.is_known = info.has_const_fast_stride();
+				access.stride = info.fast_stride;
+				return;
+			}
+			for (auto& term : access.terms) {
+				const auto info = analyze_floor_affine_id_value(SE, *term.index);
+				if (!info.has_const_fast_stride()) {
+					access.is_known = false;
+					return;
+				}
+				term.coeff = info.fast_stride;
+			}
+			access.is_known = true;
+		}
+
+		//! returns the byte stride between neighboring work-items of "access" with the specified padding of its array
+		static int64_t get_stride(const access_t& access, const uint64_t padding) {
+			if (!access.var) {
+				return access.stride;
+			}
+			int64_t stride = 0;
+			for (const auto& term : access.terms) {
+				const auto size = (term.depth >= 0 ? get_padded_size(*access.var, uint32_t(term.depth), padding) : term.fixed_size);
+				stride += term.coeff * int64_t(size);
+			}
+			return stride;
+		}
+
+		//! simulates the banks accessed by all lanes, returns <max #words accessed in a single bank, conflict-free #words per bank>
+		std::pair<uint32_t, uint32_t> compute_bank_conflict(const int64_t stride, const uint32_t access_size, const uint32_t lanes) const {
+			// NOTE: negative strides access the same banks in reverse order
+			const auto abs_stride = uint64_t(stride < 0 ? -stride : stride);
+			std::vector<SmallVector<uint64_t, 4>> bank_words(bank_count);
+			uint32_t word_count = 0;
+			for (uint64_t lane = 0; lane < lanes; ++lane) {
+				const auto offset = lane * abs_stride;
+				for (uint64_t word = offset / bank_width, last_word = (offset + std::max(access_size, 1u) - 1u) / bank_width;
+					 word <= last_word; ++word) {
+					auto& words = bank_words[word % bank_count];
+					if (!is_contained(words, word)) {
+						words.emplace_back(word);
+						++word_count;
+					}
+				}
+			}
+			uint32_t max_words = 0;
+			for (const auto& words : bank_words) {
+				max_words = std::max(max_words, uint32_t(words.size()));
+			}
+			return { max_words, std::max(1u, (word_count + bank_count - 1u) / bank_count) };
+		}
+
+		//! returns the least amount of elements the innermost dimension of "var" must be padded by to minimize
+		//! the bank conflicts of all its accesses (0 if padding doesn't help)
+		uint64_t find_padding(const local_var_t& var, const SmallVector<const access_t*, 16>& var_accesses) const {
+			const auto compute_conflicts = [this, &var_accesses](const uint64_t padding) {
+				uint64_t conflicts = 0;
+				for (const auto& access : var_accesses) {
+					if (!access->is_known) {
+						continue;
+					}
+					const auto conflict = compute_bank_conflict(get_stride(*access, padding), access->size, access->lanes);
+					conflicts += conflict.first - std::min(conflict.first, conflict.second);
+				}
+				return conflicts;
+			};
+
+			auto min_conflicts = compute_conflicts(0u);
+			if (min_conflicts == 0u) {
+				return 0u;
+			}
+			const auto size = get_padded_size(var, 0, 0);
+			const auto max_size = size + size / max_padding_growth_divisor;
+			// padding by more than a whole bank row never helps
+			const auto max_padding = std::max(uint64_t(1u), uint64_t(bank_count) * uint64_t(bank_width) / var.elem_size);
+			uint64_t best_padding = 0;
+			for (uint64_t padding = 1; padding <= max_padding && get_padded_size(var, 0, padding) <= max_size; ++padding) {
+				const auto conflicts = compute_conflicts(padding);
+				if (conflicts < min_conflicts) {
+					min_conflicts = conflicts;
+					best_padding = padding;
+					if (conflicts == 0u) {
+						break;
+					}
+				}
+			}
+			DBG(errs() << var.GV->getName() << ": padding " << best_padding << ", remaining conflicts " << min_conflicts << "\n";)
+			return best_padding;
+		}
+
+		//! returns the padded type at "depth" of "var"
+		static Type* get_padded_type(const local_var_t& var, const uint32_t depth, const uint64_t padding) {
+			const auto dim_count = uint32_t(var.dims.size());
+			Type* type = var.types[dim_count];
+			for (uint32_t dim = dim_count; dim > depth; --dim) {
+				type = ArrayType::get(type, var.dims[dim - 1u] + (dim == dim_count ? padding : 0u));
+			}
+			return type;
+		}
+
+		//! replaces "var" by an array with a padded innermost dimension
+		void pad_var(Module& M, local_var_t& var, const uint64_t padding) {
+			auto& GV = *var.GV;
+			auto padded_type = get_padded_type(var, 0, padding);
+			auto padded_GV = new GlobalVariable(M, padded_type, GV.isConstant(), GV.getLinkage(), UndefValue::get(padded_type),
+												"", &GV, GV.getThreadLocalMode(), GV.getAddressSpace());
+			padded_GV->takeName(&GV);
+			padded_GV->copyAttributesFrom(&GV);
+			padded_GV->setAlignment(GV.getAlign());
+
+			rewrite_users(var, GV, *padded_GV, 0, padding);
+			GV.removeDeadConstantUsers();
+			GV.eraseFromParent();
+		}
+
+		//! recursively rewrites all GEPs that are derived from "ptr" to use the padded "padded_ptr" instead
+		void rewrite_users(local_var_t& var, Value& ptr, Value& padded_ptr, const uint32_t depth, const uint64_t padding) {
+			const auto dim_count = uint32_t(var.dims.size());
+			auto src_type = get_padded_type(var, std::min(depth, dim_count), padding);
+			for (auto user : make_early_inc_range(ptr.users())) {
+				auto GEP = cast<GEPOperator>(user);
+				SmallVector<Value*, 4> indices(GEP->idx_begin(), GEP->idx_end());
+				const auto gep_depth = depth + GEP->getNumIndices() - 1u;
+				Value* padded_gep = nullptr;
+				if (auto const_expr = dyn_cast<ConstantExpr>(GEP); const_expr) {
+					SmallVector<Constant*, 4> const_indices;
+					for (auto idx : indices) {
+						const_indices.emplace_back(cast<Constant>(idx));
+					}
+					padded_gep = ConstantExpr::getGetElementPtr(src_type, cast<Constant>(&padded_ptr), const_indices, GEP->isInBounds());
+				} else {
+					auto gep_instr = cast<GetElementPtrInst>(GEP);
+					IRBuilder<> builder(gep_instr);
+					padded_gep = (GEP->isInBounds() ?
+								  builder.CreateInBoundsGEP(src_type, &padded_ptr, indices) :
+								  builder.CreateGEP(src_type, &padded_ptr, indices));
+					padded_gep->takeName(gep_instr);
+				}
+
+				if (gep_depth >= dim_count) {
+					// same result type as before
+					GEP->replaceAllUsesWith(padded_gep);
+				} else {
+					rewrite_users(var, *GEP, *padded_gep, gep_depth, padding);
+				}
+				if (auto gep_instr = dyn_cast<GetElementPtrInst>(GEP); gep_instr) {
+					gep_instr->eraseFromParent();
+				}
+			}
+		}
+	};
+
+}
+
+char LocalMemoryBankConflicts::ID = 0;
+ModulePass *llvm::createLocalMemoryBankConflictsPass(const bool enable_padding, const uint32_t bank_count, const uint32_t bank_width) {
+	return new LocalMemoryBankConflicts(enable_padding, bank_count, bank_width);
+}
+INITIALIZE_PASS_BEGIN(LocalMemoryBankConflicts, "LocalMemoryBankConflicts", "LocalMemoryBankConflicts Pass", false, false)
+INITIALIZE_PASS_DEPENDENCY(ScalarEvolutionWrapperPass)
+INITIALIZE_PASS_END(LocalMemoryBankConflicts, "LocalMemoryBankConflicts", "LocalMemoryBankConflicts Pass", false, false)
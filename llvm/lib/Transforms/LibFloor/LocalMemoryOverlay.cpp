@@ -0,0 +1,356 @@
+//===- LocalMemoryOverlay.cpp - lifetime-based local memory overlay -------===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass overlays local memory variables of each kernel whose lifetimes
+// don't overlap into a single local memory allocation (i.e. "stack coloring"
+// for local/threadgroup/shared memory).
+//
+// Lifetimes are tracked at the granularity of barrier regions: the CFG of a
+// kernel is split at all work-group barriers that order local memory accesses
+// (barriers that only fence global memory or whose fence flags are unknown or
+// not constant don't split regions), and all parts that are connected
+// without crossing a barrier form one region. Since work-items may be at any
+// point within a region, a variable is live in all regions that lie on a path
+// from any access of it to any access of it. Two variables can share the same
+// memory iff they are never live in the same region.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/LibFloor/FloorUtils.h"
+#include <algorithm>
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "LocalMemoryOverlay"
+
+#if 1
+#define DBG(x)
+#else
+#define DBG(x) x
+#endif
+
+namespace {
+	// LocalMemoryOverlay
+	struct LocalMemoryOverlay : public ModulePass {
+		static char ID; // Pass identification, replacement for typeid
+
+		LocalMemoryOverlay() : ModulePass(ID) {
+			initializeLocalMemoryOverlayPass(*PassRegistry::getPassRegistry());
+		}
+
+		StringRef getPassName() const override {
+			return "local memory overlay";
+		}
+
+		void getAnalysisUsage(AnalysisUsage &AU) const override {
+			AU.setPreservesCFG();
+		}
+
+		//! barrier region info of a single function
+		struct region_info_t {
+			//! instruction -> region index
+			DenseMap<const Instruction*, uint32_t> instr_regions;
+			//! region -> successor regions (across a barrier)
+			std::vector<SmallVector<uint32_t, 4>> succs;
+			//! region -> predecessor regions (across a barrier)
+			std::vector<SmallVector<uint32_t, 4>> preds;
+		};
+
+		//! local memory variable that is a candidate for overlaying
+		struct local_var_t {
+			GlobalVariable* GV { nullptr };
+			uint64_t size { 0u };
+			Align align;
+			//! all instructions that access or derive a pointer from this variable
+			SmallPtrSet<const Instruction*, 16> accesses;
+			//! regions in which this variable is live
+			BitVector live;
+			//! assigned offset in the overlay allocation
+			uint64_t offset { 0u };
+		};
+
+		bool runOnModule(Module& M) override {
+			const auto& DL = M.getDataLayout();
+
+			// local memory vars that are exclusively used in a single kernel
+			MapVector<Function*, std::vector<local_var_t>> kernel_vars;
+			for (auto& GV : M.globals()) {
+				if (GV.getAddressSpace() != libfloor_utils::local_address_space ||
+					GV.isDeclaration() || !GV.hasLocalLinkage() ||
+					!isa<UndefValue>(GV.getInitializer())) {
+					continue;
+				}
+
+				local_var_t var;
+				var.GV = &GV;
+				Function* kernel = nullptr;
+				if (!gather_accesses(GV, var.accesses, kernel) || kernel == nullptr) {
+					continue;
+				}
+				if (kernel->getCallingConv() != CallingConv::FLOOR_KERNEL) {
+					continue;
+				}
+				var.size = DL.getTypeAllocSize(GV.getValueType()).getFixedSize();
+				var.align = DL.getValueOrABITypeAlignment(GV.getAlign(), GV.getValueType());
+				kernel_vars[kernel].emplace_back(std::move(var));
+			}
+
+			bool was_modified = false;
+			for (auto& kernel_and_vars : kernel_vars) {
+				if (kernel_and_vars.second.size() < 2) {
+					continue;
+				}
+				was_modified |= overlay_kernel_vars(M, *kernel_and_vars.first, kernel_and_vars.second);
+			}
+			return was_modified;
+		}
+
+		//! gathers all instructions that access "GV" (or values derived from it),
+		//! returns false if "GV" escapes or is used in more than one function
+		static bool gather_accesses(GlobalVariable& GV, SmallPtrSet<const Instruction*, 16>& accesses, Function*& func) {
+			SmallVector<const Value*, 16> worklist { &GV };
+			SmallPtrSet<const Value*, 16> visited;
+			while (!worklist.empty()) {
+				const auto val = worklist.pop_back_val();
+				if (!visited.insert(val).second) {
+					continue;
+				}
+				for (const auto& use : val->uses()) {
+					const auto user = use.getUser();
+					if (const auto const_expr = dyn_cast<ConstantExpr>(user); const_expr) {
+						worklist.emplace_back(const_expr);
+						continue;
+					}
+					const auto instr = dyn_cast<Instruction>(user);
+					if (!instr) {
+						// used by another global or other non-instruction
+						return false;
+					}
+					if (func == nullptr) {
+						func = instr->getFunction();
+					} else if (func != instr->getFunction()) {
+						return false;
+					}
+					accesses.insert(instr);
+
+					if (isa<LoadInst>(instr) || isa<ICmpInst>(instr)) {
+						continue;
+					} else if (const auto SI = dyn_cast<StoreInst>(instr); SI) {
+						if (SI->getValueOperand() == val) {
+							return false;
+						}
+					} else if (const auto RMW = dyn_cast<AtomicRMWInst>(instr); RMW) {
+						if (RMW->getValOperand() == val) {
+							return false;
+						}
+					} else if (const auto CX = dyn_cast<AtomicCmpXchgInst>(instr); CX) {
+						if (CX->getPointerOperand() != val) {
+							return false;
+						}
+					} else if (isa<GetElementPtrInst>(instr) || isa<BitCastInst>(instr) || isa<AddrSpaceCastInst>(instr) ||
+							   isa<PHINode>(instr) || isa<SelectInst>(instr)) {
+						worklist.emplace_back(instr);
+					} else if (const auto CB = dyn_cast<CallBase>(instr); CB) {
+						// only allow calls to builtins/intrinsics (e.g. atomics or memcpy), we can't track anything beyond that
+						const auto called_func = CB->getCalledFunction();
+						if (!called_func || !called_func->isDeclaration()) {
+							return false;
+						}
+					} else {
+						// ptrtoint, return, ...
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		//! splits "F" into regions that are delimited by work-group barriers that fence local memory
+		static region_info_t compute_regions(Function& F) {
+			region_info_t info;
+
+			// split all blocks at barriers into nodes, a barrier is the last instruction of a node
+			uint32_t node_count = 0;
+			DenseMap<const Instruction*, uint32_t> instr_nodes;
+			DenseMap<const BasicBlock*, std::pair<uint32_t, uint32_t>> block_nodes; // first, last
+			SmallVector<std::pair<uint32_t, uint32_t>, 16> barrier_edges;
+			for (const auto& BB : F) {
+				const auto first_node = node_count;
+				for (const auto& I : BB) {
+					instr_nodes[&I] = node_count;
+					if (const auto CB = dyn_cast<CallBase>(&I);
+						CB && libfloor_utils::is_local_memory_barrier_call(*CB) && !I.isTerminator()) {
+						barrier_edges.emplace_back(node_count, node_count + 1);
+						++node_count;
+					}
+				}
+				block_nodes[&BB] = { first_node, node_count };
+				++node_count;
+			}
+
+			// nodes that are connected without crossing a barrier belong to the same region
+			EquivalenceClasses<uint32_t> node_classes;
+			for (uint32_t node = 0; node < node_count; ++node) {
+				node_classes.insert(node);
+			}
+			for (const auto& BB : F) {
+				for (const auto succ : successors(&BB)) {
+					node_classes.unionSets(block_nodes[&BB].second, block_nodes[succ].first);
+				}
+			}
+
+			DenseMap<uint32_t, uint32_t> leader_regions;
+			auto get_region = [&node_classes, &leader_regions](const uint32_t node) {
+				const auto leader = node_classes.getLeaderValue(node);
+				return leader_regions.insert({ leader, uint32_t(leader_regions.size()) }).first->second;
+			};
+			for (const auto& instr_node : instr_nodes) {
+				info.instr_regions[instr_node.first] = get_region(instr_node.second);
+			}
+			for (const auto& edge : barrier_edges) {
+				// NOTE: nodes directly following a barrier may be empty if they are not connected to anything else
+				get_region(edge.first);
+				get_region(edge.second);
+			}
+			info.succs.resize(leader_regions.size());
+			info.preds.resize(leader_regions.size());
+			for (const auto& edge : barrier_edges) {
+				const auto from = get_region(edge.first), to = get_region(edge.second);
+				info.succs[from].emplace_back(to);
+				info.preds[to].emplace_back(from);
+			}
+			return info;
+		}
+
+		//! returns all regions reachable from "start" (including "start") via "edges"
+		static BitVector reachable_regions(const BitVector& start, const std::vector<SmallVector<uint32_t, 4>>& edges) {
+			BitVector reachable(start);
+			SmallVector<uint32_t, 16> worklist;
+			for (const auto region : start.set_bits()) {
+				worklist.emplace_back(region);
+			}
+			while (!worklist.empty()) {
+				const auto region = worklist.pop_back_val();
+				for (const auto next : edges[region]) {
+					if (!reachable.test(next)) {
+						reachable.set(next);
+						worklist.emplace_back(next);
+					}
+				}
+			}
+			return reachable;
+		}
+
+		//! computes non-overlapping offsets for all vars in "vars" and replaces them by a single overlay variable,
+		//! returns true if this actually saved memory
+		static bool overlay_kernel_vars(Module& M, Function& F, std::vector<local_var_t>& vars) {
+			const auto info = compute_regions(F);
+			const auto region_count = uint32_t(info.succs.size());
+
+			// compute liveness: all regions that are on a path from an access to an access
+			for (auto& var : vars) {
+				BitVector accessed(region_count);
+				for (const auto& instr : var.accesses) {
+					accessed.set(info.instr_regions.lookup(instr));
+				}
+				var.live = reachable_regions(accessed, info.succs);
+				var.live &= reachable_regions(accessed, info.preds);
+			}
+
+			// place biggest vars first, then try to fit each var at the lowest offset that doesn't overlap any interfering var
+			std::stable_sort(vars.begin(), vars.end(), [](const local_var_t& lhs, const local_var_t& rhs) {
+				return (lhs.size != rhs.size ? lhs.size > rhs.size : lhs.align > rhs.align);
+			});
+			uint64_t orig_size = 0, overlay_size = 0;
+			Align max_align;
+			for (size_t i = 0; i < vars.size(); ++i) {
+				auto& var = vars[i];
+				orig_size = alignTo(orig_size, var.align) + var.size;
+				max_align = std::max(max_align, var.align);
+
+				uint64_t offset = 0;
+				for (bool placed = false; !placed; ) {
+					placed = true;
+					for (size_t j = 0; j < i; ++j) {
+						const auto& other = vars[j];
+						if (!var.live.anyCommon(other.live)) {
+							continue;
+						}
+						if (offset < other.offset + other.size && other.offset < offset + var.size) {
+							offset = alignTo(other.offset + other.size, var.align);
+							placed = false;
+						}
+					}
+				}
+				var.offset = offset;
+				overlay_size = std::max(overlay_size, offset + var.size);
+				DBG(errs() << F.getName() << ": " << var.GV->getName() << " @" << offset << " (" << var.size << " bytes)\n";)
+			}
+			if (overlay_size >= orig_size) {
+				return false;
+			}
+			DBG(errs() << F.getName() << ": local memory " << orig_size << " -> " << overlay_size << " bytes\n";)
+
+			// create the backing overlay variable and replace all vars with the corresponding offset into it
+			auto& ctx = M.getContext();
+			auto i8_type = Type::getInt8Ty(ctx);
+			auto overlay_type = ArrayType::get(i8_type, overlay_size);
+			auto overlay_GV = new GlobalVariable(M, overlay_type, false, GlobalValue::InternalLinkage,
+												 UndefValue::get(overlay_type), F.getName() + ".local_mem_overlay",
+												 nullptr, GlobalValue::NotThreadLocal, libfloor_utils::local_address_space);
+			overlay_GV->setAlignment(max_align);
+			for (auto& var : vars) {
+				Constant* idx[] { ConstantInt::get(Type::getInt32Ty(ctx), 0), ConstantInt::get(Type::getInt32Ty(ctx), var.offset) };
+				auto var_ptr = ConstantExpr::getInBoundsGetElementPtr(overlay_type, overlay_GV, idx);
+				var.GV->replaceAllUsesWith(ConstantExpr::getPointerBitCastOrAddrSpaceCast(var_ptr, var.GV->getType()));
+				var.GV->eraseFromParent();
+			}
+			return true;
+		}
+	};
+
+}
+
+char LocalMemoryOverlay::ID = 0;
+ModulePass *llvm::createLocalMemoryOverlayPass() {
+	return new LocalMemoryOverlay();
+}
+INITIALIZE_PASS_BEGIN(LocalMemoryOverlay, "LocalMemoryOverlay", "LocalMemoryOverlay Pass", false, false)
+INITIALIZE_PASS_END(LocalMemoryOverlay, "LocalMemoryOverlay", "LocalMemoryOverlay Pass", false, false)
@@ -0,0 +1,199 @@
+//===- MemoryCoalescingAnalysis.cpp - global memory coalescing remarks ----===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass analyzes how global memory loads and stores of kernels are
+// coalesced across the work-items of a sub-group and reports the result as
+// optimization analysis remarks (-Rpass-analysis=MemoryCoalescingAnalysis or
+// the YAML remarks file). It does not modify the IR.
+//
+// The address of each access is expressed as an affine function of the
+// work-item id builtins (CUDA, Metal, OpenCL/SPIR and Vulkan) using SCEV.
+// The coefficient of the "fast" id (x dim of the local/global id, sub-group
+// local id), i.e. the address difference of neighboring work-items, then
+// determines the access pattern:
+//  * contiguous: neighboring work-items access neighboring elements
+//  * strided: neighboring work-items access elements that are a constant or
+//    uniform (but unknown) distance apart
+//  * broadcast: all work-items (along the x dim) access the same address
+//  * random: the address is not an affine function of the ids (e.g. it
+//    depends on loaded values)
+//
+// Must run after inlining, but before the final backend passes, since these
+// replace the id builtins.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/CallingConv.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/LibFloor/FloorAffineIdAnalysis.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "MemoryCoalescingAnalysis"
+
+#if 1
+#define DBG(x)
+#else
+#define DBG(x) x
+#endif
+
+namespace {
+	// MemoryCoalescingAnalysis
+	struct MemoryCoalescingAnalysis : public FunctionPass {
+		static char ID; // Pass identification, replacement for typeid
+
+		MemoryCoalescingAnalysis() : FunctionPass(ID) {
+			initializeMemoryCoalescingAnalysisPass(*PassRegistry::getPassRegistry());
+		}
+
+		StringRef getPassName() const override {
+			return "memory coalescing analysis";
+		}
+
+		void getAnalysisUsage(AnalysisUsage &AU) const override {
+			AU.addRequired<LoopInfoWrapperPass>();
+			AU.addRequired<ScalarEvolutionWrapperPass>();
+			AU.addRequired<OptimizationRemarkEmitterWrapperPass>();
+			AU.setPreservesAll();
+		}
+
+		//! address space of global/device memory
+		static constexpr const uint32_t global_address_space { 1u };
+
+		bool runOnFunction(Function& F) override {
+			if (F.empty() || F.getCallingConv() != CallingConv::FLOOR_KERNEL) {
+				return false;
+			}
+			const auto triple = Triple(F.getParent()->getTargetTriple());
+			is_cuda = triple.isNVPTX();
+			const bool is_metal = (triple.getArch() == Triple::air64);
+			const bool is_spir = triple.isSPIR(); // incl. Vulkan
+			if (!is_cuda && !is_metal && !is_spir) {
+				return false;
+			}
+
+			// only run the analysis if anyone is interested in its results
+			auto& ORE = getAnalysis<OptimizationRemarkEmitterWrapperPass>().getORE();
+			if (!ORE.allowExtraAnalysis(DEBUG_TYPE)) {
+				return false;
+			}
+			SE = &getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+			const auto& LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+			const auto& DL = F.getParent()->getDataLayout();
+
+			for (auto& BB : F) {
+				for (auto& I : BB) {
+					Value* ptr = nullptr;
+					Type* access_type = nullptr;
+					if (auto LD = dyn_cast<LoadInst>(&I); LD) {
+						ptr = LD->getPointerOperand();
+						access_type = LD->getType();
+					} else if (auto ST = dyn_cast<StoreInst>(&I); ST) {
+						ptr = ST->getPointerOperand();
+						access_type = ST->getValueOperand()->getType();
+					} else {
+						continue;
+					}
+					if (!is_global_pointer(*ptr)) {
+						continue;
+					}
+
+					const auto access_size = int64_t(DL.getTypeStoreSize(access_type).getFixedSize());
+					const auto info = analyze_floor_affine_id_pointer(*SE, *ptr);
+					const auto loop_depth = LI.getLoopDepth(&BB);
+					DBG(errs() << I << ": stride " << info.fast_stride << ", dyn " << info.dynamic_stride << ", slow "
+							   << info.has_slow_ids << ", non-affine " << info.non_affine << "\n";)
+
+					StringRef pattern;
+					if (info.non_affine) {
+						pattern = "random";
+					} else if (!info.is_fast_varying()) {
+						pattern = "broadcast";
+					} else if (!info.dynamic_stride && (info.fast_stride == access_size || info.fast_stride == -access_size)) {
+						pattern = "contiguous";
+					} else {
+						pattern = "strided";
+					}
+
+					ORE.emit([&]() {
+						OptimizationRemarkAnalysis remark(DEBUG_TYPE, "GlobalAccessPattern", &I);
+						remark << (isa<LoadInst>(&I) ? "global load" : "global store")
+							<< " of " << ore::NV("AccessSize", access_size) << " bytes is "
+							<< ore::NV("Pattern", pattern) << " across work-items";
+						if (pattern == "strided") {
+							if (info.dynamic_stride) {
+								remark << " (dynamic stride)";
+							} else {
+								remark << " (stride of " << ore::NV("Stride", info.fast_stride) << " bytes)";
+							}
+						}
+						if (loop_depth > 0) {
+							remark << " in loop at depth " << ore::NV("LoopDepth", loop_depth);
+						}
+						return remark;
+					});
+				}
+			}
+			return false;
+		}
+
+	protected:
+		bool is_cuda { false };
+		ScalarEvolution* SE { nullptr };
+
+		//! returns true if "ptr" points to global memory
+		//! NOTE: with CUDA, generic pointers that don't point to private memory are also considered global
+		bool is_global_pointer(const Value& ptr) const {
+			const auto address_space = ptr.getType()->getPointerAddressSpace();
+			if (address_space == global_address_space) {
+				return true;
+			}
+			if (is_cuda && address_space == 0u) {
+				return !isa<AllocaInst>(getUnderlyingObject(&ptr));
+			}
+			return false;
+		}
+	};
+
+}
+
+char MemoryCoalescingAnalysis::ID = 0;
+FunctionPass *llvm::createMemoryCoalescingAnalysisPass() {
+	return new MemoryCoalescingAnalysis();
+}
+INITIALIZE_PASS_BEGIN(MemoryCoalescingAnalysis, "MemoryCoalescingAnalysis", "MemoryCoalescingAnalysis Pass", false, true)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(ScalarEvolutionWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(OptimizationRemarkEmitterWrapperPass)
+INITIALIZE_PASS_END(MemoryCoalescingAnalysis, "MemoryCoalescingAnalysis", "MemoryCoalescingAnalysis Pass", false, true)
@@ -62,6 +62,7 @@
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/LibFloor/FloorIntrinsicLowering.h"
 #include "llvm/Transforms/LibFloor/FloorUtils.h"
 #include <algorithm>
 #include <cstdarg>
@@ -385,34 +386,6 @@ namespace {
 			InstVisitor<MetalFinal>::visit(I);
 		}
 		
-		static std::optional<std::string> get_suffix_for_type(llvm::Type* type, const bool is_signed) {
-			std::string ret = ".";
-			auto elem_type = type;
-			if (auto vec_type = dyn_cast_or_null<FixedVectorType>(type); vec_type) {
-				elem_type = vec_type->getElementType();
-				ret += "v" + std::to_string(vec_type->getNumElements());
-			}
-			switch (elem_type->getTypeID()) {
-				case llvm::Type::IntegerTyID:
-					ret += (is_signed ? "s." : "u.");
-					ret += "i" + std::to_string(cast<IntegerType>(type)->getBitWidth());
-					break;
-				// NOTE: we generally omit the ".f" here, because it's usually not wanted
-				case llvm::Type::HalfTyID:
-					ret += "f16";
-					break;
-				case llvm::Type::FloatTyID:
-					ret += "f32";
-					break;
-				case llvm::Type::DoubleTyID:
-					ret += "f64";
-					break;
-				default:
-					return {};
-			}
-			return ret;
-		}
-		
 		void visitIntrinsicInst(IntrinsicInst &I) {
 			const auto print_instr = [](const Instruction& instr) {
 				std::string instr_str;
@@ -440,212 +413,15 @@ namespace {
 					// pass
 					break;
 					
-				// single arguments cases
-				case Intrinsic::abs:
-				case Intrinsic::fabs: {
-					auto op_val = I.getOperand(0);
-					
-					// handled signedness and AIR function name
-					bool is_signed = true;
-					std::string func_name = "air.";
-					const bool is_fast = (op_val->getType()->isFloatTy() ||
-										  (op_val->getType()->isVectorTy() &&
-										   cast<FixedVectorType>(op_val->getType())->getElementType()->isFloatTy()));
-					switch (I.getIntrinsicID()) {
-						case Intrinsic::abs:
-							func_name += "abs";
-							break;
-						case Intrinsic::fabs:
-							if (is_fast) {
-								func_name += "fast_";
-							}
-							func_name += "fabs";
-							break;
-						default:
-							ctx->emitError(&I, "unexpected intrinsic:\n" + print_instr(I));
-							return;
-					}
-					
-					auto suffix = get_suffix_for_type(op_val->getType(), is_signed);
-					if (!suffix) {
-						ctx->emitError(&I, "unexpected type in intrinsic:\n" + print_instr(I));
-						return;
-					}
-					func_name += *suffix;
-					
-					// create the new call
-					SmallVector<llvm::Type*, 1> param_types { op_val->getType() };
-					const auto func_type = llvm::FunctionType::get(I.getType(), param_types, false);
-					builder->SetInsertPoint(&I);
-					
-					auto call = builder->CreateCall(M->getOrInsertFunction(func_name, func_type), { op_val });
-					call->setDebugLoc(I.getDebugLoc());
-					
-					I.replaceAllUsesWith(call);
-					I.eraseFromParent();
-					was_modified = true;
-					break;
-				}
-					
-				// two arguments cases
-				case Intrinsic::umin:
-				case Intrinsic::smin:
-				case Intrinsic::umax:
-				case Intrinsic::smax:
-				case Intrinsic::minnum:
-				case Intrinsic::maxnum: {
-					auto op_lhs = I.getOperand(0);
-					auto op_rhs = I.getOperand(1);
-					
-					// handled signedness and AIR function name
-					bool is_signed = true;
-					std::string func_name = "air.";
-					const bool is_fast = (op_lhs->getType()->isFloatTy() ||
-										  (op_lhs->getType()->isVectorTy() &&
-										   cast<FixedVectorType>(op_lhs->getType())->getElementType()->isFloatTy()));
-					switch (I.getIntrinsicID()) {
-						case Intrinsic::umin:
-							is_signed = false;
-							func_name += "min";
-							break;
-						case Intrinsic::smin:
-							func_name += "min";
-							break;
-						case Intrinsic::umax:
-							is_signed = false;
-							func_name += "max";
-							break;
-						case Intrinsic::smax:
-							func_name += "max";
-							break;
-						case Intrinsic::minnum:
-							func_name += (is_fast ? "fast_fmin" : "fmin");
-							break;
-						case Intrinsic::maxnum:
-							func_name += (is_fast ? "fast_fmax" : "fmax");
-							break;
-						default:
-							ctx->emitError(&I, "unexpected intrinsic:\n" + print_instr(I));
-							return;
-					}
-					
-					auto suffix = get_suffix_for_type(op_lhs->getType(), is_signed);
-					if (!suffix) {
-						ctx->emitError(&I, "unexpected type in intrinsic:\n" + print_instr(I));
-						return;
-					}
-					func_name += *suffix;
-					
-					// create the new call
-					SmallVector<llvm::Type*, 2> param_types { op_lhs->getType(), op_rhs->getType() };
-					const auto func_type = llvm::FunctionType::get(I.getType(), param_types, false);
-					builder->SetInsertPoint(&I);
-					
-					auto call = builder->CreateCall(M->getOrInsertFunction(func_name, func_type), { op_lhs, op_rhs });
-					call->setDebugLoc(I.getDebugLoc());
-					
-					I.replaceAllUsesWith(call);
-					I.eraseFromParent();
-					was_modified = true;
-					break;
-				}
-					
-				// three arguments cases
-				case Intrinsic::fma: {
-					auto op_0 = I.getOperand(0);
-					auto op_1 = I.getOperand(1);
-					auto op_2 = I.getOperand(2);
-					
-					// create AIR function name
-					auto suffix = get_suffix_for_type(op_0->getType(), true);
-					if (!suffix) {
-						ctx->emitError(&I, "unexpected type in intrinsic:\n" + print_instr(I));
-						return;
-					}
-					std::string func_name = "air.fma" + *suffix;
-					
-					// create the new call
-					SmallVector<llvm::Type*, 3> param_types { op_0->getType(), op_1->getType(), op_2->getType() };
-					const auto func_type = llvm::FunctionType::get(I.getType(), param_types, false);
-					builder->SetInsertPoint(&I);
-					
-					auto call = builder->CreateCall(M->getOrInsertFunction(func_name, func_type), { op_0, op_1, op_2 });
-					call->setDebugLoc(I.getDebugLoc());
-					
-					I.replaceAllUsesWith(call);
-					I.eraseFromParent();
-					was_modified = true;
-					break;
-				}
-					
-#if 0 // TODO: implement these
-				case Intrinsic::vector_reduce_fadd: {
-					auto init = I.getOperand(0);
-					auto vec = I.getOperand(1);
-					const auto vec_type = dyn_cast_or_null<FixedVectorType>(vec->getType());
-					if (!vec_type) {
-						ctx->emitError(&I, "expected vector type in operand #1:\n" + print_instr(I));
-						return;
-					}
-					const auto elem_type = vec_type->getElementType();
-					if (!elem_type->isFloatTy()) {
-						ctx->emitError(&I, "expected element type of vector to be f32:\n" + print_instr(I));
-					}
-					
-					const auto width = vec_type->getNumElements();
-					if (width != 1 && width != 2 && width != 3 && width != 4 && width != 8 && width != 16) {
-						ctx->emitError(&I, "unexpected vector width " + std::to_string(width) + ":\n" + print_instr(I));
-						return;
+				default: {
+					// lower to AIR builtins or expand (abs, min/max, fma, bit ops, saturating ops, reductions, ...)
+					if (!lower_floor_intrinsic(I, *builder, FLOOR_INTRINSIC_TARGET::METAL)) {
+						ctx->emitError(&I, "unknown/unhandled intrinsic:\n" + print_instr(I));
+						break;
 					}
-					
-					SmallVector<llvm::Type*, 2> func_arg_types;
-					SmallVector<llvm::Value*, 2> func_args;
-					func_arg_types.push_back(vec_type);
-					func_arg_types.push_back(vec_type);
-					func_args.push_back(vec);
-					func_args.push_back(ConstantVector::getSplat(ElementCount::getFixed(width), ConstantFP::get(elem_type, 1.0)));
-					
-					// -> build get func name
-					const std::string get_func_name = "air.dot.v" + std::to_string(width) + "f32";
-					
-					AttrBuilder attr_builder;
-					attr_builder.addAttribute(llvm::Attribute::NoUnwind);
-					attr_builder.addAttribute(llvm::Attribute::ReadOnly);
-					auto func_attrs = AttributeList::get(*ctx, ~0, attr_builder);
-					
-					// create the air call
-					const auto func_type = llvm::FunctionType::get(elem_type, func_arg_types, false);
-					builder->SetInsertPoint(&I);
-					llvm::CallInst* get_call = builder->CreateCall(M->getOrInsertFunction(get_func_name, func_type, func_attrs), func_args);
-					get_call->setDoesNotThrow();
-					get_call->setOnlyReadsMemory();
-					get_call->setDebugLoc(I.getDebugLoc()); // keep debug loc
-					
-					// TODO: handle "init" if not 0
-					
-					I.replaceAllUsesWith(get_call);
-					I.eraseFromParent();
 					was_modified = true;
 					break;
 				}
-#endif
-				case Intrinsic::vector_reduce_add:
-				case Intrinsic::vector_reduce_and:
-				case Intrinsic::vector_reduce_fadd:
-				case Intrinsic::vector_reduce_fmax:
-				case Intrinsic::vector_reduce_fmin:
-				case Intrinsic::vector_reduce_fmul:
-				case Intrinsic::vector_reduce_mul:
-				case Intrinsic::vector_reduce_or:
-				case Intrinsic::vector_reduce_smax:
-				case Intrinsic::vector_reduce_smin:
-				case Intrinsic::vector_reduce_umax:
-				case Intrinsic::vector_reduce_umin:
-				case Intrinsic::vector_reduce_xor:
-				default: {
-					ctx->emitError(&I, "unknown/unhandled intrinsic:\n" + print_instr(I));
-					break;
-				}
 			}
 		}
 		
@@ -0,0 +1,461 @@
+//===- PromotePrivateArrays.cpp - promote private arrays -------------------===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass promotes small private (alloca) arrays that are accessed with
+// dynamic indices, and thus can't be handled by SROA, out of private memory.
+// This is modelled on the AMDGPU alloca promotion.
+//
+//  * arrays that fit into the register budget are promoted to registers:
+//    arrays with at most 4 elements become a vector that is accessed with
+//    extractelement/insertelement (except for CUDA/PTX, where dynamic vector
+//    indexing goes through local memory again), all others are split into
+//    their elements, with each access becoming a select chain
+//  * NOTE: select chains are not free: with N elements, every dynamic load
+//    becomes N loads and N - 1 compares + selects, every dynamic store becomes
+//    N loads, compares, selects and stores -> the default register budget (16)
+//    is kept small, so that this stays cheaper than private memory accesses
+//  * arrays in kernels with a required work-group size that don't fit into
+//    the register budget are moved into work-group local memory if the local
+//    memory budget allows it: the local memory array holds the array of each
+//    work-item, strided by the linear local id, so that work-items access
+//    consecutive addresses
+//
+// Only arrays (including nested arrays) of integer or floating point values
+// are handled, which are exclusively used by full-depth GEPs that are used by
+// simple loads and stores (and lifetime markers).
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/CallingConv.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/IntrinsicsNVPTX.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/LibFloor/FloorUtils.h"
+#include "llvm/Transforms/Utils/PromoteMemToReg.h"
+#include <array>
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "PromotePrivateArrays"
+
+#if 1
+#define DBG(x)
+#else
+#define DBG(x) x
+#endif
+
+namespace {
+	// PromotePrivateArrays
+	struct PromotePrivateArrays : public FunctionPass {
+		static char ID; // Pass identification, replacement for typeid
+
+		//! max number of 32-bit registers a promoted array may occupy
+		const uint32_t register_budget;
+		//! max amount of local memory (in bytes) a kernel may use after promotion
+		const uint32_t local_memory_budget;
+
+		PromotePrivateArrays(const uint32_t register_budget_ = 16u, const uint32_t local_memory_budget_ = 16384u) :
+		FunctionPass(ID), register_budget(register_budget_), local_memory_budget(local_memory_budget_) {
+			initializePromotePrivateArraysPass(*PassRegistry::getPassRegistry());
+		}
+
+		StringRef getPassName() const override {
+			return "promote private arrays";
+		}
+
+		void getAnalysisUsage(AnalysisUsage &AU) const override {
+			AU.addRequired<DominatorTreeWrapperPass>();
+			AU.setPreservesCFG();
+		}
+
+		//! promotable private array
+		struct private_array_t {
+			AllocaInst* AI { nullptr };
+			//! scalar element type
+			Type* elem_type { nullptr };
+			//! total (flattened) element count
+			uint32_t elem_count { 0u };
+			//! element counts of all array dimensions (outermost first)
+			SmallVector<uint32_t, 4> dims;
+			//! all accessing GEPs
+			SmallVector<GetElementPtrInst*, 16> geps;
+			//! bitcasts only used by lifetime markers
+			SmallVector<BitCastInst*, 4> lifetime_casts;
+		};
+
+		bool runOnFunction(Function& F) override {
+			if (F.empty() || !libfloor_utils::is_entry_point(F)) {
+				return false;
+			}
+			const auto triple = Triple(F.getParent()->getTargetTriple());
+			is_cuda = triple.isNVPTX();
+			is_metal = (triple.getArch() == Triple::air64);
+			is_vulkan = (triple.getEnvironment() == Triple::Vulkan);
+			is_spir = (triple.isSPIR() && !is_vulkan);
+			if (!is_cuda && !is_metal && !is_vulkan && !is_spir) {
+				return false;
+			}
+
+			std::vector<private_array_t> arrays;
+			for (auto& I : F.getEntryBlock()) {
+				if (auto AI = dyn_cast<AllocaInst>(&I); AI) {
+					private_array_t arr;
+					if (gather_array(*AI, arr)) {
+						arrays.emplace_back(std::move(arr));
+					}
+				}
+			}
+			if (arrays.empty()) {
+				return false;
+			}
+
+			const auto& DL = F.getParent()->getDataLayout();
+			const auto wg_size = get_required_work_group_size(F);
+			uint64_t local_memory_size = (wg_size ? get_local_memory_size(F) : 0u);
+			Value* linear_local_id = nullptr;
+
+			std::vector<AllocaInst*> promotable_allocas;
+			bool was_modified = false;
+			for (auto& arr : arrays) {
+				const auto reg_count = arr.elem_count * libfloor_utils::get_register_count(arr.elem_type);
+				if (reg_count <= register_budget) {
+					DBG(errs() << "promoting to registers: " << *arr.AI << "\n";)
+					if (!is_cuda && arr.elem_count <= 4u) {
+						promote_to_vector(arr, promotable_allocas);
+					} else {
+						promote_to_scalars(arr, promotable_allocas);
+					}
+					was_modified = true;
+					continue;
+				}
+
+				if (!wg_size) {
+					continue;
+				}
+				const auto work_group_size = (*wg_size)[0] * (*wg_size)[1] * (*wg_size)[2];
+				const auto size = uint64_t(arr.elem_count) * DL.getTypeAllocSize(arr.elem_type).getFixedSize() * work_group_size;
+				if (local_memory_size + size > local_memory_budget) {
+					continue;
+				}
+				local_memory_size += size;
+
+				DBG(errs() << "promoting to local memory: " << *arr.AI << "\n";)
+				if (!linear_local_id) {
+					linear_local_id = create_linear_local_id(F, *wg_size);
+				}
+				promote_to_local_memory(arr, work_group_size, linear_local_id);
+				was_modified = true;
+			}
+
+			if (!promotable_allocas.empty()) {
+				PromoteMemToReg(promotable_allocas, getAnalysis<DominatorTreeWrapperPass>().getDomTree());
+			}
+			return was_modified;
+		}
+
+	protected:
+		bool is_cuda { false };
+		bool is_metal { false };
+		bool is_vulkan { false };
+		bool is_spir { false };
+
+		//! checks if "AI" is a promotable array, fills "arr" if so
+		static bool gather_array(AllocaInst& AI, private_array_t& arr) {
+			if (!AI.isStaticAlloca() || AI.isArrayAllocation()) {
+				return false;
+			}
+
+			// flatten (nested) arrays of scalars
+			Type* type = AI.getAllocatedType();
+			uint64_t elem_count = 1u;
+			while (auto arr_type = dyn_cast<ArrayType>(type)) {
+				if (arr_type->getNumElements() == 0u) {
+					return false;
+				}
+				arr.dims.emplace_back(uint32_t(arr_type->getNumElements()));
+				elem_count *= arr_type->getNumElements();
+				type = arr_type->getElementType();
+			}
+			if (arr.dims.empty() || elem_count < 2u || elem_count > 0xFFFFu ||
+				!(type->isIntegerTy() || type->isFloatingPointTy())) {
+				return false;
+			}
+			arr.AI = &AI;
+			arr.elem_type = type;
+			arr.elem_count = uint32_t(elem_count);
+
+			for (auto user : AI.users()) {
+				if (auto GEP = dyn_cast<GetElementPtrInst>(user); GEP) {
+					// must be a full-depth GEP starting with index 0
+					if (GEP->getPointerOperand() != &AI || GEP->getNumIndices() != arr.dims.size() + 1u) {
+						return false;
+					}
+					if (auto first_idx = dyn_cast<ConstantInt>(GEP->idx_begin()->get()); !first_idx || !first_idx->isZero()) {
+						return false;
+					}
+					for (auto gep_user : GEP->users()) {
+						if (auto LI = dyn_cast<LoadInst>(gep_user); LI && LI->isSimple() && LI->getType() == type) {
+							continue;
+						}
+						if (auto SI = dyn_cast<StoreInst>(gep_user); SI && SI->isSimple() &&
+							SI->getPointerOperand() == GEP && SI->getValueOperand()->getType() == type) {
+							continue;
+						}
+						return false;
+					}
+					arr.geps.emplace_back(GEP);
+				} else if (auto BC = dyn_cast<BitCastInst>(user); BC) {
+					for (auto bc_user : BC->users()) {
+						if (auto II = dyn_cast<IntrinsicInst>(bc_user); !II || !II->isLifetimeStartOrEnd()) {
+							return false;
+						}
+					}
+					arr.lifetime_casts.emplace_back(BC);
+				} else if (auto II = dyn_cast<IntrinsicInst>(user); !II || !II->isLifetimeStartOrEnd()) {
+					return false;
+				}
+			}
+			return !arr.geps.empty();
+		}
+
+		//! returns the flattened i32 element index of "GEP" into the array
+		static Value* get_flat_index(IRBuilder<>& builder, const private_array_t& arr, GetElementPtrInst& GEP) {
+			Value* flat_idx = nullptr;
+			uint32_t dim = 0;
+			for (auto idx_iter = std::next(GEP.idx_begin()); idx_iter != GEP.idx_end(); ++idx_iter, ++dim) {
+				auto idx = builder.CreateZExtOrTrunc(idx_iter->get(), builder.getInt32Ty());
+				flat_idx = (flat_idx ? builder.CreateAdd(builder.CreateMul(flat_idx, builder.getInt32(arr.dims[dim])), idx) : idx);
+			}
+			return flat_idx;
+		}
+
+		//! removes the lifetime markers, GEPs and the alloca of "arr" (after all accesses have been replaced)
+		static void erase_array(private_array_t& arr) {
+			for (auto& BC : arr.lifetime_casts) {
+				for (auto bc_user : make_early_inc_range(BC->users())) {
+					cast<Instruction>(bc_user)->eraseFromParent();
+				}
+				BC->eraseFromParent();
+			}
+			for (auto user : make_early_inc_range(arr.AI->users())) {
+				if (auto II = dyn_cast<IntrinsicInst>(user); II) {
+					II->eraseFromParent();
+				}
+			}
+			for (auto& GEP : arr.geps) {
+				GEP->eraseFromParent();
+			}
+			arr.AI->eraseFromParent();
+		}
+
+		//! array -> single vector alloca, accessed via extractelement/insertelement
+		static void promote_to_vector(private_array_t& arr, std::vector<AllocaInst*>& promotable_allocas) {
+			IRBuilder<> builder(arr.AI);
+			auto vec_type = FixedVectorType::get(arr.elem_type, arr.elem_count);
+			auto vec_alloca = builder.CreateAlloca(vec_type, nullptr, arr.AI->getName() + ".vec");
+
+			for (auto& GEP : arr.geps) {
+				for (auto user : make_early_inc_range(GEP->users())) {
+					auto I = cast<Instruction>(user);
+					builder.SetInsertPoint(I);
+					auto flat_idx = get_flat_index(builder, arr, *GEP);
+					auto vec = builder.CreateLoad(vec_type, vec_alloca);
+					if (auto LI = dyn_cast<LoadInst>(I); LI) {
+						auto elem = builder.CreateExtractElement(vec, flat_idx);
+						elem->takeName(LI);
+						LI->replaceAllUsesWith(elem);
+					} else {
+						auto SI = cast<StoreInst>(I);
+						builder.CreateStore(builder.CreateInsertElement(vec, SI->getValueOperand(), flat_idx), vec_alloca);
+					}
+					I->eraseFromParent();
+				}
+			}
+			erase_array(arr);
+			promotable_allocas.emplace_back(vec_alloca);
+		}
+
+		//! array -> one alloca per element, accesses become select chains
+		static void promote_to_scalars(private_array_t& arr, std::vector<AllocaInst*>& promotable_allocas) {
+			IRBuilder<> builder(arr.AI);
+			SmallVector<AllocaInst*, 32> elem_allocas;
+			for (uint32_t i = 0; i < arr.elem_count; ++i) {
+				elem_allocas.emplace_back(builder.CreateAlloca(arr.elem_type, nullptr, arr.AI->getName() + "." + Twine(i)));
+			}
+
+			for (auto& GEP : arr.geps) {
+				for (auto user : make_early_inc_range(GEP->users())) {
+					auto I = cast<Instruction>(user);
+					builder.SetInsertPoint(I);
+					auto flat_idx = get_flat_index(builder, arr, *GEP);
+					if (auto const_idx = dyn_cast<ConstantInt>(flat_idx); const_idx && const_idx->getZExtValue() < arr.elem_count) {
+						// constant index: direct access
+						I->replaceUsesOfWith(GEP, elem_allocas[const_idx->getZExtValue()]);
+						continue;
+					}
+					if (auto LI = dyn_cast<LoadInst>(I); LI) {
+						Value* elem = builder.CreateLoad(arr.elem_type, elem_allocas[0]);
+						for (uint32_t i = 1; i < arr.elem_count; ++i) {
+							elem = builder.CreateSelect(builder.CreateICmpEQ(flat_idx, builder.getInt32(i)),
+														builder.CreateLoad(arr.elem_type, elem_allocas[i]), elem);
+						}
+						elem->takeName(LI);
+						LI->replaceAllUsesWith(elem);
+					} else {
+						auto SI = cast<StoreInst>(I);
+						for (uint32_t i = 0; i < arr.elem_count; ++i) {
+							auto cur_elem = builder.CreateLoad(arr.elem_type, elem_allocas[i]);
+							builder.CreateStore(builder.CreateSelect(builder.CreateICmpEQ(flat_idx, builder.getInt32(i)),
+																	 SI->getValueOperand(), cur_elem),
+												elem_allocas[i]);
+						}
+					}
+					I->eraseFromParent();
+				}
+			}
+			erase_array(arr);
+			promotable_allocas.insert(promotable_allocas.end(), elem_allocas.begin(), elem_allocas.end());
+		}
+
+		//! array -> local memory array [elem_count x [work_group_size x elem_type]], indexed by the linear local id
+		void promote_to_local_memory(private_array_t& arr, const uint32_t work_group_size, Value* linear_local_id) {
+			auto& M = *arr.AI->getModule();
+			auto local_type = ArrayType::get(ArrayType::get(arr.elem_type, work_group_size), arr.elem_count);
+			auto GV = new GlobalVariable(M, local_type, false, GlobalValue::InternalLinkage, UndefValue::get(local_type),
+										 arr.AI->getFunction()->getName() + "." + arr.AI->getName() + ".local", nullptr,
+										 GlobalValue::NotThreadLocal, libfloor_utils::local_address_space);
+			GV->setAlignment(arr.AI->getAlign());
+
+			IRBuilder<> builder(arr.AI);
+			for (auto& GEP : arr.geps) {
+				builder.SetInsertPoint(GEP);
+				auto flat_idx = get_flat_index(builder, arr, *GEP);
+				auto local_gep = builder.CreateInBoundsGEP(local_type, GV, { builder.getInt32(0), flat_idx, linear_local_id });
+				for (auto user : make_early_inc_range(GEP->users())) {
+					cast<Instruction>(user)->replaceUsesOfWith(GEP, local_gep);
+				}
+			}
+			erase_array(arr);
+		}
+
+		//! returns the required work-group size of "F" (if it has one)
+		static Optional<std::array<uint32_t, 3>> get_required_work_group_size(const Function& F) {
+			if (F.getCallingConv() != CallingConv::FLOOR_KERNEL) {
+				return None;
+			}
+			const auto wg_size_node = F.getMetadata("reqd_work_group_size");
+			if (!wg_size_node || wg_size_node->getNumOperands() != 3) {
+				return None;
+			}
+			std::array<uint32_t, 3> wg_size {{ 1, 1, 1 }};
+			for (uint32_t dim = 0; dim < 3; ++dim) {
+				if (const auto size = mdconst::dyn_extract<ConstantInt>(wg_size_node->getOperand(dim)); size) {
+					wg_size[dim] = uint32_t(std::max(uint64_t(1u), size->getZExtValue()));
+				}
+			}
+			return wg_size;
+		}
+
+		//! returns the size of all local memory variables that are used in "F"
+		static uint64_t get_local_memory_size(const Function& F) {
+			const auto& M = *F.getParent();
+			const auto& DL = M.getDataLayout();
+			uint64_t size = 0u;
+			for (const auto& GV : M.globals()) {
+				if (GV.getAddressSpace() != libfloor_utils::local_address_space || GV.isDeclaration()) {
+					continue;
+				}
+				bool is_used = false;
+				libfloor_utils::for_all_instruction_users(GV, [&F, &is_used](const Instruction& I) {
+					is_used |= (I.getFunction() == &F);
+				});
+				if (is_used) {
+					size += DL.getTypeAllocSize(GV.getValueType()).getFixedSize();
+				}
+			}
+			return size;
+		}
+
+		//! emits the backend-specific local id query of dimension "dim" (as i32)
+		Value* create_local_id(IRBuilder<>& builder, Module& M, const uint32_t dim) {
+			if (is_cuda) {
+				static constexpr const std::array<Intrinsic::ID, 3> tid_intrinsics {{
+					Intrinsic::nvvm_read_ptx_sreg_tid_x,
+					Intrinsic::nvvm_read_ptx_sreg_tid_y,
+					Intrinsic::nvvm_read_ptx_sreg_tid_z,
+				}};
+				return builder.CreateIntrinsic(tid_intrinsics[dim], {}, {});
+			}
+
+			const char* func_name = (is_metal ? "floor.get_local_id.i32" :
+									 is_vulkan ? "floor.builtin.local_id.i32" : "_Z12get_local_idj");
+			// OpenCL/SPIR: returns size_t
+			auto ret_type = (is_spir ? M.getDataLayout().getIntPtrType(M.getContext()) : builder.getInt32Ty());
+			auto func_type = FunctionType::get(ret_type, { builder.getInt32Ty() }, false);
+			auto call = builder.CreateCall(M.getOrInsertFunction(func_name, func_type), { builder.getInt32(dim) });
+			call->setDoesNotAccessMemory();
+			call->setDoesNotThrow();
+			return builder.CreateZExtOrTrunc(call, builder.getInt32Ty());
+		}
+
+		//! emits the linear local id (x + y * size_x + z * size_x * size_y) at the start of "F"
+		Value* create_linear_local_id(Function& F, const std::array<uint32_t, 3>& wg_size) {
+			auto& entry = F.getEntryBlock();
+			IRBuilder<> builder(&*entry.getFirstInsertionPt());
+			auto& M = *F.getParent();
+			Value* linear_id = create_local_id(builder, M, 0);
+			if (wg_size[1] > 1u) {
+				linear_id = builder.CreateNUWAdd(linear_id, builder.CreateNUWMul(create_local_id(builder, M, 1),
+																				 builder.getInt32(wg_size[0])));
+			}
+			if (wg_size[2] > 1u) {
+				linear_id = builder.CreateNUWAdd(linear_id, builder.CreateNUWMul(create_local_id(builder, M, 2),
+																				 builder.getInt32(wg_size[0] * wg_size[1])));
+			}
+			linear_id->setName("linear_local_id");
+			return linear_id;
+		}
+	};
+
+}
+
+char PromotePrivateArrays::ID = 0;
+FunctionPass *llvm::createPromotePrivateArraysPass(const uint32_t register_budget, const uint32_t local_memory_budget) {
+	return new PromotePrivateArrays(register_budget, local_memory_budget);
+}
+INITIALIZE_PASS_BEGIN(PromotePrivateArrays, "PromotePrivateArrays", "PromotePrivateArrays Pass", false, false)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_END(PromotePrivateArrays, "PromotePrivateArrays", "PromotePrivateArrays Pass", false, false)
@@ -0,0 +1,407 @@
+//===- RegisterPressureSinking.cpp - reduce register pressure -------------===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass reduces the register pressure of Metal and Vulkan functions at the
+// end of the pipeline, i.e. right before AIR/SPIR-V emission, so that the
+// backend/driver compiler can achieve a higher occupancy.
+//
+// Values that are computed early on (address computations, id math, loaded
+// constants), but that are only used much later, are live across all blocks
+// in between (e.g. long loops). For each block in which the estimated
+// register pressure exceeds the register target, all values that are live
+// through the block are considered:
+//  * cheap, side-effect free values are rematerialized (cloned) right before
+//    their uses in other blocks, if all of their operands (or operand chains)
+//    are available there anyway, so that the original value no longer needs
+//    to be kept live
+//  * loads from constant memory are sunk to their use block, if this doesn't
+//    sink them into a loop and if it frees more registers than it occupies
+//
+// With Vulkan, the structured CFG must be kept intact: CFG structurization
+// markers (floor.*_merge, floor.merge_block, floor.continue_block) are never
+// moved or cloned, and no instruction is ever inserted between a marker and
+// the terminator of its block.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ValueHandle.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/LibFloor/FloorUtils.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include <algorithm>
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "RegisterPressureSinking"
+
+#if 1
+#define DBG(x)
+#else
+#define DBG(x) x
+#endif
+
+namespace {
+	// RegisterPressureSinking
+	struct RegisterPressureSinking : public FunctionPass {
+		static char ID; // Pass identification, replacement for typeid
+
+		//! max number of 32-bit registers that should be live at any point
+		const uint32_t register_target;
+
+		//! max number of instructions that are cloned to rematerialize a single value in a single block
+		static constexpr const uint32_t max_remat_chain_length { 4u };
+		//! max number of blocks a single value is rematerialized in
+		static constexpr const uint32_t max_remat_block_count { 4u };
+		//! max number of sink/rematerialization rounds (liveness is recomputed after each round)
+		static constexpr const uint32_t max_rounds { 4u };
+
+		RegisterPressureSinking(const uint32_t register_target_ = 64u) :
+		FunctionPass(ID), register_target(register_target_) {
+			initializeRegisterPressureSinkingPass(*PassRegistry::getPassRegistry());
+		}
+
+		StringRef getPassName() const override {
+			return "register pressure sinking";
+		}
+
+		void getAnalysisUsage(AnalysisUsage &AU) const override {
+			AU.addRequired<DominatorTreeWrapperPass>();
+			AU.addRequired<LoopInfoWrapperPass>();
+			AU.setPreservesCFG();
+		}
+
+		bool runOnFunction(Function& F) override {
+			if (F.empty()) {
+				return false;
+			}
+			const auto triple = Triple(F.getParent()->getTargetTriple());
+			const bool is_metal = (triple.getArch() == Triple::air64);
+			const bool is_vulkan = (triple.getEnvironment() == Triple::Vulkan);
+			if (!is_metal && !is_vulkan) {
+				return false;
+			}
+			DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+			LI = &getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+
+			bool was_modified = false;
+			for (uint32_t round = 0; round < max_rounds; ++round) {
+				liveness = libfloor_utils::compute_register_liveness(F);
+				DBG(errs() << F.getName() << ": round #" << round << ": max register count "
+						   << liveness.max_register_count << "\n";)
+				if (liveness.max_register_count <= register_target) {
+					break;
+				}
+
+				// gather all values that are live through high pressure blocks
+				SetVector<Instruction*> candidates;
+				for (const auto& BB : F) {
+					const auto liveness_iter = liveness.blocks.find(&BB);
+					if (liveness_iter == liveness.blocks.end() ||
+						liveness_iter->second.max_register_count <= register_target) {
+						continue;
+					}
+					for (const auto V : liveness_iter->second.live_in) {
+						if (auto I = dyn_cast<Instruction>(const_cast<Value*>(V)); I && !isa<PHINode>(I)) {
+							candidates.insert(I);
+						}
+					}
+				}
+				// handle the largest values first
+				std::vector<Instruction*> sorted_candidates(candidates.begin(), candidates.end());
+				std::stable_sort(sorted_candidates.begin(), sorted_candidates.end(), [](const Instruction* a, const Instruction* b) {
+					return (libfloor_utils::get_register_count(a->getType()) > libfloor_utils::get_register_count(b->getType()));
+				});
+				// NOTE: candidates may be deleted while rematerializing other candidates (dead operand chains)
+				std::vector<WeakTrackingVH> candidate_handles(sorted_candidates.begin(), sorted_candidates.end());
+
+				bool round_modified = false;
+				created_values.clear();
+				for (auto& handle : candidate_handles) {
+					auto I = cast_or_null<Instruction>(handle);
+					if (!I) {
+						continue;
+					}
+					if (is_rematerializable(*I)) {
+						round_modified |= rematerialize(*I);
+					} else if (is_sinkable_load(*I)) {
+						round_modified |= sink_load(cast<LoadInst>(*I));
+					}
+				}
+				if (!round_modified) {
+					break;
+				}
+				was_modified = true;
+			}
+			return was_modified;
+		}
+
+	protected:
+		DominatorTree* DT { nullptr };
+		LoopInfo* LI { nullptr };
+		libfloor_utils::function_liveness_t liveness;
+		//! all values that have been created in the current round (these are unknown to "liveness")
+		SmallPtrSet<const Value*, 32> created_values;
+
+		//! returns true if "I" is cheap to compute and can be cloned anywhere it is dominated by its operands
+		static bool is_rematerializable(const Instruction& I) {
+			if (I.mayHaveSideEffects() || I.mayReadFromMemory() || I.isTerminator() || isa<PHINode>(I) ||
+				isa<CallBase>(I) || isa<AllocaInst>(I)) {
+				return false;
+			}
+			switch (I.getOpcode()) {
+				// too expensive to recompute
+				case Instruction::UDiv:
+				case Instruction::SDiv:
+				case Instruction::URem:
+				case Instruction::SRem:
+				case Instruction::FDiv:
+				case Instruction::FRem:
+					return false;
+				default:
+					break;
+			}
+			return (isa<BinaryOperator>(I) || isa<UnaryOperator>(I) || isa<CastInst>(I) || isa<GetElementPtrInst>(I) ||
+					isa<CmpInst>(I) || isa<SelectInst>(I) || isa<ExtractElementInst>(I) || isa<InsertElementInst>(I) ||
+					isa<ShuffleVectorInst>(I) || isa<ExtractValueInst>(I) || isa<InsertValueInst>(I));
+		}
+
+		//! returns true if "I" is a simple load from memory that can't be modified
+		static bool is_sinkable_load(const Instruction& I) {
+			const auto LD = dyn_cast<LoadInst>(&I);
+			if (!LD || !LD->isSimple()) {
+				return false;
+			}
+			return (LD->getPointerAddressSpace() == libfloor_utils::constant_address_space ||
+					LD->hasMetadata(LLVMContext::MD_invariant_load));
+		}
+
+		//! returns the block in which the use "U" occurs (for PHIs: the incoming block)
+		static BasicBlock* get_use_block(const Use& U) {
+			auto user = cast<Instruction>(U.getUser());
+			if (auto phi = dyn_cast<PHINode>(user); phi) {
+				return phi->getIncomingBlock(U);
+			}
+			return user->getParent();
+		}
+
+		//! returns the instruction before which new instructions can be inserted at the end of "BB",
+		//! i.e. before all trailing CFG structurization markers and the terminator
+		static Instruction* get_end_insert_point(BasicBlock& BB) {
+			Instruction* insert_point = BB.getTerminator();
+			while (auto prev = insert_point->getPrevNode()) {
+				if (!libfloor_utils::is_cfg_marker_call(*prev)) {
+					break;
+				}
+				insert_point = prev;
+			}
+			return insert_point;
+		}
+
+		//! returns the insert point for a value that is used by "uses" in "BB": right before the first user in "BB",
+		//! or at the end of "BB" if it is only used by the terminator or PHIs in successor blocks
+		static Instruction* get_insert_point(BasicBlock& BB, const SmallVectorImpl<Use*>& uses) {
+			SmallPtrSet<const Instruction*, 8> users;
+			for (const auto& U : uses) {
+				users.insert(cast<Instruction>(U->getUser()));
+			}
+			for (auto& I : BB) {
+				if (isa<PHINode>(I)) {
+					continue;
+				}
+				if (I.isTerminator() || libfloor_utils::is_cfg_marker_call(I)) {
+					break;
+				}
+				if (users.count(&I) > 0) {
+					return &I;
+				}
+			}
+			return get_end_insert_point(BB);
+		}
+
+		//! returns true if "V" is available in a register at the start of "BB" anyway (or doesn't need a register)
+		bool is_available_in(const Value* V, const BasicBlock& BB) const {
+			if (!libfloor_utils::is_register_value(V)) {
+				return true;
+			}
+			if (created_values.count(V) > 0) {
+				return false;
+			}
+			const auto liveness_iter = liveness.blocks.find(&BB);
+			return (liveness_iter != liveness.blocks.end() && liveness_iter->second.live_in.contains(V));
+		}
+
+		//! returns true if moving or cloning a value from "def_block" into "use_block" doesn't move it into a loop, i.e.
+		//! "use_block" is either not inside a loop or inside the loop of "def_block" (or one of its parent loops)
+		//! NOTE: comparing loop depths is not enough, this would allow moving into a sibling loop of the same depth
+		bool is_outside_of_other_loops(const BasicBlock& def_block, const BasicBlock& use_block) const {
+			const auto use_loop = LI->getLoopFor(&use_block);
+			if (!use_loop) {
+				return true;
+			}
+			const auto def_loop = LI->getLoopFor(&def_block);
+			return (def_loop && use_loop->contains(def_loop));
+		}
+
+		//! checks if "I" can be rematerialized in "BB", i.e. all of its operands are either available in "BB" or can be
+		//! rematerialized as well, adds all instructions that must be cloned to "chain" (operands first)
+		bool can_rematerialize_in(Instruction& I, const BasicBlock& BB, SmallVectorImpl<Instruction*>& chain) const {
+			if (find(chain, &I) != chain.end()) {
+				return true;
+			}
+			for (const auto& op : I.operands()) {
+				if (is_available_in(op.get(), BB)) {
+					continue;
+				}
+				auto op_instr = dyn_cast<Instruction>(op.get());
+				if (!op_instr || !is_rematerializable(*op_instr) ||
+					!can_rematerialize_in(*op_instr, BB, chain)) {
+					return false;
+				}
+			}
+			if (chain.size() >= max_remat_chain_length) {
+				return false;
+			}
+			chain.emplace_back(&I);
+			return true;
+		}
+
+		//! rematerializes "I" in all blocks (other than its own) in which it is used, erases "I" if it is no longer used,
+		//! returns true if anything was changed
+		bool rematerialize(Instruction& I) {
+			// gather all uses outside of the defining block, per use block
+			auto def_block = I.getParent();
+			SmallVector<BasicBlock*, 4> use_blocks;
+			DenseMap<BasicBlock*, SmallVector<Use*, 4>> block_uses;
+			for (auto& U : I.uses()) {
+				auto use_block = get_use_block(U);
+				if (use_block == def_block) {
+					continue;
+				}
+				auto& uses = block_uses[use_block];
+				if (uses.empty()) {
+					use_blocks.emplace_back(use_block);
+				}
+				uses.emplace_back(&U);
+			}
+			if (use_blocks.empty() || use_blocks.size() > max_remat_block_count) {
+				return false;
+			}
+
+			// only rematerialize if this is possible for all use blocks, otherwise "I" would stay live regardless
+			// NOTE: never rematerialize into another loop, this would recompute the value in each iteration
+			SmallVector<SmallVector<Instruction*, max_remat_chain_length>, 4> chains(use_blocks.size());
+			for (size_t i = 0, count = use_blocks.size(); i < count; ++i) {
+				if (liveness.blocks.count(use_blocks[i]) == 0 ||
+					!is_outside_of_other_loops(*def_block, *use_blocks[i]) ||
+					!can_rematerialize_in(I, *use_blocks[i], chains[i])) {
+					return false;
+				}
+			}
+
+			for (size_t i = 0, count = use_blocks.size(); i < count; ++i) {
+				auto use_block = use_blocks[i];
+				auto& uses = block_uses[use_block];
+				auto insert_point = get_insert_point(*use_block, uses);
+				DenseMap<Value*, Value*> clones;
+				for (auto& chain_instr : chains[i]) {
+					auto clone = chain_instr->clone();
+					clone->setName(chain_instr->getName() + ".remat");
+					clone->insertBefore(insert_point);
+					for (auto& op : clone->operands()) {
+						if (auto clone_iter = clones.find(op.get()); clone_iter != clones.end()) {
+							op.set(clone_iter->second);
+						}
+					}
+					clones[chain_instr] = clone;
+					created_values.insert(clone);
+				}
+				DBG(errs() << "rematerialized " << I << " in " << use_block->getName() << "\n";)
+				for (auto& U : uses) {
+					U->set(clones[&I]);
+				}
+			}
+
+			RecursivelyDeleteTriviallyDeadInstructions(&I);
+			return true;
+		}
+
+		//! sinks the load "LD" into its single use block if this doesn't sink it into a loop and reduces register pressure,
+		//! returns true if "LD" was sunk
+		bool sink_load(LoadInst& LD) {
+			BasicBlock* use_block = nullptr;
+			SmallVector<Use*, 4> uses;
+			for (auto& U : LD.uses()) {
+				if (isa<PHINode>(U.getUser())) {
+					return false;
+				}
+				auto user_block = get_use_block(U);
+				if (use_block && use_block != user_block) {
+					return false;
+				}
+				use_block = user_block;
+				uses.emplace_back(&U);
+			}
+			auto def_block = LD.getParent();
+			if (!use_block || use_block == def_block || liveness.blocks.count(use_block) == 0 ||
+				!DT->dominates(def_block, use_block) ||
+				!is_outside_of_other_loops(*def_block, *use_block)) {
+				return false;
+			}
+
+			// the pointer must be kept live instead of the loaded value
+			const auto ptr = LD.getPointerOperand();
+			const auto ptr_reg_count = (is_available_in(ptr, *use_block) ? 0u :
+										libfloor_utils::get_register_count(ptr->getType()));
+			if (ptr_reg_count >= libfloor_utils::get_register_count(LD.getType())) {
+				return false;
+			}
+
+			DBG(errs() << "sinking " << LD << " into " << use_block->getName() << "\n";)
+			LD.moveBefore(get_insert_point(*use_block, uses));
+			return true;
+		}
+	};
+
+}
+
+char RegisterPressureSinking::ID = 0;
+FunctionPass *llvm::createRegisterPressureSinkingPass(const uint32_t register_target) {
+	return new RegisterPressureSinking(register_target);
+}
+INITIALIZE_PASS_BEGIN(RegisterPressureSinking, "RegisterPressureSinking", "RegisterPressureSinking Pass", false, false)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_END(RegisterPressureSinking, "RegisterPressureSinking", "RegisterPressureSinking Pass", false, false)
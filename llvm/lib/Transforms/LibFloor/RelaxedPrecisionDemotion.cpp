@@ -0,0 +1,830 @@
+//===- RelaxedPrecisionDemotion.cpp - demote float dataflow to half --------===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass demotes 32-bit floating point dataflow to 16-bit half precision
+// for Metal and Vulkan (opt-in, as this trades precision for speed/register
+// pressure on mobile GPUs).
+//
+// Demotion starts at "relaxed precision sinks", i.e. values whose precision
+// is limited anyway:
+//  * data written to normalized integer images with at most 10 bits per
+//    channel (e.g. RGBA8 unorm, BGR10A2 unorm)
+//  * floating point outputs of fragment shaders, but only if explicitly
+//    enabled (the render target formats are not known at compile time)
+//
+// From there, the float dataflow is walked backwards: an operation is demoted
+// if an interval analysis proves that its value stays within the finite half
+// range and if it is exclusively used by other demoted operations or the sink
+// itself. Leaf values (constants, values extended from half, normalized image
+// reads) provide the initial intervals.
+//
+// Demotion is precision-based: for each demoted value, an upper bound of its
+// absolute error (vs. the float value) is propagated forward, starting with the
+// conversion error of the leaf values and adding the half rounding error of
+// each arithmetic operation (operations that only select, rearrange or change
+// the sign/magnitude of their operands are exact). A sink is only demoted if
+// the error bound of its value stays below half of its quantization step
+// (1/255 for 8-bit, 1/1023 for 10-bit unorm, ...), i.e. cancellation of large
+// values (a * 2048 - b * 2047) or long dependency chains are not demoted.
+//
+// A remark is emitted for each function that has been modified, containing the
+// amount of demoted operations.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/CallingConv.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/LibFloor/FloorImageType.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "RelaxedPrecisionDemotion"
+
+#if 1
+#define DBG(x)
+#else
+#define DBG(x) x
+#endif
+
+namespace {
+	// RelaxedPrecisionDemotion
+	struct RelaxedPrecisionDemotion : public FunctionPass {
+		static char ID; // Pass identification, replacement for typeid
+
+		//! if set, float outputs of fragment shaders are relaxed precision sinks
+		const bool fragment_outputs_are_sinks;
+
+		RelaxedPrecisionDemotion(const bool fragment_outputs_are_sinks_ = false) :
+		FunctionPass(ID), fragment_outputs_are_sinks(fragment_outputs_are_sinks_) {
+			initializeRelaxedPrecisionDemotionPass(*PassRegistry::getPassRegistry());
+		}
+
+		StringRef getPassName() const override {
+			return "relaxed precision demotion";
+		}
+
+		void getAnalysisUsage(AnalysisUsage &AU) const override {
+			AU.addRequired<OptimizationRemarkEmitterWrapperPass>();
+			AU.setPreservesCFG();
+		}
+
+		//! max finite half value
+		static constexpr double max_half { 65504.0 };
+		//! min normal half value (2^-14)
+		static constexpr double min_normal_half { 1.0 / 16384.0 };
+		//! max error of fragment outputs: the render target formats are unknown -> assume 10-bit unorm
+		static constexpr double max_fragment_output_error { 0.5 / 1023.0 };
+
+		//! relaxed precision sink: a float use whose value is quantized by the sink
+		struct sink_t {
+			Use* use { nullptr };
+			//! max absolute error of the demoted value (half the quantization step of the sink)
+			double max_error { 0.0 };
+		};
+
+		//! closed value interval [lo, hi] of all lanes of a value, empty if lo > hi (undef/poison)
+		struct interval_t {
+			double lo { -std::numeric_limits<double>::infinity() };
+			double hi { std::numeric_limits<double>::infinity() };
+
+			static interval_t empty() {
+				return { std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() };
+			}
+			bool is_empty() const {
+				return (lo > hi);
+			}
+			//! true if the magnitude of all values is at most "limit"
+			bool is_bounded(const double limit) const {
+				return (is_empty() || (lo >= -limit && hi <= limit));
+			}
+			interval_t merge(const interval_t& iv) const {
+				return { std::min(lo, iv.lo), std::max(hi, iv.hi) };
+			}
+			//! max magnitude of all values, 0 if empty
+			double max_magnitude() const {
+				return (is_empty() ? 0.0 : std::max(std::abs(lo), std::abs(hi)));
+			}
+		};
+
+		bool runOnFunction(Function& F) override {
+			if (F.empty()) {
+				return false;
+			}
+			const auto triple = Triple(F.getParent()->getTargetTriple());
+			const bool is_metal = (triple.getArch() == Triple::air64);
+			const bool is_vulkan = (triple.getEnvironment() == Triple::Vulkan);
+			if (!is_metal && !is_vulkan) {
+				return false;
+			}
+			ctx = &F.getContext();
+			intervals.clear();
+			errors.clear();
+			reachable_blocks.clear();
+			ReversePostOrderTraversal<Function*> RPOT(&F);
+			reachable_blocks.insert(RPOT.begin(), RPOT.end());
+
+			// gather all sinks: each sink is a use of a float value whose precision doesn't matter beyond half
+			SmallVector<sink_t, 16> sinks;
+			const bool has_output_sinks = (fragment_outputs_are_sinks && F.getCallingConv() == CallingConv::FLOOR_FRAGMENT);
+			for (auto& BB : F) {
+				for (auto& I : BB) {
+					if (auto CB = dyn_cast<CallBase>(&I); CB) {
+						if (auto sink = get_image_write_sink(*CB); sink) {
+							sinks.emplace_back(*sink);
+						}
+					} else if (auto RI = dyn_cast<ReturnInst>(&I); RI && has_output_sinks && RI->getReturnValue()) {
+						gather_fragment_output_sinks(RI->getOperandUse(0), sinks);
+					}
+				}
+			}
+			if (sinks.empty()) {
+				return false;
+			}
+
+			// gather candidates: all bounded float instructions that (transitively) feed into a sink
+			SetVector<Instruction*> candidates;
+			SmallPtrSet<Use*, 16> sink_set;
+			for (auto& sink : sinks) {
+				sink_set.insert(sink.use);
+				gather_candidates(sink.use->get(), candidates);
+			}
+
+			// prune the candidates, then drop all sinks whose demoted value would exceed the max error of the sink
+			// -> repeat until no more sinks are dropped, since this in turn invalidates candidates
+			for (;;) {
+				prune_candidates(candidates, sink_set);
+				if (candidates.empty()) {
+					return false;
+				}
+
+				// errors depend on which operands are demoted -> recompute for the current candidates
+				errors.clear();
+				const auto sink_count = sinks.size();
+				erase_if(sinks, [this, &candidates, &sink_set](const sink_t& sink) {
+					auto I = dyn_cast<Instruction>(sink.use->get());
+					if (!I || candidates.count(I) == 0 || get_error(I, candidates) <= sink.max_error) {
+						return false;
+					}
+					DBG(errs() << "error bound exceeded: " << *I << ": " << get_error(I, candidates) << "\n";)
+					sink_set.erase(sink.use);
+					return true;
+				});
+				if (sinks.size() == sink_count) {
+					break;
+				}
+			}
+
+			const auto demoted_count = demote(candidates, sinks);
+			getAnalysis<OptimizationRemarkEmitterWrapperPass>().getORE().emit([&]() {
+				return OptimizationRemark(DEBUG_TYPE, "RelaxedPrecisionDemotion", &F)
+					<< "demoted " << ore::NV("DemotedOps", demoted_count) << " floating point operations to half precision";
+			});
+			return true;
+		}
+
+	protected:
+		LLVMContext* ctx { nullptr };
+		//! cached intervals of all visited values
+		DenseMap<Value*, interval_t> intervals;
+		//! cached error bounds of all visited values (for the current candidates)
+		DenseMap<Value*, double> errors;
+		//! all blocks reachable from the entry block (in reverse post order)
+		SetVector<BasicBlock*> reachable_blocks;
+
+		//! returns the image type of an opaque image call if it is constant
+		static Optional<COMPUTE_IMAGE_TYPE> get_const_image_type(const CallBase& CB, const uint32_t arg_idx) {
+			if (CB.arg_size() <= arg_idx) {
+				return {};
+			}
+			if (auto type_arg = dyn_cast<ConstantInt>(CB.getArgOperand(arg_idx)); type_arg) {
+				return COMPUTE_IMAGE_TYPE(type_arg->getZExtValue());
+			}
+			return {};
+		}
+
+		//! returns the quantization step of a normalized integer format with at most 10 bits per channel
+		//! (using the largest channel bit count), or nothing if the image type is not such a format
+		static Optional<double> get_low_precision_normalized_step(const COMPUTE_IMAGE_TYPE& image_type) {
+			if (!has_flag<COMPUTE_IMAGE_TYPE::FLAG_NORMALIZED>(image_type) ||
+				has_flag<COMPUTE_IMAGE_TYPE::FLAG_DEPTH>(image_type)) {
+				return {};
+			}
+			const auto data_type = (image_type & COMPUTE_IMAGE_TYPE::__DATA_TYPE_MASK);
+			if (data_type != COMPUTE_IMAGE_TYPE::INT && data_type != COMPUTE_IMAGE_TYPE::UINT) {
+				return {};
+			}
+			uint32_t bits = 0;
+			switch (image_type & COMPUTE_IMAGE_TYPE::__FORMAT_MASK) {
+				case COMPUTE_IMAGE_TYPE::FORMAT_1: bits = 1; break;
+				case COMPUTE_IMAGE_TYPE::FORMAT_2: bits = 2; break;
+				case COMPUTE_IMAGE_TYPE::FORMAT_3_3_2: bits = 3; break;
+				case COMPUTE_IMAGE_TYPE::FORMAT_5_5_5:
+				case COMPUTE_IMAGE_TYPE::FORMAT_5_5_5_ALPHA_1: bits = 5; break;
+				case COMPUTE_IMAGE_TYPE::FORMAT_5_6_5: bits = 6; break;
+				// NOTE: FORMAT_4 may also be YUV444 -> assume 8-bit like the other YUV formats
+				case COMPUTE_IMAGE_TYPE::FORMAT_4:
+				case COMPUTE_IMAGE_TYPE::FORMAT_4_2_0:
+				case COMPUTE_IMAGE_TYPE::FORMAT_4_1_1:
+				case COMPUTE_IMAGE_TYPE::FORMAT_4_2_2:
+				case COMPUTE_IMAGE_TYPE::FORMAT_8: bits = 8; break;
+				case COMPUTE_IMAGE_TYPE::FORMAT_10:
+				case COMPUTE_IMAGE_TYPE::FORMAT_10_10_10_ALPHA_2: bits = 10; break;
+				default:
+					return {};
+			}
+			// snorm: one bit is used for the sign
+			if (data_type == COMPUTE_IMAGE_TYPE::INT) {
+				if (bits < 2) {
+					return {};
+				}
+				--bits;
+			}
+			return 1.0 / double((1u << bits) - 1u);
+		}
+
+		//! returns true if "type" is a 32-bit float scalar or vector
+		static bool is_float_type(const Type* type) {
+			return type->getScalarType()->isFloatTy();
+		}
+
+		//! returns the data use of an opaque image write to a low precision normalized image
+		//! opaque write: image_t img, COMPUTE_IMAGE_TYPE type, coord_vec_type coord, uint32_t layer, uint32_t lod, bool is_lod, data_vec_type data
+		static Optional<sink_t> get_image_write_sink(CallBase& CB) {
+			const auto func = CB.getCalledFunction();
+			if (!func || !func->getName().startswith("floor.opaque.write_image.") || CB.arg_size() != 7) {
+				return {};
+			}
+			const auto image_type = get_const_image_type(CB, 1);
+			if (!image_type) {
+				return {};
+			}
+			const auto step = get_low_precision_normalized_step(*image_type);
+			if (!step) {
+				return {};
+			}
+			auto& data_use = CB.getArgOperandUse(6);
+			if (!is_float_type(data_use->getType())) {
+				return {};
+			}
+			return sink_t { &data_use, *step * 0.5 };
+		}
+
+		//! gathers all float values of a fragment shader return value (either returned directly or inserted into a struct)
+		static void gather_fragment_output_sinks(Use& ret_use, SmallVectorImpl<sink_t>& sinks) {
+			if (is_float_type(ret_use->getType())) {
+				sinks.emplace_back(sink_t { &ret_use, max_fragment_output_error });
+				return;
+			}
+			for (auto IVI = dyn_cast<InsertValueInst>(ret_use.get()); IVI;
+				 IVI = dyn_cast<InsertValueInst>(IVI->getAggregateOperand())) {
+				auto& elem_use = IVI->getOperandUse(InsertValueInst::getInsertedValueOperandIndex());
+				if (is_float_type(elem_use->getType()) && IVI->hasOneUse()) {
+					sinks.emplace_back(sink_t { &elem_use, max_fragment_output_error });
+				}
+			}
+		}
+
+		//! returns the interval of a constant (across all lanes)
+		static interval_t get_constant_interval(Constant* C) {
+			if (isa<UndefValue>(C)) {
+				return interval_t::empty();
+			}
+			if (auto CFP = dyn_cast<ConstantFP>(C); CFP) {
+				if (CFP->isNaN()) {
+					// NaN stays NaN in half
+					return interval_t::empty();
+				}
+				const auto val = CFP->getValueAPF().convertToFloat();
+				return { double(val), double(val) };
+			}
+			if (auto vec_type = dyn_cast<FixedVectorType>(C->getType()); vec_type) {
+				auto ret = interval_t::empty();
+				for (uint32_t i = 0, count = vec_type->getNumElements(); i < count; ++i) {
+					auto elem = C->getAggregateElement(i);
+					if (!elem) {
+						return {};
+					}
+					ret = ret.merge(get_constant_interval(elem));
+				}
+				return ret;
+			}
+			return {};
+		}
+
+		//! computes the interval of "V", returns an unbounded interval if unknown
+		interval_t get_interval(Value* V) {
+			if (auto C = dyn_cast<Constant>(V); C) {
+				return get_constant_interval(C);
+			}
+			auto I = dyn_cast<Instruction>(V);
+			if (!I) {
+				return {};
+			}
+			if (auto iter = intervals.find(V); iter != intervals.end()) {
+				return iter->second;
+			}
+			// mark as unbounded while computing -> cycles (loop phis) stay unbounded
+			intervals[V] = {};
+			const auto ret = compute_interval(*I);
+			intervals[V] = ret;
+			return ret;
+		}
+
+		interval_t compute_interval(Instruction& I) {
+			const auto mul = [](const interval_t& a, const interval_t& b) -> interval_t {
+				if (a.is_empty() || b.is_empty()) {
+					return interval_t::empty();
+				}
+				const double products[] { a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi };
+				if (any_of(products, [](const double& p) { return std::isnan(p); })) {
+					// 0 * inf
+					return {};
+				}
+				return { *std::min_element(std::begin(products), std::end(products)),
+						 *std::max_element(std::begin(products), std::end(products)) };
+			};
+			const auto add = [](const interval_t& a, const interval_t& b) -> interval_t {
+				if (a.is_empty() || b.is_empty()) {
+					return interval_t::empty();
+				}
+				return { a.lo + b.lo, a.hi + b.hi };
+			};
+			const auto neg = [](const interval_t& a) -> interval_t {
+				return { -a.hi, -a.lo };
+			};
+
+			switch (I.getOpcode()) {
+				case Instruction::FAdd:
+					return add(get_interval(I.getOperand(0)), get_interval(I.getOperand(1)));
+				case Instruction::FSub:
+					return add(get_interval(I.getOperand(0)), neg(get_interval(I.getOperand(1))));
+				case Instruction::FMul:
+					return mul(get_interval(I.getOperand(0)), get_interval(I.getOperand(1)));
+				case Instruction::FNeg:
+					return neg(get_interval(I.getOperand(0)));
+				case Instruction::FPExt:
+					// values extended from half are exactly representable (inf/nan stay inf/nan)
+					if (I.getOperand(0)->getType()->getScalarType()->isHalfTy()) {
+						return { -max_half, max_half };
+					}
+					return {};
+				case Instruction::Select:
+					return get_interval(I.getOperand(1)).merge(get_interval(I.getOperand(2)));
+				case Instruction::PHI: {
+					auto ret = interval_t::empty();
+					for (auto& incoming : cast<PHINode>(I).incoming_values()) {
+						ret = ret.merge(get_interval(incoming.get()));
+					}
+					return ret;
+				}
+				case Instruction::ExtractElement:
+					return get_interval(I.getOperand(0));
+				case Instruction::InsertElement:
+				case Instruction::ShuffleVector:
+					return get_interval(I.getOperand(0)).merge(get_interval(I.getOperand(1)));
+				case Instruction::Call:
+					break;
+				default:
+					return {};
+			}
+
+			auto& CB = cast<CallBase>(I);
+			if (auto II = dyn_cast<IntrinsicInst>(&CB); II) {
+				switch (II->getIntrinsicID()) {
+					case Intrinsic::fma:
+					case Intrinsic::fmuladd:
+						return add(mul(get_interval(II->getArgOperand(0)), get_interval(II->getArgOperand(1))),
+								   get_interval(II->getArgOperand(2)));
+					case Intrinsic::minnum: {
+						const auto a = get_interval(II->getArgOperand(0));
+						const auto b = get_interval(II->getArgOperand(1));
+						if (a.is_empty() || b.is_empty()) {
+							return a.merge(b);
+						}
+						return { std::min(a.lo, b.lo), std::min(a.hi, b.hi) };
+					}
+					case Intrinsic::maxnum: {
+						const auto a = get_interval(II->getArgOperand(0));
+						const auto b = get_interval(II->getArgOperand(1));
+						if (a.is_empty() || b.is_empty()) {
+							return a.merge(b);
+						}
+						return { std::max(a.lo, b.lo), std::max(a.hi, b.hi) };
+					}
+					case Intrinsic::fabs: {
+						const auto a = get_interval(II->getArgOperand(0));
+						if (a.is_empty()) {
+							return a;
+						}
+						const auto abs_max = std::max(std::abs(a.lo), std::abs(a.hi));
+						if (a.lo <= 0.0 && a.hi >= 0.0) {
+							return { 0.0, abs_max };
+						}
+						return { std::min(std::abs(a.lo), std::abs(a.hi)), abs_max };
+					}
+					default:
+						return {};
+				}
+			}
+
+			// normalized image reads are within [0, 1] (unorm) or [-1, 1] (snorm)
+			if (const auto func = CB.getCalledFunction(); func && func->getName().startswith("floor.opaque.read_image.")) {
+				const auto image_type = get_const_image_type(CB, 2);
+				if (image_type && is_float_type(CB.getType()) &&
+					has_flag<COMPUTE_IMAGE_TYPE::FLAG_NORMALIZED>(*image_type) &&
+					!has_flag<COMPUTE_IMAGE_TYPE::FLAG_DEPTH>(*image_type)) {
+					const auto data_type = (*image_type & COMPUTE_IMAGE_TYPE::__DATA_TYPE_MASK);
+					if (data_type == COMPUTE_IMAGE_TYPE::UINT) {
+						return { 0.0, 1.0 };
+					} else if (data_type == COMPUTE_IMAGE_TYPE::INT) {
+						return { -1.0, 1.0 };
+					}
+				}
+			}
+			return {};
+		}
+
+		//! returns true if "I" is an operation that can be performed in half precision
+		static bool is_demotable_op(const Instruction& I) {
+			if (!is_float_type(I.getType())) {
+				return false;
+			}
+			switch (I.getOpcode()) {
+				case Instruction::FAdd:
+				case Instruction::FSub:
+				case Instruction::FMul:
+				case Instruction::FNeg:
+				case Instruction::Select:
+				case Instruction::PHI:
+				case Instruction::ExtractElement:
+				case Instruction::InsertElement:
+				case Instruction::ShuffleVector:
+					return true;
+				case Instruction::Call:
+					if (auto II = dyn_cast<IntrinsicInst>(&I); II) {
+						switch (II->getIntrinsicID()) {
+							case Intrinsic::fma:
+							case Intrinsic::fmuladd:
+							case Intrinsic::minnum:
+							case Intrinsic::maxnum:
+							case Intrinsic::fabs:
+								return true;
+							default:
+								break;
+						}
+					}
+					return false;
+				default:
+					return false;
+			}
+		}
+
+		//! walks the dataflow backwards from "V" and adds all half-bounded demotable operations to "candidates"
+		void gather_candidates(Value* V, SetVector<Instruction*>& candidates) {
+			SmallVector<Value*, 32> worklist { V };
+			while (!worklist.empty()) {
+				auto I = dyn_cast<Instruction>(worklist.pop_back_val());
+				if (!I || candidates.count(I) > 0 || !is_demotable_op(*I) || reachable_blocks.count(I->getParent()) == 0) {
+					continue;
+				}
+				if (!get_interval(I).is_bounded(max_half)) {
+					continue;
+				}
+				candidates.insert(I);
+				for (auto& op : I->operands()) {
+					if (is_float_type(op->getType())) {
+						worklist.emplace_back(op.get());
+					}
+				}
+			}
+		}
+
+		//! removes all candidates that are not exclusively used by other candidates or sinks
+		static void prune_candidates(SetVector<Instruction*>& candidates, const SmallPtrSetImpl<Use*>& sink_set) {
+			// NOTE: restarts after each removal, since this may invalidate other candidates (and SetVector iterators)
+			for (auto iter = candidates.begin(); iter != candidates.end();) {
+				const auto all_demoted_users = all_of((*iter)->uses(), [&candidates, &sink_set](const Use& U) {
+					return (sink_set.count(const_cast<Use*>(&U)) > 0 ||
+							candidates.count(dyn_cast<Instruction>(U.getUser())) > 0);
+				});
+				if (!all_demoted_users) {
+					candidates.remove(*iter);
+					iter = candidates.begin();
+					continue;
+				}
+				++iter;
+			}
+		}
+
+		//! returns the max rounding error (half an ulp) of a half value with a magnitude of at most "magnitude",
+		//! returns infinity if the value may overflow
+		static double get_rounding_error(const double magnitude) {
+			if (!(magnitude <= max_half)) {
+				return std::numeric_limits<double>::infinity();
+			}
+			if (magnitude < min_normal_half) {
+				// subnormal: fixed ulp of 2^-24
+				return std::ldexp(1.0, -25);
+			}
+			// magnitude in [2^(exp - 1), 2^exp) -> ulp is 2^(exp - 1 - 10)
+			int exp = 0;
+			std::frexp(magnitude, &exp);
+			return std::ldexp(1.0, exp - 12);
+		}
+
+		//! returns the exact error of converting the constant "C" to half (across all lanes)
+		static double get_constant_error(Constant* C) {
+			if (isa<UndefValue>(C)) {
+				return 0.0;
+			}
+			if (auto CFP = dyn_cast<ConstantFP>(C); CFP) {
+				if (CFP->isNaN() || CFP->isInfinity()) {
+					return 0.0;
+				}
+				APFloat half_val = CFP->getValueAPF();
+				bool loses_info = false;
+				half_val.convert(APFloat::IEEEhalf(), APFloat::rmNearestTiesToEven, &loses_info);
+				if (half_val.isInfinity()) {
+					return std::numeric_limits<double>::infinity();
+				}
+				half_val.convert(APFloat::IEEEdouble(), APFloat::rmNearestTiesToEven, &loses_info);
+				return std::abs(half_val.convertToDouble() - double(CFP->getValueAPF().convertToFloat()));
+			}
+			if (auto vec_type = dyn_cast<FixedVectorType>(C->getType()); vec_type) {
+				double ret = 0.0;
+				for (uint32_t i = 0, count = vec_type->getNumElements(); i < count; ++i) {
+					auto elem = C->getAggregateElement(i);
+					if (!elem) {
+						return std::numeric_limits<double>::infinity();
+					}
+					ret = std::max(ret, get_constant_error(elem));
+				}
+				return ret;
+			}
+			return std::numeric_limits<double>::infinity();
+		}
+
+		//! returns the max absolute error of the half version of "V" if all "candidates" are demoted,
+		//! returns infinity if unknown
+		double get_error(Value* V, const SetVector<Instruction*>& candidates) {
+			if (auto C = dyn_cast<Constant>(V); C) {
+				return get_constant_error(C);
+			}
+			auto I = dyn_cast<Instruction>(V);
+			if (!I || candidates.count(I) == 0) {
+				// leaf: values extended from half are exact, everything else is rounded once
+				if (auto FPE = dyn_cast_or_null<FPExtInst>(I); FPE && FPE->getOperand(0)->getType()->getScalarType()->isHalfTy()) {
+					return 0.0;
+				}
+				return get_rounding_error(get_interval(V).max_magnitude());
+			}
+			if (auto iter = errors.find(V); iter != errors.end()) {
+				return iter->second;
+			}
+			// mark as unbounded while computing -> cycles stay unbounded
+			errors[V] = std::numeric_limits<double>::infinity();
+			auto ret = compute_error(*I, candidates);
+			if (std::isnan(ret)) {
+				ret = std::numeric_limits<double>::infinity();
+			}
+			errors[V] = ret;
+			return ret;
+		}
+
+		double compute_error(Instruction& I, const SetVector<Instruction*>& candidates) {
+			const auto error = [this, &candidates](Value* V) {
+				return get_error(V, candidates);
+			};
+			const auto magnitude = [this](Value* V) {
+				return get_interval(V).max_magnitude();
+			};
+			// error of a product: |a| * err(b) + |b| * err(a) + err(a) * err(b)
+			const auto mul_error = [&error, &magnitude](Value* a, Value* b) {
+				const auto err_a = error(a), err_b = error(b);
+				return magnitude(a) * err_b + magnitude(b) * err_a + err_a * err_b;
+			};
+			// adds the rounding error of the result of "I" to the propagated input error
+			const auto round = [this, &I](const double input_error) {
+				return input_error + get_rounding_error(get_interval(&I).max_magnitude() + input_error);
+			};
+
+			switch (I.getOpcode()) {
+				case Instruction::FAdd:
+				case Instruction::FSub:
+					return round(error(I.getOperand(0)) + error(I.getOperand(1)));
+				case Instruction::FMul:
+					return round(mul_error(I.getOperand(0), I.getOperand(1)));
+				case Instruction::FNeg:
+				case Instruction::ExtractElement:
+					return error(I.getOperand(0));
+				case Instruction::Select:
+					return std::max(error(I.getOperand(1)), error(I.getOperand(2)));
+				case Instruction::PHI: {
+					double ret = 0.0;
+					for (auto& incoming : cast<PHINode>(I).incoming_values()) {
+						ret = std::max(ret, error(incoming.get()));
+					}
+					return ret;
+				}
+				case Instruction::InsertElement:
+				case Instruction::ShuffleVector:
+					return std::max(error(I.getOperand(0)), error(I.getOperand(1)));
+				case Instruction::Call:
+					break;
+				default:
+					return std::numeric_limits<double>::infinity();
+			}
+
+			auto& II = cast<IntrinsicInst>(I);
+			switch (II.getIntrinsicID()) {
+				case Intrinsic::fma:
+				case Intrinsic::fmuladd: {
+					// NOTE: assume that the product is rounded as well (fmuladd may not be fused)
+					auto a = II.getArgOperand(0), b = II.getArgOperand(1);
+					const auto product_error = mul_error(a, b);
+					const auto rounded_product_error = product_error +
+						get_rounding_error(magnitude(a) * magnitude(b) + product_error);
+					return round(rounded_product_error + error(II.getArgOperand(2)));
+				}
+				case Intrinsic::minnum:
+				case Intrinsic::maxnum:
+					return std::max(error(II.getArgOperand(0)), error(II.getArgOperand(1)));
+				case Intrinsic::fabs:
+					return error(II.getArgOperand(0));
+				default:
+					break;
+			}
+			return std::numeric_limits<double>::infinity();
+		}
+
+		//! returns the half type corresponding to the float (vector) type "type"
+		Type* get_half_type(Type* type) const {
+			auto half_type = Type::getHalfTy(*ctx);
+			if (auto vec_type = dyn_cast<FixedVectorType>(type); vec_type) {
+				return FixedVectorType::get(half_type, vec_type->getNumElements());
+			}
+			return half_type;
+		}
+
+		//! rebuilds all candidates in half precision, returns the amount of demoted operations
+		uint32_t demote(const SetVector<Instruction*>& candidates, const SmallVectorImpl<sink_t>& sinks) {
+			DenseMap<Value*, Value*> demoted;
+			IRBuilder<> builder(*ctx);
+
+			// returns the half version of a non-candidate (leaf) operand "V" at the current insert point
+			const auto get_leaf = [this, &builder](Value* V) -> Value* {
+				if (auto FPE = dyn_cast<FPExtInst>(V); FPE && FPE->getOperand(0)->getType()->getScalarType()->isHalfTy()) {
+					return FPE->getOperand(0);
+				}
+				// NOTE: constants are folded by the builder
+				return builder.CreateFPTrunc(V, get_half_type(V->getType()));
+			};
+			const auto get_operand = [&demoted, &get_leaf](Value* V) -> Value* {
+				if (auto iter = demoted.find(V); iter != demoted.end()) {
+					return iter->second;
+				}
+				return get_leaf(V);
+			};
+
+			// create all phis first, so that loop-carried values can be referenced
+			for (auto& I : candidates) {
+				if (auto phi = dyn_cast<PHINode>(I); phi) {
+					builder.SetInsertPoint(phi);
+					demoted[phi] = builder.CreatePHI(get_half_type(phi->getType()), phi->getNumIncomingValues(),
+													 phi->getName() + ".half");
+				}
+			}
+
+			// rebuild in reverse post order, so that operands are always demoted before their users
+			for (auto BB : reachable_blocks) {
+				for (auto& I : *BB) {
+					if (candidates.count(&I) == 0 || isa<PHINode>(&I)) {
+						continue;
+					}
+					builder.SetInsertPoint(&I);
+					builder.setFastMathFlags(isa<FPMathOperator>(&I) ? I.getFastMathFlags() : FastMathFlags {});
+					const auto half_type = get_half_type(I.getType());
+					const auto name = I.getName() + ".half";
+					Value* half_val = nullptr;
+					switch (I.getOpcode()) {
+						case Instruction::FAdd:
+						case Instruction::FSub:
+						case Instruction::FMul:
+							half_val = builder.CreateBinOp(Instruction::BinaryOps(I.getOpcode()),
+														   get_operand(I.getOperand(0)), get_operand(I.getOperand(1)), name);
+							break;
+						case Instruction::FNeg:
+							half_val = builder.CreateFNeg(get_operand(I.getOperand(0)), name);
+							break;
+						case Instruction::Select:
+							half_val = builder.CreateSelect(I.getOperand(0), get_operand(I.getOperand(1)),
+															get_operand(I.getOperand(2)), name);
+							break;
+						case Instruction::ExtractElement:
+							half_val = builder.CreateExtractElement(get_operand(I.getOperand(0)), I.getOperand(1), name);
+							break;
+						case Instruction::InsertElement:
+							half_val = builder.CreateInsertElement(get_operand(I.getOperand(0)), get_operand(I.getOperand(1)),
+																   I.getOperand(2), name);
+							break;
+						case Instruction::ShuffleVector:
+							half_val = builder.CreateShuffleVector(get_operand(I.getOperand(0)), get_operand(I.getOperand(1)),
+																   cast<ShuffleVectorInst>(I).getShuffleMask(), name);
+							break;
+						case Instruction::Call: {
+							auto& II = cast<IntrinsicInst>(I);
+							SmallVector<Value*, 3> args;
+							for (auto& arg : II.args()) {
+								args.emplace_back(get_operand(arg.get()));
+							}
+							half_val = builder.CreateIntrinsic(II.getIntrinsicID(), { half_type }, args, nullptr, name);
+							break;
+						}
+						default:
+							llvm_unreachable("unhandled demotable op");
+					}
+					DBG(errs() << "demoted: " << I << " -> " << *half_val << "\n";)
+					demoted[&I] = half_val;
+				}
+			}
+
+			// fill in phi incoming values (leaf conversions are placed at the end of the incoming block)
+			for (auto& I : candidates) {
+				if (auto phi = dyn_cast<PHINode>(I); phi) {
+					auto half_phi = cast<PHINode>(demoted[phi]);
+					for (uint32_t i = 0, count = phi->getNumIncomingValues(); i < count; ++i) {
+						auto incoming_block = phi->getIncomingBlock(i);
+						builder.SetInsertPoint(incoming_block->getTerminator());
+						half_phi->addIncoming(get_operand(phi->getIncomingValue(i)), incoming_block);
+					}
+				}
+			}
+
+			// sinks use the extended half value
+			for (auto& sink : sinks) {
+				auto iter = demoted.find(sink.use->get());
+				if (iter == demoted.end()) {
+					continue;
+				}
+				builder.SetInsertPoint(cast<Instruction>(sink.use->getUser()));
+				sink.use->set(builder.CreateFPExt(iter->second, sink.use->get()->getType()));
+			}
+
+			// all candidates are now dead: drop all references first, since they may reference each other (phis)
+			for (auto& I : candidates) {
+				I->dropAllReferences();
+			}
+			for (auto& I : candidates) {
+				I->eraseFromParent();
+			}
+			return uint32_t(candidates.size());
+		}
+	};
+}
+
+char RelaxedPrecisionDemotion::ID = 0;
+FunctionPass *llvm::createRelaxedPrecisionDemotionPass(const bool fragment_outputs_are_sinks) {
+	return new RelaxedPrecisionDemotion(fragment_outputs_are_sinks);
+}
+INITIALIZE_PASS_BEGIN(RelaxedPrecisionDemotion, "RelaxedPrecisionDemotion", "RelaxedPrecisionDemotion Pass", false, false)
+INITIALIZE_PASS_DEPENDENCY(OptimizationRemarkEmitterWrapperPass)
+INITIALIZE_PASS_END(RelaxedPrecisionDemotion, "RelaxedPrecisionDemotion", "RelaxedPrecisionDemotion Pass", false, false)
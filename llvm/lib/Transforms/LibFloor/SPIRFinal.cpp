@@ -28,6 +28,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/Triple.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/InitializePasses.h"
 #include "llvm/IR/CFG.h"
@@ -58,6 +59,7 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/LibFloor.h"
 #include "llvm/Transforms/LibFloor/AddressSpaceFix.h"
+#include "llvm/Transforms/LibFloor/FloorIntrinsicLowering.h"
 #include "llvm/Transforms/LibFloor/FloorUtils.h"
 #include <algorithm>
 #include <cstdarg>
@@ -87,6 +89,7 @@ namespace {
 		Function* func { nullptr };
 		Instruction* alloca_insert { nullptr };
 		bool was_modified { false };
+		bool is_vulkan { false };
 		
 		SPIRFinal() : FunctionPass(ID) {
 			initializeSPIRFinalPass(*PassRegistry::getPassRegistry());
@@ -101,6 +104,7 @@ namespace {
 			ctx = &M->getContext();
 			func = &F;
 			builder = std::make_shared<llvm::IRBuilder<>>(*ctx);
+			is_vulkan = (Triple(M->getTargetTriple()).getEnvironment() == Triple::Vulkan);
 			
 			// visit everything in this function
 			was_modified = false; // reset every time
@@ -214,7 +218,7 @@ namespace {
 		}
 		
 		// SPIR doesn't support various LLVM intrinsics
-		// -> simply remove them
+		// -> simply remove them or lower them to OpenCL builtins / plain IR
 		// TODO: should probably kill the global decl as well
 		void visitIntrinsicInst(IntrinsicInst &I) {
 			if (I.getIntrinsicID() == Intrinsic::lifetime_start ||
@@ -223,6 +227,15 @@ namespace {
 				I.getIntrinsicID() == Intrinsic::experimental_noalias_scope_decl) {
 				I.eraseFromParent();
 				was_modified = true;
+				return;
+			}
+			
+			// Vulkan: lowered later on in VulkanFinal
+			if (is_vulkan) {
+				return;
+			}
+			if (lower_floor_intrinsic(I, *builder, FLOOR_INTRINSIC_TARGET::SPIR)) {
+				was_modified = true;
 			}
 		}
 		
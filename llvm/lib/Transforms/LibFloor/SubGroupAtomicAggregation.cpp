@@ -0,0 +1,285 @@
+//===- SubGroupAtomicAggregation.cpp - sub-group atomic aggregation -------===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass aggregates atomic read-modify-write operations on an address that
+// is uniform across the sub-group (warp): instead of one atomic per work-item,
+// the values of all active work-items are combined within the sub-group and
+// only the first active work-item (the "leader") performs a single atomic.
+// This is modelled on the AMDGPU atomic optimizer.
+//
+//  * uniform values: the combined value is computed from the number of active
+//    work-items (add/sub: value * count, xor: count parity, and/or/min/max:
+//    the value itself). If the old value is used, the leader's result is
+//    broadcast and each work-item computes its own result, as if the atomics
+//    had been executed in order of the work-item lane ids.
+//  * divergent values: the values are reduced with a sub-group reduction
+//    (redux.sync, sm_80+, 32-bit only). This is only done if the old value is
+//    unused, since each work-item would otherwise need an exclusive scan.
+//
+// Only relaxed (monotonic) atomics are aggregated, since all other work-items
+// no longer perform an atomic operation and would lose any ordering.
+//
+// Currently only implemented for CUDA/PTX, where the set of active work-items
+// can be queried (activemask) and uniformity is known through the divergence
+// analysis.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/LegacyDivergenceAnalysis.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/IntrinsicsNVPTX.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "SubGroupAtomicAggregation"
+
+#if 1
+#define DBG(x)
+#else
+#define DBG(x) x
+#endif
+
+namespace {
+	// SubGroupAtomicAggregation
+	struct SubGroupAtomicAggregation : public FunctionPass {
+		static char ID; // Pass identification, replacement for typeid
+
+		LegacyDivergenceAnalysis* DA { nullptr };
+		//! true if redux.sync is supported (sm_80+)
+		bool has_redux { false };
+
+		SubGroupAtomicAggregation() : FunctionPass(ID) {
+			initializeSubGroupAtomicAggregationPass(*PassRegistry::getPassRegistry());
+		}
+
+		StringRef getPassName() const override {
+			return "sub-group atomic aggregation";
+		}
+
+		void getAnalysisUsage(AnalysisUsage &AU) const override {
+			AU.addRequired<LegacyDivergenceAnalysis>();
+			AU.addRequired<TargetTransformInfoWrapperPass>();
+		}
+
+		bool runOnFunction(Function& F) override {
+			if (!Triple(F.getParent()->getTargetTriple()).isNVPTX()) {
+				return false;
+			}
+			// w/o divergence info, every value would be considered uniform
+			if (!getAnalysis<TargetTransformInfoWrapperPass>().getTTI(F).hasBranchDivergence()) {
+				return false;
+			}
+			DA = &getAnalysis<LegacyDivergenceAnalysis>();
+
+			has_redux = false;
+			if (const auto cpu = F.getFnAttribute("target-cpu").getValueAsString(); cpu.startswith("sm_")) {
+				uint32_t sm_version = 0;
+				has_redux = (!cpu.drop_front(3).getAsInteger(10, sm_version) && sm_version >= 80);
+			}
+
+			std::vector<AtomicRMWInst*> atomics;
+			for (auto& I : instructions(F)) {
+				if (auto RMW = dyn_cast<AtomicRMWInst>(&I); RMW && can_aggregate(*RMW)) {
+					atomics.emplace_back(RMW);
+				}
+			}
+			for (auto& RMW : atomics) {
+				DBG(errs() << "aggregating " << *RMW << "\n";)
+				aggregate(*RMW);
+			}
+			return !atomics.empty();
+		}
+
+		//! returns the redux.sync intrinsic that reduces values of the specified operation (or not_intrinsic)
+		static Intrinsic::ID get_redux_intrinsic(const AtomicRMWInst::BinOp op) {
+			switch (op) {
+				case AtomicRMWInst::Add:
+				case AtomicRMWInst::Sub: return Intrinsic::nvvm_redux_sync_add;
+				case AtomicRMWInst::And: return Intrinsic::nvvm_redux_sync_and;
+				case AtomicRMWInst::Or: return Intrinsic::nvvm_redux_sync_or;
+				case AtomicRMWInst::Xor: return Intrinsic::nvvm_redux_sync_xor;
+				case AtomicRMWInst::Max: return Intrinsic::nvvm_redux_sync_max;
+				case AtomicRMWInst::Min: return Intrinsic::nvvm_redux_sync_min;
+				case AtomicRMWInst::UMax: return Intrinsic::nvvm_redux_sync_umax;
+				case AtomicRMWInst::UMin: return Intrinsic::nvvm_redux_sync_umin;
+				default: return Intrinsic::not_intrinsic;
+			}
+		}
+
+		bool can_aggregate(const AtomicRMWInst& RMW) const {
+			if (RMW.isVolatile() || get_redux_intrinsic(RMW.getOperation()) == Intrinsic::not_intrinsic) {
+				return false;
+			}
+			// only the leader performs an atomic operation after aggregation, so all other work-items would lose
+			// any acquire/release ordering -> only aggregate relaxed atomics
+			if (RMW.getOrdering() != AtomicOrdering::Monotonic) {
+				return false;
+			}
+			const auto type = RMW.getType();
+			if (!type->isIntegerTy(32) && !type->isIntegerTy(64)) {
+				return false;
+			}
+			if (!DA->isUniform(RMW.getPointerOperand())) {
+				return false;
+			}
+			if (DA->isUniform(RMW.getValOperand())) {
+				return true;
+			}
+			// divergent values: only possible with a sub-group reduction, and if we don't need the old value
+			return (has_redux && type->isIntegerTy(32) && RMW.use_empty());
+		}
+
+		//! broadcasts the 32-bit or 64-bit "val" from lane "src_lane" to all lanes in "mask"
+		static Value* broadcast(IRBuilder<>& builder, Module& M, Value* mask, Value* val, Value* src_lane) {
+			auto shfl = Intrinsic::getDeclaration(&M, Intrinsic::nvvm_shfl_sync_idx_i32);
+			auto i32_type = builder.getInt32Ty();
+			const auto shuffle = [&](Value* val32) {
+				return builder.CreateCall(shfl, { mask, val32, src_lane, builder.getInt32(0x1F) });
+			};
+			if (val->getType()->isIntegerTy(32)) {
+				return shuffle(val);
+			}
+			auto lo = shuffle(builder.CreateTrunc(val, i32_type));
+			auto hi = shuffle(builder.CreateTrunc(builder.CreateLShr(val, 32), i32_type));
+			auto type = val->getType();
+			return builder.CreateOr(builder.CreateZExt(lo, type), builder.CreateShl(builder.CreateZExt(hi, type), 32));
+		}
+
+		void aggregate(AtomicRMWInst& RMW) {
+			auto& M = *RMW.getModule();
+			auto& ctx = M.getContext();
+			auto i32_type = Type::getInt32Ty(ctx);
+			auto type = RMW.getType();
+			const auto op = RMW.getOperation();
+			auto val = RMW.getValOperand();
+			const bool uniform_val = DA->isUniform(val);
+
+			IRBuilder<> builder(&RMW);
+			auto activemask_asm = InlineAsm::get(FunctionType::get(i32_type, false), "activemask.b32 $0;", "=r", true);
+			auto mask = builder.CreateCall(activemask_asm, {}, "active_mask");
+			mask->setConvergent();
+			auto lane_id = builder.CreateCall(Intrinsic::getDeclaration(&M, Intrinsic::nvvm_read_ptx_sreg_laneid), {}, "lane_id");
+			auto leader = builder.CreateIntrinsic(Intrinsic::cttz, { i32_type }, { mask, builder.getTrue() }, nullptr, "leader");
+			auto is_leader = builder.CreateICmpEQ(lane_id, leader);
+
+			// number of active lanes (and those below this lane) as "type"
+			const auto count_lanes = [&](Value* lane_mask) {
+				auto count = builder.CreateUnaryIntrinsic(Intrinsic::ctpop, lane_mask);
+				return builder.CreateZExtOrTrunc(count, type);
+			};
+
+			Value* combined = nullptr;
+			if (uniform_val) {
+				switch (op) {
+					case AtomicRMWInst::Add:
+					case AtomicRMWInst::Sub:
+						combined = builder.CreateMul(val, count_lanes(mask));
+						break;
+					case AtomicRMWInst::Xor:
+						combined = builder.CreateMul(val, builder.CreateAnd(count_lanes(mask), ConstantInt::get(type, 1)));
+						break;
+					default:
+						// and/or/min/max are idempotent
+						combined = val;
+						break;
+				}
+			} else {
+				combined = builder.CreateCall(Intrinsic::getDeclaration(&M, get_redux_intrinsic(op)), { val, mask });
+			}
+
+			// only the leader performs the atomic operation
+			auto then_term = SplitBlockAndInsertIfThen(is_leader, &RMW, false, nullptr, (DominatorTree*)nullptr);
+			auto leader_block = then_term->getParent();
+			auto tail_block = then_term->getSuccessor(0);
+			RMW.moveBefore(then_term);
+			RMW.setOperand(1, combined); // value operand
+			if (RMW.use_empty()) {
+				return;
+			}
+
+			// broadcast the leader's result and compute the result of each lane
+			builder.SetInsertPoint(&tail_block->front());
+			auto phi = builder.CreatePHI(type, 2);
+			phi->addIncoming(&RMW, leader_block);
+			phi->addIncoming(UndefValue::get(type), is_leader->getParent());
+			auto old_val = broadcast(builder, M, mask, phi, leader);
+
+			Value* result = nullptr;
+			switch (op) {
+				case AtomicRMWInst::Add:
+				case AtomicRMWInst::Sub: {
+					auto lanemask_lt = builder.CreateCall(Intrinsic::getDeclaration(&M, Intrinsic::nvvm_read_ptx_sreg_lanemask_lt));
+					auto prev_val = builder.CreateMul(val, count_lanes(builder.CreateAnd(mask, lanemask_lt)));
+					result = (op == AtomicRMWInst::Add ? builder.CreateAdd(old_val, prev_val) : builder.CreateSub(old_val, prev_val));
+					break;
+				}
+				case AtomicRMWInst::Xor: {
+					auto lanemask_lt = builder.CreateCall(Intrinsic::getDeclaration(&M, Intrinsic::nvvm_read_ptx_sreg_lanemask_lt));
+					auto parity = builder.CreateAnd(count_lanes(builder.CreateAnd(mask, lanemask_lt)), ConstantInt::get(type, 1));
+					result = builder.CreateXor(old_val, builder.CreateMul(val, parity));
+					break;
+				}
+				default: {
+					// all lanes after the leader see the already combined value
+					Value* combined_val = nullptr;
+					switch (op) {
+						case AtomicRMWInst::And: combined_val = builder.CreateAnd(old_val, val); break;
+						case AtomicRMWInst::Or: combined_val = builder.CreateOr(old_val, val); break;
+						case AtomicRMWInst::Max: combined_val = builder.CreateBinaryIntrinsic(Intrinsic::smax, old_val, val); break;
+						case AtomicRMWInst::Min: combined_val = builder.CreateBinaryIntrinsic(Intrinsic::smin, old_val, val); break;
+						case AtomicRMWInst::UMax: combined_val = builder.CreateBinaryIntrinsic(Intrinsic::umax, old_val, val); break;
+						case AtomicRMWInst::UMin: combined_val = builder.CreateBinaryIntrinsic(Intrinsic::umin, old_val, val); break;
+						default: llvm_unreachable("unhandled atomic operation");
+					}
+					result = builder.CreateSelect(is_leader, old_val, combined_val);
+					break;
+				}
+			}
+			RMW.replaceUsesWithIf(result, [phi](Use& U) { return U.getUser() != phi; });
+		}
+	};
+
+}
+
+char SubGroupAtomicAggregation::ID = 0;
+FunctionPass *llvm::createSubGroupAtomicAggregationPass() {
+	return new SubGroupAtomicAggregation();
+}
+INITIALIZE_PASS_BEGIN(SubGroupAtomicAggregation, "SubGroupAtomicAggregation", "SubGroupAtomicAggregation Pass", false, false)
+INITIALIZE_PASS_DEPENDENCY(LegacyDivergenceAnalysis)
+INITIALIZE_PASS_DEPENDENCY(TargetTransformInfoWrapperPass)
+INITIALIZE_PASS_END(SubGroupAtomicAggregation, "SubGroupAtomicAggregation", "SubGroupAtomicAggregation Pass", false, false)
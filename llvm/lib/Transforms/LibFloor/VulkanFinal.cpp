@@ -70,6 +70,7 @@
 #include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/LowerMemIntrinsics.h"
 #include "llvm/Transforms/LibFloor/AddressSpaceFix.h"
+#include "llvm/Transforms/LibFloor/FloorIntrinsicLowering.h"
 #include "llvm/Transforms/LibFloor/FloorUtils.h"
 #include <algorithm>
 #include <cstdarg>
@@ -1195,6 +1196,12 @@ namespace {
 			// TODO: no pointers to pointers in vulkan
 		}
 		
+		// expand intrinsics that have no SPIR-V / GLSL.std.450 equivalent (funnel shifts, clz/ctz,
+		// saturating ops, fmuladd, vector reductions, ...), others are handled by the SPIR-V translator
+		void visitIntrinsicInst(IntrinsicInst &I) {
+			lower_floor_intrinsic(I, *builder, FLOOR_INTRINSIC_TARGET::VULKAN);
+		}
+		
 		void visitReturnInst(ReturnInst &RI) {
 			if(!is_vertex_func && !is_fragment_func && !is_tess_eval_func) return;
 			
@@ -0,0 +1,337 @@
+//===- VulkanStructuredCleanup.cpp - post-structurization Vulkan cleanup --===//
+//
+//  Flo's Open libRary (floor)
+//  Copyright (C) 2004 - 2024 Florian Ziesche
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; version 2 of the License only.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along
+//  with this program; if not, write to the Free Software Foundation, Inc.,
+//  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass cleans up the residue of CFG structurization (ladder blocks,
+// trivial/duplicate PHIs, redundant loads, loop invariants in loop bodies)
+// after CFGStructurization has run, while keeping the CFG structured:
+//  * blocks referenced by floor.loop_merge/floor.selection_merge (merge and
+//    continue blocks) are never removed or merged into another block
+//  * blocks containing a merge/continue marker are never merged into another
+//    block, and no block is merged into a block with a header marker
+//  * instructions are never inserted between a header marker and the
+//    terminator of its block
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/LoopIterator.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/LibFloor.h"
+#include "llvm/Transforms/LibFloor/FloorUtils.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "VulkanStructuredCleanup"
+
+#if 1
+#define DBG(x)
+#else
+#define DBG(x) x
+#endif
+
+namespace {
+	// VulkanStructuredCleanup
+	struct VulkanStructuredCleanup : public FunctionPass {
+		static char ID; // Pass identification, replacement for typeid
+
+		Function* func { nullptr };
+		bool was_modified { false };
+
+		VulkanStructuredCleanup() : FunctionPass(ID) {
+			initializeVulkanStructuredCleanupPass(*PassRegistry::getPassRegistry());
+		}
+
+		StringRef getPassName() const override {
+			return "Vulkan structured cleanup";
+		}
+
+		bool runOnFunction(Function& F) override {
+			if (F.isDeclaration()) {
+				return false;
+			}
+			func = &F;
+			was_modified = false;
+
+			// LICM (no CFG changes)
+			{
+				DominatorTree DT(F);
+				LoopInfo LI(DT);
+				// NOTE: process inner loops first, so that invariants can move outwards step by step
+				auto loops = LI.getLoopsInPreorder();
+				for (auto loop_iter = loops.rbegin(); loop_iter != loops.rend(); ++loop_iter) {
+					was_modified |= hoist_loop_invariants(**loop_iter, LI);
+				}
+			}
+
+			// block-local load/store forwarding (no CFG changes)
+			for (auto& BB : F) {
+				was_modified |= forward_loads_and_stores(BB);
+			}
+
+			// PHI simplification (no CFG changes)
+			{
+				DominatorTree DT(F);
+				was_modified |= simplify_phis(F, DT);
+			}
+
+			// CFG changes: ladder collapsing and dead block removal
+			was_modified |= collapse_ladders(F);
+			was_modified |= remove_dead_blocks(F);
+
+			return was_modified;
+		}
+
+		//! returns true if "I" is side-effect free and can be hoisted out of "L"
+		static bool can_hoist(const Instruction& I, const Loop& L) {
+			if (isa<PHINode>(I) || I.isTerminator() || isa<CallBase>(I) || isa<AllocaInst>(I) ||
+				I.mayReadOrWriteMemory() || I.isEHPad()) {
+				return false;
+			}
+			return (L.hasLoopInvariantOperands(&I) && isSafeToSpeculativelyExecute(&I));
+		}
+
+		//! hoists all loop-invariant and side-effect free instructions into the loop preheader
+		bool hoist_loop_invariants(Loop& L, LoopInfo& LI) {
+			auto preheader = L.getLoopPreheader();
+			if (!preheader) {
+				return false;
+			}
+			auto insert_point = libfloor_utils::get_cfg_marker_safe_insert_point(*preheader);
+
+			bool hoisted = false;
+			LoopBlocksRPO loop_rpo(&L);
+			loop_rpo.perform(&LI);
+			for (auto BB : loop_rpo) {
+				for (auto instr_iter = BB->begin(); instr_iter != BB->end(); ) {
+					auto& I = *instr_iter++;
+					if (!can_hoist(I, L)) {
+						continue;
+					}
+					DBG(errs() << "hoisting " << I << " out of " << L.getHeader()->getName() << "\n";)
+					I.moveBefore(insert_point);
+					hoisted = true;
+				}
+			}
+			return hoisted;
+		}
+
+		//! returns false if "ptr_a" and "ptr_b" definitely don't alias, true otherwise
+		static bool may_alias(const Value* ptr_a, const Value* ptr_b) {
+			if (ptr_a == ptr_b) {
+				return true;
+			}
+			const auto obj_a = getUnderlyingObject(ptr_a);
+			const auto obj_b = getUnderlyingObject(ptr_b);
+			if (obj_a != obj_b && isIdentifiedObject(obj_a) && isIdentifiedObject(obj_b)) {
+				return false;
+			}
+			return true;
+		}
+
+		//! forwards stored/loaded values to later loads from the same pointer in "BB",
+		//! removes stores that store the value that was just loaded from the same pointer
+		bool forward_loads_and_stores(BasicBlock& BB) {
+			bool modified = false;
+			// pointer -> currently known value
+			DenseMap<Value*, Value*> avail_values;
+			for (auto instr_iter = BB.begin(); instr_iter != BB.end(); ) {
+				auto& I = *instr_iter++;
+				if (auto LD = dyn_cast<LoadInst>(&I); LD) {
+					if (!LD->isSimple()) {
+						avail_values.clear();
+						continue;
+					}
+					const auto ptr = LD->getPointerOperand();
+					if (const auto avail_iter = avail_values.find(ptr);
+						avail_iter != avail_values.end() && avail_iter->second->getType() == LD->getType()) {
+						LD->replaceAllUsesWith(avail_iter->second);
+						LD->eraseFromParent();
+						modified = true;
+						continue;
+					}
+					avail_values[ptr] = LD;
+				} else if (auto ST = dyn_cast<StoreInst>(&I); ST) {
+					if (!ST->isSimple()) {
+						avail_values.clear();
+						continue;
+					}
+					const auto ptr = ST->getPointerOperand();
+					const auto value = ST->getValueOperand();
+					if (const auto avail_iter = avail_values.find(ptr);
+						avail_iter != avail_values.end() && avail_iter->second == value) {
+						// storing the same value again
+						ST->eraseFromParent();
+						modified = true;
+						continue;
+					}
+					SmallVector<Value*, 8> clobbered;
+					for (const auto& avail : avail_values) {
+						if (may_alias(avail.first, ptr)) {
+							clobbered.emplace_back(avail.first);
+						}
+					}
+					for (const auto& clobbered_ptr : clobbered) {
+						avail_values.erase(clobbered_ptr);
+					}
+					avail_values[ptr] = value;
+				} else if (libfloor_utils::is_cfg_marker_call(I)) {
+					// markers don't touch memory
+					continue;
+				} else if (I.mayWriteToMemory()) {
+					avail_values.clear();
+				}
+			}
+			return modified;
+		}
+
+		//! removes PHIs that only have a single (non-undef) incoming value and merges identical PHIs
+		bool simplify_phis(Function& F, DominatorTree& DT) {
+			bool modified = false;
+			for (auto& BB : F) {
+				// trivial PHIs
+				for (auto& phi : make_early_inc_range(BB.phis())) {
+					Value* common_value = nullptr;
+					bool is_trivial = true;
+					for (const auto& incoming : phi.incoming_values()) {
+						if (incoming == &phi || isa<UndefValue>(incoming)) {
+							continue;
+						}
+						if (common_value != nullptr && common_value != incoming) {
+							is_trivial = false;
+							break;
+						}
+						common_value = incoming;
+					}
+					if (!is_trivial) {
+						continue;
+					}
+					if (common_value == nullptr) {
+						common_value = UndefValue::get(phi.getType());
+					} else if (const auto common_instr = dyn_cast<Instruction>(common_value);
+							   common_instr && !DT.properlyDominates(common_instr->getParent(), &BB)) {
+						continue;
+					}
+					phi.replaceAllUsesWith(common_value);
+					phi.eraseFromParent();
+					modified = true;
+				}
+
+				// duplicate PHIs
+				SmallVector<PHINode*, 8> unique_phis;
+				for (auto& phi : make_early_inc_range(BB.phis())) {
+					PHINode* identical_phi = nullptr;
+					for (const auto& other : unique_phis) {
+						if (other->getType() != phi.getType() ||
+							other->getNumIncomingValues() != phi.getNumIncomingValues()) {
+							continue;
+						}
+						bool is_identical = true;
+						for (uint32_t i = 0, count = phi.getNumIncomingValues(); i < count; ++i) {
+							if (other->getIncomingValueForBlock(phi.getIncomingBlock(i)) != phi.getIncomingValue(i)) {
+								is_identical = false;
+								break;
+							}
+						}
+						if (is_identical) {
+							identical_phi = other;
+							break;
+						}
+					}
+					if (identical_phi) {
+						phi.replaceAllUsesWith(identical_phi);
+						phi.eraseFromParent();
+						modified = true;
+					} else {
+						unique_phis.emplace_back(&phi);
+					}
+				}
+			}
+			return modified;
+		}
+
+		//! merges ladder blocks (blocks with a single predecessor that unconditionally branches to them) into their predecessor
+		bool collapse_ladders(Function& F) {
+			bool modified = false;
+			for (auto& BB : make_early_inc_range(F)) {
+				if (&BB == &F.getEntryBlock()) {
+					continue;
+				}
+				auto pred = BB.getSinglePredecessor();
+				if (!pred || pred == &BB) {
+					continue;
+				}
+				const auto pred_br = dyn_cast<BranchInst>(pred->getTerminator());
+				if (!pred_br || !pred_br->isUnconditional()) {
+					continue;
+				}
+				// structure must be kept intact: markers must always directly precede the terminator,
+				// so nothing may be merged into a block that ends in a marker call
+				if (libfloor_utils::has_trailing_cfg_marker(*pred) || libfloor_utils::is_cfg_marker_referenced(BB)) {
+					continue;
+				}
+				if (any_of(BB, [](const Instruction& I) { return libfloor_utils::is_cfg_marker_call(I); })) {
+					continue;
+				}
+				DBG(errs() << "merging ladder block " << BB.getName() << " into " << pred->getName() << "\n";)
+				modified |= MergeBlockIntoPredecessor(&BB);
+			}
+			return modified;
+		}
+
+		//! removes all blocks that have no predecessors and are not referenced by any marker
+		bool remove_dead_blocks(Function& F) {
+			std::vector<BasicBlock*> dead_blocks;
+			for (auto& BB : F) {
+				if (&BB == &F.getEntryBlock() || !pred_empty(&BB) || libfloor_utils::is_cfg_marker_referenced(BB)) {
+					continue;
+				}
+				dead_blocks.emplace_back(&BB);
+			}
+			if (dead_blocks.empty()) {
+				return false;
+			}
+			DeleteDeadBlocks(dead_blocks);
+			return true;
+		}
+	};
+
+}
+
+char VulkanStructuredCleanup::ID = 0;
+FunctionPass *llvm::createVulkanStructuredCleanupPass() {
+	return new VulkanStructuredCleanup();
+}
+INITIALIZE_PASS_BEGIN(VulkanStructuredCleanup, "VulkanStructuredCleanup", "VulkanStructuredCleanup Pass", false, false)
+INITIALIZE_PASS_END(VulkanStructuredCleanup, "VulkanStructuredCleanup", "VulkanStructuredCleanup Pass", false, false)
@@ -0,0 +1,109 @@
+; RUN: opt -enable-new-pm=0 -MetalFinal -S < %s | FileCheck %s
+
+; Metal: LLVM intrinsics are mapped onto the corresponding air.* builtins,
+; funnel shifts of a single value onto air.rotate and reductions are expanded.
+
+target triple = "air64-apple-macosx14.0.0"
+
+declare i32 @llvm.ctlz.i32(i32, i1)
+declare i32 @llvm.cttz.i32(i32, i1)
+declare <2 x i16> @llvm.fshl.v2i16(<2 x i16>, <2 x i16>, <2 x i16>)
+declare i32 @llvm.fshr.i32(i32, i32, i32)
+declare i32 @llvm.sadd.sat.i32(i32, i32)
+declare float @llvm.fabs.f32(float)
+declare float @llvm.vector.reduce.fadd.v4f32(float, <4 x float>)
+declare i32 @llvm.vector.reduce.smax.v4i32(<4 x i32>)
+
+; CHECK-LABEL: define i32 @clz(
+; CHECK: %[[R:[0-9]+]] = call i32 @air.clz.u.i32(i32 %x)
+; CHECK-NEXT: ret i32 %[[R]]
+define i32 @clz(i32 %x) {
+  %r = call i32 @llvm.ctlz.i32(i32 %x, i1 false)
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @ctz(
+; CHECK: %[[R:[0-9]+]] = call i32 @air.ctz.u.i32(i32 %x)
+; CHECK-NEXT: ret i32 %[[R]]
+define i32 @ctz(i32 %x) {
+  %r = call i32 @llvm.cttz.i32(i32 %x, i1 true)
+  ret i32 %r
+}
+
+; a left funnel shift of a single value is a left rotate
+; CHECK-LABEL: define <2 x i16> @rotate_left(
+; CHECK: %[[SHIFT:[0-9]+]] = urem <2 x i16> %s, <i16 16, i16 16>
+; CHECK: %[[R:[0-9]+]] = call <2 x i16> @air.rotate.v2u.i16(<2 x i16> %x, <2 x i16> %[[SHIFT]])
+; CHECK-NEXT: ret <2 x i16> %[[R]]
+define <2 x i16> @rotate_left(<2 x i16> %x, <2 x i16> %s) {
+  %r = call <2 x i16> @llvm.fshl.v2i16(<2 x i16> %x, <2 x i16> %x, <2 x i16> %s)
+  ret <2 x i16> %r
+}
+
+; a right rotate is a left rotate by the inverse shift amount
+; CHECK-LABEL: define i32 @rotate_right(
+; CHECK: %[[SHIFT:[0-9]+]] = urem i32 %s, 32
+; CHECK-NEXT: %[[INV_SHIFT:[0-9]+]] = sub i32 32, %[[SHIFT]]
+; CHECK-NEXT: %[[R:[0-9]+]] = call i32 @air.rotate.u.i32(i32 %x, i32 %[[INV_SHIFT]])
+; CHECK-NEXT: ret i32 %[[R]]
+define i32 @rotate_right(i32 %x, i32 %s) {
+  %r = call i32 @llvm.fshr.i32(i32 %x, i32 %x, i32 %s)
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @add_sat(
+; CHECK: %[[R:[0-9]+]] = call i32 @air.add_sat.s.i32(i32 %x, i32 %y)
+; CHECK-NEXT: ret i32 %[[R]]
+define i32 @add_sat(i32 %x, i32 %y) {
+  %r = call i32 @llvm.sadd.sat.i32(i32 %x, i32 %y)
+  ret i32 %r
+}
+
+; f32 uses the fast variant
+; CHECK-LABEL: define float @fabs(
+; CHECK: %[[R:[0-9]+]] = call float @air.fast_fabs.f32(float %x)
+; CHECK-NEXT: ret float %[[R]]
+define float @fabs(float %x) {
+  %r = call float @llvm.fabs.f32(float %x)
+  ret float %r
+}
+
+; unordered f32 fadd reductions are a dot product with a vector of ones
+; CHECK-LABEL: define float @reduce_fadd_unordered(
+; CHECK: %[[R:[0-9]+]] = call reassoc float @air.dot.v4f32(<4 x float> %v, <4 x float> <float 1.000000e+00, float 1.000000e+00, float 1.000000e+00, float 1.000000e+00>)
+; CHECK-NEXT: ret float %[[R]]
+define float @reduce_fadd_unordered(<4 x float> %v) {
+  %r = call reassoc float @llvm.vector.reduce.fadd.v4f32(float 0.0, <4 x float> %v)
+  ret float %r
+}
+
+; ordered fadd reductions are performed sequentially, starting with the start value
+; CHECK-LABEL: define float @reduce_fadd_ordered(
+; CHECK: %[[E0:[0-9]+]] = extractelement <4 x float> %v, i32 0
+; CHECK-NEXT: %[[E1:[0-9]+]] = extractelement <4 x float> %v, i32 1
+; CHECK-NEXT: %[[E2:[0-9]+]] = extractelement <4 x float> %v, i32 2
+; CHECK-NEXT: %[[E3:[0-9]+]] = extractelement <4 x float> %v, i32 3
+; CHECK-NEXT: %[[A0:[0-9]+]] = fadd float %start, %[[E0]]
+; CHECK-NEXT: %[[A1:[0-9]+]] = fadd float %[[A0]], %[[E1]]
+; CHECK-NEXT: %[[A2:[0-9]+]] = fadd float %[[A1]], %[[E2]]
+; CHECK-NEXT: %[[A3:[0-9]+]] = fadd float %[[A2]], %[[E3]]
+; CHECK-NEXT: ret float %[[A3]]
+define float @reduce_fadd_ordered(float %start, <4 x float> %v) {
+  %r = call float @llvm.vector.reduce.fadd.v4f32(float %start, <4 x float> %v)
+  ret float %r
+}
+
+; integer reductions are performed as a tree
+; CHECK-LABEL: define i32 @reduce_smax(
+; CHECK: %[[E0:[0-9]+]] = extractelement <4 x i32> %v, i32 0
+; CHECK-NEXT: %[[E1:[0-9]+]] = extractelement <4 x i32> %v, i32 1
+; CHECK-NEXT: %[[E2:[0-9]+]] = extractelement <4 x i32> %v, i32 2
+; CHECK-NEXT: %[[E3:[0-9]+]] = extractelement <4 x i32> %v, i32 3
+; CHECK-NEXT: %[[M01:[0-9]+]] = call i32 @air.max.s.i32(i32 %[[E0]], i32 %[[E1]])
+; CHECK-NEXT: %[[M23:[0-9]+]] = call i32 @air.max.s.i32(i32 %[[E2]], i32 %[[E3]])
+; CHECK-NEXT: %[[M:[0-9]+]] = call i32 @air.max.s.i32(i32 %[[M01]], i32 %[[M23]])
+; CHECK-NEXT: ret i32 %[[M]]
+define i32 @reduce_smax(<4 x i32> %v) {
+  %r = call i32 @llvm.vector.reduce.smax.v4i32(<4 x i32> %v)
+  ret i32 %r
+}
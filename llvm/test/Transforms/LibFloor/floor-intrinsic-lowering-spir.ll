@@ -0,0 +1,107 @@
+; RUN: opt -enable-new-pm=0 -SPIRFinal -S < %s | FileCheck %s
+
+; OpenCL/SPIR: LLVM intrinsics are mapped onto the Itanium-mangled OpenCL C
+; builtins, everything that doesn't exist in OpenCL 1.2 (ctz) is expanded.
+
+target triple = "spir64-unknown-unknown"
+
+declare i32 @llvm.ctlz.i32(i32, i1)
+declare i32 @llvm.cttz.i32(i32, i1)
+declare i32 @llvm.sadd.sat.i32(i32, i32)
+declare i16 @llvm.uadd.sat.i16(i16, i16)
+declare float @llvm.fma.f32(float, float, float)
+declare <4 x i32> @llvm.smax.v4i32(<4 x i32>, <4 x i32>)
+declare <4 x i32> @llvm.fshl.v4i32(<4 x i32>, <4 x i32>, <4 x i32>)
+declare i32 @llvm.fshr.i32(i32, i32, i32)
+declare i32 @llvm.vector.reduce.add.v3i32(<3 x i32>)
+
+; CHECK-LABEL: define i32 @clz(
+; CHECK: %[[R:[0-9]+]] = call i32 @_Z3clzj(i32 %x)
+; CHECK-NEXT: ret i32 %[[R]]
+define i32 @clz(i32 %x) {
+  %r = call i32 @llvm.ctlz.i32(i32 %x, i1 false)
+  ret i32 %r
+}
+
+; ctz(x) = popcount(~x & (x - 1))
+; CHECK-LABEL: define i32 @ctz(
+; CHECK-DAG: %[[NOT:[0-9]+]] = xor i32 %x, -1
+; CHECK-DAG: %[[DEC:[0-9]+]] = sub i32 %x, 1
+; CHECK: %[[MASK:[0-9]+]] = and i32 %[[NOT]], %[[DEC]]
+; CHECK-NEXT: %[[R:[0-9]+]] = call i32 @_Z8popcountj(i32 %[[MASK]])
+; CHECK-NEXT: ret i32 %[[R]]
+define i32 @ctz(i32 %x) {
+  %r = call i32 @llvm.cttz.i32(i32 %x, i1 false)
+  ret i32 %r
+}
+
+; builtin scalar types are repeated for each parameter
+; CHECK-LABEL: define i32 @add_sat(
+; CHECK: %[[R:[0-9]+]] = call i32 @_Z7add_satii(i32 %x, i32 %y)
+; CHECK-NEXT: ret i32 %[[R]]
+define i32 @add_sat(i32 %x, i32 %y) {
+  %r = call i32 @llvm.sadd.sat.i32(i32 %x, i32 %y)
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i16 @add_sat_u16(
+; CHECK: %[[R:[0-9]+]] = call i16 @_Z7add_sattt(i16 %x, i16 %y)
+; CHECK-NEXT: ret i16 %[[R]]
+define i16 @add_sat_u16(i16 %x, i16 %y) {
+  %r = call i16 @llvm.uadd.sat.i16(i16 %x, i16 %y)
+  ret i16 %r
+}
+
+; CHECK-LABEL: define float @fma(
+; CHECK: %[[R:[0-9]+]] = call float @_Z3fmafff(float %x, float %y, float %z)
+; CHECK-NEXT: ret float %[[R]]
+define float @fma(float %x, float %y, float %z) {
+  %r = call float @llvm.fma.f32(float %x, float %y, float %z)
+  ret float %r
+}
+
+; vector types are substituted after their first occurrence
+; CHECK-LABEL: define <4 x i32> @max_v4(
+; CHECK: %[[R:[0-9]+]] = call <4 x i32> @_Z3maxDv4_iS_(<4 x i32> %x, <4 x i32> %y)
+; CHECK-NEXT: ret <4 x i32> %[[R]]
+define <4 x i32> @max_v4(<4 x i32> %x, <4 x i32> %y) {
+  %r = call <4 x i32> @llvm.smax.v4i32(<4 x i32> %x, <4 x i32> %y)
+  ret <4 x i32> %r
+}
+
+; CHECK-LABEL: define <4 x i32> @rotate_v4(
+; CHECK: %[[SHIFT:[0-9]+]] = urem <4 x i32> %s, <i32 32, i32 32, i32 32, i32 32>
+; CHECK: %[[R:[0-9]+]] = call <4 x i32> @_Z6rotateDv4_jS_(<4 x i32> %x, <4 x i32> %[[SHIFT]])
+; CHECK-NEXT: ret <4 x i32> %[[R]]
+define <4 x i32> @rotate_v4(<4 x i32> %x, <4 x i32> %s) {
+  %r = call <4 x i32> @llvm.fshl.v4i32(<4 x i32> %x, <4 x i32> %x, <4 x i32> %s)
+  ret <4 x i32> %r
+}
+
+; funnel shift of two different values: shift expansion, a zero shift returns the unshifted input
+; CHECK-LABEL: define i32 @funnel_shift_right(
+; CHECK: %[[SHIFT:[0-9]+]] = urem i32 %s, 32
+; CHECK-NEXT: %[[INV_SHIFT:[0-9]+]] = sub i32 32, %[[SHIFT]]
+; CHECK-DAG: %[[HI:[0-9]+]] = shl i32 %x, %[[INV_SHIFT]]
+; CHECK-DAG: %[[LO:[0-9]+]] = lshr i32 %y, %[[SHIFT]]
+; CHECK: %[[OR:[0-9]+]] = or i32 %[[HI]], %[[LO]]
+; CHECK-NEXT: %[[IS_ZERO:[0-9]+]] = icmp eq i32 %[[SHIFT]], 0
+; CHECK-NEXT: %[[R:[0-9]+]] = select i1 %[[IS_ZERO]], i32 %y, i32 %[[OR]]
+; CHECK-NEXT: ret i32 %[[R]]
+define i32 @funnel_shift_right(i32 %x, i32 %y, i32 %s) {
+  %r = call i32 @llvm.fshr.i32(i32 %x, i32 %y, i32 %s)
+  ret i32 %r
+}
+
+; tree reduction, an odd element is carried over to the next level
+; CHECK-LABEL: define i32 @reduce_add_v3(
+; CHECK: %[[E0:[0-9]+]] = extractelement <3 x i32> %v, i32 0
+; CHECK-NEXT: %[[E1:[0-9]+]] = extractelement <3 x i32> %v, i32 1
+; CHECK-NEXT: %[[E2:[0-9]+]] = extractelement <3 x i32> %v, i32 2
+; CHECK-NEXT: %[[A01:[0-9]+]] = add i32 %[[E0]], %[[E1]]
+; CHECK-NEXT: %[[A:[0-9]+]] = add i32 %[[A01]], %[[E2]]
+; CHECK-NEXT: ret i32 %[[A]]
+define i32 @reduce_add_v3(<3 x i32> %v) {
+  %r = call i32 @llvm.vector.reduce.add.v3i32(<3 x i32> %v)
+  ret i32 %r
+}
@@ -0,0 +1,136 @@
+; RUN: opt -enable-new-pm=0 -VulkanFinal -S < %s | FileCheck %s
+
+; Vulkan: intrinsics with a direct SPIR-V/GLSL.std.450 equivalent are kept,
+; everything else (clz, saturating ops, funnel shifts, reductions) is expanded.
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir64-unknown-unknown-vulkan"
+
+declare i32 @llvm.ctpop.i32(i32)
+declare i32 @llvm.ctlz.i32(i32, i1)
+declare i32 @llvm.sadd.sat.i32(i32, i32)
+declare i32 @llvm.ssub.sat.i32(i32, i32)
+declare i32 @llvm.fshl.i32(i32, i32, i32)
+declare i32 @llvm.vector.reduce.add.v4i32(<4 x i32>)
+declare float @llvm.vector.reduce.fadd.v2f32(float, <2 x float>)
+
+; CHECK-LABEL: define floor_kernel void @popcount(
+; CHECK: %r = call i32 @llvm.ctpop.i32(i32 %x)
+; CHECK-NEXT: store i32 %r, i32 addrspace(1)* %out
+define floor_kernel void @popcount(i32 addrspace(1)* %out, i32 %x) {
+  %r = call i32 @llvm.ctpop.i32(i32 %x)
+  store i32 %r, i32 addrspace(1)* %out
+  ret void
+}
+
+; clz(x) = bit width - popcount(x with the highest set bit smeared into all lower bits)
+; CHECK-LABEL: define floor_kernel void @clz(
+; CHECK: %[[S1:[0-9]+]] = lshr i32 %x, 1
+; CHECK-NEXT: %[[O1:[0-9]+]] = or i32 %x, %[[S1]]
+; CHECK-NEXT: %[[S2:[0-9]+]] = lshr i32 %[[O1]], 2
+; CHECK-NEXT: %[[O2:[0-9]+]] = or i32 %[[O1]], %[[S2]]
+; CHECK-NEXT: %[[S4:[0-9]+]] = lshr i32 %[[O2]], 4
+; CHECK-NEXT: %[[O4:[0-9]+]] = or i32 %[[O2]], %[[S4]]
+; CHECK-NEXT: %[[S8:[0-9]+]] = lshr i32 %[[O4]], 8
+; CHECK-NEXT: %[[O8:[0-9]+]] = or i32 %[[O4]], %[[S8]]
+; CHECK-NEXT: %[[S16:[0-9]+]] = lshr i32 %[[O8]], 16
+; CHECK-NEXT: %[[O16:[0-9]+]] = or i32 %[[O8]], %[[S16]]
+; CHECK-NEXT: %[[POP:[0-9]+]] = call i32 @llvm.ctpop.i32(i32 %[[O16]])
+; CHECK-NEXT: %[[R:[0-9]+]] = sub i32 32, %[[POP]]
+; CHECK-NEXT: store i32 %[[R]], i32 addrspace(1)* %out
+define floor_kernel void @clz(i32 addrspace(1)* %out, i32 %x) {
+  %r = call i32 @llvm.ctlz.i32(i32 %x, i1 false)
+  store i32 %r, i32 addrspace(1)* %out
+  ret void
+}
+
+; add overflow: the sign of the result differs from the signs of both inputs
+; CHECK-LABEL: define floor_kernel void @add_sat(
+; CHECK: %[[SUM:[0-9]+]] = add i32 %x, %y
+; CHECK-DAG: %[[XR:[0-9]+]] = xor i32 %x, %[[SUM]]
+; CHECK-DAG: %[[YR:[0-9]+]] = xor i32 %y, %[[SUM]]
+; CHECK: %[[OVF_BITS:[0-9]+]] = and i32 %[[XR]], %[[YR]]
+; CHECK-NEXT: %[[OVF:[0-9]+]] = icmp slt i32 %[[OVF_BITS]], 0
+; CHECK-NEXT: %[[NEG:[0-9]+]] = icmp slt i32 %x, 0
+; CHECK-NEXT: %[[SAT:[0-9]+]] = select i1 %[[NEG]], i32 -2147483648, i32 2147483647
+; CHECK-NEXT: %[[R:[0-9]+]] = select i1 %[[OVF]], i32 %[[SAT]], i32 %[[SUM]]
+; CHECK-NEXT: store i32 %[[R]], i32 addrspace(1)* %out
+define floor_kernel void @add_sat(i32 addrspace(1)* %out, i32 %x, i32 %y) {
+  %r = call i32 @llvm.sadd.sat.i32(i32 %x, i32 %y)
+  store i32 %r, i32 addrspace(1)* %out
+  ret void
+}
+
+; sub overflow: the inputs have different signs and the sign of the result differs from the lhs
+; CHECK-LABEL: define floor_kernel void @sub_sat(
+; CHECK: %[[DIFF:[0-9]+]] = sub i32 %x, %y
+; CHECK-DAG: %[[XY:[0-9]+]] = xor i32 %x, %y
+; CHECK-DAG: %[[XR:[0-9]+]] = xor i32 %x, %[[DIFF]]
+; CHECK: %[[OVF_BITS:[0-9]+]] = and i32 %[[XY]], %[[XR]]
+; CHECK-NEXT: %[[OVF:[0-9]+]] = icmp slt i32 %[[OVF_BITS]], 0
+; CHECK-NEXT: %[[NEG:[0-9]+]] = icmp slt i32 %x, 0
+; CHECK-NEXT: %[[SAT:[0-9]+]] = select i1 %[[NEG]], i32 -2147483648, i32 2147483647
+; CHECK-NEXT: %[[R:[0-9]+]] = select i1 %[[OVF]], i32 %[[SAT]], i32 %[[DIFF]]
+; CHECK-NEXT: store i32 %[[R]], i32 addrspace(1)* %out
+define floor_kernel void @sub_sat(i32 addrspace(1)* %out, i32 %x, i32 %y) {
+  %r = call i32 @llvm.ssub.sat.i32(i32 %x, i32 %y)
+  store i32 %r, i32 addrspace(1)* %out
+  ret void
+}
+
+; no rotate builtin: even rotates are expanded, a zero shift returns the unshifted input
+; CHECK-LABEL: define floor_kernel void @funnel_shift_left(
+; CHECK: %[[SHIFT:[0-9]+]] = urem i32 %s, 32
+; CHECK-NEXT: %[[INV_SHIFT:[0-9]+]] = sub i32 32, %[[SHIFT]]
+; CHECK-DAG: %[[HI:[0-9]+]] = shl i32 %x, %[[SHIFT]]
+; CHECK-DAG: %[[LO:[0-9]+]] = lshr i32 %x, %[[INV_SHIFT]]
+; CHECK: %[[OR:[0-9]+]] = or i32 %[[HI]], %[[LO]]
+; CHECK-NEXT: %[[IS_ZERO:[0-9]+]] = icmp eq i32 %[[SHIFT]], 0
+; CHECK-NEXT: %[[R:[0-9]+]] = select i1 %[[IS_ZERO]], i32 %x, i32 %[[OR]]
+; CHECK-NEXT: store i32 %[[R]], i32 addrspace(1)* %out
+define floor_kernel void @funnel_shift_left(i32 addrspace(1)* %out, i32 %x, i32 %s) {
+  %r = call i32 @llvm.fshl.i32(i32 %x, i32 %x, i32 %s)
+  store i32 %r, i32 addrspace(1)* %out
+  ret void
+}
+
+; CHECK-LABEL: define floor_kernel void @reduce_add(
+; CHECK: %[[E0:[0-9]+]] = extractelement <4 x i32> %v, i32 0
+; CHECK-NEXT: %[[E1:[0-9]+]] = extractelement <4 x i32> %v, i32 1
+; CHECK-NEXT: %[[E2:[0-9]+]] = extractelement <4 x i32> %v, i32 2
+; CHECK-NEXT: %[[E3:[0-9]+]] = extractelement <4 x i32> %v, i32 3
+; CHECK-NEXT: %[[A01:[0-9]+]] = add i32 %[[E0]], %[[E1]]
+; CHECK-NEXT: %[[A23:[0-9]+]] = add i32 %[[E2]], %[[E3]]
+; CHECK-NEXT: %[[A:[0-9]+]] = add i32 %[[A01]], %[[A23]]
+; CHECK-NEXT: store i32 %[[A]], i32 addrspace(1)* %out
+define floor_kernel void @reduce_add(i32 addrspace(1)* %out, <4 x i32> %v) {
+  %r = call i32 @llvm.vector.reduce.add.v4i32(<4 x i32> %v)
+  store i32 %r, i32 addrspace(1)* %out
+  ret void
+}
+
+; ordered: sequential, starting with the start value
+; CHECK-LABEL: define floor_kernel void @reduce_fadd_ordered(
+; CHECK: %[[E0:[0-9]+]] = extractelement <2 x float> %v, i32 0
+; CHECK-NEXT: %[[E1:[0-9]+]] = extractelement <2 x float> %v, i32 1
+; CHECK-NEXT: %[[A0:[0-9]+]] = fadd float %start, %[[E0]]
+; CHECK-NEXT: %[[A1:[0-9]+]] = fadd float %[[A0]], %[[E1]]
+; CHECK-NEXT: store float %[[A1]], float addrspace(1)* %out
+define floor_kernel void @reduce_fadd_ordered(float addrspace(1)* %out, float %start, <2 x float> %v) {
+  %r = call float @llvm.vector.reduce.fadd.v2f32(float %start, <2 x float> %v)
+  store float %r, float addrspace(1)* %out
+  ret void
+}
+
+; unordered: tree, the start value is added last
+; CHECK-LABEL: define floor_kernel void @reduce_fadd_unordered(
+; CHECK: %[[E0:[0-9]+]] = extractelement <2 x float> %v, i32 0
+; CHECK-NEXT: %[[E1:[0-9]+]] = extractelement <2 x float> %v, i32 1
+; CHECK-NEXT: %[[A01:[0-9]+]] = fadd reassoc float %[[E0]], %[[E1]]
+; CHECK-NEXT: %[[A:[0-9]+]] = fadd reassoc float %start, %[[A01]]
+; CHECK-NEXT: store float %[[A]], float addrspace(1)* %out
+define floor_kernel void @reduce_fadd_unordered(float addrspace(1)* %out, float %start, <2 x float> %v) {
+  %r = call reassoc float @llvm.vector.reduce.fadd.v2f32(float %start, <2 x float> %v)
+  store float %r, float addrspace(1)* %out
+  ret void
+}
@@ -0,0 +1,54 @@
+; RUN: opt -enable-new-pm=0 -KernelWorkGroupSizeVariants -floor-wg-size-variants=16x16x1 -S < %s | FileCheck %s
+; RUN: opt -enable-new-pm=0 -KernelWorkGroupSizeVariants -floor-wg-size-variants=16x16x1 -ConstantLocalSize -S < %s \
+; RUN:   | FileCheck %s --check-prefix=CONST
+
+; Kernels that already have a required work-group size (emitted as
+; reqd_work_group_size metadata by clang for all backends, including CUDA)
+; must not be cloned, since clang doesn't emit function info for them either.
+
+target datalayout = "e-i64:64-i128:128-v16:16-v32:32-n16:32:64"
+target triple = "nvptx64-nvidia-cuda"
+
+declare i32 @llvm.nvvm.read.ptx.sreg.ntid.x()
+
+; CHECK-LABEL: define floor_kernel void @fixed(
+; CHECK-SAME: !reqd_work_group_size ![[FIXED_WG:[0-9]+]]
+; CONST-LABEL: define floor_kernel void @fixed(
+; CONST: store i32 8, i32 addrspace(1)* %out
+define floor_kernel void @fixed(i32 addrspace(1)* %out) !reqd_work_group_size !3 {
+  %size = call i32 @llvm.nvvm.read.ptx.sreg.ntid.x()
+  store i32 %size, i32 addrspace(1)* %out
+  ret void
+}
+
+; CHECK-LABEL: define floor_kernel void @dynamic(
+; CHECK-NOT: !reqd_work_group_size
+; CHECK: call i32 @llvm.nvvm.read.ptx.sreg.ntid.x()
+; CHECK-NOT: @fixed__wg_
+; CONST-LABEL: define floor_kernel void @dynamic(
+; CONST: call i32 @llvm.nvvm.read.ptx.sreg.ntid.x()
+define floor_kernel void @dynamic(i32 addrspace(1)* %out) {
+  %size = call i32 @llvm.nvvm.read.ptx.sreg.ntid.x()
+  store i32 %size, i32 addrspace(1)* %out
+  ret void
+}
+
+; CHECK-LABEL: define floor_kernel void @dynamic__wg_16x16x1(
+; CHECK-SAME: !reqd_work_group_size ![[VARIANT_WG:[0-9]+]]
+; CONST-LABEL: define floor_kernel void @dynamic__wg_16x16x1(
+; CONST: store i32 16, i32 addrspace(1)* %out
+
+; CHECK: !nvvm.annotations = !{!0, !1, !2, ![[VARIANT_KERNEL:[0-9]+]], ![[VARIANT_X:[0-9]+]], ![[VARIANT_Y:[0-9]+]], ![[VARIANT_Z:[0-9]+]]}
+; CHECK-DAG: ![[FIXED_WG]] = !{i32 8, i32 8, i32 1}
+; CHECK-DAG: ![[VARIANT_WG]] = !{i32 16, i32 16, i32 1}
+; CHECK-DAG: ![[VARIANT_KERNEL]] = !{void (i32 addrspace(1)*)* @dynamic__wg_16x16x1, !"kernel", i32 1}
+; CHECK-DAG: ![[VARIANT_X]] = !{void (i32 addrspace(1)*)* @dynamic__wg_16x16x1, !"reqntidx", i32 16}
+; CHECK-DAG: ![[VARIANT_Y]] = !{void (i32 addrspace(1)*)* @dynamic__wg_16x16x1, !"reqntidy", i32 16}
+; CHECK-DAG: ![[VARIANT_Z]] = !{void (i32 addrspace(1)*)* @dynamic__wg_16x16x1, !"reqntidz", i32 1}
+
+!nvvm.annotations = !{!0, !1, !2}
+
+!0 = !{void (i32 addrspace(1)*)* @fixed, !"kernel", i32 1}
+!1 = !{void (i32 addrspace(1)*)* @fixed, !"reqntidx", i32 8}
+!2 = !{void (i32 addrspace(1)*)* @dynamic, !"kernel", i32 1}
+!3 = !{i32 8, i32 8, i32 1}
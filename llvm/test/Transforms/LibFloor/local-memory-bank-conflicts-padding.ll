@@ -0,0 +1,64 @@
+; RUN: opt -enable-new-pm=0 -LocalMemoryBankConflicts -floor-local-memory-force-padding -S < %s | FileCheck %s
+
+; Column accesses of a 32 x 32 float tile by 32 work-items have a 32-way bank
+; conflict, which is resolved by padding the innermost dimension by one element.
+; Padding changes the memory layout, so a tile that is also accessed through
+; pointer arithmetic on an element pointer (&tile[0][0] + k) must not be padded.
+
+target datalayout = "e-i64:64-i128:128-v16:16-v32:32-n16:32:64"
+target triple = "nvptx64-nvidia-cuda"
+
+@tile = internal addrspace(3) global [32 x [32 x float]] undef, align 4
+@flat_tile = internal addrspace(3) global [32 x [32 x float]] undef, align 4
+
+; CHECK-DAG: @tile = internal addrspace(3) global [32 x [33 x float]] undef, align 4
+; CHECK-DAG: @flat_tile = internal addrspace(3) global [32 x [32 x float]] undef, align 4
+
+; CHECK-LABEL: @transpose_tile(
+; CHECK: %row.ptr = getelementptr inbounds [32 x [33 x float]], [32 x [33 x float]] addrspace(3)* @tile, i32 0, i32 %c, i32 %lid
+; CHECK: %col.ptr = getelementptr inbounds [32 x [33 x float]], [32 x [33 x float]] addrspace(3)* @tile, i32 0, i32 %lid, i32 %c
+define void @transpose_tile(float* %in, float* %out, i32 %c) !reqd_work_group_size !0 {
+entry:
+  %lid = call i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+  %lid.ext = zext i32 %lid to i64
+  %in.ptr = getelementptr inbounds float, float* %in, i64 %lid.ext
+  %val = load float, float* %in.ptr, align 4
+  %row.ptr = getelementptr inbounds [32 x [32 x float]], [32 x [32 x float]] addrspace(3)* @tile, i32 0, i32 %c, i32 %lid
+  store float %val, float addrspace(3)* %row.ptr, align 4
+  call void @llvm.nvvm.barrier0()
+  %col.ptr = getelementptr inbounds [32 x [32 x float]], [32 x [32 x float]] addrspace(3)* @tile, i32 0, i32 %lid, i32 %c
+  %res = load float, float addrspace(3)* %col.ptr, align 4
+  %out.ptr = getelementptr inbounds float, float* %out, i64 %lid.ext
+  store float %res, float* %out.ptr, align 4
+  ret void
+}
+
+; CHECK-LABEL: @flattened_tile(
+; CHECK: %row.ptr = getelementptr inbounds [32 x [32 x float]], [32 x [32 x float]] addrspace(3)* @flat_tile, i32 0, i32 %c, i32 %lid
+; CHECK: %col.ptr = getelementptr inbounds [32 x [32 x float]], [32 x [32 x float]] addrspace(3)* @flat_tile, i32 0, i32 %lid, i32 %c
+; CHECK: %flat.base = getelementptr inbounds [32 x [32 x float]], [32 x [32 x float]] addrspace(3)* @flat_tile, i32 0, i32 0, i32 0
+; CHECK: %flat.ptr = getelementptr inbounds float, float addrspace(3)* %flat.base, i32 %k
+define void @flattened_tile(float* %in, float* %out, i32 %c, i32 %k) !reqd_work_group_size !0 {
+entry:
+  %lid = call i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+  %lid.ext = zext i32 %lid to i64
+  %in.ptr = getelementptr inbounds float, float* %in, i64 %lid.ext
+  %val = load float, float* %in.ptr, align 4
+  %row.ptr = getelementptr inbounds [32 x [32 x float]], [32 x [32 x float]] addrspace(3)* @flat_tile, i32 0, i32 %c, i32 %lid
+  store float %val, float addrspace(3)* %row.ptr, align 4
+  call void @llvm.nvvm.barrier0()
+  %col.ptr = getelementptr inbounds [32 x [32 x float]], [32 x [32 x float]] addrspace(3)* @flat_tile, i32 0, i32 %lid, i32 %c
+  %res = load float, float addrspace(3)* %col.ptr, align 4
+  %flat.base = getelementptr inbounds [32 x [32 x float]], [32 x [32 x float]] addrspace(3)* @flat_tile, i32 0, i32 0, i32 0
+  %flat.ptr = getelementptr inbounds float, float addrspace(3)* %flat.base, i32 %k
+  %flat = load float, float addrspace(3)* %flat.ptr, align 4
+  %sum = fadd float %res, %flat
+  %out.ptr = getelementptr inbounds float, float* %out, i64 %lid.ext
+  store float %sum, float* %out.ptr, align 4
+  ret void
+}
+
+declare i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+declare void @llvm.nvvm.barrier0()
+
+!0 = !{i32 32, i32 1, i32 1}
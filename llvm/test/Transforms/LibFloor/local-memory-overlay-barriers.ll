@@ -0,0 +1,133 @@
+; RUN: opt -enable-new-pm=0 -LocalMemoryOverlay -S < %s | FileCheck %s
+; RUN: opt -enable-new-pm=0 -LocalMemoryOverlay -S < %s | FileCheck %s --check-prefix=NOSPLIT
+
+; Local memory variables may only share memory if a barrier that orders local
+; memory accesses lies between them. Barriers that only fence global memory or
+; whose fence flags are unknown must not split the barrier regions.
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir64-unknown-unknown"
+
+; CHECK-DAG: @cl_local_fence.local_mem_overlay = internal addrspace(3) global [256 x i8] undef, align 4
+; CHECK-DAG: @cl_local_global_fence.local_mem_overlay = internal addrspace(3) global [256 x i8] undef, align 4
+; CHECK-DAG: @air_threadgroup_fence.local_mem_overlay = internal addrspace(3) global [256 x i8] undef, align 4
+; CHECK-DAG: @nvvm_barrier.local_mem_overlay = internal addrspace(3) global [256 x i8] undef, align 4
+
+; NOSPLIT-DAG: @cl_global_fence.a = internal addrspace(3) global [64 x i32] undef
+; NOSPLIT-DAG: @cl_global_fence.b = internal addrspace(3) global [64 x i32] undef
+; NOSPLIT-DAG: @cl_dynamic_fence.a = internal addrspace(3) global [64 x i32] undef
+; NOSPLIT-DAG: @cl_dynamic_fence.b = internal addrspace(3) global [64 x i32] undef
+; NOSPLIT-DAG: @air_device_fence.a = internal addrspace(3) global [64 x i32] undef
+; NOSPLIT-DAG: @air_device_fence.b = internal addrspace(3) global [64 x i32] undef
+; NOSPLIT-DAG: @floor_barrier.a = internal addrspace(3) global [64 x i32] undef
+; NOSPLIT-DAG: @floor_barrier.b = internal addrspace(3) global [64 x i32] undef
+; NOSPLIT-NOT: @cl_global_fence.local_mem_overlay
+; NOSPLIT-NOT: @cl_dynamic_fence.local_mem_overlay
+; NOSPLIT-NOT: @air_device_fence.local_mem_overlay
+; NOSPLIT-NOT: @floor_barrier.local_mem_overlay
+
+@cl_local_fence.a = internal addrspace(3) global [64 x i32] undef, align 4
+@cl_local_fence.b = internal addrspace(3) global [64 x i32] undef, align 4
+@cl_local_global_fence.a = internal addrspace(3) global [64 x i32] undef, align 4
+@cl_local_global_fence.b = internal addrspace(3) global [64 x i32] undef, align 4
+@cl_global_fence.a = internal addrspace(3) global [64 x i32] undef, align 4
+@cl_global_fence.b = internal addrspace(3) global [64 x i32] undef, align 4
+@cl_dynamic_fence.a = internal addrspace(3) global [64 x i32] undef, align 4
+@cl_dynamic_fence.b = internal addrspace(3) global [64 x i32] undef, align 4
+@air_threadgroup_fence.a = internal addrspace(3) global [64 x i32] undef, align 4
+@air_threadgroup_fence.b = internal addrspace(3) global [64 x i32] undef, align 4
+@air_device_fence.a = internal addrspace(3) global [64 x i32] undef, align 4
+@air_device_fence.b = internal addrspace(3) global [64 x i32] undef, align 4
+@nvvm_barrier.a = internal addrspace(3) global [64 x i32] undef, align 4
+@nvvm_barrier.b = internal addrspace(3) global [64 x i32] undef, align 4
+@floor_barrier.a = internal addrspace(3) global [64 x i32] undef, align 4
+@floor_barrier.b = internal addrspace(3) global [64 x i32] undef, align 4
+
+declare void @_Z7barrierj(i32)
+declare void @air.wg.barrier(i32, i32)
+declare void @llvm.nvvm.barrier0()
+declare void @floor.barrier()
+
+; CLK_LOCAL_MEM_FENCE
+; CHECK-LABEL: @cl_local_fence(
+; CHECK: store i32 %val, i32 addrspace(3)* {{.*}}@cl_local_fence.local_mem_overlay
+; CHECK: call void @_Z7barrierj(i32 1)
+; CHECK: store i32 %val, i32 addrspace(3)* {{.*}}@cl_local_fence.local_mem_overlay
+define floor_kernel void @cl_local_fence(i32 %val) {
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @cl_local_fence.a, i32 0, i32 0)
+  call void @_Z7barrierj(i32 1)
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @cl_local_fence.b, i32 0, i32 0)
+  ret void
+}
+
+; CLK_LOCAL_MEM_FENCE | CLK_GLOBAL_MEM_FENCE
+; CHECK-LABEL: @cl_local_global_fence(
+; CHECK: call void @_Z7barrierj(i32 3)
+define floor_kernel void @cl_local_global_fence(i32 %val) {
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @cl_local_global_fence.a, i32 0, i32 0)
+  call void @_Z7barrierj(i32 3)
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @cl_local_global_fence.b, i32 0, i32 0)
+  ret void
+}
+
+; CLK_GLOBAL_MEM_FENCE only: no split
+; NOSPLIT-LABEL: @cl_global_fence(
+; NOSPLIT: store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @cl_global_fence.a, i32 0, i32 0)
+; NOSPLIT: call void @_Z7barrierj(i32 2)
+; NOSPLIT: store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @cl_global_fence.b, i32 0, i32 0)
+define floor_kernel void @cl_global_fence(i32 %val) {
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @cl_global_fence.a, i32 0, i32 0)
+  call void @_Z7barrierj(i32 2)
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @cl_global_fence.b, i32 0, i32 0)
+  ret void
+}
+
+; non-constant fence flags: no split
+; NOSPLIT-LABEL: @cl_dynamic_fence(
+; NOSPLIT: call void @_Z7barrierj(i32 %flags)
+define floor_kernel void @cl_dynamic_fence(i32 %val, i32 %flags) {
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @cl_dynamic_fence.a, i32 0, i32 0)
+  call void @_Z7barrierj(i32 %flags)
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @cl_dynamic_fence.b, i32 0, i32 0)
+  ret void
+}
+
+; mem_flags::mem_threadgroup
+; CHECK-LABEL: @air_threadgroup_fence(
+; CHECK: call void @air.wg.barrier(i32 2, i32 1)
+define floor_kernel void @air_threadgroup_fence(i32 %val) {
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @air_threadgroup_fence.a, i32 0, i32 0)
+  call void @air.wg.barrier(i32 2, i32 1)
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @air_threadgroup_fence.b, i32 0, i32 0)
+  ret void
+}
+
+; mem_flags::mem_device only: no split
+; NOSPLIT-LABEL: @air_device_fence(
+; NOSPLIT: call void @air.wg.barrier(i32 1, i32 1)
+define floor_kernel void @air_device_fence(i32 %val) {
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @air_device_fence.a, i32 0, i32 0)
+  call void @air.wg.barrier(i32 1, i32 1)
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @air_device_fence.b, i32 0, i32 0)
+  ret void
+}
+
+; bar.sync always orders shared memory
+; CHECK-LABEL: @nvvm_barrier(
+; CHECK: call void @llvm.nvvm.barrier0()
+define floor_kernel void @nvvm_barrier(i32 %val) {
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @nvvm_barrier.a, i32 0, i32 0)
+  call void @llvm.nvvm.barrier0()
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @nvvm_barrier.b, i32 0, i32 0)
+  ret void
+}
+
+; unknown fence semantics: no split
+; NOSPLIT-LABEL: @floor_barrier(
+; NOSPLIT: call void @floor.barrier()
+define floor_kernel void @floor_barrier(i32 %val) {
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @floor_barrier.a, i32 0, i32 0)
+  call void @floor.barrier()
+  store i32 %val, i32 addrspace(3)* getelementptr inbounds ([64 x i32], [64 x i32] addrspace(3)* @floor_barrier.b, i32 0, i32 0)
+  ret void
+}
@@ -0,0 +1,122 @@
+; RUN: opt -enable-new-pm=0 -PromotePrivateArrays -mtriple=air64-apple-macosx14.0.0 -S < %s | FileCheck %s --check-prefixes=CHECK,VEC,METAL
+; RUN: opt -enable-new-pm=0 -PromotePrivateArrays -mtriple=spir64-unknown-unknown -S < %s | FileCheck %s --check-prefixes=CHECK,VEC,SPIR
+; RUN: opt -enable-new-pm=0 -PromotePrivateArrays -mtriple=spir64-unknown-unknown-vulkan -S < %s | FileCheck %s --check-prefixes=CHECK,VEC,VULKAN
+; RUN: opt -enable-new-pm=0 -PromotePrivateArrays -mtriple=nvptx64-nvidia-cuda -S < %s | FileCheck %s --check-prefixes=CHECK,CUDA
+
+; Dynamically indexed private arrays are promoted out of private memory:
+;  * up to 4 elements: a vector with dynamic extract/insertelement (not CUDA)
+;  * within the register budget: one value per element, accessed via select chains
+;  * otherwise, with a required work-group size: a local memory array indexed
+;    by the array index and the linear local id
+
+; only @local_memory fits into local memory
+; CHECK: @local_memory.arr.local = internal addrspace(3) global [32 x [64 x float]] undef, align 4
+
+; CHECK-LABEL: define floor_kernel void @vector(
+; CHECK-NOT: alloca
+; VEC: %[[VEC:[0-9]+]] = insertelement <4 x float> undef, float %a, i32 %i
+; VEC-NEXT: %v = extractelement <4 x float> %[[VEC]], i32 %j
+; VEC-NEXT: store float %v, float addrspace(1)* %out
+; CUDA-NOT: extractelement
+; CUDA: %[[CMP:[0-9]+]] = icmp eq i32 %i, 0
+; CUDA-NEXT: select i1 %[[CMP]], float %a, float undef
+; CUDA: %v = select i1
+; CUDA-NEXT: store float %v, float addrspace(1)* %out
+define floor_kernel void @vector(float addrspace(1)* %out, i32 %i, i32 %j, float %a) {
+  %arr = alloca [4 x float], align 4
+  %p = getelementptr inbounds [4 x float], [4 x float]* %arr, i32 0, i32 %i
+  store float %a, float* %p, align 4
+  %q = getelementptr inbounds [4 x float], [4 x float]* %arr, i32 0, i32 %j
+  %v = load float, float* %q, align 4
+  store float %v, float addrspace(1)* %out, align 4
+  ret void
+}
+
+; nested arrays are flattened, a dynamic store writes every element,
+; a dynamic load selects between all elements, constant indices access the element directly
+; CHECK-LABEL: define floor_kernel void @scalars(
+; CHECK-NOT: alloca
+; CHECK: %[[MUL:[0-9]+]] = mul i32 %i, 3
+; CHECK-NEXT: %[[STORE_IDX:[0-9]+]] = add i32 %[[MUL]], 1
+; CHECK-NEXT: %[[CMP0:[0-9]+]] = icmp eq i32 %[[STORE_IDX]], 0
+; CHECK-NEXT: %[[E0:[0-9]+]] = select i1 %[[CMP0]], i32 %a, i32 undef
+; CHECK-NEXT: %[[CMP1:[0-9]+]] = icmp eq i32 %[[STORE_IDX]], 1
+; CHECK-NEXT: %[[E1:[0-9]+]] = select i1 %[[CMP1]], i32 %a, i32 undef
+; CHECK-NEXT: %[[CMP2:[0-9]+]] = icmp eq i32 %[[STORE_IDX]], 2
+; CHECK-NEXT: %[[E2:[0-9]+]] = select i1 %[[CMP2]], i32 %a, i32 undef
+; CHECK-NEXT: %[[CMP3:[0-9]+]] = icmp eq i32 %[[STORE_IDX]], 3
+; CHECK-NEXT: %[[E3:[0-9]+]] = select i1 %[[CMP3]], i32 %a, i32 undef
+; CHECK-NEXT: %[[CMP4:[0-9]+]] = icmp eq i32 %[[STORE_IDX]], 4
+; CHECK-NEXT: %[[E4:[0-9]+]] = select i1 %[[CMP4]], i32 %a, i32 undef
+; CHECK-NEXT: %[[CMP5:[0-9]+]] = icmp eq i32 %[[STORE_IDX]], 5
+; CHECK-NEXT: %[[E5:[0-9]+]] = select i1 %[[CMP5]], i32 %a, i32 undef
+; CHECK-NEXT: %[[LOAD_IDX:[0-9]+]] = add i32 3, %j
+; CHECK-NEXT: %[[LCMP1:[0-9]+]] = icmp eq i32 %[[LOAD_IDX]], 1
+; CHECK-NEXT: %[[L1:[0-9]+]] = select i1 %[[LCMP1]], i32 %[[E1]], i32 %[[E0]]
+; CHECK-NEXT: %[[LCMP2:[0-9]+]] = icmp eq i32 %[[LOAD_IDX]], 2
+; CHECK-NEXT: %[[L2:[0-9]+]] = select i1 %[[LCMP2]], i32 %[[E2]], i32 %[[L1]]
+; CHECK-NEXT: %[[LCMP3:[0-9]+]] = icmp eq i32 %[[LOAD_IDX]], 3
+; CHECK-NEXT: %[[L3:[0-9]+]] = select i1 %[[LCMP3]], i32 %[[E3]], i32 %[[L2]]
+; CHECK-NEXT: %[[LCMP4:[0-9]+]] = icmp eq i32 %[[LOAD_IDX]], 4
+; CHECK-NEXT: %[[L4:[0-9]+]] = select i1 %[[LCMP4]], i32 %[[E4]], i32 %[[L3]]
+; CHECK-NEXT: %[[LCMP5:[0-9]+]] = icmp eq i32 %[[LOAD_IDX]], 5
+; CHECK-NEXT: %v = select i1 %[[LCMP5]], i32 %[[E5]], i32 %[[L4]]
+; CHECK-NEXT: %sum = add i32 %v, %[[E5]]
+; CHECK-NEXT: store i32 %sum, i32 addrspace(1)* %out
+define floor_kernel void @scalars(i32 addrspace(1)* %out, i32 %i, i32 %j, i32 %a) {
+  %arr = alloca [2 x [3 x i32]], align 4
+  %p = getelementptr inbounds [2 x [3 x i32]], [2 x [3 x i32]]* %arr, i32 0, i32 %i, i32 1
+  store i32 %a, i32* %p, align 4
+  %q = getelementptr inbounds [2 x [3 x i32]], [2 x [3 x i32]]* %arr, i32 0, i32 1, i32 %j
+  %v = load i32, i32* %q, align 4
+  %r = getelementptr inbounds [2 x [3 x i32]], [2 x [3 x i32]]* %arr, i32 0, i32 1, i32 2
+  %w = load i32, i32* %r, align 4
+  %sum = add i32 %v, %w
+  store i32 %sum, i32 addrspace(1)* %out, align 4
+  ret void
+}
+
+; too large for registers -> [elements x [work-group size x float]] in local memory
+; CHECK-LABEL: define floor_kernel void @local_memory(
+; METAL: %[[LID_X:[0-9]+]] = call i32 @floor.get_local_id.i32(i32 0)
+; METAL-NEXT: %[[LID_Y:[0-9]+]] = call i32 @floor.get_local_id.i32(i32 1)
+; SPIR: %[[LID_X_SIZE:[0-9]+]] = call i64 @_Z12get_local_idj(i32 0)
+; SPIR-NEXT: %[[LID_X:[0-9]+]] = trunc i64 %[[LID_X_SIZE]] to i32
+; SPIR-NEXT: %[[LID_Y_SIZE:[0-9]+]] = call i64 @_Z12get_local_idj(i32 1)
+; SPIR-NEXT: %[[LID_Y:[0-9]+]] = trunc i64 %[[LID_Y_SIZE]] to i32
+; VULKAN: %[[LID_X:[0-9]+]] = call i32 @floor.builtin.local_id.i32(i32 0)
+; VULKAN-NEXT: %[[LID_Y:[0-9]+]] = call i32 @floor.builtin.local_id.i32(i32 1)
+; CUDA: %[[LID_X:[0-9]+]] = call i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+; CUDA-NEXT: %[[LID_Y:[0-9]+]] = call i32 @llvm.nvvm.read.ptx.sreg.tid.y()
+; CHECK-NEXT: %[[LID_Y_OFFSET:[0-9]+]] = mul nuw i32 %[[LID_Y]], 8
+; CHECK-NEXT: %linear_local_id = add nuw i32 %[[LID_X]], %[[LID_Y_OFFSET]]
+; CHECK-NOT: alloca
+; CHECK: %[[P:[0-9]+]] = getelementptr inbounds [32 x [64 x float]], [32 x [64 x float]] addrspace(3)* @local_memory.arr.local, i32 0, i32 %i, i32 %linear_local_id
+; CHECK-NEXT: store float %a, float addrspace(3)* %[[P]], align 4
+; CHECK-NEXT: %[[Q:[0-9]+]] = getelementptr inbounds [32 x [64 x float]], [32 x [64 x float]] addrspace(3)* @local_memory.arr.local, i32 0, i32 %j, i32 %linear_local_id
+; CHECK-NEXT: %v = load float, float addrspace(3)* %[[Q]], align 4
+; CHECK-NEXT: store float %v, float addrspace(1)* %out
+define floor_kernel void @local_memory(float addrspace(1)* %out, i32 %i, i32 %j, float %a) !reqd_work_group_size !0 {
+  %arr = alloca [32 x float], align 4
+  %p = getelementptr inbounds [32 x float], [32 x float]* %arr, i32 0, i32 %i
+  store float %a, float* %p, align 4
+  %q = getelementptr inbounds [32 x float], [32 x float]* %arr, i32 0, i32 %j
+  %v = load float, float* %q, align 4
+  store float %v, float addrspace(1)* %out, align 4
+  ret void
+}
+
+; no required work-group size -> stays in private memory
+; CHECK-LABEL: define floor_kernel void @no_wg_size(
+; CHECK: %arr = alloca [32 x float], align 4
+define floor_kernel void @no_wg_size(float addrspace(1)* %out, i32 %i, i32 %j, float %a) {
+  %arr = alloca [32 x float], align 4
+  %p = getelementptr inbounds [32 x float], [32 x float]* %arr, i32 0, i32 %i
+  store float %a, float* %p, align 4
+  %q = getelementptr inbounds [32 x float], [32 x float]* %arr, i32 0, i32 %j
+  %v = load float, float* %q, align 4
+  store float %v, float addrspace(1)* %out, align 4
+  ret void
+}
+
+!0 = !{i32 8, i32 8, i32 1}
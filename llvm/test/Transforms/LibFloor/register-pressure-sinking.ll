@@ -0,0 +1,160 @@
+; RUN: opt -enable-new-pm=0 -RegisterPressureSinking -mtriple=air64-apple-macosx14.0.0 -S < %s | FileCheck %s
+; RUN: opt -enable-new-pm=0 -RegisterPressureSinking -mtriple=spir64-unknown-unknown-vulkan -S < %s | FileCheck %s
+
+; In all functions, %a and %b (2 x 32 registers) are live through a loop, which
+; exceeds the default register target of 64. Cheap values are rematerialized and
+; constant loads are sunk next to their uses, but never into another loop.
+
+declare floor_func void @floor.loop_merge(label, label, i32)
+declare floor_func void @floor.merge_block()
+declare floor_func void @floor.continue_block()
+
+; CHECK-LABEL: define void @remat(
+; CHECK: entry:
+; CHECK-NOT: mul
+; CHECK: exit:
+; CHECK-NEXT: store <32 x i32> %acc.next, <32 x i32> addrspace(1)* %out
+; CHECK-NEXT: %y.remat = mul i32 %x, 3
+; CHECK-NEXT: %r = add i32 %y.remat, %x
+define void @remat(<32 x i32> addrspace(1)* %in, <32 x i32> addrspace(1)* %out, i32 addrspace(1)* %out2, i32 %x, i32 %n) {
+entry:
+  %a = load <32 x i32>, <32 x i32> addrspace(1)* %in
+  %b.ptr = getelementptr <32 x i32>, <32 x i32> addrspace(1)* %in, i64 1
+  %b = load <32 x i32>, <32 x i32> addrspace(1)* %b.ptr
+  %y = mul i32 %x, 3
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi <32 x i32> [ zeroinitializer, %entry ], [ %acc.next, %loop ]
+  %t = add <32 x i32> %acc, %a
+  %acc.next = add <32 x i32> %t, %b
+  %i.next = add i32 %i, 1
+  %cond = icmp ult i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  store <32 x i32> %acc.next, <32 x i32> addrspace(1)* %out
+  %r = add i32 %y, %x
+  store i32 %r, i32 addrspace(1)* %out2
+  ret void
+}
+
+; the pointer (2 registers) is kept live instead of the loaded value (4 registers)
+; CHECK-LABEL: define void @sink_load(
+; CHECK: entry:
+; CHECK-NOT: addrspace(2)
+; CHECK: exit:
+; CHECK-NEXT: store <32 x i32> %acc.next, <32 x i32> addrspace(1)* %out
+; CHECK-NEXT: %c = load <4 x i32>, <4 x i32> addrspace(2)* %cptr
+; CHECK-NEXT: store <4 x i32> %c, <4 x i32> addrspace(1)* %out2
+define void @sink_load(<32 x i32> addrspace(1)* %in, <32 x i32> addrspace(1)* %out, <4 x i32> addrspace(2)* %cptr, <4 x i32> addrspace(1)* %out2, i32 %n) {
+entry:
+  %a = load <32 x i32>, <32 x i32> addrspace(1)* %in
+  %b.ptr = getelementptr <32 x i32>, <32 x i32> addrspace(1)* %in, i64 1
+  %b = load <32 x i32>, <32 x i32> addrspace(1)* %b.ptr
+  %c = load <4 x i32>, <4 x i32> addrspace(2)* %cptr
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi <32 x i32> [ zeroinitializer, %entry ], [ %acc.next, %loop ]
+  %t = add <32 x i32> %acc, %a
+  %acc.next = add <32 x i32> %t, %b
+  %i.next = add i32 %i, 1
+  %cond = icmp ult i32 %i.next, %n
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  store <32 x i32> %acc.next, <32 x i32> addrspace(1)* %out
+  store <4 x i32> %c, <4 x i32> addrspace(1)* %out2
+  ret void
+}
+
+; %y and %c are defined in %loop1 and used in the sibling loop %loop2 (same loop depth)
+; -> must not be rematerialized/sunk into %loop2
+; CHECK-LABEL: define void @sibling_loops(
+; CHECK: loop1:
+; CHECK: %y = mul i32 %x, 3
+; CHECK: %c = load <4 x i32>, <4 x i32> addrspace(2)* %cptr
+; CHECK: loop2:
+; CHECK-NOT: remat
+; CHECK-NOT: load <4 x i32>
+; CHECK: exit:
+define void @sibling_loops(<32 x i32> addrspace(1)* %in, <32 x i32> addrspace(1)* %out, <4 x i32> addrspace(2)* %cptr, <4 x i32> addrspace(1)* %out2, i32 addrspace(1)* %out3, i32 %x, i32 %n) {
+entry:
+  %a = load <32 x i32>, <32 x i32> addrspace(1)* %in
+  %b.ptr = getelementptr <32 x i32>, <32 x i32> addrspace(1)* %in, i64 1
+  %b = load <32 x i32>, <32 x i32> addrspace(1)* %b.ptr
+  br label %loop1
+
+loop1:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop1 ]
+  %y = mul i32 %x, 3
+  %c = load <4 x i32>, <4 x i32> addrspace(2)* %cptr
+  %i.next = add i32 %i, 1
+  %cond1 = icmp ult i32 %i.next, %n
+  br i1 %cond1, label %loop1, label %loop2
+
+loop2:
+  %j = phi i32 [ 0, %loop1 ], [ %j.next, %loop2 ]
+  %acc = phi <32 x i32> [ zeroinitializer, %loop1 ], [ %acc.next, %loop2 ]
+  %t = add <32 x i32> %acc, %a
+  %acc.next = add <32 x i32> %t, %b
+  %s = add i32 %y, %x
+  store i32 %s, i32 addrspace(1)* %out3
+  store <4 x i32> %c, <4 x i32> addrspace(1)* %out2
+  %j.next = add i32 %j, 1
+  %cond2 = icmp ult i32 %j.next, %n
+  br i1 %cond2, label %loop2, label %exit
+
+exit:
+  store <32 x i32> %acc.next, <32 x i32> addrspace(1)* %out
+  ret void
+}
+
+; structured CFG: %y is only used by a phi in %exit -> rematerialized at the end of the merge block,
+; but in front of the merge block marker
+; CHECK-LABEL: define void @merge_marker(
+; CHECK: entry:
+; CHECK-NOT: mul
+; CHECK: merge:
+; CHECK-NEXT: store <32 x i32> %acc, <32 x i32> addrspace(1)* %out
+; CHECK-NEXT: %y.remat = mul i32 %x, 3
+; CHECK-NEXT: call floor_func void @floor.merge_block()
+; CHECK-NEXT: br label %exit
+; CHECK: exit:
+; CHECK-NEXT: %p = phi i32 [ %y.remat, %merge ]
+define void @merge_marker(<32 x i32> addrspace(1)* %in, <32 x i32> addrspace(1)* %out, i32 addrspace(1)* %out2, i32 %x, i32 %n) {
+entry:
+  %a = load <32 x i32>, <32 x i32> addrspace(1)* %in
+  %b.ptr = getelementptr <32 x i32>, <32 x i32> addrspace(1)* %in, i64 1
+  %b = load <32 x i32>, <32 x i32> addrspace(1)* %b.ptr
+  %y = mul i32 %x, 3
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %continue ]
+  %acc = phi <32 x i32> [ zeroinitializer, %entry ], [ %acc.next, %continue ]
+  %cond = icmp ult i32 %i, %n
+  call floor_func void @floor.loop_merge(label %merge, label %continue, i32 0)
+  br i1 %cond, label %continue, label %merge
+
+continue:
+  %t = add <32 x i32> %acc, %a
+  %acc.next = add <32 x i32> %t, %b
+  %i.next = add i32 %i, 1
+  call floor_func void @floor.continue_block()
+  br label %header
+
+merge:
+  store <32 x i32> %acc, <32 x i32> addrspace(1)* %out
+  call floor_func void @floor.merge_block()
+  br label %exit
+
+exit:
+  %p = phi i32 [ %y, %merge ]
+  %r = add i32 %p, %x
+  store i32 %r, i32 addrspace(1)* %out2
+  ret void
+}
@@ -0,0 +1,135 @@
+; RUN: opt -enable-new-pm=0 -RelaxedPrecisionDemotion -S < %s | FileCheck %s
+
+; Float dataflow feeding into low precision normalized image writes is demoted
+; to half, as long as the error bound of the written value stays below half of
+; the quantization step of the image format. Demoted values must only be used by
+; other demoted values or the sink.
+
+target triple = "air64-apple-macosx14.0.0"
+
+; image types: 2D, 4 channels, normalized uint, 8-bit/10-bit/16-bit
+; RGBA8 unorm  = 1073930251
+; RGBA10 unorm = 1073930253
+; RGBA16 unorm = 1073930258
+
+declare <4 x float> @floor.opaque.read_image.f.i2(i8 addrspace(1)*, i32, i64, <2 x i32>)
+declare void @floor.opaque.write_image.f.i2(i8 addrspace(1)*, i64, <2 x i32>, i32, i32, i1, <4 x float>)
+
+; error bound: 3 * 2^-11 < 0.5 / 255
+; CHECK-LABEL: define void @blend_rgba8(
+; CHECK: %[[A:[0-9]+]] = fptrunc <4 x float> %a to <4 x half>
+; CHECK-NEXT: %m.half = fmul <4 x half> %[[A]], <half 0xH3800, half 0xH3800, half 0xH3800, half 0xH3800>
+; CHECK-NEXT: %[[B:[0-9]+]] = fptrunc <4 x float> %b to <4 x half>
+; CHECK-NEXT: %n.half = fmul <4 x half> %[[B]], <half 0xH3800, half 0xH3800, half 0xH3800, half 0xH3800>
+; CHECK-NEXT: %s.half = fadd <4 x half> %m.half, %n.half
+; CHECK-NEXT: %[[S:[0-9]+]] = fpext <4 x half> %s.half to <4 x float>
+; CHECK-NEXT: call void @floor.opaque.write_image.f.i2(i8 addrspace(1)* %out, i64 1073930251, <2 x i32> %coord, i32 0, i32 0, i1 false, <4 x float> %[[S]])
+define void @blend_rgba8(i8 addrspace(1)* %img_a, i8 addrspace(1)* %img_b, i8 addrspace(1)* %out, <2 x i32> %coord) {
+  %a = call <4 x float> @floor.opaque.read_image.f.i2(i8 addrspace(1)* %img_a, i32 0, i64 1073930251, <2 x i32> %coord)
+  %b = call <4 x float> @floor.opaque.read_image.f.i2(i8 addrspace(1)* %img_b, i32 0, i64 1073930251, <2 x i32> %coord)
+  %m = fmul <4 x float> %a, <float 0.5, float 0.5, float 0.5, float 0.5>
+  %n = fmul <4 x float> %b, <float 0.5, float 0.5, float 0.5, float 0.5>
+  %s = fadd <4 x float> %m, %n
+  call void @floor.opaque.write_image.f.i2(i8 addrspace(1)* %out, i64 1073930251, <2 x i32> %coord, i32 0, i32 0, i1 false, <4 x float> %s)
+  ret void
+}
+
+; same as above, but the error bound exceeds 0.5 / 1023
+; CHECK-LABEL: define void @blend_rgba10(
+; CHECK-NOT: half
+; CHECK: ret void
+define void @blend_rgba10(i8 addrspace(1)* %img_a, i8 addrspace(1)* %img_b, i8 addrspace(1)* %out, <2 x i32> %coord) {
+  %a = call <4 x float> @floor.opaque.read_image.f.i2(i8 addrspace(1)* %img_a, i32 0, i64 1073930253, <2 x i32> %coord)
+  %b = call <4 x float> @floor.opaque.read_image.f.i2(i8 addrspace(1)* %img_b, i32 0, i64 1073930253, <2 x i32> %coord)
+  %m = fmul <4 x float> %a, <float 0.5, float 0.5, float 0.5, float 0.5>
+  %n = fmul <4 x float> %b, <float 0.5, float 0.5, float 0.5, float 0.5>
+  %s = fadd <4 x float> %m, %n
+  call void @floor.opaque.write_image.f.i2(i8 addrspace(1)* %out, i64 1073930253, <2 x i32> %coord, i32 0, i32 0, i1 false, <4 x float> %s)
+  ret void
+}
+
+; 16-bit images are not a sink
+; CHECK-LABEL: define void @blend_rgba16(
+; CHECK-NOT: half
+; CHECK: ret void
+define void @blend_rgba16(i8 addrspace(1)* %img_a, i8 addrspace(1)* %out, <2 x i32> %coord) {
+  %a = call <4 x float> @floor.opaque.read_image.f.i2(i8 addrspace(1)* %img_a, i32 0, i64 1073930251, <2 x i32> %coord)
+  %m = fmul <4 x float> %a, <float 0.5, float 0.5, float 0.5, float 0.5>
+  call void @floor.opaque.write_image.f.i2(i8 addrspace(1)* %out, i64 1073930258, <2 x i32> %coord, i32 0, i32 0, i1 false, <4 x float> %m)
+  ret void
+}
+
+; within the half range, but the cancellation amplifies the rounding error of a * 2048 (ulp 2)
+; CHECK-LABEL: define void @cancellation(
+; CHECK-NOT: half
+; CHECK: ret void
+define void @cancellation(i8 addrspace(1)* %img_a, i8 addrspace(1)* %img_b, i8 addrspace(1)* %out, <2 x i32> %coord) {
+  %a = call <4 x float> @floor.opaque.read_image.f.i2(i8 addrspace(1)* %img_a, i32 0, i64 1073930251, <2 x i32> %coord)
+  %b = call <4 x float> @floor.opaque.read_image.f.i2(i8 addrspace(1)* %img_b, i32 0, i64 1073930251, <2 x i32> %coord)
+  %m = fmul <4 x float> %a, <float 2048.0, float 2048.0, float 2048.0, float 2048.0>
+  %n = fmul <4 x float> %b, <float 2047.0, float 2047.0, float 2047.0, float 2047.0>
+  %s = fsub <4 x float> %m, %n
+  call void @floor.opaque.write_image.f.i2(i8 addrspace(1)* %out, i64 1073930251, <2 x i32> %coord, i32 0, i32 0, i1 false, <4 x float> %s)
+  ret void
+}
+
+; %m is also stored to memory -> stays float and is converted where it is used by a demoted value
+; CHECK-LABEL: define void @pruning(
+; CHECK: %m = fmul <4 x float> %a, <float 5.000000e-01, float 5.000000e-01, float 5.000000e-01, float 5.000000e-01>
+; CHECK-NEXT: store <4 x float> %m, <4 x float> addrspace(1)* %buf
+; CHECK-NEXT: %[[B:[0-9]+]] = fptrunc <4 x float> %b to <4 x half>
+; CHECK-NEXT: %n.half = fmul <4 x half> %[[B]], <half 0xH3800, half 0xH3800, half 0xH3800, half 0xH3800>
+; CHECK-NEXT: %[[M:[0-9]+]] = fptrunc <4 x float> %m to <4 x half>
+; CHECK-NEXT: %s.half = fadd <4 x half> %[[M]], %n.half
+; CHECK-NEXT: %[[S:[0-9]+]] = fpext <4 x half> %s.half to <4 x float>
+; CHECK-NEXT: call void @floor.opaque.write_image.f.i2(i8 addrspace(1)* %out, i64 1073930251, <2 x i32> %coord, i32 0, i32 0, i1 false, <4 x float> %[[S]])
+define void @pruning(i8 addrspace(1)* %img_a, i8 addrspace(1)* %img_b, i8 addrspace(1)* %out, <4 x float> addrspace(1)* %buf, <2 x i32> %coord) {
+  %a = call <4 x float> @floor.opaque.read_image.f.i2(i8 addrspace(1)* %img_a, i32 0, i64 1073930251, <2 x i32> %coord)
+  %b = call <4 x float> @floor.opaque.read_image.f.i2(i8 addrspace(1)* %img_b, i32 0, i64 1073930251, <2 x i32> %coord)
+  %m = fmul <4 x float> %a, <float 0.5, float 0.5, float 0.5, float 0.5>
+  store <4 x float> %m, <4 x float> addrspace(1)* %buf
+  %n = fmul <4 x float> %b, <float 0.5, float 0.5, float 0.5, float 0.5>
+  %s = fadd <4 x float> %m, %n
+  call void @floor.opaque.write_image.f.i2(i8 addrspace(1)* %out, i64 1073930251, <2 x i32> %coord, i32 0, i32 0, i1 false, <4 x float> %s)
+  ret void
+}
+
+; values extended from half are used directly, selects are exact
+; CHECK-LABEL: define void @half_leaf(
+; CHECK: %sel.half = select i1 %c, <4 x half> %h, <4 x half> zeroinitializer
+; CHECK-NEXT: %[[SEL:[0-9]+]] = fpext <4 x half> %sel.half to <4 x float>
+; CHECK-NEXT: call void @floor.opaque.write_image.f.i2(i8 addrspace(1)* %out, i64 1073930251, <2 x i32> %coord, i32 0, i32 0, i1 false, <4 x float> %[[SEL]])
+define void @half_leaf(i8 addrspace(1)* %out, <2 x i32> %coord, <4 x half> %h, i1 %c) {
+  %e = fpext <4 x half> %h to <4 x float>
+  %sel = select i1 %c, <4 x float> %e, <4 x float> zeroinitializer
+  call void @floor.opaque.write_image.f.i2(i8 addrspace(1)* %out, i64 1073930251, <2 x i32> %coord, i32 0, i32 0, i1 false, <4 x float> %sel)
+  ret void
+}
+
+; phis are rebuilt in half, leaf conversions of incoming values are placed at the end of the incoming block
+; CHECK-LABEL: define void @phi(
+; CHECK: entry:
+; CHECK: %[[A_ENTRY:[0-9]+]] = fptrunc <4 x float> %a to <4 x half>
+; CHECK-NEXT: br i1 %c, label %then, label %merge
+; CHECK: then:
+; CHECK-NEXT: %[[A_THEN:[0-9]+]] = fptrunc <4 x float> %a to <4 x half>
+; CHECK-NEXT: %x.half = fmul <4 x half> %[[A_THEN]], <half 0xH3400, half 0xH3400, half 0xH3400, half 0xH3400>
+; CHECK-NEXT: br label %merge
+; CHECK: merge:
+; CHECK-NEXT: %p.half = phi <4 x half> [ %x.half, %then ], [ %[[A_ENTRY]], %entry ]
+; CHECK-NEXT: %[[P:[0-9]+]] = fpext <4 x half> %p.half to <4 x float>
+; CHECK-NEXT: call void @floor.opaque.write_image.f.i2(i8 addrspace(1)* %out, i64 1073930251, <2 x i32> %coord, i32 0, i32 0, i1 false, <4 x float> %[[P]])
+define void @phi(i8 addrspace(1)* %img_a, i8 addrspace(1)* %out, <2 x i32> %coord, i1 %c) {
+entry:
+  %a = call <4 x float> @floor.opaque.read_image.f.i2(i8 addrspace(1)* %img_a, i32 0, i64 1073930251, <2 x i32> %coord)
+  br i1 %c, label %then, label %merge
+
+then:
+  %x = fmul <4 x float> %a, <float 0.25, float 0.25, float 0.25, float 0.25>
+  br label %merge
+
+merge:
+  %p = phi <4 x float> [ %x, %then ], [ %a, %entry ]
+  call void @floor.opaque.write_image.f.i2(i8 addrspace(1)* %out, i64 1073930251, <2 x i32> %coord, i32 0, i32 0, i1 false, <4 x float> %p)
+  ret void
+}
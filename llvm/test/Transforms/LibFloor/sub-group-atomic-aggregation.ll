@@ -0,0 +1,72 @@
+; RUN: opt -enable-new-pm=0 -SubGroupAtomicAggregation -S < %s | FileCheck %s
+; REQUIRES: nvptx-registered-target
+
+target datalayout = "e-i64:64-i128:128-v16:16-v32:32-n16:32:64"
+target triple = "nvptx64-nvidia-cuda"
+
+declare i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+
+; Uniform address and value: only the leader performs the atomic, its result
+; is broadcast to the other lanes.
+; CHECK-LABEL: @uniform_add(
+; CHECK: %active_mask = call i32 asm sideeffect "activemask.b32 $0;", "=r"()
+; CHECK: %leader = call i32 @llvm.cttz.i32(i32 %active_mask, i1 true)
+; CHECK: %[[IS_LEADER:.*]] = icmp eq i32 %lane_id, %leader
+; CHECK: br i1 %[[IS_LEADER]]
+; CHECK: atomicrmw add i32 addrspace(1)* %ptr, i32 %{{.*}} monotonic
+; CHECK: call i32 @llvm.nvvm.shfl.sync.idx.i32(i32 %active_mask, i32 %{{.*}}, i32 %leader, i32 31)
+define void @uniform_add(i32 addrspace(1)* %ptr, i32 %val, i32 addrspace(1)* %out) {
+  %old = atomicrmw add i32 addrspace(1)* %ptr, i32 %val monotonic
+  %tid = call i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+  %idx = zext i32 %tid to i64
+  %out.ptr = getelementptr inbounds i32, i32 addrspace(1)* %out, i64 %idx
+  store i32 %old, i32 addrspace(1)* %out.ptr
+  ret void
+}
+
+; Divergent values are reduced with redux.sync if the old value is unused.
+; CHECK-LABEL: @divergent_add(
+; CHECK: %[[SUM:.*]] = call i32 @llvm.nvvm.redux.sync.add(i32 %tid, i32 %active_mask)
+; CHECK: atomicrmw add i32 addrspace(1)* %ptr, i32 %[[SUM]] monotonic
+define void @divergent_add(i32 addrspace(1)* %ptr) #0 {
+  %tid = call i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+  %old = atomicrmw add i32 addrspace(1)* %ptr, i32 %tid monotonic
+  ret void
+}
+
+; Atomics with acquire/release semantics must be performed by every lane.
+; CHECK-LABEL: @ordered_add(
+; CHECK-NOT: activemask
+; CHECK: atomicrmw add i32 addrspace(1)* %ptr, i32 %val acquire
+; CHECK-NOT: activemask
+; CHECK: atomicrmw or i32 addrspace(1)* %ptr, i32 %val release
+; CHECK-NOT: activemask
+; CHECK: atomicrmw xor i32 addrspace(1)* %ptr, i32 %val seq_cst
+; CHECK-NOT: activemask
+; CHECK: ret void
+define void @ordered_add(i32 addrspace(1)* %ptr, i32 %val) {
+  %a = atomicrmw add i32 addrspace(1)* %ptr, i32 %val acquire
+  %b = atomicrmw or i32 addrspace(1)* %ptr, i32 %val release
+  %c = atomicrmw xor i32 addrspace(1)* %ptr, i32 %val seq_cst
+  ret void
+}
+
+; Divergent addresses are not aggregated.
+; CHECK-LABEL: @divergent_address(
+; CHECK-NOT: activemask
+; CHECK: atomicrmw add i32 addrspace(1)* %gep, i32 1 monotonic
+define void @divergent_address(i32 addrspace(1)* %ptr) {
+  %tid = call i32 @llvm.nvvm.read.ptx.sreg.tid.x()
+  %idx = zext i32 %tid to i64
+  %gep = getelementptr inbounds i32, i32 addrspace(1)* %ptr, i64 %idx
+  %old = atomicrmw add i32 addrspace(1)* %gep, i32 1 monotonic
+  ret void
+}
+
+attributes #0 = { "target-cpu"="sm_80" }
+
+!nvvm.annotations = !{!0, !1, !2, !3}
+!0 = !{void (i32 addrspace(1)*, i32, i32 addrspace(1)*)* @uniform_add, !"kernel", i32 1}
+!1 = !{void (i32 addrspace(1)*)* @divergent_add, !"kernel", i32 1}
+!2 = !{void (i32 addrspace(1)*, i32)* @ordered_add, !"kernel", i32 1}
+!3 = !{void (i32 addrspace(1)*)* @divergent_address, !"kernel", i32 1}
@@ -0,0 +1,157 @@
+; RUN: opt -enable-new-pm=0 -VulkanStructuredCleanup -S < %s | FileCheck %s
+
+; The cleanup must keep the structured CFG intact: merge/continue blocks and
+; their markers survive (even if unreachable), markers stay directly in front of
+; the terminator, and no block is merged across a marker.
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir64-unknown-unknown-vulkan"
+
+declare floor_func void @floor.loop_merge(label, label, i32)
+declare floor_func void @floor.selection_merge(label, i32)
+declare floor_func void @floor.merge_block()
+declare floor_func void @floor.continue_block()
+
+; CHECK-LABEL: @loop(
+; CHECK: entry:
+; CHECK-NEXT: call floor_func void @floor.selection_merge(label %pre, i32 0)
+; CHECK-NEXT: br i1 %c, label %then, label %pre
+; CHECK: then:
+; CHECK-NEXT: br label %pre
+; loop invariants are hoisted in front of the merge block marker of the preheader
+; CHECK: pre:
+; CHECK-NEXT: %inv = mul i32 %a, %b
+; CHECK-NEXT: call floor_func void @floor.merge_block()
+; CHECK-NEXT: br label %header
+; CHECK: header:
+; CHECK-NEXT: %i = phi i32 [ 0, %pre ], [ %i.next, %continue ]
+; CHECK-NEXT: %cmp = icmp slt i32 %i, %n
+; CHECK-NEXT: call floor_func void @floor.loop_merge(label %merge, label %continue, i32 0)
+; CHECK-NEXT: br i1 %cmp, label %body, label %merge
+; the ladder block is merged into the body
+; CHECK: body:
+; CHECK-NEXT: %idx = zext i32 %i to i64
+; CHECK-NEXT: %ptr = getelementptr inbounds i32, i32 addrspace(1)* %out, i64 %idx
+; CHECK-NEXT: store i32 %inv, i32 addrspace(1)* %ptr, align 4
+; CHECK-NEXT: br label %continue
+; CHECK-NOT: ladder:
+; the continue block has a single predecessor, but must not be merged
+; CHECK: continue:
+; CHECK-NEXT: %i.next = add i32 %i, 1
+; CHECK-NEXT: call floor_func void @floor.continue_block()
+; CHECK-NEXT: br label %header
+; nothing may be merged into a block ending in a marker
+; CHECK: merge:
+; CHECK-NEXT: call floor_func void @floor.merge_block()
+; CHECK-NEXT: br label %exit
+; CHECK: exit:
+; CHECK-NEXT: ret void
+define floor_kernel void @loop(i32 addrspace(1)* %out, i1 %c, i32 %n, i32 %a, i32 %b) {
+entry:
+  call floor_func void @floor.selection_merge(label %pre, i32 0)
+  br i1 %c, label %then, label %pre
+
+then:
+  br label %pre
+
+pre:
+  call floor_func void @floor.merge_block()
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %pre ], [ %i.next, %continue ]
+  %cmp = icmp slt i32 %i, %n
+  call floor_func void @floor.loop_merge(label %merge, label %continue, i32 0)
+  br i1 %cmp, label %body, label %merge
+
+body:
+  %inv = mul i32 %a, %b
+  %idx = zext i32 %i to i64
+  %ptr = getelementptr inbounds i32, i32 addrspace(1)* %out, i64 %idx
+  store i32 %inv, i32 addrspace(1)* %ptr, align 4
+  br label %ladder
+
+ladder:
+  br label %continue
+
+continue:
+  %i.next = add i32 %i, 1
+  call floor_func void @floor.continue_block()
+  br label %header
+
+merge:
+  call floor_func void @floor.merge_block()
+  br label %exit
+
+exit:
+  ret void
+}
+
+; CHECK-LABEL: @selection(
+; CHECK: entry:
+; CHECK-NEXT: call floor_func void @floor.selection_merge(label %merge, i32 0)
+; CHECK-NEXT: br i1 %c, label %then, label %merge
+; CHECK: then:
+; CHECK-NEXT: store i32 %x, i32 addrspace(1)* %out, align 4
+; CHECK-NEXT: br label %merge
+; CHECK-NOT: then.ladder:
+; trivial PHIs are removed and identical PHIs are merged
+; CHECK: merge:
+; CHECK-NEXT: %sel = phi i32 [ 1, %then ], [ 2, %entry ]
+; CHECK-NEXT: %sum = add i32 %x, %sel
+; CHECK-NEXT: %sum2 = add i32 %sum, %sel
+; CHECK-NEXT: store i32 %sum2, i32 addrspace(1)* %out, align 4
+; CHECK-NEXT: call floor_func void @floor.merge_block()
+; CHECK-NEXT: ret void
+; unreferenced dead blocks are removed
+; CHECK-NOT: dead:
+; CHECK: }
+define floor_kernel void @selection(i32 addrspace(1)* %out, i1 %c, i32 %x) {
+entry:
+  call floor_func void @floor.selection_merge(label %merge, i32 0)
+  br i1 %c, label %then, label %merge
+
+then:
+  br label %then.ladder
+
+then.ladder:
+  store i32 %x, i32 addrspace(1)* %out, align 4
+  br label %merge
+
+merge:
+  %triv = phi i32 [ %x, %then.ladder ], [ %x, %entry ]
+  %sel = phi i32 [ 1, %then.ladder ], [ 2, %entry ]
+  %sel.dup = phi i32 [ 1, %then.ladder ], [ 2, %entry ]
+  %sum = add i32 %triv, %sel
+  %sum2 = add i32 %sum, %sel.dup
+  store i32 %sum2, i32 addrspace(1)* %out, align 4
+  call floor_func void @floor.merge_block()
+  ret void
+
+dead:
+  ret void
+}
+
+; an unreachable merge block is referenced by its header marker and must survive
+; CHECK-LABEL: @unreachable_merge(
+; CHECK: entry:
+; CHECK-NEXT: call floor_func void @floor.selection_merge(label %merge, i32 0)
+; CHECK-NEXT: br i1 %c, label %then, label %else
+; CHECK: merge:
+; CHECK-NEXT: call floor_func void @floor.merge_block()
+; CHECK-NEXT: unreachable
+define floor_kernel void @unreachable_merge(i1 %c) {
+entry:
+  call floor_func void @floor.selection_merge(label %merge, i32 0)
+  br i1 %c, label %then, label %else
+
+then:
+  ret void
+
+else:
+  ret void
+
+merge:
+  call floor_func void @floor.merge_block()
+  unreachable
+}
@@ -0,0 +1,217 @@
+; RUN: opt -vector-library=LLVMLibc-X86 -passes=inject-tli-mappings,loop-vectorize -force-vector-width=4 -force-vector-interleave=1 -mattr=avx512f -S < %s | FileCheck %s --check-prefix=VF4
+; RUN: opt -vector-library=LLVMLibc-X86 -passes=inject-tli-mappings,loop-vectorize -force-vector-width=8 -force-vector-interleave=1 -mattr=avx512f -S < %s | FileCheck %s --check-prefix=VF8
+; RUN: opt -vector-library=LLVMLibc-X86 -passes=inject-tli-mappings,loop-vectorize -force-vector-width=16 -force-vector-interleave=1 -mattr=avx512f -S < %s | FileCheck %s --check-prefix=VF16
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+declare float @expf(float) #0
+declare float @exp2f(float) #0
+declare float @logf(float) #0
+declare float @log2f(float) #0
+declare float @sinf(float) #0
+declare float @cosf(float) #0
+declare float @llvm.exp.f32(float) #0
+declare float @llvm.cos.f32(float) #0
+
+; VF4-LABEL: @expf_f32(
+; VF4: call <4 x float> @_ZGVbN4v_expf(<4 x float>
+; VF8-LABEL: @expf_f32(
+; VF8: call <8 x float> @_ZGVdN8v_expf(<8 x float>
+; VF16-LABEL: @expf_f32(
+; VF16: call <16 x float> @_ZGVeN16v_expf(<16 x float>
+define void @expf_f32(float* nocapture %varray) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.body ]
+  %tmp = trunc i64 %iv to i32
+  %conv = sitofp i32 %tmp to float
+  %call = tail call float @expf(float %conv)
+  %arrayidx = getelementptr inbounds float, float* %varray, i64 %iv
+  store float %call, float* %arrayidx, align 4
+  %iv.next = add nuw nsw i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 1000
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; VF4-LABEL: @exp2f_f32(
+; VF4: call <4 x float> @_ZGVbN4v_exp2f(<4 x float>
+; VF8-LABEL: @exp2f_f32(
+; VF8: call <8 x float> @_ZGVdN8v_exp2f(<8 x float>
+; VF16-LABEL: @exp2f_f32(
+; VF16: call <16 x float> @_ZGVeN16v_exp2f(<16 x float>
+define void @exp2f_f32(float* nocapture %varray) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.body ]
+  %tmp = trunc i64 %iv to i32
+  %conv = sitofp i32 %tmp to float
+  %call = tail call float @exp2f(float %conv)
+  %arrayidx = getelementptr inbounds float, float* %varray, i64 %iv
+  store float %call, float* %arrayidx, align 4
+  %iv.next = add nuw nsw i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 1000
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; VF4-LABEL: @logf_f32(
+; VF4: call <4 x float> @_ZGVbN4v_logf(<4 x float>
+; VF8-LABEL: @logf_f32(
+; VF8: call <8 x float> @_ZGVdN8v_logf(<8 x float>
+; VF16-LABEL: @logf_f32(
+; VF16: call <16 x float> @_ZGVeN16v_logf(<16 x float>
+define void @logf_f32(float* nocapture %varray) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.body ]
+  %tmp = trunc i64 %iv to i32
+  %conv = sitofp i32 %tmp to float
+  %call = tail call float @logf(float %conv)
+  %arrayidx = getelementptr inbounds float, float* %varray, i64 %iv
+  store float %call, float* %arrayidx, align 4
+  %iv.next = add nuw nsw i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 1000
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; VF4-LABEL: @log2f_f32(
+; VF4: call <4 x float> @_ZGVbN4v_log2f(<4 x float>
+; VF8-LABEL: @log2f_f32(
+; VF8: call <8 x float> @_ZGVdN8v_log2f(<8 x float>
+; VF16-LABEL: @log2f_f32(
+; VF16: call <16 x float> @_ZGVeN16v_log2f(<16 x float>
+define void @log2f_f32(float* nocapture %varray) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.body ]
+  %tmp = trunc i64 %iv to i32
+  %conv = sitofp i32 %tmp to float
+  %call = tail call float @log2f(float %conv)
+  %arrayidx = getelementptr inbounds float, float* %varray, i64 %iv
+  store float %call, float* %arrayidx, align 4
+  %iv.next = add nuw nsw i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 1000
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; VF4-LABEL: @sinf_f32(
+; VF4: call <4 x float> @_ZGVbN4v_sinf(<4 x float>
+; VF8-LABEL: @sinf_f32(
+; VF8: call <8 x float> @_ZGVdN8v_sinf(<8 x float>
+; VF16-LABEL: @sinf_f32(
+; VF16: call <16 x float> @_ZGVeN16v_sinf(<16 x float>
+define void @sinf_f32(float* nocapture %varray) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.body ]
+  %tmp = trunc i64 %iv to i32
+  %conv = sitofp i32 %tmp to float
+  %call = tail call float @sinf(float %conv)
+  %arrayidx = getelementptr inbounds float, float* %varray, i64 %iv
+  store float %call, float* %arrayidx, align 4
+  %iv.next = add nuw nsw i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 1000
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; VF4-LABEL: @cosf_f32(
+; VF4: call <4 x float> @_ZGVbN4v_cosf(<4 x float>
+; VF8-LABEL: @cosf_f32(
+; VF8: call <8 x float> @_ZGVdN8v_cosf(<8 x float>
+; VF16-LABEL: @cosf_f32(
+; VF16: call <16 x float> @_ZGVeN16v_cosf(<16 x float>
+define void @cosf_f32(float* nocapture %varray) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.body ]
+  %tmp = trunc i64 %iv to i32
+  %conv = sitofp i32 %tmp to float
+  %call = tail call float @cosf(float %conv)
+  %arrayidx = getelementptr inbounds float, float* %varray, i64 %iv
+  store float %call, float* %arrayidx, align 4
+  %iv.next = add nuw nsw i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 1000
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; VF4-LABEL: @exp_f32_intrinsic(
+; VF4: call <4 x float> @_ZGVbN4v_expf(<4 x float>
+; VF8-LABEL: @exp_f32_intrinsic(
+; VF8: call <8 x float> @_ZGVdN8v_expf(<8 x float>
+; VF16-LABEL: @exp_f32_intrinsic(
+; VF16: call <16 x float> @_ZGVeN16v_expf(<16 x float>
+define void @exp_f32_intrinsic(float* nocapture %varray) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.body ]
+  %tmp = trunc i64 %iv to i32
+  %conv = sitofp i32 %tmp to float
+  %call = tail call float @llvm.exp.f32(float %conv)
+  %arrayidx = getelementptr inbounds float, float* %varray, i64 %iv
+  store float %call, float* %arrayidx, align 4
+  %iv.next = add nuw nsw i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 1000
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; VF4-LABEL: @cos_f32_intrinsic(
+; VF4: call <4 x float> @_ZGVbN4v_cosf(<4 x float>
+; VF8-LABEL: @cos_f32_intrinsic(
+; VF8: call <8 x float> @_ZGVdN8v_cosf(<8 x float>
+; VF16-LABEL: @cos_f32_intrinsic(
+; VF16: call <16 x float> @_ZGVeN16v_cosf(<16 x float>
+define void @cos_f32_intrinsic(float* nocapture %varray) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.body ]
+  %tmp = trunc i64 %iv to i32
+  %conv = sitofp i32 %tmp to float
+  %call = tail call float @llvm.cos.f32(float %conv)
+  %arrayidx = getelementptr inbounds float, float* %varray, i64 %iv
+  store float %call, float* %arrayidx, align 4
+  %iv.next = add nuw nsw i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 1000
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+attributes #0 = { nounwind readnone }
@@ -79,7 +79,9 @@ static cl::opt<DebugCompressionType> CompressDebugSections(
                clEnumValN(DebugCompressionType::Z, "zlib",
                           "Use zlib compression"),
                clEnumValN(DebugCompressionType::GNU, "zlib-gnu",
-                          "Use zlib-gnu compression (deprecated)")),
+                          "Use zlib-gnu compression (deprecated)"),
+               clEnumValN(DebugCompressionType::Zstd, "zstd",
+                          "Use zstd compression")),
     cl::cat(MCCategory));
 
 static cl::opt<bool>
@@ -402,7 +404,14 @@ int main(int argc, char **argv) {
 
   MAI->setRelaxELFRelocations(RelaxELFRel);
 
-  if (CompressDebugSections != DebugCompressionType::None) {
+  if (CompressDebugSections == DebugCompressionType::Zstd) {
+    if (!zstd::isAvailable()) {
+      WithColor::error(errs(), ProgName)
+          << "build tools with zstd to enable -compress-debug-sections=zstd";
+      return 1;
+    }
+    MAI->setCompressDebugSections(CompressDebugSections);
+  } else if (CompressDebugSections != DebugCompressionType::None) {
     if (!zlib::isAvailable()) {
       WithColor::error(errs(), ProgName)
           << "build tools with zlib to enable -compress-debug-sections";
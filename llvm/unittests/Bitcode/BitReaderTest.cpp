@@ -15,10 +15,12 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -255,4 +257,54 @@ TEST(BitReaderTest, MaterializeFunctionsForBlockAddrInFunctionAfter) {
   EXPECT_FALSE(verifyModule(*M, &dbgs()));
 }
 
+static std::string materializeAndPrint(const char *Assembly,
+                                       bool ParallelDecoding) {
+  auto &Opts = cl::getRegisteredOptions();
+  auto *ParallelDecodingOpt = static_cast<cl::opt<bool> *>(
+      Opts["bitcode-parallel-function-decoding"]);
+  EXPECT_NE(ParallelDecodingOpt, nullptr);
+  ParallelDecodingOpt->setValue(ParallelDecoding);
+
+  SmallString<1024> Mem;
+  LLVMContext Context;
+  std::unique_ptr<Module> M = getLazyModuleFromAssembly(Context, Mem, Assembly);
+  EXPECT_FALSE(M->materializeAll());
+  ParallelDecodingOpt->setValue(false);
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+
+  std::string Str;
+  raw_string_ostream OS(Str);
+  M->print(OS, nullptr);
+  return OS.str();
+}
+
+TEST(BitReaderTest, MaterializeAllParallelFunctionDecoding) {
+  // Function bodies with constants, value symbol tables, metadata attachments
+  // and blockaddress forward references.
+  const char *Assembly = "@g = global i32 0\n"
+                         "define i32 @f(i32 %a) {\n"
+                         "entry:\n"
+                         "  %b = add i32 %a, 1234567\n"
+                         "  %c = load i32, i32* @g, !range !0\n"
+                         "  %d = mul i32 %b, %c\n"
+                         "  ret i32 %d\n"
+                         "}\n"
+                         "define i8* @before() {\n"
+                         "  ret i8* blockaddress(@func, %bb)\n"
+                         "}\n"
+                         "define void @func() {\n"
+                         "  unreachable\n"
+                         "bb:\n"
+                         "  unreachable\n"
+                         "}\n"
+                         "define double @h(double %x) {\n"
+                         "  %y = fmul double %x, 3.5\n"
+                         "  %z = call i32 @f(i32 7)\n"
+                         "  ret double %y\n"
+                         "}\n"
+                         "!0 = !{i32 0, i32 10}\n";
+  EXPECT_EQ(materializeAndPrint(Assembly, true),
+            materializeAndPrint(Assembly, false));
+}
+
 } // end namespace
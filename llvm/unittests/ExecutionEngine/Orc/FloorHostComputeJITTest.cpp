@@ -0,0 +1,135 @@
+//===------ FloorHostComputeJITTest.cpp - FloorHostComputeJIT tests -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ExecutionEngine/Orc/FloorHostComputeJIT.h"
+#include "OrcTestCommon.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Testing/Support/Error.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace llvm::orc;
+
+namespace {
+
+class FloorHostComputeJITTest : public testing::Test {
+public:
+  static void SetUpTestCase() {
+    OrcNativeTarget::initialize();
+    // Disable these tests if no JIT can be created for the host.
+    auto J = FloorHostComputeJIT::Create();
+    if (!J) {
+      consumeError(J.takeError());
+      return;
+    }
+    const Triple &TT = (*J)->getLLJIT().getTargetTriple();
+    TargetSupported = !TT.isARM() && !(TT.isOSAIX() && TT.isPPC64());
+  }
+
+  void SetUp() override {
+    if (!TargetSupported)
+      GTEST_SKIP();
+    ASSERT_FALSE(sys::fs::createUniqueDirectory("floor-hc-jit-cache", CacheDir));
+  }
+
+  void TearDown() override {
+    if (!CacheDir.empty())
+      sys::fs::remove_directories(CacheDir);
+  }
+
+protected:
+  /// Returns a module with a "kernel" function that returns \p Value.
+  static ThreadSafeModule createKernelModule(int Value) {
+    auto Ctx = std::make_unique<LLVMContext>();
+    SMDiagnostic Err;
+    std::string Source = "define i32 @kernel() {\n"
+                         "  ret i32 " +
+                         std::to_string(Value) +
+                         "\n"
+                         "}\n";
+    auto M = parseIR(MemoryBufferRef(Source, "kernel"), Err, *Ctx);
+    EXPECT_TRUE(M);
+    return ThreadSafeModule(std::move(M), std::move(Ctx));
+  }
+
+  /// Compiles (or loads) a kernel module that returns \p Value and runs it.
+  Expected<int> runKernel(int Value, StringRef Dir) {
+    FloorHostComputeJIT::Options Opts;
+    Opts.CacheDir = Dir.str();
+    auto J = FloorHostComputeJIT::Create(std::move(Opts));
+    if (!J)
+      return J.takeError();
+    if (auto Err = (*J)->addModule(createKernelModule(Value)))
+      return std::move(Err);
+    auto Kernel = (*J)->getKernel("kernel");
+    if (!Kernel)
+      return Kernel.takeError();
+    return reinterpret_cast<int (*)()>(*Kernel)();
+  }
+
+  /// Returns the paths of all cached objects in \p Dir.
+  static std::vector<std::string> getCachedObjects(StringRef Dir) {
+    std::vector<std::string> Objects;
+    std::error_code EC;
+    for (sys::fs::directory_iterator It(Dir, EC), End; It != End && !EC;
+         It.increment(EC)) {
+      if (sys::path::extension(It->path()) == ".o")
+        Objects.push_back(It->path());
+    }
+    return Objects;
+  }
+
+  static bool TargetSupported;
+  SmallString<128> CacheDir;
+};
+
+bool FloorHostComputeJITTest::TargetSupported = false;
+
+TEST_F(FloorHostComputeJITTest, CompileWithoutCache) {
+  EXPECT_THAT_EXPECTED(runKernel(42, ""), HasValue(42));
+  EXPECT_TRUE(getCachedObjects(CacheDir).empty());
+}
+
+TEST_F(FloorHostComputeJITTest, CacheMissAndHit) {
+  // Miss: the object is compiled and stored in the cache.
+  EXPECT_THAT_EXPECTED(runKernel(42, CacheDir), HasValue(42));
+  auto Objects = getCachedObjects(CacheDir);
+  ASSERT_EQ(Objects.size(), 1u);
+
+  // A different module is a miss as well and gets its own cache entry.
+  EXPECT_THAT_EXPECTED(runKernel(7, CacheDir), HasValue(7));
+  auto AllObjects = getCachedObjects(CacheDir);
+  ASSERT_EQ(AllObjects.size(), 2u);
+  std::string Object7 =
+      AllObjects[0] == Objects[0] ? AllObjects[1] : AllObjects[0];
+
+  // Hit: replace the cached object of the first module with the one of the
+  // second module, which is then used instead of compiling the first module.
+  ASSERT_FALSE(sys::fs::copy_file(Object7, Objects[0]));
+  EXPECT_THAT_EXPECTED(runKernel(42, CacheDir), HasValue(7));
+  EXPECT_EQ(getCachedObjects(CacheDir).size(), 2u);
+}
+
+TEST_F(FloorHostComputeJITTest, CacheKey) {
+  auto J = FloorHostComputeJIT::Create();
+  ASSERT_THAT_EXPECTED(J, Succeeded());
+  auto TSM42 = createKernelModule(42);
+  auto TSM42Again = createKernelModule(42);
+  auto TSM7 = createKernelModule(7);
+  std::string Key42 = (*J)->getCacheKey(*TSM42.getModuleUnlocked());
+  EXPECT_EQ(Key42, (*J)->getCacheKey(*TSM42Again.getModuleUnlocked()));
+  EXPECT_NE(Key42, (*J)->getCacheKey(*TSM7.getModuleUnlocked()));
+}
+
+} // end anonymous namespace
@@ -45,6 +45,35 @@ TEST(VerifierTest, Branch_i1) {
   EXPECT_TRUE(verifyFunction(*F));
 }
 
+TEST(VerifierTest, VerifyFunctions) {
+  LLVMContext C;
+  Module M("M", C);
+  FunctionType *FTy = FunctionType::get(Type::getVoidTy(C), /*isVarArg=*/false);
+  SmallVector<const Function *, 8> Fs;
+  for (unsigned I = 0; I < 8; ++I) {
+    Function *F = Function::Create(FTy, Function::ExternalLinkage,
+                                   "foo" + Twine(I), M);
+    ReturnInst::Create(C, BasicBlock::Create(C, "entry", F));
+    Fs.push_back(F);
+  }
+
+  EXPECT_FALSE(verifyFunctions(Fs));
+  EXPECT_FALSE(verifyModuleGlobals(M));
+
+  // Break a single function: a block without a terminator.
+  Function *Broken = const_cast<Function *>(Fs[5]);
+  BasicBlock::Create(C, "noterm", Broken);
+
+  std::string Error;
+  raw_string_ostream ErrorOS(Error);
+  EXPECT_TRUE(verifyFunctions(Fs, &ErrorOS));
+  EXPECT_TRUE(StringRef(ErrorOS.str()).contains("foo5"));
+  EXPECT_FALSE(StringRef(Error).contains("foo4"));
+
+  // The module-level IR is still valid.
+  EXPECT_FALSE(verifyModuleGlobals(M));
+}
+
 TEST(VerifierTest, Freeze) {
   LLVMContext C;
   Module M("M", C);
@@ -16,6 +16,7 @@
 #include "llvm/Config/config.h"
 #include "llvm/Support/Error.h"
 #include "gtest/gtest.h"
+#include <string>
 
 using namespace llvm;
 
@@ -71,6 +72,65 @@ TEST(CompressionTest, ZlibCRC32) {
       zlib::crc32(StringRef("The quick brown fox jumps over the lazy dog")));
 }
 
+TEST(CompressionTest, ZlibChunked) {
+  std::string Input;
+  for (size_t i = 0; i < 10000; ++i)
+    Input += "chunk " + std::to_string(i % 97) + " ";
+
+  // Compress in independent chunks and assemble a single zlib stream.
+  const size_t ChunkSize = 4096;
+  SmallString<32> Compressed(
+      StringRef(zlib::ChunkedHeader, sizeof(zlib::ChunkedHeader)));
+  uint32_t Checksum = zlib::adler32(StringRef());
+  for (size_t Offset = 0; Offset < Input.size(); Offset += ChunkSize) {
+    StringRef Chunk = StringRef(Input).substr(Offset, ChunkSize);
+    SmallString<32> CompressedChunk;
+    Error E = zlib::compressChunk(Chunk, CompressedChunk,
+                                  Offset + ChunkSize >= Input.size());
+    EXPECT_FALSE(E);
+    consumeError(std::move(E));
+    Compressed += CompressedChunk;
+    Checksum = zlib::adler32Combine(Checksum, zlib::adler32(Chunk),
+                                    Chunk.size());
+  }
+  EXPECT_EQ(zlib::adler32(Input), Checksum);
+  for (int i = 3; i >= 0; --i)
+    Compressed.push_back(char(Checksum >> (i * 8)));
+
+  SmallString<32> Uncompressed;
+  Error E = zlib::uncompress(Compressed, Uncompressed, Input.size());
+  EXPECT_FALSE(E);
+  consumeError(std::move(E));
+  EXPECT_EQ(Input, Uncompressed);
+}
+
 #endif
 
+TEST(CompressionTest, Zstd) {
+  if (!zstd::isAvailable())
+    GTEST_SKIP();
+
+  const std::string Input(100000, 'x');
+  SmallString<32> Compressed;
+  for (size_t Offset = 0; Offset < Input.size(); Offset += 30000) {
+    // Multiple concatenated frames form a single stream.
+    SmallString<32> Frame;
+    Error E = zstd::compress(StringRef(Input).substr(Offset, 30000), Frame);
+    EXPECT_FALSE(E);
+    consumeError(std::move(E));
+    Compressed += Frame;
+  }
+
+  SmallString<32> Uncompressed;
+  Error E = zstd::uncompress(Compressed, Uncompressed, Input.size());
+  EXPECT_FALSE(E);
+  consumeError(std::move(E));
+  EXPECT_EQ(Input, Uncompressed);
+
+  // Uncompression fails if expected length is too short.
+  E = zstd::uncompress(Compressed, Uncompressed, Input.size() - 1);
+  EXPECT_TRUE(bool(E));
+  consumeError(std::move(E));
+}
+
 }
@@ -14,6 +14,7 @@
 #include "llvm/Support/Parallel.h"
 #include "gtest/gtest.h"
 #include <array>
+#include <atomic>
 #include <random>
 
 uint32_t array[1024 * 1024];
@@ -49,6 +50,35 @@ TEST(Parallel, parallel_for) {
   ASSERT_EQ(range[2049], 1u);
 }
 
+TEST(Parallel, NestedParallelForEach) {
+  // Nested parallel loops must neither deadlock nor lose any work items.
+  std::atomic<size_t> count{0};
+  parallelForEachN(0, 64, [&](size_t) {
+    parallelForEachN(0, 256, [&](size_t) {
+      parallelForEachN(0, 8, [&](size_t) { ++count; });
+    });
+  });
+  ASSERT_EQ(count, 64u * 256u * 8u);
+}
+
+#if LLVM_ENABLE_THREADS
+TEST(Parallel, NestedTaskGroup) {
+  std::atomic<size_t> count{0};
+  parallel::detail::TaskGroup outer;
+  for (size_t i = 0; i < 32; ++i) {
+    outer.spawn([&count] {
+      parallel::detail::TaskGroup inner;
+      for (size_t j = 0; j < 32; ++j)
+        inner.spawn([&count] { ++count; });
+      inner.sync();
+      ++count;
+    });
+  }
+  outer.sync();
+  ASSERT_EQ(count, 32u * 32u + 32u);
+}
+#endif
+
 TEST(Parallel, TransformReduce) {
   // Sum an empty list, check that it works.
   auto identity = [](uint32_t v) { return v; };
@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Threading.h"
+#include "llvm/Support/Jobserver.h"
 #include "llvm/Support/thread.h"
 #include "gtest/gtest.h"
 
@@ -25,6 +26,28 @@ TEST(Threading, PhysicalConcurrency) {
             hardware_concurrency().compute_thread_count());
 }
 
+TEST(Threading, JobserverStrategy) {
+  Optional<ThreadPoolStrategy> S = get_threadpool_strategy("jobserver");
+  ASSERT_TRUE(S.hasValue());
+  EXPECT_TRUE(S->UseJobserver);
+  EXPECT_EQ(S->ThreadsRequested, 0u);
+  EXPECT_FALSE(get_threadpool_strategy("4")->UseJobserver);
+}
+
+TEST(Threading, JobserverAuth) {
+  EXPECT_EQ(JobserverClient::getJobserverAuth(""), "");
+  EXPECT_EQ(JobserverClient::getJobserverAuth("-j8"), "");
+  EXPECT_EQ(JobserverClient::getJobserverAuth(" -j8 --jobserver-fds=3,4 -j"),
+            "3,4");
+  EXPECT_EQ(JobserverClient::getJobserverAuth(
+                "-j8 --jobserver-auth=fifo:/tmp/GMfifo123"),
+            "fifo:/tmp/GMfifo123");
+  // The last one wins.
+  EXPECT_EQ(JobserverClient::getJobserverAuth(
+                "--jobserver-auth=3,4 --jobserver-auth=5,6"),
+            "5,6");
+}
+
 #if LLVM_ENABLE_THREADS
 
 class Notification {
@@ -408,6 +408,14 @@ static void registerPollyPasses(llvm::legacy::PassManagerBase &PM,
 
 static bool shouldEnablePollyForOptimization() { return PollyEnabled; }
 
+/// Polly is always enabled for floor host-compute modules whose kernels have
+/// been put into work-group loop nests, since that is their sole purpose.
+static bool
+shouldEnablePollyForOptimization(const llvm::PassManagerBuilder &Builder) {
+  return shouldEnablePollyForOptimization() ||
+         Builder.EnableHostComputeWorkGroupLoops;
+}
+
 static bool shouldEnablePollyForDiagnostic() {
   // FIXME: PollyTrackFailures is user-controlled, should not be set
   // programmatically.
@@ -424,7 +432,7 @@ registerPollyEarlyAsPossiblePasses(const llvm::PassManagerBuilder &Builder,
   if (PassPosition != POSITION_EARLY)
     return;
 
-  bool EnableForOpt = shouldEnablePollyForOptimization() &&
+  bool EnableForOpt = shouldEnablePollyForOptimization(Builder) &&
                       Builder.OptLevel >= 1 && Builder.SizeLevel == 0;
   if (!shouldEnablePollyForDiagnostic() && !EnableForOpt)
     return;
@@ -439,7 +447,7 @@ registerPollyLoopOptimizerEndPasses(const llvm::PassManagerBuilder &Builder,
   if (PassPosition != POSITION_AFTER_LOOPOPT)
     return;
 
-  bool EnableForOpt = shouldEnablePollyForOptimization() &&
+  bool EnableForOpt = shouldEnablePollyForOptimization(Builder) &&
                       Builder.OptLevel >= 1 && Builder.SizeLevel == 0;
   if (!shouldEnablePollyForDiagnostic() && !EnableForOpt)
     return;
@@ -455,7 +463,7 @@ registerPollyScalarOptimizerLatePasses(const llvm::PassManagerBuilder &Builder,
   if (PassPosition != POSITION_BEFORE_VECTORIZER)
     return;
 
-  bool EnableForOpt = shouldEnablePollyForOptimization() &&
+  bool EnableForOpt = shouldEnablePollyForOptimization(Builder) &&
                       Builder.OptLevel >= 1 && Builder.SizeLevel == 0;
   if (!shouldEnablePollyForDiagnostic() && !EnableForOpt)
     return;